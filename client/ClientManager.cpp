@@ -22,6 +22,11 @@
  */
 #include <tellstore/ClientManager.hpp>
 
+#include <crossbow/byte_buffer.hpp>
+
+#include <algorithm>
+#include <initializer_list>
+
 namespace tell {
 namespace store {
 namespace {
@@ -59,6 +64,18 @@ Table ClientHandle::createTable(const crossbow::string& name, Schema schema) {
     return mProcessor.createTable(mFiber, name, std::move(schema));
 }
 
+Table ClientHandle::alterTable(const Table& table, Schema schema) {
+    return mProcessor.alterTable(mFiber, table, std::move(schema));
+}
+
+void ClientHandle::dropTable(const Table& table) {
+    mProcessor.dropTable(mFiber, table);
+}
+
+void ClientHandle::truncateTable(const Table& table) {
+    mProcessor.truncateTable(mFiber, table);
+}
+
 std::shared_ptr<GetTablesResponse> ClientHandle::getTables() {
     return mProcessor.getTables(mFiber);
 }
@@ -71,14 +88,50 @@ std::shared_ptr<GetResponse> ClientHandle::get(const Table& table, uint64_t key)
     checkTableType(table, TableType::NON_TRANSACTIONAL);
 
     auto snapshot = createNonTransactionalSnapshot(std::numeric_limits<uint64_t>::max());
-    return mProcessor.get(mFiber, table.tableId(), key, *snapshot);
+    return mProcessor.get(mFiber, table, key, *snapshot);
 }
 
 std::shared_ptr<GetResponse> ClientHandle::get(const Table& table, uint64_t key,
         const commitmanager::SnapshotDescriptor& snapshot) {
     checkTableType(table, TableType::TRANSACTIONAL);
 
-    return mProcessor.get(mFiber, table.tableId(), key, snapshot);
+    return mProcessor.get(mFiber, table, key, snapshot);
+}
+
+std::shared_ptr<const Tuple> ClientHandle::getCached(const Table& table, uint64_t key,
+        const commitmanager::SnapshotDescriptor& snapshot) {
+    checkTableType(table, TableType::TRANSACTIONAL);
+
+    auto& cache = mProcessor.readCache();
+    if (!cache.isCached(table)) {
+        return std::shared_ptr<const Tuple>(mProcessor.get(mFiber, table, key, snapshot)->get());
+    }
+
+    auto& watermark = cacheWatermark(table, snapshot);
+    auto shard = mProcessor.shardIndex(table, key);
+
+    auto entry = cache.lookup(table.tableId(), key);
+    if (entry != nullptr && watermark[shard] != UNKNOWN_WATERMARK && entry->watermark == watermark[shard]
+            && snapshot.inReadSet(entry->tuple->version())) {
+        cache.recordHit();
+        return entry->tuple;
+    }
+    cache.recordMiss();
+
+    auto response = mProcessor.get(mFiber, table, key, snapshot);
+    std::shared_ptr<const Tuple> tuple(response->get());
+
+    // The shard read the counter after the snapshot was acquired, tuples tagged with the same counter are the newest
+    // version for the rest of the snapshot
+    if (watermark[shard] == UNKNOWN_WATERMARK) {
+        watermark[shard] = response->watermark();
+    }
+    if (tuple->isNewest()) {
+        cache.insert(table.tableId(), key, tuple, response->watermark());
+    } else {
+        cache.invalidate(table.tableId(), key);
+    }
+    return tuple;
 }
 
 std::shared_ptr<ModificationResponse> ClientHandle::insert(const Table& table, uint64_t key, uint64_t version,
@@ -92,7 +145,7 @@ std::shared_ptr<ModificationResponse> ClientHandle::insert(const Table& table, u
     checkTableType(table, TableType::NON_TRANSACTIONAL);
 
     auto snapshot = createNonTransactionalSnapshot(version);
-    return mProcessor.insert(mFiber, table.tableId(), key, *snapshot, tuple);
+    return mProcessor.insert(mFiber, table, key, *snapshot, tuple);
 }
 
 std::shared_ptr<ModificationResponse> ClientHandle::insert(const Table& table, uint64_t key,
@@ -105,7 +158,7 @@ std::shared_ptr<ModificationResponse> ClientHandle::insert(const Table& table, u
         const commitmanager::SnapshotDescriptor& snapshot, const AbstractTuple& tuple) {
     checkTableType(table, TableType::TRANSACTIONAL);
 
-    return mProcessor.insert(mFiber, table.tableId(), key, snapshot, tuple);
+    return mProcessor.insert(mFiber, table, key, snapshot, tuple);
 }
 
 std::shared_ptr<ModificationResponse> ClientHandle::update(const Table& table, uint64_t key, uint64_t version,
@@ -119,7 +172,7 @@ std::shared_ptr<ModificationResponse> ClientHandle::update(const Table& table, u
     checkTableType(table, TableType::NON_TRANSACTIONAL);
 
     auto snapshot = createNonTransactionalSnapshot(version);
-    return mProcessor.update(mFiber, table.tableId(), key, *snapshot, tuple);
+    return mProcessor.update(mFiber, table, key, *snapshot, tuple);
 }
 
 std::shared_ptr<ModificationResponse> ClientHandle::update(const Table& table, uint64_t key,
@@ -132,28 +185,28 @@ std::shared_ptr<ModificationResponse> ClientHandle::update(const Table& table, u
         const commitmanager::SnapshotDescriptor& snapshot, const AbstractTuple& tuple) {
     checkTableType(table, TableType::TRANSACTIONAL);
 
-    return mProcessor.update(mFiber, table.tableId(), key, snapshot, tuple);
+    return mProcessor.update(mFiber, table, key, snapshot, tuple);
 }
 
 std::shared_ptr<ModificationResponse> ClientHandle::remove(const Table& table, uint64_t key, uint64_t version) {
     checkTableType(table, TableType::NON_TRANSACTIONAL);
 
     auto snapshot = createNonTransactionalSnapshot(version);
-    return mProcessor.remove(mFiber, table.tableId(), key, *snapshot);
+    return mProcessor.remove(mFiber, table, key, *snapshot);
 }
 
 std::shared_ptr<ModificationResponse> ClientHandle::remove(const Table& table, uint64_t key,
         const commitmanager::SnapshotDescriptor& snapshot) {
     checkTableType(table, TableType::TRANSACTIONAL);
 
-    return mProcessor.remove(mFiber, table.tableId(), key, snapshot);
+    return mProcessor.remove(mFiber, table, key, snapshot);
 }
 
 std::shared_ptr<ModificationResponse> ClientHandle::revert(const Table& table, uint64_t key,
         const commitmanager::SnapshotDescriptor& snapshot) {
     checkTableType(table, TableType::TRANSACTIONAL);
 
-    return mProcessor.revert(mFiber, table.tableId(), key, snapshot);
+    return mProcessor.revert(mFiber, table, key, snapshot);
 }
 
 std::shared_ptr<ScanIterator> ClientHandle::scan(const Table& table, const commitmanager::SnapshotDescriptor& snapshot,
@@ -161,14 +214,55 @@ std::shared_ptr<ScanIterator> ClientHandle::scan(const Table& table, const commi
         uint32_t queryLength, const char* query) {
     checkTableType(table, TableType::TRANSACTIONAL);
 
-    return mProcessor.scan(mFiber, table.tableId(), snapshot, table.record(), memoryManager, queryType, selectionLength,
-            selection, queryLength, query);
+    return mProcessor.scan(mFiber, table, snapshot, memoryManager, queryType, selectionLength, selection, queryLength,
+            query);
+}
+
+constexpr uint64_t ClientHandle::UNKNOWN_WATERMARK;
+
+std::vector<uint64_t>& ClientHandle::cacheWatermark(const Table& table,
+        const commitmanager::SnapshotDescriptor& snapshot) {
+    // Counters received in a previous snapshot might miss modifications committed before the current snapshot
+    if (mCacheSnapshot != &snapshot || mCacheVersion != snapshot.version()) {
+        mCacheWatermarks.clear();
+        mCacheSnapshot = &snapshot;
+        mCacheVersion = snapshot.version();
+    }
+
+    auto i = mCacheWatermarks.find(table.tableId());
+    if (i == mCacheWatermarks.end()) {
+        i = mCacheWatermarks.emplace(table.tableId(),
+                std::vector<uint64_t>(mProcessor.shardCount(), UNKNOWN_WATERMARK)).first;
+    }
+    return i->second;
+}
+
+std::unique_ptr<ClientBatch> ClientHandle::startBatch(const commitmanager::SnapshotDescriptor& snapshot) {
+    return std::unique_ptr<ClientBatch>(new ClientBatch(mProcessor, mFiber, snapshot));
+}
+
+ServerStatistics ClientHandle::stats() {
+    return mProcessor.stats(mFiber);
+}
+
+MemoryUsage ClientHandle::memoryUsage() {
+    return mProcessor.memoryUsage(mFiber);
+}
+
+uint64_t ClientHandle::exportTable(const Table& table, const crossbow::string& fileName,
+        const commitmanager::SnapshotDescriptor& snapshot) {
+    checkTableType(table, TableType::TRANSACTIONAL);
+
+    return mProcessor.exportTable(mFiber, table, fileName, snapshot);
 }
 
 BaseClientProcessor::BaseClientProcessor(crossbow::infinio::InfinibandService& service, const ClientConfig& config,
         uint64_t processorNum)
         : mProcessor(service.createProcessor()),
+          mFiberPool(*mProcessor, config.fiberPoolSize, config.maxFiberPoolSize),
           mCommitManagerSocket(service.createSocket(*mProcessor), config.maxPendingResponses, config.maxBatchSize),
+          mReadCache(config.readCacheCapacity, config.readCacheTables),
+          mMaxRequestLength(config.infinibandConfig.bufferLength - REQUEST_HEADER_LENGTH),
           mProcessorNum(processorNum),
           mScanId(0u) {
     mCommitManagerSocket.connect(config.commitManager);
@@ -190,6 +284,12 @@ void BaseClientProcessor::shutdown() {
     for (auto& socket : mTellStoreSocket) {
         socket->shutdown();
     }
+
+    LOG_INFO("Fiber pool of processor %1% [size = %2%, hits = %3%, misses = %4%, waits = %5%]", mProcessorNum,
+            mFiberPool.size(), mFiberPool.hits(), mFiberPool.misses(), mFiberPool.waits());
+    LOG_INFO("Read cache of processor %1% [size = %2%, hits = %3%, misses = %4%]", mProcessorNum, mReadCache.size(),
+            mReadCache.hits(), mReadCache.misses());
+    mFiberPool.shutdown();
 }
 
 std::unique_ptr<commitmanager::SnapshotDescriptor> BaseClientProcessor::start(crossbow::infinio::Fiber& fiber,
@@ -210,6 +310,9 @@ void BaseClientProcessor::commit(crossbow::infinio::Fiber& fiber, const commitma
 }
 
 Table BaseClientProcessor::createTable(crossbow::infinio::Fiber& fiber, const crossbow::string& name, Schema schema) {
+    // Check if the partition specification can be applied to the shards before creating the table
+    Partitioner::create(schema.partitioning(), mTellStoreSocket.size());
+
     // TODO Return a combined createTable future?
     std::vector<std::shared_ptr<CreateTableResponse>> requests;
     requests.reserve(mTellStoreSocket.size());
@@ -225,14 +328,79 @@ Table BaseClientProcessor::createTable(crossbow::infinio::Fiber& fiber, const cr
     return Table(tableId, name, std::move(schema));
 }
 
-std::shared_ptr<ScanIterator> BaseClientProcessor::scan(crossbow::infinio::Fiber& fiber, uint64_t tableId,
-        const commitmanager::SnapshotDescriptor& snapshot, Record record, ScanMemoryManager& memoryManager,
-        ScanQueryType queryType, uint32_t selectionLength, const char* selection, uint32_t queryLength,
-        const char* query) {
-    auto scanId = ++mScanId;
+Table BaseClientProcessor::alterTable(crossbow::infinio::Fiber& fiber, const Table& table, Schema schema) {
+    // The partitioning is fixed when the table is created
+    schema.setPartitioning(table.record().schema().partitioning());
+
+    // Validate the schema change on all shards first so a rejected change does not leave some shards altered
+    for (auto validateOnly : {true, false}) {
+        std::vector<std::shared_ptr<ModificationResponse>> requests;
+        requests.reserve(mTellStoreSocket.size());
+        for (auto& socket : mTellStoreSocket) {
+            requests.emplace_back(socket->alterTable(fiber, table.tableId(), table.schemaVersion(), schema,
+                    validateOnly));
+        }
+        for (auto& i : requests) {
+            if (!i->waitForResult()) {
+                throw std::system_error(i->error());
+            }
+        }
+    }
+    return Table(table.tableId(), table.tableName(), std::move(schema), table.schemaVersion() + 1u);
+}
 
-    auto iterator = std::make_shared<ScanIterator>(fiber, std::move(record), mTellStoreSocket.size());
+void BaseClientProcessor::dropTable(crossbow::infinio::Fiber& fiber, const Table& table) {
+    std::vector<std::shared_ptr<ModificationResponse>> requests;
+    requests.reserve(mTellStoreSocket.size());
     for (auto& socket : mTellStoreSocket) {
+        requests.emplace_back(socket->dropTable(fiber, table.tableId()));
+    }
+    for (auto& i : requests) {
+        if (!i->waitForResult()) {
+            throw std::system_error(i->error());
+        }
+    }
+}
+
+void BaseClientProcessor::truncateTable(crossbow::infinio::Fiber& fiber, const Table& table) {
+    std::vector<std::shared_ptr<ModificationResponse>> requests;
+    requests.reserve(mTellStoreSocket.size());
+    for (auto& socket : mTellStoreSocket) {
+        requests.emplace_back(socket->truncateTable(fiber, table.tableId()));
+    }
+    for (auto& i : requests) {
+        if (!i->waitForResult()) {
+            throw std::system_error(i->error());
+        }
+    }
+}
+
+std::shared_ptr<ScanIterator> BaseClientProcessor::scan(crossbow::infinio::Fiber& fiber, const Table& table,
+        const commitmanager::SnapshotDescriptor& snapshot, ScanMemoryManager& memoryManager, ScanQueryType queryType,
+        uint32_t selectionLength, const char* selection, uint32_t queryLength, const char* query) {
+    auto scanId = ++mScanId;
+
+    // Only shards that can hold keys matching the partition selection of the query have to take part in the scan
+    std::vector<bool> shards;
+    if (selectionLength >= 4 * sizeof(uint32_t)) {
+        crossbow::buffer_reader selectionReader(selection, selectionLength);
+        selectionReader.advance(sizeof(uint32_t) + sizeof(uint16_t));
+        auto partitionShift = selectionReader.read<uint16_t>();
+        auto partitionModulo = selectionReader.read<uint32_t>();
+        auto partitionNumber = selectionReader.read<uint32_t>();
+        partitioner(table).shardsOf(partitionShift, partitionModulo, partitionNumber, shards);
+    } else {
+        shards.assign(mTellStoreSocket.size(), true);
+    }
+
+    auto iterator = std::make_shared<ScanIterator>(fiber, table.record(),
+            std::count(shards.begin(), shards.end(), true));
+    for (decltype(mTellStoreSocket.size()) i = 0; i < mTellStoreSocket.size(); ++i) {
+        if (!shards[i]) {
+            continue;
+        }
+        auto& socket = mTellStoreSocket[i];
+
         auto memory = memoryManager.acquire();
         if (!memory.valid()) {
             iterator->abort(std::make_error_code(std::errc::not_enough_memory));
@@ -242,11 +410,193 @@ std::shared_ptr<ScanIterator> BaseClientProcessor::scan(crossbow::infinio::Fiber
         auto response = std::make_shared<ScanResponse>(fiber, iterator, *socket, std::move(memory), scanId);
         iterator->addScanResponse(response);
 
-        socket->scanStart(scanId, std::move(response), tableId, queryType, selectionLength, selection, queryLength,
-                query, snapshot);
+        socket->scanStart(scanId, std::move(response), table.tableId(), queryType, selectionLength, selection,
+                queryLength, query, snapshot);
     }
     return iterator;
 }
 
+ServerStatistics BaseClientProcessor::stats(crossbow::infinio::Fiber& fiber) {
+    std::vector<std::shared_ptr<StatsResponse>> requests;
+    requests.reserve(mTellStoreSocket.size());
+    for (auto& socket : mTellStoreSocket) {
+        requests.emplace_back(socket->stats(fiber));
+    }
+
+    ServerStatistics result;
+    for (auto& i : requests) {
+        result.merge(i->get());
+    }
+    return result;
+}
+
+MemoryUsage BaseClientProcessor::memoryUsage(crossbow::infinio::Fiber& fiber) {
+    std::vector<std::shared_ptr<MemoryUsageResponse>> requests;
+    requests.reserve(mTellStoreSocket.size());
+    for (auto& socket : mTellStoreSocket) {
+        requests.emplace_back(socket->memoryUsage(fiber));
+    }
+
+    MemoryUsage result;
+    for (auto& i : requests) {
+        result.merge(i->get());
+    }
+    return result;
+}
+
+uint64_t BaseClientProcessor::exportTable(crossbow::infinio::Fiber& fiber, const Table& table,
+        const crossbow::string& fileName, const commitmanager::SnapshotDescriptor& snapshot) {
+    std::vector<std::shared_ptr<ExportTableResponse>> requests;
+    requests.reserve(mTellStoreSocket.size());
+    for (auto& socket : mTellStoreSocket) {
+        requests.emplace_back(socket->exportTable(fiber, table.tableId(), fileName, snapshot));
+    }
+
+    uint64_t result = 0u;
+    for (auto& i : requests) {
+        result += i->get();
+    }
+    return result;
+}
+
+const Partitioner& BaseClientProcessor::partitioner(const Table& table) {
+    auto i = mPartitioner.find(table.tableId());
+    if (i == mPartitioner.end()) {
+        auto partitioner = Partitioner::create(table.record().schema().partitioning(), mTellStoreSocket.size());
+        i = mPartitioner.emplace(table.tableId(), std::move(partitioner)).first;
+    }
+    return *i->second;
+}
+
+bool ClientBatch::Future::waitForResult() {
+    auto& response = mBatch->response(mShard, mRequest);
+    if (!response.waitForResult()) {
+        return false;
+    }
+    return !response.operationError(mIndex);
+}
+
+const std::error_code& ClientBatch::Future::error() const {
+    auto& response = mBatch->response(mShard, mRequest);
+    if (response.error()) {
+        return response.error();
+    }
+    return response.operationError(mIndex);
+}
+
+std::unique_ptr<Tuple> ClientBatch::Future::get() {
+    if (!waitForResult()) {
+        throw std::system_error(error());
+    }
+    return mBatch->response(mShard, mRequest).operationTuple(mIndex);
+}
+
+ClientBatch::ClientBatch(BaseClientProcessor& processor, crossbow::infinio::Fiber& fiber,
+        const commitmanager::SnapshotDescriptor& snapshot)
+        : mProcessor(processor),
+          mFiber(fiber),
+          mSnapshot(snapshot),
+          mMaxOperationsLength(0u),
+          mOperations(processor.shardCount()),
+          mResponses(processor.shardCount()),
+          mSent(false) {
+    // Every request carries the batch header and the snapshot besides the operations
+    auto requestOverhead = 2 * sizeof(uint64_t) + snapshot.serializedLength();
+    if (requestOverhead < processor.maxRequestLength()) {
+        mMaxOperationsLength = processor.maxRequestLength() - requestOverhead;
+    }
+}
+
+ClientBatch::Future ClientBatch::get(const Table& table, uint64_t key) {
+    return append(RequestType::GET, table, key, nullptr);
+}
+
+ClientBatch::Future ClientBatch::insert(const Table& table, uint64_t key, GenericTuple data) {
+    GenericTupleSerializer tuple(table.record(), std::move(data));
+    return insert(table, key, tuple);
+}
+
+ClientBatch::Future ClientBatch::insert(const Table& table, uint64_t key, const AbstractTuple& tuple) {
+    return append(RequestType::INSERT, table, key, &tuple);
+}
+
+ClientBatch::Future ClientBatch::update(const Table& table, uint64_t key, GenericTuple data) {
+    GenericTupleSerializer tuple(table.record(), std::move(data));
+    return update(table, key, tuple);
+}
+
+ClientBatch::Future ClientBatch::update(const Table& table, uint64_t key, const AbstractTuple& tuple) {
+    return append(RequestType::UPDATE, table, key, &tuple);
+}
+
+ClientBatch::Future ClientBatch::remove(const Table& table, uint64_t key) {
+    return append(RequestType::REMOVE, table, key, nullptr);
+}
+
+ClientBatch::Future ClientBatch::revert(const Table& table, uint64_t key) {
+    return append(RequestType::REVERT, table, key, nullptr);
+}
+
+void ClientBatch::send() {
+    if (mSent) {
+        return;
+    }
+    mSent = true;
+
+    for (decltype(mOperations.size()) i = 0; i < mOperations.size(); ++i) {
+        if (!mOperations[i].empty()) {
+            flush(i);
+        }
+    }
+}
+
+void ClientBatch::reset() {
+    for (auto& operations : mOperations) {
+        operations.clear();
+    }
+    for (auto& responses : mResponses) {
+        responses.clear();
+    }
+    mSent = false;
+}
+
+ClientBatch::Future ClientBatch::append(RequestType type, const Table& table, uint64_t key,
+        const AbstractTuple* tuple) {
+    checkTableType(table, TableType::TRANSACTIONAL);
+    if (mSent) {
+        throw std::logic_error("Batch was already sent");
+    }
+
+    auto length = BatchOperations::operationLength(tuple);
+    if (length > mMaxOperationsLength) {
+        throw std::length_error("Operation does not fit into a batch request");
+    }
+
+    if (type != RequestType::GET) {
+        mProcessor.readCache().invalidate(table.tableId(), key);
+    }
+
+    auto shard = mProcessor.shardIndex(table, key);
+    auto& operations = mOperations[shard];
+    if (operations.data().size() + length > mMaxOperationsLength) {
+        flush(shard);
+    }
+
+    auto index = operations.append(type, table.tableId(), table.schemaVersion(), key, tuple);
+    return Future(this, shard, mResponses[shard].size(), index);
+}
+
+void ClientBatch::flush(size_t shard) {
+    auto& operations = mOperations[shard];
+    mResponses[shard].emplace_back(mProcessor.batch(mFiber, shard, operations, mSnapshot));
+    operations.clear();
+}
+
+BatchResponse& ClientBatch::response(size_t shard, size_t request) {
+    send();
+    LOG_ASSERT(request < mResponses.at(shard).size(), "No response for request");
+    return *mResponses.at(shard)[request];
+}
+
 } // namespace store
 } // namespace tell
@@ -31,6 +31,8 @@
 #include <crossbow/infinio/InfinibandBuffer.hpp>
 #include <crossbow/logger.hpp>
 
+#include <algorithm>
+
 namespace tell {
 namespace store {
 namespace {
@@ -63,9 +65,11 @@ void GetTablesResponse::processResponse(crossbow::buffer_reader& message) {
         crossbow::string tableName(message.read(tableNameLength), tableNameLength);
         message.align(8u);
 
+        auto schemaVersion = message.read<uint32_t>();
+        message.align(8u);
         auto schema = Schema::deserialize(message);
 
-        result.emplace_back(tableId, std::move(tableName), std::move(schema));
+        result.emplace_back(tableId, std::move(tableName), std::move(schema), schemaVersion);
     }
 
     setResult(std::move(result));
@@ -73,12 +77,15 @@ void GetTablesResponse::processResponse(crossbow::buffer_reader& message) {
 
 void GetTableResponse::processResponse(crossbow::buffer_reader& message) {
     auto tableId = message.read<uint64_t>();
+    auto schemaVersion = message.read<uint32_t>();
+    message.align(8u);
     auto schema = Schema::deserialize(message);
 
-    setResult(tableId, std::move(mTableName), std::move(schema));
+    setResult(tableId, std::move(mTableName), std::move(schema), schemaVersion);
 }
 
 void GetResponse::processResponse(crossbow::buffer_reader& message) {
+    mWatermark = message.read<uint64_t>();
     setResult(Tuple::deserialize(message));
 }
 
@@ -86,6 +93,76 @@ void ModificationResponse::processResponse(crossbow::buffer_reader& /* message *
     // Nothing to do
 }
 
+uint32_t BatchOperations::operationLength(const AbstractTuple* tuple) {
+    return 3 * sizeof(uint64_t) + (tuple != nullptr ? tuple->size() : 0u);
+}
+
+uint32_t BatchOperations::append(RequestType type, uint64_t tableId, uint32_t schemaVersion, uint64_t key,
+        const AbstractTuple* tuple) {
+    uint32_t tupleLength = (tuple != nullptr ? tuple->size() : 0u);
+    LOG_ASSERT(tupleLength % 8 == 0, "Data must be 8 byte padded");
+
+    auto offset = mData.size();
+    mData.resize(offset + operationLength(tuple));
+
+    crossbow::buffer_writer message(mData.data() + offset, mData.size() - offset);
+    message.write<uint16_t>(crossbow::to_underlying(type));
+    message.write<uint16_t>(schemaVersion);
+    message.write<uint32_t>(tupleLength);
+    message.write<uint64_t>(tableId);
+    message.write<uint64_t>(key);
+    if (tuple != nullptr) {
+        tuple->serialize(message.data());
+    }
+
+    return mCount++;
+}
+
+void BatchResponse::processResponse(crossbow::buffer_reader& message) {
+    auto resultCount = message.read<uint64_t>();
+    mResults.clear();
+    mResults.reserve(resultCount);
+
+    for (decltype(resultCount) i = 0; i < resultCount; ++i) {
+        auto ec = message.read<uint32_t>();
+        auto hasTuple = (message.read<uint32_t>() != 0x0u);
+
+        std::unique_ptr<Tuple> tuple;
+        if (hasTuple) {
+            tuple = Tuple::deserialize(message);
+            message.align(8u);
+        }
+
+        if (ec == 0) {
+            mResults.emplace_back(std::error_code(), std::move(tuple));
+        } else {
+            mResults.emplace_back(std::error_code(ec, error::get_error_category()), std::move(tuple));
+        }
+    }
+}
+
+void WatermarkResponse::processResponse(crossbow::buffer_reader& message) {
+    std::vector<uint64_t> result;
+    result.reserve(mCount);
+    for (decltype(mCount) i = 0; i < mCount; ++i) {
+        result.emplace_back(message.read<uint64_t>());
+    }
+    setResult(std::move(result));
+}
+
+void StatsResponse::processResponse(crossbow::buffer_reader& message) {
+    setResult(ServerStatistics::deserialize(message));
+}
+
+void MemoryUsageResponse::processResponse(crossbow::buffer_reader& message) {
+    setResult(MemoryUsage::deserialize(message));
+}
+
+void ExportTableResponse::processResponse(crossbow::buffer_reader& message) {
+    auto rowCount = message.read<uint64_t>();
+    setResult(rowCount);
+}
+
 ScanResponse::ScanResponse(crossbow::infinio::Fiber& fiber, std::shared_ptr<ScanIterator> iterator,
         ClientSocket& socket, ScanMemory memory, uint16_t scanId)
         : crossbow::infinio::RpcResponse(fiber),
@@ -94,24 +171,54 @@ ScanResponse::ScanResponse(crossbow::infinio::Fiber& fiber, std::shared_ptr<Scan
           mMemory(std::move(memory)),
           mScanId(scanId),
           mOffsetRead(0u),
-          mOffsetWritten(0u) {
+          mOffsetReleased(0u),
+          mOffsetAdvertised(0u),
+          mOffsetWritten(0u),
+          mWrapOffset(0u) {
     LOG_ASSERT(mMemory.valid(), "Memory not valid");
 }
 
 std::tuple<const char*, const char*> ScanResponse::nextChunk() {
     LOG_ASSERT(available(), "No data available");
 
-    auto start = reinterpret_cast<const char*>(mMemory.data()) + mOffsetRead;
-    auto end = reinterpret_cast<const char*>(mMemory.data()) + mOffsetWritten;
-    mOffsetRead = mOffsetWritten;
+    auto length = mMemory.length();
 
-    if (!done()) {
-        mSocket.scanProgress(mScanId, shared_from_this(), mOffsetRead);
+    // Skip the space the remote server left empty before it wrapped around
+    if (mOffsetRead == mWrapOffset && (mOffsetRead % length) != 0u) {
+        mOffsetRead += length - (mOffsetRead % length);
+        LOG_ASSERT(available(), "No data available after wrap around");
     }
 
+    // The chunk ends at the end of the written data, at the end of the memory or where the server wrapped around
+    auto position = mOffsetRead % length;
+    auto offsetEnd = std::min(mOffsetWritten, mOffsetRead + (length - position));
+    if (mWrapOffset > mOffsetRead) {
+        offsetEnd = std::min(offsetEnd, mWrapOffset);
+    }
+
+    auto start = reinterpret_cast<const char*>(mMemory.data()) + position;
+    auto end = start + (offsetEnd - mOffsetRead);
+    mOffsetRead = offsetEnd;
+
     return std::make_tuple(start, end);
 }
 
+void ScanResponse::releaseChunk() {
+    mOffsetReleased = mOffsetRead;
+    if (done() || mOffsetReleased == mOffsetAdvertised) {
+        return;
+    }
+
+    // Advertise released memory in batches: Only notify the server when half of the memory was released or when all
+    // available data was consumed (the client would otherwise wait on the server while the server waits on the client)
+    if (available() && (mOffsetReleased - mOffsetAdvertised) < (mMemory.length() / 2)) {
+        return;
+    }
+
+    mOffsetAdvertised = mOffsetReleased;
+    mSocket.scanProgress(mScanId, shared_from_this(), mOffsetReleased);
+}
+
 void ScanResponse::onResponse(uint32_t messageType, crossbow::buffer_reader& message) {
     if (messageType == std::numeric_limits<uint32_t>::max()) {
         onAbort(std::error_code(message.read<uint64_t>(), error::get_error_category()));
@@ -130,8 +237,10 @@ void ScanResponse::onResponse(uint32_t messageType, crossbow::buffer_reader& mes
 
     message.advance(sizeof(size_t) - sizeof(uint8_t));
     auto offset = message.read<size_t>();
+    auto wrapOffset = message.read<size_t>();
     if (mOffsetWritten < offset) {
         mOffsetWritten = offset;
+        mWrapOffset = wrapOffset;
     }
 
     if (scanDone) {
@@ -161,6 +270,7 @@ ScanIterator::ScanIterator(crossbow::infinio::Fiber& fiber, Record record, size_
         : mFiber(fiber),
           mRecord(std::move(record)),
           mWaiting(false),
+          mChunkResponse(nullptr),
           mChunkPos(nullptr),
           mChunkEnd(nullptr) {
     mScans.reserve(shardSize);
@@ -171,6 +281,12 @@ bool ScanIterator::hasNext() {
         throw std::system_error(mError);
     }
     while (mChunkPos == nullptr) {
+        // The previous chunk is no longer accessed so the memory can be reused by the server
+        if (mChunkResponse != nullptr) {
+            mChunkResponse->releaseChunk();
+            mChunkResponse = nullptr;
+        }
+
         auto done = true;
         for (auto& response : mScans) {
             done = (done && response->done());
@@ -178,6 +294,7 @@ bool ScanIterator::hasNext() {
                 continue;
             }
             std::tie(mChunkPos, mChunkEnd) = response->nextChunk();
+            mChunkResponse = response.get();
             return true;
         }
         if (done) {
@@ -277,6 +394,49 @@ std::shared_ptr<CreateTableResponse> ClientSocket::createTable(crossbow::infinio
     return response;
 }
 
+std::shared_ptr<ModificationResponse> ClientSocket::alterTable(crossbow::infinio::Fiber& fiber, uint64_t tableId,
+        uint32_t schemaVersion, const Schema& schema, bool validateOnly) {
+    auto response = std::make_shared<ModificationResponse>(fiber);
+
+    uint32_t messageLength = 2 * sizeof(uint64_t) + schema.serializedLength();
+
+    sendRequest(response, RequestType::ALTER_TABLE, messageLength, [tableId, schemaVersion, validateOnly, &schema]
+            (crossbow::buffer_writer& message, std::error_code& /* ec */) {
+        message.write<uint64_t>(tableId);
+        message.write<uint32_t>(schemaVersion);
+        message.write<uint32_t>(validateOnly ? 0x1u : 0x0u);
+        schema.serialize(message);
+    });
+
+    return response;
+}
+
+std::shared_ptr<ModificationResponse> ClientSocket::dropTable(crossbow::infinio::Fiber& fiber, uint64_t tableId) {
+    auto response = std::make_shared<ModificationResponse>(fiber);
+
+    uint32_t messageLength = sizeof(uint64_t);
+
+    sendRequest(response, RequestType::DROP_TABLE, messageLength, [tableId]
+            (crossbow::buffer_writer& message, std::error_code& /* ec */) {
+        message.write<uint64_t>(tableId);
+    });
+
+    return response;
+}
+
+std::shared_ptr<ModificationResponse> ClientSocket::truncateTable(crossbow::infinio::Fiber& fiber, uint64_t tableId) {
+    auto response = std::make_shared<ModificationResponse>(fiber);
+
+    uint32_t messageLength = sizeof(uint64_t);
+
+    sendRequest(response, RequestType::TRUNCATE_TABLE, messageLength, [tableId]
+            (crossbow::buffer_writer& message, std::error_code& /* ec */) {
+        message.write<uint64_t>(tableId);
+    });
+
+    return response;
+}
+
 std::shared_ptr<GetTablesResponse> ClientSocket::getTables(crossbow::infinio::Fiber& fiber) {
     auto response = std::make_shared<GetTablesResponse>(fiber);
 
@@ -320,19 +480,20 @@ std::shared_ptr<GetResponse> ClientSocket::get(crossbow::infinio::Fiber& fiber,
 }
 
 std::shared_ptr<ModificationResponse> ClientSocket::insert(crossbow::infinio::Fiber& fiber, uint64_t tableId,
-        uint64_t key, const commitmanager::SnapshotDescriptor& snapshot, const AbstractTuple& tuple) {
+        uint32_t schemaVersion, uint64_t key, const commitmanager::SnapshotDescriptor& snapshot,
+        const AbstractTuple& tuple) {
     auto response = std::make_shared<ModificationResponse>(fiber);
 
     auto tupleLength = tuple.size();
     LOG_ASSERT(tupleLength % 8 == 0, "Data must be 8 byte padded");
 
     uint32_t messageLength = 4 * sizeof(uint64_t) + tupleLength + snapshot.serializedLength();
-    sendRequest(response, RequestType::INSERT, messageLength, [tableId, key, tupleLength, &tuple, &snapshot]
-            (crossbow::buffer_writer& message, std::error_code& /* ec */) {
+    sendRequest(response, RequestType::INSERT, messageLength, [tableId, schemaVersion, key, tupleLength, &tuple,
+            &snapshot] (crossbow::buffer_writer& message, std::error_code& /* ec */) {
         message.write<uint64_t>(tableId);
         message.write<uint64_t>(key);
 
-        message.write<uint32_t>(0x0u);
+        message.write<uint32_t>(schemaVersion);
         message.write<uint32_t>(tupleLength);
         tuple.serialize(message.data());
         message.advance(tupleLength);
@@ -344,19 +505,20 @@ std::shared_ptr<ModificationResponse> ClientSocket::insert(crossbow::infinio::Fi
 }
 
 std::shared_ptr<ModificationResponse> ClientSocket::update(crossbow::infinio::Fiber& fiber, uint64_t tableId,
-        uint64_t key, const commitmanager::SnapshotDescriptor& snapshot, const AbstractTuple& tuple) {
+        uint32_t schemaVersion, uint64_t key, const commitmanager::SnapshotDescriptor& snapshot,
+        const AbstractTuple& tuple) {
     auto response = std::make_shared<ModificationResponse>(fiber);
 
     auto tupleLength = tuple.size();
     LOG_ASSERT(tupleLength % 8 == 0, "Data must be 8 byte padded");
 
     uint32_t messageLength = 4 * sizeof(uint64_t) + tupleLength + snapshot.serializedLength();
-    sendRequest(response, RequestType::UPDATE, messageLength, [tableId, key, tupleLength, &tuple, &snapshot]
-            (crossbow::buffer_writer& message, std::error_code& /* ec */) {
+    sendRequest(response, RequestType::UPDATE, messageLength, [tableId, schemaVersion, key, tupleLength, &tuple,
+            &snapshot] (crossbow::buffer_writer& message, std::error_code& /* ec */) {
         message.write<uint64_t>(tableId);
         message.write<uint64_t>(key);
 
-        message.write<uint32_t>(0x0u);
+        message.write<uint32_t>(schemaVersion);
         message.write<uint32_t>(tupleLength);
         tuple.serialize(message.data());
         message.advance(tupleLength);
@@ -399,6 +561,84 @@ std::shared_ptr<ModificationResponse> ClientSocket::revert(crossbow::infinio::Fi
     return response;
 }
 
+std::shared_ptr<BatchResponse> ClientSocket::batch(crossbow::infinio::Fiber& fiber,
+        const BatchOperations& operations, const commitmanager::SnapshotDescriptor& snapshot) {
+    auto response = std::make_shared<BatchResponse>(fiber, operations.count());
+
+    auto& data = operations.data();
+    uint32_t messageLength = 2 * sizeof(uint64_t) + data.size() + snapshot.serializedLength();
+
+    sendRequest(response, RequestType::BATCH, messageLength, [&operations, &data, &snapshot]
+            (crossbow::buffer_writer& message, std::error_code& /* ec */) {
+        message.write<uint32_t>(operations.count());
+        message.write<uint32_t>(0x0u);
+        message.write(data.data(), data.size());
+
+        writeSnapshot(message, snapshot);
+    });
+
+    return response;
+}
+
+std::shared_ptr<WatermarkResponse> ClientSocket::watermark(crossbow::infinio::Fiber& fiber,
+        const std::vector<uint64_t>& tableIds) {
+    auto response = std::make_shared<WatermarkResponse>(fiber, tableIds.size());
+
+    uint32_t messageLength = sizeof(uint64_t) + tableIds.size() * sizeof(uint64_t);
+    sendRequest(response, RequestType::WATERMARK, messageLength, [&tableIds]
+            (crossbow::buffer_writer& message, std::error_code& /* ec */) {
+        message.write<uint32_t>(tableIds.size());
+        message.write<uint32_t>(0x0u);
+        for (auto tableId : tableIds) {
+            message.write<uint64_t>(tableId);
+        }
+    });
+
+    return response;
+}
+
+std::shared_ptr<StatsResponse> ClientSocket::stats(crossbow::infinio::Fiber& fiber) {
+    auto response = std::make_shared<StatsResponse>(fiber);
+
+    sendRequest(response, RequestType::STATS, 0, []
+            (crossbow::buffer_writer& /* message */, std::error_code& /* ec */) {
+    });
+
+    return response;
+}
+
+std::shared_ptr<MemoryUsageResponse> ClientSocket::memoryUsage(crossbow::infinio::Fiber& fiber) {
+    auto response = std::make_shared<MemoryUsageResponse>(fiber);
+
+    sendRequest(response, RequestType::MEMORY_USAGE, 0, []
+            (crossbow::buffer_writer& /* message */, std::error_code& /* ec */) {
+    });
+
+    return response;
+}
+
+std::shared_ptr<ExportTableResponse> ClientSocket::exportTable(crossbow::infinio::Fiber& fiber, uint64_t tableId,
+        const crossbow::string& fileName, const commitmanager::SnapshotDescriptor& snapshot) {
+    auto response = std::make_shared<ExportTableResponse>(fiber);
+
+    auto nameLength = fileName.size();
+    uint32_t messageLength = sizeof(uint64_t) + sizeof(uint32_t) + nameLength;
+    messageLength = crossbow::align(messageLength, sizeof(uint64_t));
+    messageLength += sizeof(uint64_t) + snapshot.serializedLength();
+
+    sendRequest(response, RequestType::EXPORT_TABLE, messageLength, [tableId, nameLength, &fileName, &snapshot]
+            (crossbow::buffer_writer& message, std::error_code& /* ec */) {
+        message.write<uint64_t>(tableId);
+        message.write<uint32_t>(nameLength);
+        message.write(fileName.data(), nameLength);
+
+        message.align(sizeof(uint64_t));
+        writeSnapshot(message, snapshot);
+    });
+
+    return response;
+}
+
 void ClientSocket::scanStart(uint16_t scanId, std::shared_ptr<ScanResponse> response, uint64_t tableId,
         ScanQueryType queryType, uint32_t selectionLength, const char* selection, uint32_t queryLength,
         const char* query, const commitmanager::SnapshotDescriptor& snapshot) {
@@ -0,0 +1,115 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <tellstore/FiberPool.hpp>
+
+#include <crossbow/logger.hpp>
+
+#include <algorithm>
+
+namespace tell {
+namespace store {
+
+FiberPool::FiberPool(crossbow::infinio::InfinibandProcessor& processor, size_t initialSize, size_t maxSize)
+        : mProcessor(processor),
+          mMaxSize(std::max(initialSize, maxSize)),
+          mShutdown(false),
+          mSize(0u),
+          mHits(0u),
+          mMisses(0u),
+          mWaits(0u) {
+    mIdle.reserve(mMaxSize);
+
+    mProcessor.execute([this, initialSize] () {
+        for (decltype(initialSize) i = 0; i < initialSize; ++i) {
+            spawn();
+        }
+    });
+}
+
+void FiberPool::execute(Function fun) {
+    LOG_ASSERT(!mShutdown, "Executing function on shut down pool");
+
+    if (!mIdle.empty()) {
+        ++mHits;
+        auto worker = mIdle.back();
+        mIdle.pop_back();
+        worker->fun = std::move(fun);
+        worker->fiber.resume();
+        return;
+    }
+
+    mQueue.emplace_back(std::move(fun));
+    if (mSize.load() < mMaxSize) {
+        ++mMisses;
+        spawn();
+    } else {
+        ++mWaits;
+    }
+}
+
+void FiberPool::shutdown() {
+    mProcessor.execute([this] () {
+        mShutdown = true;
+
+        auto idle = std::move(mIdle);
+        mIdle.clear();
+        for (auto worker : idle) {
+            worker->fiber.resume();
+        }
+    });
+}
+
+void FiberPool::spawn() {
+    ++mSize;
+    mProcessor.executeFiber([this] (crossbow::infinio::Fiber& fiber) {
+        run(fiber);
+    });
+}
+
+void FiberPool::run(crossbow::infinio::Fiber& fiber) {
+    Worker worker(fiber);
+    while (true) {
+        if (!mQueue.empty()) {
+            worker.fun = std::move(mQueue.front());
+            mQueue.pop_front();
+        } else if (!mShutdown) {
+            // Park the fiber until a new function is handed to it or the pool is shut down
+            mIdle.emplace_back(&worker);
+            fiber.wait();
+        }
+
+        if (!worker.fun) {
+            if (mShutdown) {
+                break;
+            }
+            continue;
+        }
+
+        worker.fun(fiber);
+        worker.fun = nullptr;
+    }
+    --mSize;
+}
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,78 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include <tellstore/ReadCache.hpp>
+
+namespace tell {
+namespace store {
+
+bool ReadCache::isCached(const Table& table) {
+    if (mCapacity == 0u) {
+        return false;
+    }
+
+    auto i = mTables.find(table.tableId());
+    if (i == mTables.end()) {
+        auto cached = (mTableNames.find(table.tableName()) != mTableNames.end());
+        i = mTables.emplace(table.tableId(), cached).first;
+    }
+    return i->second;
+}
+
+const ReadCache::Entry* ReadCache::lookup(uint64_t tableId, uint64_t key) {
+    auto i = mEntries.find(std::make_pair(tableId, key));
+    if (i == mEntries.end()) {
+        return nullptr;
+    }
+    mLru.splice(mLru.begin(), mLru, i->second);
+    return &i->second->second;
+}
+
+void ReadCache::insert(uint64_t tableId, uint64_t key, std::shared_ptr<const Tuple> tuple, uint64_t watermark) {
+    auto entryKey = std::make_pair(tableId, key);
+    auto i = mEntries.find(entryKey);
+    if (i != mEntries.end()) {
+        i->second->second = Entry(std::move(tuple), watermark);
+        mLru.splice(mLru.begin(), mLru, i->second);
+        return;
+    }
+
+    if (mEntries.size() >= mCapacity) {
+        mEntries.erase(mLru.back().first);
+        mLru.pop_back();
+    }
+    mLru.emplace_front(entryKey, Entry(std::move(tuple), watermark));
+    mEntries.emplace(entryKey, mLru.begin());
+}
+
+void ReadCache::invalidate(uint64_t tableId, uint64_t key) {
+    auto i = mEntries.find(std::make_pair(tableId, key));
+    if (i == mEntries.end()) {
+        return;
+    }
+    mLru.erase(i->second);
+    mEntries.erase(i);
+}
+
+} // namespace store
+} // namespace tell
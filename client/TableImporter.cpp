@@ -0,0 +1,137 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <tellstore/TableImporter.hpp>
+
+#include <tellstore/ClientManager.hpp>
+
+#include <crossbow/logger.hpp>
+
+#include <system_error>
+#include <vector>
+
+namespace tell {
+namespace store {
+namespace {
+
+/**
+ * @brief Size of the header preceding every operation in a batch request
+ */
+constexpr size_t BATCH_OPERATION_HEADER = 3 * sizeof(uint64_t);
+
+} // anonymous namespace
+
+constexpr size_t TableImporter::DEFAULT_BATCH_BYTES;
+
+TableImporter::TableImporter(const ImportSource& source, const Table& table, size_t batchBytes)
+        : mSource(source),
+          mTable(table),
+          mBatchBytes(batchBytes),
+          mRowCount(0u) {
+}
+
+uint64_t TableImporter::importChunk(ClientHandle& handle, size_t idx) {
+    auto cursor = mSource.chunk(idx);
+    auto snapshot = handle.startTransaction();
+    auto batch = handle.startBatch(*snapshot);
+
+    std::vector<ClientBatch::Future> futures;
+    std::vector<uint64_t> pendingKeys;
+    std::vector<uint64_t> insertedKeys;
+    size_t batchSize = 0u;
+
+    // Waits for all operations in the current batch and returns the first error (the keys of the succeeded operations
+    // are appended to the given vector)
+    auto collect = [&batch, &futures, &pendingKeys, &batchSize] (std::vector<uint64_t>& succeeded) {
+        std::error_code ec;
+        if (futures.empty()) {
+            return ec;
+        }
+        batch->send();
+        for (size_t i = 0u; i < futures.size(); ++i) {
+            if (futures[i].waitForResult()) {
+                succeeded.emplace_back(pendingKeys[i]);
+            } else if (!ec) {
+                ec = futures[i].error();
+            }
+        }
+        batch->reset();
+        futures.clear();
+        pendingKeys.clear();
+        batchSize = 0u;
+        return ec;
+    };
+
+    try {
+        uint64_t key;
+        const char* data;
+        size_t size;
+        while (cursor->next(key, data, size)) {
+            if (batchSize != 0u && batchSize + BATCH_OPERATION_HEADER + size > mBatchBytes) {
+                auto ec = collect(insertedKeys);
+                if (ec) {
+                    throw std::system_error(ec);
+                }
+            }
+
+            futures.emplace_back(batch->insert(mTable, key, SerializedTuple(data, size)));
+            pendingKeys.emplace_back(key);
+            batchSize += BATCH_OPERATION_HEADER + size;
+        }
+        auto ec = collect(insertedKeys);
+        if (ec) {
+            throw std::system_error(ec);
+        }
+    } catch (...) {
+        // Inserts still in flight have to complete before it is known which of them have to be reverted
+        collect(insertedKeys);
+
+        // Revert the rows inserted so far so the transaction leaves no partial chunk behind and the chunk can be
+        // imported again from the start
+        std::vector<uint64_t> revertedKeys;
+        for (auto key : insertedKeys) {
+            if (batchSize != 0u && batchSize + BATCH_OPERATION_HEADER > mBatchBytes) {
+                collect(revertedKeys);
+            }
+            futures.emplace_back(batch->revert(mTable, key));
+            pendingKeys.emplace_back(key);
+            batchSize += BATCH_OPERATION_HEADER;
+        }
+        collect(revertedKeys);
+        if (revertedKeys.size() != insertedKeys.size()) {
+            LOG_ERROR("Unable to revert %1% of %2% rows imported from chunk %3%",
+                    insertedKeys.size() - revertedKeys.size(), insertedKeys.size(), idx);
+        }
+
+        handle.commit(*snapshot);
+        throw;
+    }
+    handle.commit(*snapshot);
+
+    auto rowCount = static_cast<uint64_t>(insertedKeys.size());
+    LOG_DEBUG("Imported %1% rows from chunk %2%", rowCount, idx);
+    mRowCount += rowCount;
+    return rowCount;
+}
+
+} // namespace store
+} // namespace tell
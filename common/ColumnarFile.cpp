@@ -0,0 +1,395 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <tellstore/ColumnarFile.hpp>
+
+#include <crossbow/alignment.hpp>
+#include <crossbow/byte_buffer.hpp>
+#include <crossbow/logger.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace tell {
+namespace store {
+namespace {
+
+const uint64_t gFileMagic = 0x314c4f434c4c4554ull; // "TELLCOL1"
+
+template <typename T, typename Wide>
+void updateValue(char* min, char* max, const char* data, bool first) {
+    Wide value = static_cast<Wide>(*reinterpret_cast<const T*>(data));
+    if (first || value < *reinterpret_cast<const Wide*>(min)) {
+        memcpy(min, &value, sizeof(Wide));
+    }
+    if (first || value > *reinterpret_cast<const Wide*>(max)) {
+        memcpy(max, &value, sizeof(Wide));
+    }
+}
+
+size_t alignedLength(size_t length) {
+    return crossbow::align(length, sizeof(uint64_t));
+}
+
+} // anonymous namespace
+
+constexpr uint32_t ColumnChunkHeader::HAS_NULLS;
+constexpr uint32_t ColumnChunkHeader::HAS_MIN_MAX;
+
+ColumnarRowGroupBuilder::ColumnarRowGroupBuilder(const Record& record)
+        : mRecord(record),
+          mColumns(record.fieldCount()) {
+    for (Record::id_t id = 0u; id < mColumns.size(); ++id) {
+        if (!mRecord.getFieldMeta(id).field.isFixedSized()) {
+            mColumns[id].offsets.emplace_back(0u);
+        }
+    }
+}
+
+void ColumnarRowGroupBuilder::add(uint64_t key, const char* tuple) {
+    mKeys.emplace_back(key);
+
+    for (Record::id_t id = 0u; id < mColumns.size(); ++id) {
+        auto& column = mColumns[id];
+        auto& field = mRecord.getFieldMeta(id).field;
+
+        auto isNull = false;
+        auto data = mRecord.data(tuple, id, isNull);
+        if (!field.isNotNull()) {
+            column.nulls.emplace_back(isNull ? 1 : 0);
+            column.hasNulls |= isNull;
+        }
+
+        if (field.isFixedSized()) {
+            column.values.insert(column.values.end(), data, data + field.staticSize());
+            if (!isNull) {
+                updateMinMax(column, field.type(), data);
+            }
+        } else {
+            auto begin = reinterpret_cast<const uint32_t*>(data)[0];
+            auto end = reinterpret_cast<const uint32_t*>(data)[1];
+            column.values.insert(column.values.end(), tuple + begin, tuple + end);
+            column.offsets.emplace_back(static_cast<uint32_t>(column.values.size()));
+        }
+    }
+}
+
+void ColumnarRowGroupBuilder::serialize(std::vector<char>& buffer) const {
+    auto rowCount = mKeys.size();
+
+    size_t length = sizeof(uint64_t) + rowCount * sizeof(uint64_t);
+    for (Record::id_t id = 0u; id < mColumns.size(); ++id) {
+        auto& column = mColumns[id];
+        length += sizeof(ColumnChunkHeader) + alignedLength(column.nulls.size()) + alignedLength(column.values.size())
+                + alignedLength(column.offsets.size() * sizeof(uint32_t));
+    }
+
+    // Zero the buffer so the padding is deterministic
+    buffer.assign(length, 0);
+    crossbow::buffer_writer writer(buffer.data(), buffer.size());
+    writer.write<uint64_t>(rowCount);
+    writer.write(reinterpret_cast<const char*>(mKeys.data()), rowCount * sizeof(uint64_t));
+
+    for (Record::id_t id = 0u; id < mColumns.size(); ++id) {
+        auto& column = mColumns[id];
+        auto chunkLength = alignedLength(column.nulls.size()) + alignedLength(column.values.size())
+                + alignedLength(column.offsets.size() * sizeof(uint32_t));
+
+        ColumnChunkHeader header;
+        memset(&header, 0, sizeof(header));
+        header.encoding = static_cast<uint32_t>(ColumnEncoding::PLAIN);
+        header.flags = (column.hasNulls ? ColumnChunkHeader::HAS_NULLS : 0u)
+                | (column.hasMinMax ? ColumnChunkHeader::HAS_MIN_MAX : 0u);
+        header.length = chunkLength;
+        if (column.hasMinMax) {
+            memcpy(header.min, column.min, sizeof(header.min));
+            memcpy(header.max, column.max, sizeof(header.max));
+        }
+        writer.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        writer.write(column.nulls.data(), column.nulls.size());
+        writer.align(sizeof(uint64_t));
+        if (!column.offsets.empty()) {
+            writer.write(reinterpret_cast<const char*>(column.offsets.data()),
+                    column.offsets.size() * sizeof(uint32_t));
+            writer.align(sizeof(uint64_t));
+        }
+        writer.write(column.values.data(), column.values.size());
+        writer.align(sizeof(uint64_t));
+    }
+    LOG_ASSERT(writer.data() == buffer.data() + buffer.size(), "Row group length does not match");
+}
+
+void ColumnarRowGroupBuilder::clear() {
+    mKeys.clear();
+    for (Record::id_t id = 0u; id < mColumns.size(); ++id) {
+        auto& column = mColumns[id];
+        column.nulls.clear();
+        column.values.clear();
+        if (!column.offsets.empty()) {
+            column.offsets.resize(1u);
+        }
+        column.hasNulls = false;
+        column.hasMinMax = false;
+    }
+}
+
+void ColumnarRowGroupBuilder::updateMinMax(Column& column, FieldType type, const char* data) {
+    auto first = !column.hasMinMax;
+    switch (type) {
+    case FieldType::SMALLINT: {
+        updateValue<int16_t, int64_t>(column.min, column.max, data, first);
+    } break;
+
+    case FieldType::INT: {
+        updateValue<int32_t, int64_t>(column.min, column.max, data, first);
+    } break;
+
+    case FieldType::BIGINT: {
+        updateValue<int64_t, int64_t>(column.min, column.max, data, first);
+    } break;
+
+    case FieldType::FLOAT: {
+        updateValue<float, double>(column.min, column.max, data, first);
+    } break;
+
+    case FieldType::DOUBLE: {
+        updateValue<double, double>(column.min, column.max, data, first);
+    } break;
+
+    default: {
+        return;
+    }
+    }
+    column.hasMinMax = true;
+}
+
+ColumnarFileWriter::ColumnarFileWriter(const crossbow::string& path, Schema schema)
+        : mFd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)),
+          mSchema(std::move(schema)),
+          mOffset(sizeof(uint64_t)),
+          mRowCount(0u) {
+    if (mFd < 0) {
+        throw std::system_error(errno, std::system_category(), "Unable to create columnar file");
+    }
+    write(reinterpret_cast<const char*>(&gFileMagic), sizeof(gFileMagic), 0u);
+}
+
+ColumnarFileWriter::~ColumnarFileWriter() {
+    if (mFd >= 0) {
+        ::close(mFd);
+    }
+}
+
+void ColumnarFileWriter::append(const std::vector<char>& rowGroup, uint64_t rowCount) {
+    uint64_t offset;
+    {
+        std::lock_guard<std::mutex> _(mMutex);
+        offset = mOffset;
+        mOffset += rowGroup.size();
+        mRowCount += rowCount;
+        mRowGroups.emplace_back(RowGroupInfo{offset, rowGroup.size(), rowCount});
+    }
+    write(rowGroup.data(), rowGroup.size(), offset);
+}
+
+uint64_t ColumnarFileWriter::close() {
+    std::lock_guard<std::mutex> _(mMutex);
+
+    auto schemaLength = alignedLength(mSchema.serializedLength());
+    auto footerLength = schemaLength + sizeof(uint64_t) + mRowGroups.size() * sizeof(RowGroupInfo);
+
+    std::vector<char> footer(footerLength + 2 * sizeof(uint64_t), 0);
+    crossbow::buffer_writer writer(footer.data(), footer.size());
+    mSchema.serialize(writer);
+    writer.align(sizeof(uint64_t));
+    writer.write<uint64_t>(mRowGroups.size());
+    writer.write(reinterpret_cast<const char*>(mRowGroups.data()), mRowGroups.size() * sizeof(RowGroupInfo));
+    writer.write<uint64_t>(footerLength);
+    writer.write<uint64_t>(gFileMagic);
+    write(footer.data(), footer.size(), mOffset);
+
+    if (::fsync(mFd) != 0 || ::close(mFd) != 0) {
+        mFd = -1;
+        throw std::system_error(errno, std::system_category(), "Unable to close columnar file");
+    }
+    mFd = -1;
+    return mRowCount;
+}
+
+void ColumnarFileWriter::write(const char* data, size_t length, uint64_t offset) {
+    while (length > 0) {
+        auto res = ::pwrite(mFd, data, length, static_cast<off_t>(offset));
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::system_category(), "Unable to write columnar file");
+        }
+        data += res;
+        length -= static_cast<size_t>(res);
+        offset += static_cast<uint64_t>(res);
+    }
+}
+
+ColumnarRowGroup::ColumnarRowGroup(const Record& record, const char* data, size_t length)
+        : mRecord(&record),
+          mColumns(record.fieldCount()) {
+    crossbow::buffer_reader reader(data, length);
+    mRowCount = reader.read<uint64_t>();
+    mKeys = reinterpret_cast<const uint64_t*>(reader.read(mRowCount * sizeof(uint64_t)));
+
+    for (Record::id_t id = 0u; id < mColumns.size(); ++id) {
+        auto& column = mColumns[id];
+        auto& field = record.getFieldMeta(id).field;
+
+        column.header = reinterpret_cast<const ColumnChunkHeader*>(reader.read(sizeof(ColumnChunkHeader)));
+        if (column.header->encoding != static_cast<uint32_t>(ColumnEncoding::PLAIN)) {
+            throw std::runtime_error("Unsupported column encoding");
+        }
+        auto chunkEnd = reader.data() + column.header->length;
+
+        column.nulls = (field.isNotNull() ? nullptr : reader.read(mRowCount));
+        reader.align(sizeof(uint64_t));
+        if (field.isFixedSized()) {
+            column.offsets = nullptr;
+            column.values = reader.data();
+            column.heap = nullptr;
+        } else {
+            column.offsets = reinterpret_cast<const uint32_t*>(reader.read((mRowCount + 1) * sizeof(uint32_t)));
+            reader.align(sizeof(uint64_t));
+            column.values = nullptr;
+            column.heap = reader.data();
+        }
+        reader.advance(static_cast<size_t>(chunkEnd - reader.data()));
+    }
+    if (reader.data() != data + length) {
+        throw std::runtime_error("Invalid row group");
+    }
+}
+
+uint32_t ColumnarRowGroup::tupleSize(uint64_t row) const {
+    size_t size = mRecord->staticSize();
+    for (Record::id_t id = 0u; id < mColumns.size(); ++id) {
+        auto& column = mColumns[id];
+        if (column.offsets) {
+            size += column.offsets[row + 1] - column.offsets[row];
+        }
+    }
+    return static_cast<uint32_t>(crossbow::align(size, 8u));
+}
+
+void ColumnarRowGroup::materialize(uint64_t row, char* dest) const {
+    auto size = tupleSize(row);
+    memset(dest, 0, mRecord->staticSize());
+
+    auto heapOffset = mRecord->staticSize();
+    for (Record::id_t id = 0u; id < mColumns.size(); ++id) {
+        auto& column = mColumns[id];
+        auto& meta = mRecord->getFieldMeta(id);
+        if (column.nulls) {
+            mRecord->setFieldNull(dest, meta.nullIdx, column.nulls[row] != 0);
+        }
+
+        if (!column.offsets) {
+            auto fieldSize = meta.field.staticSize();
+            memcpy(dest + meta.offset, column.values + row * fieldSize, fieldSize);
+            continue;
+        }
+
+        auto begin = column.offsets[row];
+        auto end = column.offsets[row + 1];
+        *reinterpret_cast<uint32_t*>(dest + meta.offset) = heapOffset;
+        memcpy(dest + heapOffset, column.heap + begin, end - begin);
+        heapOffset += end - begin;
+    }
+    if (mRecord->varSizeFieldCount() != 0u) {
+        *reinterpret_cast<uint32_t*>(dest + mRecord->staticSize() - sizeof(uint32_t)) = heapOffset;
+    }
+    memset(dest + heapOffset, 0, size - heapOffset);
+}
+
+ColumnarFileReader::ColumnarFileReader(const crossbow::string& path)
+        : mData(nullptr),
+          mLength(0u),
+          mRowCount(0u) {
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Unable to open columnar file");
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        auto err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::system_category(), "Unable to open columnar file");
+    }
+    mLength = static_cast<size_t>(st.st_size);
+    if (mLength < 4 * sizeof(uint64_t)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid columnar file");
+    }
+
+    auto data = ::mmap(nullptr, mLength, PROT_READ, MAP_PRIVATE, fd, 0);
+    auto err = errno;
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        throw std::system_error(err, std::system_category(), "Unable to map columnar file");
+    }
+    mData = reinterpret_cast<const char*>(data);
+
+    // The file is read sequentially by row group
+    ::madvise(data, mLength, MADV_SEQUENTIAL);
+
+    auto trailer = reinterpret_cast<const uint64_t*>(mData + mLength - 2 * sizeof(uint64_t));
+    auto footerLength = trailer[0];
+    if (*reinterpret_cast<const uint64_t*>(mData) != gFileMagic || trailer[1] != gFileMagic
+            || footerLength > mLength - 3 * sizeof(uint64_t)) {
+        ::munmap(data, mLength);
+        throw std::runtime_error("Invalid columnar file");
+    }
+
+    crossbow::buffer_reader reader(mData + mLength - 2 * sizeof(uint64_t) - footerLength, footerLength);
+    mRecord = Record(Schema::deserialize(reader));
+    reader.align(sizeof(uint64_t));
+
+    auto rowGroupCount = reader.read<uint64_t>();
+    mRowGroups.resize(rowGroupCount);
+    memcpy(mRowGroups.data(), reader.read(rowGroupCount * sizeof(RowGroupInfo)), rowGroupCount * sizeof(RowGroupInfo));
+    for (auto& info : mRowGroups) {
+        mRowCount += info.rowCount;
+    }
+}
+
+ColumnarFileReader::~ColumnarFileReader() {
+    ::munmap(const_cast<char*>(mData), mLength);
+}
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,653 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <tellstore/ImportSource.hpp>
+
+#include <crossbow/alignment.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+namespace tell {
+namespace store {
+namespace {
+
+/**
+ * @brief Position of the first delimiter or line end in the range (or the end of the range)
+ */
+const char* findSeparator(const char* pos, const char* end, char delimiter) {
+#ifdef __SSE2__
+    auto delimiterMask = _mm_set1_epi8(delimiter);
+    auto newlineMask = _mm_set1_epi8('\n');
+    for (; pos + sizeof(__m128i) <= end; pos += sizeof(__m128i)) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        auto match = _mm_or_si128(_mm_cmpeq_epi8(block, delimiterMask), _mm_cmpeq_epi8(block, newlineMask));
+        auto mask = _mm_movemask_epi8(match);
+        if (mask != 0) {
+            return pos + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+#endif
+    while (pos != end && *pos != delimiter && *pos != '\n') {
+        ++pos;
+    }
+    return pos;
+}
+
+/**
+ * @brief Parses a decimal integer and checks it against the range
+ */
+bool parseInteger(const char* begin, const char* end, int64_t min, int64_t max, int64_t& value) {
+    auto negative = (begin != end && *begin == '-');
+    if (negative || (begin != end && *begin == '+')) {
+        ++begin;
+    }
+    if (begin == end) {
+        return false;
+    }
+
+    uint64_t result = 0u;
+    for (; begin != end; ++begin) {
+        auto digit = static_cast<uint64_t>(*begin - '0');
+        if (digit > 9u || result > (std::numeric_limits<uint64_t>::max() - digit) / 10u) {
+            return false;
+        }
+        result = result * 10u + digit;
+    }
+
+    if (negative) {
+        if (result > static_cast<uint64_t>(max) + 1u) {
+            return false;
+        }
+        value = static_cast<int64_t>(0u - result);
+    } else {
+        if (result > static_cast<uint64_t>(max)) {
+            return false;
+        }
+        value = static_cast<int64_t>(result);
+    }
+    return (value >= min);
+}
+
+bool parseKey(const char* begin, const char* end, uint64_t& key) {
+    if (begin == end) {
+        return false;
+    }
+
+    key = 0u;
+    for (; begin != end; ++begin) {
+        auto digit = static_cast<uint64_t>(*begin - '0');
+        if (digit > 9u || key > (std::numeric_limits<uint64_t>::max() - digit) / 10u) {
+            return false;
+        }
+        key = key * 10u + digit;
+    }
+    return true;
+}
+
+bool parseDouble(const char* begin, const char* end, double& value) {
+    // strtod requires a terminated string
+    char buffer[64];
+    auto length = static_cast<size_t>(end - begin);
+    if (length == 0u || length >= sizeof(buffer)) {
+        return false;
+    }
+    memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+
+    char* parsed;
+    value = std::strtod(buffer, &parsed);
+    return (parsed == buffer + length);
+}
+
+std::invalid_argument invalidRow(const char* what) {
+    return std::invalid_argument(std::string("Invalid CSV row: ") + what);
+}
+
+} // anonymous namespace
+
+MappedFile::MappedFile(const crossbow::string& path)
+        : mData(nullptr),
+          mSize(0u) {
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Unable to open import file");
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        auto err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::system_category(), "Unable to open import file");
+    }
+    mSize = static_cast<size_t>(st.st_size);
+    if (mSize == 0u) {
+        ::close(fd);
+        return;
+    }
+
+    auto data = ::mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    auto err = errno;
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        throw std::system_error(err, std::system_category(), "Unable to map import file");
+    }
+    ::madvise(data, mSize, MADV_SEQUENTIAL);
+    mData = reinterpret_cast<const char*>(data);
+}
+
+MappedFile::~MappedFile() {
+    if (mData) {
+        ::munmap(const_cast<char*>(mData), mSize);
+    }
+}
+
+ImportCursor::~ImportCursor() = default;
+
+std::unique_ptr<ImportSource> ImportSource::open(const crossbow::string& path, const Record& record,
+        const ImportConfig& config, size_t chunkCount) {
+    switch (config.format) {
+    case ImportFormat::CSV: {
+        return std::unique_ptr<ImportSource>(new CsvImportSource(path, record, config, chunkCount));
+    } break;
+
+    case ImportFormat::BINARY: {
+        return std::unique_ptr<ImportSource>(new BinaryImportSource(path, record, chunkCount));
+    } break;
+
+    case ImportFormat::COLUMNAR: {
+        return std::unique_ptr<ImportSource>(new ColumnarImportSource(path, record));
+    } break;
+
+    default: {
+        throw std::invalid_argument("Unknown import format");
+    }
+    }
+}
+
+ImportSource::~ImportSource() = default;
+
+/**
+ * @brief Parses the rows of a CSV chunk field by field directly into the record format
+ */
+class CsvImportSource::Cursor : public ImportCursor {
+public:
+    Cursor(const CsvImportSource& source, const char* begin, const char* end)
+            : mSource(source),
+              mRecord(source.mRecord),
+              mPos(begin),
+              mEnd(end),
+              mFileEnd(source.mFile.data() + source.mFile.size()),
+              mSet(mRecord.fieldCount()),
+              mValues(mRecord.varSizeFieldCount()),
+              mScratch(source.mColumns.size()) {
+    }
+
+    virtual bool next(uint64_t& key, const char*& data, size_t& size) final override;
+
+private:
+    struct Value {
+        const char* data;
+        size_t size;
+    };
+
+    /**
+     * @brief Reads the next field and advances past its delimiter
+     *
+     * @return Whether the field was the last one on the line
+     */
+    bool readField(size_t column, const char*& begin, const char*& end, bool& quoted);
+
+    void setValue(Record::id_t id, const char* begin, const char* end, bool quoted);
+
+    void setNull(Record::id_t id);
+
+    void finishTuple();
+
+    const CsvImportSource& mSource;
+
+    const Record& mRecord;
+
+    const char* mPos;
+
+    const char* mEnd;
+
+    const char* mFileEnd;
+
+    /// Tuple of the current row
+    std::vector<char> mTuple;
+
+    /// Marker for every field if it was set in the current row
+    std::vector<char> mSet;
+
+    /// Values of the variable sized fields of the current row
+    std::vector<Value> mValues;
+
+    /// Unescaped values of quoted fields containing escaped quotes (one per column)
+    std::vector<std::string> mScratch;
+};
+
+bool CsvImportSource::Cursor::next(uint64_t& key, const char*& data, size_t& size) {
+    // Skip empty lines
+    while (mPos != mEnd && (*mPos == '\n' || (*mPos == '\r' && mPos + 1 != mFileEnd && mPos[1] == '\n'))) {
+        mPos += (*mPos == '\n' ? 1 : 2);
+    }
+    if (mPos >= mEnd) {
+        return false;
+    }
+
+    mTuple.assign(mRecord.staticSize(), 0);
+    std::fill(mSet.begin(), mSet.end(), 0);
+
+    auto& columns = mSource.mColumns;
+    auto hasKey = false;
+    for (size_t column = 0u; ; ++column) {
+        if (column == columns.size()) {
+            throw invalidRow("Too many columns");
+        }
+
+        const char* begin;
+        const char* end;
+        bool quoted;
+        auto last = readField(column, begin, end, quoted);
+
+        auto target = columns[column];
+        if (target == KEY_COLUMN) {
+            if (!parseKey(begin, end, key)) {
+                throw invalidRow("Invalid key");
+            }
+            hasKey = true;
+        } else if (target != SKIP_COLUMN) {
+            setValue(static_cast<Record::id_t>(target), begin, end, quoted);
+        }
+
+        if (last) {
+            break;
+        }
+    }
+
+    if (!hasKey) {
+        throw invalidRow("Missing key");
+    }
+    for (Record::id_t id = 0u; id < mSet.size(); ++id) {
+        if (!mSet[id]) {
+            setNull(id);
+        }
+    }
+    finishTuple();
+
+    data = mTuple.data();
+    size = mTuple.size();
+    return true;
+}
+
+bool CsvImportSource::Cursor::readField(size_t column, const char*& begin, const char*& end, bool& quoted) {
+    quoted = (mPos != mFileEnd && *mPos == '"');
+    if (!quoted) {
+        begin = mPos;
+        mPos = findSeparator(mPos, mFileEnd, mSource.mDelimiter);
+        end = mPos;
+        if (end != begin && end[-1] == '\r' && (mPos == mFileEnd || *mPos == '\n')) {
+            --end;
+        }
+    } else {
+        // Quoted fields are only copied if they contain escaped quotes
+        auto& scratch = mScratch[column];
+        auto escaped = false;
+        auto pos = ++mPos;
+        while (true) {
+            auto quote = reinterpret_cast<const char*>(memchr(pos, '"', static_cast<size_t>(mFileEnd - pos)));
+            if (!quote) {
+                throw invalidRow("Unterminated quoted field");
+            }
+            if (quote + 1 != mFileEnd && quote[1] == '"') {
+                if (!escaped) {
+                    scratch.assign(mPos, quote + 1);
+                    escaped = true;
+                } else {
+                    scratch.append(pos, quote + 1);
+                }
+                pos = quote + 2;
+                continue;
+            }
+
+            if (escaped) {
+                scratch.append(pos, quote);
+                begin = scratch.data();
+                end = begin + scratch.size();
+            } else {
+                begin = mPos;
+                end = quote;
+            }
+            mPos = quote + 1;
+            break;
+        }
+
+        if (mPos != mFileEnd && *mPos == '\r') {
+            ++mPos;
+        }
+        if (mPos != mFileEnd && *mPos != mSource.mDelimiter && *mPos != '\n') {
+            throw invalidRow("Unexpected character after quoted field");
+        }
+    }
+
+    if (mPos == mFileEnd) {
+        return true;
+    }
+    return (*(mPos++) == '\n');
+}
+
+void CsvImportSource::Cursor::setValue(Record::id_t id, const char* begin, const char* end, bool quoted) {
+    auto& meta = mRecord.getFieldMeta(id);
+    auto& field = meta.field;
+    mSet[id] = 1;
+
+    if (begin == end && !quoted) {
+        setNull(id);
+        return;
+    }
+
+    auto dest = mTuple.data() + meta.offset;
+    int64_t integer;
+    double floating;
+    switch (field.type()) {
+    case FieldType::SMALLINT: {
+        if (!parseInteger(begin, end, std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max(),
+                integer)) {
+            throw invalidRow("Invalid smallint");
+        }
+        *reinterpret_cast<int16_t*>(dest) = static_cast<int16_t>(integer);
+    } break;
+
+    case FieldType::INT: {
+        if (!parseInteger(begin, end, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max(),
+                integer)) {
+            throw invalidRow("Invalid int");
+        }
+        *reinterpret_cast<int32_t*>(dest) = static_cast<int32_t>(integer);
+    } break;
+
+    case FieldType::BIGINT: {
+        if (!parseInteger(begin, end, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(),
+                integer)) {
+            throw invalidRow("Invalid bigint");
+        }
+        *reinterpret_cast<int64_t*>(dest) = integer;
+    } break;
+
+    case FieldType::FLOAT: {
+        if (!parseDouble(begin, end, floating)) {
+            throw invalidRow("Invalid float");
+        }
+        *reinterpret_cast<float*>(dest) = static_cast<float>(floating);
+    } break;
+
+    case FieldType::DOUBLE: {
+        if (!parseDouble(begin, end, floating)) {
+            throw invalidRow("Invalid double");
+        }
+        *reinterpret_cast<double*>(dest) = floating;
+    } break;
+
+    case FieldType::TEXT:
+    case FieldType::BLOB: {
+        mValues[id - mRecord.fixedSizeFieldCount()] = Value{begin, static_cast<size_t>(end - begin)};
+    } break;
+
+    default: {
+        throw invalidRow("Unsupported field type");
+    }
+    }
+}
+
+void CsvImportSource::Cursor::setNull(Record::id_t id) {
+    auto& meta = mRecord.getFieldMeta(id);
+    if (meta.field.isNotNull()) {
+        throw invalidRow("Missing value for NOT NULL field");
+    }
+    mRecord.setFieldNull(mTuple.data(), meta.nullIdx, true);
+    if (!meta.field.isFixedSized()) {
+        mValues[id - mRecord.fixedSizeFieldCount()] = Value{nullptr, 0u};
+    }
+}
+
+void CsvImportSource::Cursor::finishTuple() {
+    if (mValues.empty()) {
+        mTuple.resize(crossbow::align(mTuple.size(), 8u));
+        return;
+    }
+
+    size_t heapSize = 0u;
+    for (auto& value : mValues) {
+        heapSize += value.size;
+    }
+    auto staticSize = mRecord.staticSize();
+    mTuple.resize(crossbow::align(staticSize + heapSize, 8u));
+
+    auto offsets = reinterpret_cast<uint32_t*>(mTuple.data() + mRecord.variableOffset());
+    auto heapOffset = staticSize;
+    for (auto& value : mValues) {
+        *(offsets++) = heapOffset;
+        if (value.size != 0u) {
+            memcpy(mTuple.data() + heapOffset, value.data, value.size);
+        }
+        heapOffset += value.size;
+    }
+    *offsets = heapOffset;
+}
+
+constexpr int32_t CsvImportSource::SKIP_COLUMN;
+constexpr int32_t CsvImportSource::KEY_COLUMN;
+
+CsvImportSource::CsvImportSource(const crossbow::string& path, const Record& record, const ImportConfig& config,
+        size_t chunkCount)
+        : mRecord(record),
+          mFile(path),
+          mDelimiter(config.delimiter),
+          mBegin(mFile.data()),
+          mChunkCount(std::max(chunkCount, size_t(1u))) {
+    if (mDelimiter == '\n' || mDelimiter == '"') {
+        throw std::invalid_argument("Invalid CSV delimiter");
+    }
+
+    if (!config.header) {
+        mColumns.emplace_back(KEY_COLUMN);
+        for (Record::id_t id = 0u; id < mRecord.fieldCount(); ++id) {
+            mColumns.emplace_back(static_cast<int32_t>(id));
+        }
+        return;
+    }
+
+    // Map the columns named in the header to the fields of the record
+    auto end = mFile.data() + mFile.size();
+    auto hasKey = false;
+    std::vector<char> mapped(mRecord.fieldCount(), 0);
+    for (auto pos = mFile.data(); pos != end; ) {
+        auto next = findSeparator(pos, end, mDelimiter);
+        auto nameEnd = next;
+        if (nameEnd != pos && nameEnd[-1] == '\r') {
+            --nameEnd;
+        }
+        if (nameEnd - pos >= 2 && *pos == '"' && nameEnd[-1] == '"') {
+            ++pos;
+            --nameEnd;
+        }
+        crossbow::string name(pos, static_cast<size_t>(nameEnd - pos));
+
+        Record::id_t id;
+        if (name == config.keyColumn) {
+            mColumns.emplace_back(KEY_COLUMN);
+            hasKey = true;
+        } else if (mRecord.idOf(name, id) && !mapped[id]) {
+            mColumns.emplace_back(static_cast<int32_t>(id));
+            mapped[id] = 1;
+        } else {
+            mColumns.emplace_back(SKIP_COLUMN);
+        }
+
+        pos = (next == end ? end : next + 1);
+        if (next == end || *next == '\n') {
+            mBegin = pos;
+            break;
+        }
+    }
+
+    if (!hasKey) {
+        throw std::invalid_argument("CSV header does not contain the key column");
+    }
+    for (Record::id_t id = 0u; id < mRecord.fieldCount(); ++id) {
+        if (!mapped[id] && mRecord.getFieldMeta(id).field.isNotNull()) {
+            throw std::invalid_argument("CSV header does not contain all NOT NULL fields");
+        }
+    }
+}
+
+std::unique_ptr<ImportCursor> CsvImportSource::chunk(size_t idx) const {
+    auto begin = lineStart(idx * mFile.size() / mChunkCount);
+    auto end = lineStart((idx + 1) * mFile.size() / mChunkCount);
+    return std::unique_ptr<ImportCursor>(new Cursor(*this, begin, end));
+}
+
+const char* CsvImportSource::lineStart(size_t offset) const {
+    auto pos = mFile.data() + offset;
+    auto end = mFile.data() + mFile.size();
+    if (pos <= mBegin) {
+        return mBegin;
+    }
+    if (pos == end || pos[-1] == '\n') {
+        return pos;
+    }
+    auto newline = reinterpret_cast<const char*>(memchr(pos, '\n', static_cast<size_t>(end - pos)));
+    return (newline ? newline + 1 : end);
+}
+
+/**
+ * @brief Passes on the rows of the file without copying
+ */
+class BinaryImportSource::Cursor : public ImportCursor {
+public:
+    Cursor(const char* begin, const char* end, size_t rowSize)
+            : mPos(begin),
+              mEnd(end),
+              mRowSize(rowSize) {
+    }
+
+    virtual bool next(uint64_t& key, const char*& data, size_t& size) final override {
+        if (mPos == mEnd) {
+            return false;
+        }
+        key = *reinterpret_cast<const uint64_t*>(mPos);
+        data = mPos + sizeof(uint64_t);
+        size = mRowSize - sizeof(uint64_t);
+        mPos += mRowSize;
+        return true;
+    }
+
+private:
+    const char* mPos;
+    const char* mEnd;
+    size_t mRowSize;
+};
+
+BinaryImportSource::BinaryImportSource(const crossbow::string& path, const Record& record, size_t chunkCount)
+        : mFile(path),
+          mRowSize(sizeof(uint64_t) + crossbow::align(record.staticSize(), 8u)),
+          mRowCount(mFile.size() / mRowSize),
+          mChunkCount(std::max(chunkCount, size_t(1u))) {
+    if (record.varSizeFieldCount() != 0u) {
+        throw std::invalid_argument("Binary import does not support variable sized fields");
+    }
+    if (mFile.size() % mRowSize != 0u) {
+        throw std::invalid_argument("Binary import file size is not a multiple of the row size");
+    }
+}
+
+std::unique_ptr<ImportCursor> BinaryImportSource::chunk(size_t idx) const {
+    auto begin = mFile.data() + (idx * mRowCount / mChunkCount) * mRowSize;
+    auto end = mFile.data() + ((idx + 1) * mRowCount / mChunkCount) * mRowSize;
+    return std::unique_ptr<ImportCursor>(new Cursor(begin, end, mRowSize));
+}
+
+/**
+ * @brief Materializes the rows of a row group into the record format
+ */
+class ColumnarImportSource::Cursor : public ImportCursor {
+public:
+    Cursor(ColumnarRowGroup rowGroup)
+            : mRowGroup(std::move(rowGroup)),
+              mRow(0u) {
+    }
+
+    virtual bool next(uint64_t& key, const char*& data, size_t& size) final override {
+        if (mRow == mRowGroup.rowCount()) {
+            return false;
+        }
+        size = mRowGroup.tupleSize(mRow);
+        mTuple.resize(size);
+        mRowGroup.materialize(mRow, mTuple.data());
+
+        key = mRowGroup.key(mRow);
+        data = mTuple.data();
+        ++mRow;
+        return true;
+    }
+
+private:
+    ColumnarRowGroup mRowGroup;
+    uint64_t mRow;
+    std::vector<char> mTuple;
+};
+
+ColumnarImportSource::ColumnarImportSource(const crossbow::string& path, const Record& record)
+        : mReader(path) {
+    auto& fileRecord = mReader.record();
+    if (fileRecord.fieldCount() != record.fieldCount()) {
+        throw std::invalid_argument("Columnar file does not match the table schema");
+    }
+    for (Record::id_t id = 0u; id < record.fieldCount(); ++id) {
+        auto& fileField = fileRecord.getFieldMeta(id).field;
+        auto& field = record.getFieldMeta(id).field;
+        if (fileField.type() != field.type() || fileField.isNotNull() != field.isNotNull()
+                || fileField.name() != field.name()) {
+            throw std::invalid_argument("Columnar file does not match the table schema");
+        }
+    }
+}
+
+std::unique_ptr<ImportCursor> ColumnarImportSource::chunk(size_t idx) const {
+    return std::unique_ptr<ImportCursor>(new Cursor(mReader.rowGroup(idx)));
+}
+
+} // namespace store
+} // namespace tell
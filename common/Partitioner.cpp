@@ -0,0 +1,210 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include <tellstore/Partitioner.hpp>
+
+#include <crossbow/alignment.hpp>
+#include <crossbow/byte_buffer.hpp>
+#include <crossbow/logger.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace tell {
+namespace store {
+namespace {
+
+/**
+ * @brief Mixes the bits of the value (finalizer of the SplitMix64 generator)
+ */
+uint64_t mixHash(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+uint64_t greatestCommonDivisor(uint64_t a, uint64_t b) {
+    while (b != 0) {
+        auto t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+} // anonymous namespace
+
+PartitionSpec PartitionSpec::deserialize(crossbow::buffer_reader& reader) {
+    reader.align(sizeof(uint32_t));
+    auto type = reader.read<PartitionType>();
+    reader.advance(3);
+    auto virtualNodes = reader.read<uint32_t>();
+    auto numBounds = reader.read<uint32_t>();
+
+    std::vector<uint64_t> bounds;
+    if (numBounds != 0) {
+        reader.align(sizeof(uint64_t));
+        bounds.reserve(numBounds);
+        for (decltype(numBounds) i = 0; i < numBounds; ++i) {
+            bounds.emplace_back(reader.read<uint64_t>());
+        }
+    }
+    return PartitionSpec(type, virtualNodes, std::move(bounds));
+}
+
+size_t PartitionSpec::serializedLength(size_t offset) const {
+    auto res = crossbow::align(offset, sizeof(uint32_t)) + 3 * sizeof(uint32_t);
+    if (!mBounds.empty()) {
+        res = crossbow::align(res, sizeof(uint64_t)) + mBounds.size() * sizeof(uint64_t);
+    }
+    return res - offset;
+}
+
+void PartitionSpec::serialize(crossbow::buffer_writer& writer) const {
+    writer.align(sizeof(uint32_t));
+    writer.write<PartitionType>(mType);
+    writer.set(0, 3);
+    writer.write<uint32_t>(mVirtualNodes);
+    writer.write<uint32_t>(mBounds.size());
+    if (!mBounds.empty()) {
+        writer.align(sizeof(uint64_t));
+        for (auto bound : mBounds) {
+            writer.write<uint64_t>(bound);
+        }
+    }
+}
+
+std::unique_ptr<Partitioner> Partitioner::create(const PartitionSpec& spec, size_t shardCount) {
+    if (shardCount == 0) {
+        throw std::invalid_argument("Partitioner requires at least one shard");
+    }
+
+    switch (spec.type()) {
+    case PartitionType::HASH:
+        return std::unique_ptr<Partitioner>(new HashPartitioner(shardCount));
+
+    case PartitionType::CONSISTENT_HASH:
+        return std::unique_ptr<Partitioner>(new ConsistentHashPartitioner(shardCount, spec.virtualNodes()));
+
+    case PartitionType::RANGE:
+        return std::unique_ptr<Partitioner>(new RangePartitioner(shardCount, spec.bounds()));
+
+    default:
+        throw std::invalid_argument("Unknown partition type");
+    }
+}
+
+Partitioner::~Partitioner() = default;
+
+void Partitioner::shardsOf(uint16_t /* shift */, uint32_t /* modulo */, uint32_t /* number */,
+        std::vector<bool>& shards) const {
+    shards.assign(mShardCount, true);
+}
+
+void HashPartitioner::shardsOf(uint16_t shift, uint32_t modulo, uint32_t number, std::vector<bool>& shards) const {
+    if (modulo == 0u || shift != 0u) {
+        Partitioner::shardsOf(shift, modulo, number, shards);
+        return;
+    }
+
+    // All keys with key % modulo == number satisfy key == number modulo gcd(modulo, shardCount). As the shard count is a
+    // multiple of the gcd the same holds for the shard index key % shardCount.
+    auto divisor = greatestCommonDivisor(modulo, mShardCount);
+    auto remainder = number % divisor;
+    shards.resize(mShardCount);
+    for (decltype(mShardCount) i = 0; i < mShardCount; ++i) {
+        shards[i] = (i % divisor == remainder);
+    }
+}
+
+ConsistentHashPartitioner::ConsistentHashPartitioner(size_t shardCount, uint32_t virtualNodes)
+        : Partitioner(shardCount) {
+    if (virtualNodes == 0u) {
+        throw std::invalid_argument("Consistent hashing requires at least one virtual node per shard");
+    }
+    if (shardCount > std::numeric_limits<uint32_t>::max()) {
+        throw std::invalid_argument("Too many shards");
+    }
+
+    mRing.reserve(shardCount * virtualNodes);
+    for (uint64_t shard = 0; shard < shardCount; ++shard) {
+        for (uint64_t node = 0; node < virtualNodes; ++node) {
+            mRing.emplace_back(mixHash((shard << 32) | node), static_cast<uint32_t>(shard));
+        }
+    }
+    std::sort(mRing.begin(), mRing.end());
+}
+
+size_t ConsistentHashPartitioner::shardOf(uint64_t key) const {
+    auto i = std::lower_bound(mRing.begin(), mRing.end(), std::make_pair(mixHash(key), uint32_t(0u)));
+    if (i == mRing.end()) {
+        i = mRing.begin();
+    }
+    return i->second;
+}
+
+RangePartitioner::RangePartitioner(size_t shardCount, std::vector<uint64_t> bounds)
+        : Partitioner(shardCount),
+          mBounds(std::move(bounds)) {
+    if (mBounds.size() + 1 != shardCount) {
+        throw std::invalid_argument("Number of range bounds does not match the number of shards");
+    }
+    if (!std::is_sorted(mBounds.begin(), mBounds.end())) {
+        throw std::invalid_argument("Range bounds are not in ascending order");
+    }
+}
+
+size_t RangePartitioner::shardOf(uint64_t key) const {
+    return static_cast<size_t>(std::upper_bound(mBounds.begin(), mBounds.end(), key) - mBounds.begin());
+}
+
+void RangePartitioner::shardsOf(uint16_t shift, uint32_t modulo, uint32_t number, std::vector<bool>& shards) const {
+    if (modulo == 0u || shift >= 64u) {
+        Partitioner::shardsOf(shift, modulo, number, shards);
+        return;
+    }
+
+    shards.resize(mShardCount);
+    for (decltype(mShardCount) i = 0; i < mShardCount; ++i) {
+        auto lower = (i == 0 ? 0u : mBounds[i - 1]);
+        auto upper = (i == mBounds.size() ? std::numeric_limits<uint64_t>::max() : mBounds[i]);
+        if (i != mBounds.size()) {
+            if (lower == upper) {
+                // The range is empty
+                shards[i] = false;
+                continue;
+            }
+            --upper;
+        }
+
+        // Check if the range contains a key whose partition value (key >> shift) is congruent to number
+        auto lowerValue = (lower >> shift);
+        auto upperValue = (upper >> shift);
+        auto distance = (static_cast<uint64_t>(number) + modulo - (lowerValue % modulo)) % modulo;
+        shards[i] = (number < modulo && upperValue - lowerValue >= distance);
+    }
+}
+
+} // namespace store
+} // namespace tell
@@ -99,6 +99,28 @@ bool Schema::addField(FieldType type, const crossbow::string& name, bool notNull
     return true;
 }
 
+bool Schema::removeField(const crossbow::string& name) {
+    if (!mIndexes.empty()) {
+        LOG_ERROR("Can not remove fields after adding indexes");
+        return false;
+    }
+
+    for (auto fields : {&mFixedSizeFields, &mVarSizeFields}) {
+        for (auto iter = fields->begin(); iter != fields->end(); ++iter) {
+            if (iter->name() != name) {
+                continue;
+            }
+            if (!iter->isNotNull()) {
+                --mNullFields;
+            }
+            fields->erase(iter);
+            return true;
+        }
+    }
+    LOG_TRACE("Tried to remove a non existing field: %s", name);
+    return false;
+}
+
 size_t Schema::serializedLength() const
 {
     size_t res = sizeof(uint32_t);
@@ -119,6 +141,7 @@ size_t Schema::serializedLength() const
         res += strLen + (strLen % 2);
         res += sizeof(id_t) * idx.second.second.size();
     }
+    res += mPartitioning.serializedLength(res);
     return res;
 }
 
@@ -153,6 +176,7 @@ void Schema::serialize(crossbow::buffer_writer& writer) const
             writer.write<decltype(id)>(id);
         }
     }
+    mPartitioning.serialize(writer);
 }
 
 Schema Schema::deserialize(crossbow::buffer_reader& reader)
@@ -193,6 +217,7 @@ Schema Schema::deserialize(crossbow::buffer_reader& reader)
         }
         res.mIndexes.emplace(crossbow::string(name, nameSize), std::make_pair(isUnique, std::move(fields)));
     }
+    res.mPartitioning = PartitionSpec::deserialize(reader);
     return res;
 }
 
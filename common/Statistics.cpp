@@ -0,0 +1,315 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include <tellstore/Statistics.hpp>
+
+#include <crossbow/byte_buffer.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace tell {
+namespace store {
+
+constexpr uint32_t LatencyBuckets::SUB_BUCKET_BITS;
+constexpr uint32_t LatencyBuckets::SUB_BUCKET_COUNT;
+constexpr uint32_t LatencyBuckets::MAX_EXPONENT;
+constexpr uint32_t LatencyBuckets::BUCKET_COUNT;
+
+void LatencyHistogram::collect(LatencyDistribution& distribution) const {
+    for (uint32_t i = 0; i < mBuckets.size(); ++i) {
+        auto count = mBuckets[i].load(std::memory_order_relaxed);
+        if (count != 0u) {
+            distribution.add(i, count);
+        }
+    }
+}
+
+LatencyDistribution LatencyDistribution::deserialize(crossbow::buffer_reader& reader) {
+    LatencyDistribution distribution;
+
+    reader.align(sizeof(uint32_t));
+    auto bucketCount = reader.read<uint32_t>();
+    reader.advance(sizeof(uint32_t));
+    for (decltype(bucketCount) i = 0; i < bucketCount; ++i) {
+        auto bucket = reader.read<uint64_t>();
+        auto count = reader.read<uint64_t>();
+        distribution.add(static_cast<uint32_t>(bucket), count);
+    }
+    return distribution;
+}
+
+void LatencyDistribution::merge(const LatencyDistribution& other) {
+    for (uint32_t i = 0; i < mBuckets.size(); ++i) {
+        mBuckets[i] += other.mBuckets[i];
+    }
+    mCount += other.mCount;
+}
+
+uint64_t LatencyDistribution::percentile(double fraction) const {
+    if (mCount == 0u) {
+        return 0u;
+    }
+    auto target = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(mCount)));
+    if (target == 0u) {
+        target = 1u;
+    }
+
+    uint64_t seen = 0u;
+    for (uint32_t i = 0; i < mBuckets.size(); ++i) {
+        seen += mBuckets[i];
+        if (seen >= target) {
+            return LatencyBuckets::upperBound(i);
+        }
+    }
+    return LatencyBuckets::upperBound(LatencyBuckets::BUCKET_COUNT - 1u);
+}
+
+double LatencyDistribution::mean() const {
+    if (mCount == 0u) {
+        return 0.0;
+    }
+
+    double sum = 0.0;
+    for (uint32_t i = 0; i < mBuckets.size(); ++i) {
+        if (mBuckets[i] == 0u) {
+            continue;
+        }
+        auto lower = static_cast<double>(LatencyBuckets::lowerBound(i));
+        auto upper = (i + 1u < LatencyBuckets::BUCKET_COUNT ? static_cast<double>(LatencyBuckets::upperBound(i))
+                                                              : lower);
+        sum += static_cast<double>(mBuckets[i]) * (lower + upper) / 2.0;
+    }
+    return sum / static_cast<double>(mCount);
+}
+
+size_t LatencyDistribution::serializedLength() const {
+    size_t bucketCount = 0u;
+    for (auto count : mBuckets) {
+        if (count != 0u) {
+            ++bucketCount;
+        }
+    }
+    return 2 * sizeof(uint32_t) + bucketCount * 2 * sizeof(uint64_t);
+}
+
+void LatencyDistribution::serialize(crossbow::buffer_writer& writer) const {
+    uint32_t bucketCount = 0u;
+    for (auto count : mBuckets) {
+        if (count != 0u) {
+            ++bucketCount;
+        }
+    }
+
+    writer.align(sizeof(uint32_t));
+    writer.write<uint32_t>(bucketCount);
+    writer.set(0, sizeof(uint32_t));
+    for (uint32_t i = 0; i < mBuckets.size(); ++i) {
+        if (mBuckets[i] == 0u) {
+            continue;
+        }
+        writer.write<uint64_t>(i);
+        writer.write<uint64_t>(mBuckets[i]);
+    }
+}
+
+PerfCounterSample& PerfCounterSample::operator+=(const PerfCounterSample& other) {
+    runs += other.runs;
+    cycles += other.cycles;
+    instructions += other.instructions;
+    llcMisses += other.llcMisses;
+    dtlbMisses += other.dtlbMisses;
+    tuples += other.tuples;
+    pages += other.pages;
+    return *this;
+}
+
+PerfCounterSample& PerfCounterSample::operator-=(const PerfCounterSample& other) {
+    runs -= other.runs;
+    cycles -= other.cycles;
+    instructions -= other.instructions;
+    llcMisses -= other.llcMisses;
+    dtlbMisses -= other.dtlbMisses;
+    tuples -= other.tuples;
+    pages -= other.pages;
+    return *this;
+}
+
+ServerStatistics ServerStatistics::deserialize(crossbow::buffer_reader& reader) {
+    ServerStatistics statistics;
+
+    reader.align(sizeof(uint32_t));
+    auto count = reader.read<uint32_t>();
+    reader.advance(sizeof(uint32_t));
+    for (decltype(count) i = 0; i < count; ++i) {
+        auto kind = reader.read<StatisticsKind>();
+        reader.advance(sizeof(uint32_t));
+        auto id = reader.read<uint64_t>();
+        statistics.mDistributions[std::make_pair(kind, id)].merge(LatencyDistribution::deserialize(reader));
+    }
+
+    reader.align(sizeof(uint32_t));
+    auto sampleCount = reader.read<uint32_t>();
+    reader.advance(sizeof(uint32_t));
+    for (decltype(sampleCount) i = 0; i < sampleCount; ++i) {
+        auto source = reader.read<PerfCounterSource>();
+        reader.advance(sizeof(uint32_t));
+        PerfCounterSample sample;
+        sample.runs = reader.read<uint64_t>();
+        sample.cycles = reader.read<uint64_t>();
+        sample.instructions = reader.read<uint64_t>();
+        sample.llcMisses = reader.read<uint64_t>();
+        sample.dtlbMisses = reader.read<uint64_t>();
+        sample.tuples = reader.read<uint64_t>();
+        sample.pages = reader.read<uint64_t>();
+        statistics.mPerfCounters[source] += sample;
+    }
+    return statistics;
+}
+
+void ServerStatistics::merge(const ServerStatistics& other) {
+    for (auto& entry : other.mDistributions) {
+        mDistributions[entry.first].merge(entry.second);
+    }
+    for (auto& entry : other.mPerfCounters) {
+        mPerfCounters[entry.first] += entry.second;
+    }
+}
+
+size_t ServerStatistics::truncateTables(size_t maxLength) {
+    auto length = serializedLength();
+    if (length <= maxLength) {
+        return 0u;
+    }
+
+    std::vector<std::pair<uint64_t, Key>> tables;
+    for (auto& entry : mDistributions) {
+        if (entry.first.first == StatisticsKind::TABLE) {
+            tables.emplace_back(entry.second.count(), entry.first);
+        }
+    }
+    std::sort(tables.begin(), tables.end());
+
+    size_t dropped = 0u;
+    for (auto& table : tables) {
+        if (length <= maxLength) {
+            break;
+        }
+        auto i = mDistributions.find(table.second);
+        length -= 2 * sizeof(uint32_t) + sizeof(uint64_t) + i->second.serializedLength();
+        mDistributions.erase(i);
+        ++dropped;
+    }
+    return dropped;
+}
+
+size_t ServerStatistics::serializedLength() const {
+    auto length = 2 * sizeof(uint32_t);
+    for (auto& entry : mDistributions) {
+        length += 2 * sizeof(uint32_t) + sizeof(uint64_t) + entry.second.serializedLength();
+    }
+    length += 2 * sizeof(uint32_t) + mPerfCounters.size() * (2 * sizeof(uint32_t) + 7 * sizeof(uint64_t));
+    return length;
+}
+
+void ServerStatistics::serialize(crossbow::buffer_writer& writer) const {
+    writer.align(sizeof(uint32_t));
+    writer.write<uint32_t>(mDistributions.size());
+    writer.set(0, sizeof(uint32_t));
+    for (auto& entry : mDistributions) {
+        writer.write<StatisticsKind>(entry.first.first);
+        writer.set(0, sizeof(uint32_t));
+        writer.write<uint64_t>(entry.first.second);
+        entry.second.serialize(writer);
+    }
+
+    writer.align(sizeof(uint32_t));
+    writer.write<uint32_t>(mPerfCounters.size());
+    writer.set(0, sizeof(uint32_t));
+    for (auto& entry : mPerfCounters) {
+        writer.write<PerfCounterSource>(entry.first);
+        writer.set(0, sizeof(uint32_t));
+        writer.write<uint64_t>(entry.second.runs);
+        writer.write<uint64_t>(entry.second.cycles);
+        writer.write<uint64_t>(entry.second.instructions);
+        writer.write<uint64_t>(entry.second.llcMisses);
+        writer.write<uint64_t>(entry.second.dtlbMisses);
+        writer.write<uint64_t>(entry.second.tuples);
+        writer.write<uint64_t>(entry.second.pages);
+    }
+}
+
+MemoryUsage MemoryUsage::deserialize(crossbow::buffer_reader& reader) {
+    MemoryUsage usage;
+
+    reader.align(sizeof(uint32_t));
+    auto count = reader.read<uint32_t>();
+    reader.advance(sizeof(uint32_t));
+    for (decltype(count) i = 0; i < count; ++i) {
+        auto tableId = reader.read<uint64_t>();
+        auto category = reader.read<MemoryCategory>();
+        reader.advance(sizeof(uint64_t) - sizeof(MemoryCategory));
+        usage.add(tableId, category, reader.read<uint64_t>());
+    }
+    return usage;
+}
+
+uint64_t MemoryUsage::table(uint64_t tableId) const {
+    uint64_t bytes = 0u;
+    for (auto i = mEntries.lower_bound(std::make_pair(tableId, MemoryCategory::FREE));
+            i != mEntries.end() && i->first.first == tableId; ++i) {
+        bytes += i->second;
+    }
+    return bytes;
+}
+
+uint64_t MemoryUsage::category(MemoryCategory category) const {
+    uint64_t bytes = 0u;
+    for (auto& entry : mEntries) {
+        if (entry.first.second == category) {
+            bytes += entry.second;
+        }
+    }
+    return bytes;
+}
+
+void MemoryUsage::merge(const MemoryUsage& other) {
+    for (auto& entry : other.mEntries) {
+        mEntries[entry.first] += entry.second;
+    }
+}
+
+void MemoryUsage::serialize(crossbow::buffer_writer& writer) const {
+    writer.align(sizeof(uint32_t));
+    writer.write<uint32_t>(mEntries.size());
+    writer.set(0, sizeof(uint32_t));
+    for (auto& entry : mEntries) {
+        writer.write<uint64_t>(entry.first.first);
+        writer.write<MemoryCategory>(entry.first.second);
+        writer.set(0, sizeof(uint64_t) - sizeof(MemoryCategory));
+        writer.write<uint64_t>(entry.second);
+    }
+}
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,114 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include <tellstore/TupleBinding.hpp>
+
+#include <crossbow/alignment.hpp>
+#include <crossbow/logger.hpp>
+
+#include <cstring>
+
+namespace tell {
+namespace store {
+
+FieldBinding::FieldBinding(const Record& record, Record::id_t id)
+        : mId(id) {
+    if (id >= record.fieldCount()) {
+        throw std::logic_error("Field not found");
+    }
+    auto& meta = record.getFieldMeta(id);
+    mType = meta.field.type();
+    mOffset = meta.offset;
+    mNullIdx = meta.nullIdx;
+    mNullable = !meta.field.isNotNull();
+}
+
+Record::id_t FieldBinding::resolve(const Record& record, const crossbow::string& name) {
+    Record::id_t id;
+    if (!record.idOf(name, id)) {
+        throw std::logic_error("Field not found");
+    }
+    return id;
+}
+
+TupleWriter::TupleWriter(const Record& record)
+        : mRecord(record),
+          mStatic(record.varSizeFieldCount() == 0 ? record.staticSize() : record.variableOffset(), 0),
+          mVariable(record.varSizeFieldCount()),
+          mSet(record.fieldCount(), 0),
+          mHeapSize(0u) {
+    clear();
+}
+
+TupleWriter::~TupleWriter() = default;
+
+void TupleWriter::setNull(const FieldBinding& field) {
+    LOG_ASSERT(field.isNullable(), "Trying to set a NOT NULL field to NULL");
+    mStatic[field.nullIdx()] = 1;
+    if (field.id() >= mRecord.fixedSizeFieldCount()) {
+        auto& entry = mVariable[field.id() - mRecord.fixedSizeFieldCount()];
+        mHeapSize -= entry.size();
+        entry.clear();
+    } else {
+        memset(mStatic.data() + field.offset(), 0, mRecord.getFieldMeta(field.id()).field.staticSize());
+    }
+    mSet[field.id()] = 0;
+}
+
+void TupleWriter::clear() {
+    memset(mStatic.data(), 0, mStatic.size());
+    memset(mStatic.data(), 1, mRecord.headerSize());
+    for (auto& entry : mVariable) {
+        entry.clear();
+    }
+    memset(mSet.data(), 0, mSet.size());
+    mHeapSize = 0u;
+}
+
+size_t TupleWriter::size() const {
+    return crossbow::align(mRecord.staticSize() + mHeapSize, 8u);
+}
+
+void TupleWriter::serialize(char* dest) const {
+#ifndef NDEBUG
+    for (Record::id_t id = 0; id < mSet.size(); ++id) {
+        LOG_ASSERT(mSet[id] || !mRecord.getFieldMeta(id).field.isNotNull(), "NOT NULL field %1% was not set", id);
+    }
+#endif
+    memcpy(dest, mStatic.data(), mStatic.size());
+    if (mVariable.empty()) {
+        return;
+    }
+
+    auto offsetData = reinterpret_cast<uint32_t*>(dest + mRecord.variableOffset());
+    auto heapOffset = mRecord.staticSize();
+    for (auto& entry : mVariable) {
+        *(offsetData++) = heapOffset;
+        memcpy(dest + heapOffset, entry.data(), entry.size());
+        heapOffset += entry.size();
+    }
+    *offsetData = heapOffset;
+}
+
+} // namespace store
+} // namespace tell
@@ -71,6 +71,26 @@ struct DeltaMainRewriteStore : crossbow::non_copyable, crossbow::non_movable {
         return tableManager.createTable(name, schema, idx, tableManager.config().hashMapCapacity);
     }
 
+    int checkAlterTable(uint64_t tableId, uint32_t schemaVersion, const Schema& schema)
+    {
+        return tableManager.checkAlterTable(tableId, schemaVersion, schema);
+    }
+
+    int alterTable(uint64_t tableId, uint32_t schemaVersion, const Schema& schema)
+    {
+        return tableManager.alterTable(tableId, schemaVersion, schema);
+    }
+
+    int dropTable(uint64_t tableId)
+    {
+        return tableManager.dropTable(tableId);
+    }
+
+    int truncateTable(uint64_t tableId)
+    {
+        return tableManager.truncateTable(tableId, tableManager.config().hashMapCapacity);
+    }
+
     std::vector<const Table*> getTables() const
     {
         return tableManager.getTables();
@@ -92,16 +112,23 @@ struct DeltaMainRewriteStore : crossbow::non_copyable, crossbow::non_movable {
         return tableManager.get(tableId, key, snapshot, std::move(fun));
     }
 
+    template <typename Fun>
+    void get(uint64_t tableId, const uint64_t* keys, size_t count, const commitmanager::SnapshotDescriptor& snapshot,
+            int* ec, Fun fun)
+    {
+        tableManager.get(tableId, keys, count, snapshot, ec, std::move(fun));
+    }
+
     int update(uint64_t tableId, uint64_t key, size_t size, const char* data,
-            const commitmanager::SnapshotDescriptor& snapshot)
+            const commitmanager::SnapshotDescriptor& snapshot, uint32_t schemaVersion)
     {
-        return tableManager.update(tableId, key, size, data, snapshot);
+        return tableManager.update(tableId, key, size, data, snapshot, schemaVersion);
     }
 
     int insert(uint64_t tableId, uint64_t key, size_t size, const char* data,
-               const commitmanager::SnapshotDescriptor& snapshot)
+               const commitmanager::SnapshotDescriptor& snapshot, uint32_t schemaVersion)
     {
-        return tableManager.insert(tableId, key, size, data, snapshot);
+        return tableManager.insert(tableId, key, size, data, snapshot, schemaVersion);
     }
 
     int remove(uint64_t tableId, uint64_t key, const commitmanager::SnapshotDescriptor& snapshot)
@@ -119,6 +146,21 @@ struct DeltaMainRewriteStore : crossbow::non_copyable, crossbow::non_movable {
         return tableManager.scan(tableId, query);
     }
 
+    bool reserveScan(ScanQuery* query)
+    {
+        return tableManager.reserveScan(query);
+    }
+
+    void releaseScan(ScanQuery* query)
+    {
+        tableManager.releaseScan(query);
+    }
+
+    int scanReserved(uint64_t tableId, ScanQuery* query)
+    {
+        return tableManager.scanReserved(tableId, query);
+    }
+
     /**
      * We use this method mostly for test purposes. But
      * it might be handy in the future as well. If possible,
@@ -129,6 +171,14 @@ struct DeltaMainRewriteStore : crossbow::non_copyable, crossbow::non_movable {
         tableManager.forceGC();
     }
 
+    /**
+     * @brief Adds the memory of all pages to the usage by table and category
+     */
+    void collectMemoryUsage(MemoryUsage& usage) const
+    {
+        mPageManager->collectUsage(usage);
+    }
+
 private:
     PageManager::Ptr mPageManager;
     GC gc;
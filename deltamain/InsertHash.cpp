@@ -24,6 +24,7 @@
 #include "InsertHash.hpp"
 
 #include <util/Log.hpp>
+#include <util/PageManager.hpp>
 
 #include <crossbow/allocator.hpp>
 #include <crossbow/logger.hpp>
@@ -51,59 +52,92 @@ size_t nextPowerOf2(size_t v) {
 
 } // anonymous namespace
 
+constexpr size_t InsertTable::MIGRATION_CHUNK_SIZE;
+
 InsertTable::InsertTable(size_t capacity)
         : mCapacity(capacity),
           mBuckets(new AtomicEntry[mCapacity]),
-          mHash(mCapacity) {
+          mHash(mCapacity),
+          mUsed(0u),
+          mNext(nullptr),
+          mChunks((mCapacity + MIGRATION_CHUNK_SIZE - 1) / MIGRATION_CHUNK_SIZE),
+          mChunkDone(new std::atomic<bool>[mChunks]),
+          mMigrateCursor(0u),
+          mMigrated(0u) {
+    for (size_t i = 0; i < mChunks; ++i) {
+        mChunkDone[i].store(false, std::memory_order_relaxed);
+    }
+}
+
+size_t InsertTable::memoryUsage(size_t capacity) {
+    auto chunks = (capacity + MIGRATION_CHUNK_SIZE - 1) / MIGRATION_CHUNK_SIZE;
+    return sizeof(InsertTable) + capacity * sizeof(AtomicEntry) + chunks * sizeof(std::atomic<bool>);
 }
 
 const void* InsertTable::get(uint64_t key) const {
-    return execOnElement(key, static_cast<const void*>(nullptr), [] (const AtomicEntry& /* entry */, uintptr_t ptr) {
-        return reinterpret_cast<const void*>(ptr);
-    });
+    uintptr_t ptr;
+    if (!find(key, ptr)) {
+        return nullptr;
+    }
+
+    // The bucket was migrated: Continue in the next table
+    if (isMoved(ptr)) {
+        return forward(key, ptr)->get(key);
+    }
+
+    return (isElement(ptr) ? reinterpret_cast<const void*>(ptr) : nullptr);
 }
 
 bool InsertTable::insert(uint64_t key, void* data, void** actualData /* = nullptr */) {
     LOG_ASSERT(data != nullptr, "Data pointer not allowed to be null");
+    LOG_ASSERT((reinterpret_cast<uintptr_t>(data) % 8u) == 0u, "Data pointer must be 8 byte aligned");
 
     auto hash = mHash(key);
     for (auto pos = hash; pos < (hash + mCapacity); ++pos) {
         auto& entry = mBuckets[pos % mCapacity];
 
-        // If the pointer is null then we reached the end of the overflow bucket and the element was not found
-        auto ptr = entry.loadValue();
-        if (ptr == crossbow::to_underlying(EntryMarker::FREE)) {
-            // Try to claim the current bucket
-            Entry oldEntry;
-            Entry newEntry(key, reinterpret_cast<uintptr_t>(data));
-            if (entry.compare_exchange_strong(oldEntry, newEntry)) {
-                return true;
-            }
-
-            // Move to the next bucket if the current one was claimed by an insert with a different key
-            if (oldEntry.key != key) {
+        // Repeat the current bucket until it is either claimed or moved to the next one
+        while (true) {
+            auto ptr = entry.loadValue();
+            if (ptr == crossbow::to_underlying(EntryMarker::FREE)) {
+                // Try to claim the current bucket
+                Entry oldEntry;
+                Entry newEntry(key, reinterpret_cast<uintptr_t>(data));
+                if (entry.compare_exchange_strong(oldEntry, newEntry)) {
+                    mUsed.fetch_add(1u);
+                    return true;
+                }
+
+                // The bucket was claimed or frozen in the meantime: Check it again
                 continue;
             }
 
-            // Update the pointer
-            ptr = oldEntry.value;
-        } else {
             // If the stored key is different than the target key we have to search the next bucket
-            auto k = entry.loadKey();
-            if (k != key) {
+            // A frozen free bucket ends the probe sequence as the key can not be found after it
+            if ((ptr & ~crossbow::to_underlying(EntryMarker::MOVED)) != crossbow::to_underlying(EntryMarker::FREE)
+                    && entry.loadKey() != key) {
+                break;
+            }
+
+            // The bucket was migrated: Continue in the next table
+            if (isMoved(ptr)) {
+                return forward(key, ptr)->insert(key, data, actualData);
+            }
+
+            // Try to claim the bucket if the pointer marks a deletion
+            if (ptr == crossbow::to_underlying(EntryMarker::DELETED)) {
+                if (entry.updateValue(ptr, reinterpret_cast<uintptr_t>(data))) {
+                    return true;
+                }
+
+                // The bucket was reclaimed or frozen in the meantime: Check it again
                 continue;
             }
-        }
 
-        // Try to claim the bucket if the pointer marks a deletion
-        if (ptr == crossbow::to_underlying(EntryMarker::DELETED)
-                && entry.updateValue(ptr, reinterpret_cast<uintptr_t>(data))) {
-            return true;
+            // The element was not deleted
+            if (actualData) *actualData = reinterpret_cast<void*>(ptr);
+            return false;
         }
-
-        // The element was not deleted
-        if (actualData) *actualData = reinterpret_cast<void*>(ptr);
-        return false;
     }
 
     LOG_ERROR("Hash table is full");
@@ -119,196 +153,268 @@ bool InsertTable::remove(uint64_t key, const void* oldData, void** actualData /*
     return internalUpdate(key, oldData, crossbow::to_underlying(EntryMarker::DELETED), actualData);
 }
 
-bool InsertTable::internalUpdate(uint64_t key, const void* oldData, uintptr_t newData, void** actualData) {
-    return execOnElement(key, false, [oldData, newData, actualData] (AtomicEntry& entry, uintptr_t ptr) {
-        auto expected = reinterpret_cast<uintptr_t>(oldData);
-        if (ptr != expected) {
-            if (actualData) *actualData = reinterpret_cast<void*>(ptr);
+bool InsertTable::startMigration(InsertTable* target) {
+    LOG_ASSERT(target != nullptr, "Target table must not be null");
+    InsertTable* expected = nullptr;
+    return mNext.compare_exchange_strong(expected, target);
+}
+
+bool InsertTable::migrate() {
+    auto next = mNext.load();
+    LOG_ASSERT(next != nullptr, "Migrating a table without target");
+
+    auto chunk = mMigrateCursor.fetch_add(1u);
+    if (chunk >= mChunks) {
+        // All chunks were handed out: Help with a chunk whose owner did not finish yet
+        for (chunk = 0u; chunk < mChunks && mChunkDone[chunk].load(); ++chunk);
+        if (chunk == mChunks) {
             return false;
         }
+    }
 
-        // Try to update the pointer
-        if (entry.updateValue(expected, newData)) {
-            return true;
-        }
+    auto end = std::min((chunk + 1) * MIGRATION_CHUNK_SIZE, mCapacity);
+    for (auto pos = chunk * MIGRATION_CHUNK_SIZE; pos < end; ++pos) {
+        auto& entry = mBuckets[pos];
 
-        // Set the actual data only in case its not a deletion
-        if (expected != crossbow::to_underlying(EntryMarker::DELETED)) {
-            if (actualData) *actualData = reinterpret_cast<void*>(expected);
+        // Freeze the bucket (unless another thread already did), afterwards no operation can change it anymore
+        auto ptr = entry.loadValue();
+        while (!isMoved(ptr) && !entry.updateValue(ptr, ptr | crossbow::to_underlying(EntryMarker::MOVED)));
+
+        auto value = ptr & ~crossbow::to_underlying(EntryMarker::MOVED);
+        if (isElement(value)) {
+            next->migrateInsert(entry.loadKey(), value);
         }
+    }
+
+    auto done = false;
+    if (!mChunkDone[chunk].compare_exchange_strong(done, true)) {
         return false;
-    });
+    }
+    return (mMigrated.fetch_add(1u) + 1 == mChunks);
 }
 
-template <typename T, typename F>
-T InsertTable::execOnElement(uint64_t key, T notFound, F fun) const {
+const InsertTable::AtomicEntry* InsertTable::find(uint64_t key, uintptr_t& ptr) const {
     auto hash = mHash(key);
     for (auto pos = hash; pos < (hash + mCapacity); ++pos) {
         auto& entry = mBuckets[pos % mCapacity];
 
         // If the pointer is null then we reached the end of the overflow bucket and the element was not found
-        auto ptr = entry.loadValue();
-        if (ptr == crossbow::to_underlying(EntryMarker::FREE)) {
-            return notFound;
+        ptr = entry.loadValue();
+        if ((ptr & ~crossbow::to_underlying(EntryMarker::MOVED)) == crossbow::to_underlying(EntryMarker::FREE)) {
+            return &entry;
         }
 
         // If the stored key is different than the target key we have to search the next bucket
-        auto k = entry.loadKey();
-        if (k != key) {
-            continue;
+        if (entry.loadKey() == key) {
+            return &entry;
         }
-
-        // The entry was marked as deleted
-        if (ptr == crossbow::to_underlying(EntryMarker::DELETED)) {
-            return notFound;
-        }
-
-        // The element was found
-        return fun(entry, ptr);
     }
 
     LOG_ERROR("Hash table is full");
-    return notFound;
-}
-
-template <typename T, typename F>
-T InsertTable::execOnElement(uint64_t key, T notFound, F fun) {
-    return const_cast<const InsertTable*>(this)->execOnElement(key, notFound,
-            [&fun] (const AtomicEntry& entry, uintptr_t ptr) {
-        return fun(const_cast<AtomicEntry&>(entry), ptr);
-    });
+    return nullptr;
 }
 
-DynamicInsertTable::DynamicInsertTable(size_t minimumCapacity)
-        : mMinimumCapacity(minimumCapacity),
-          mHeadList(crossbow::allocator::construct<DynamicInsertTableEntry>(nullptr, minimumCapacity)) {
-    LOG_ASSERT(minimumCapacity > 1, "Minimum capacity must be larger than 1");
-    LOG_ASSERT(isPowerOf2(minimumCapacity), "Minimum capacity must be power of 2");
-}
+InsertTable* InsertTable::forward(uint64_t key, uintptr_t ptr) const {
+    auto next = mNext.load();
+    LOG_ASSERT(next != nullptr, "Bucket is frozen but table has no migration target");
 
-DynamicInsertTable::~DynamicInsertTable() {
-    auto headList = mHeadList.exchange(nullptr);
-    while (headList != nullptr) {
-        auto previousList = headList->nextList.load();
-        crossbow::allocator::destroy_now(headList);
-        headList = previousList;
+    // The migration might not have copied the element yet
+    auto value = ptr & ~crossbow::to_underlying(EntryMarker::MOVED);
+    if (isElement(value)) {
+        next->migrateInsert(key, value);
     }
+    return next;
 }
 
-const void* DynamicInsertTable::get(uint64_t key, DynamicInsertTableEntry** headList) const {
-    auto insertList = mHeadList.load();
-    if (headList) *headList = insertList;
-    LOG_ASSERT(insertList != nullptr, "Head insert list must never be null");
+void InsertTable::migrateInsert(uint64_t key, uintptr_t value) {
+    auto hash = mHash(key);
+    for (auto pos = hash; pos < (hash + mCapacity); ++pos) {
+        auto& entry = mBuckets[pos % mCapacity];
 
-    for (auto currentList = insertList; currentList; currentList = currentList->nextList.load()) {
-        if (auto ptr = currentList->table.get(key)) {
-            return ptr;
+        while (true) {
+            auto ptr = entry.loadValue();
+            if (ptr == crossbow::to_underlying(EntryMarker::FREE)) {
+                Entry oldEntry;
+                Entry newEntry(key, value);
+                if (entry.compare_exchange_strong(oldEntry, newEntry)) {
+                    mUsed.fetch_add(1u);
+                    return;
+                }
+                continue;
+            }
+
+            // This table is migrated itself: The key can only be in the next table
+            if (ptr == crossbow::to_underlying(EntryMarker::MOVED)) {
+                forward(key, ptr)->migrateInsert(key, value);
+                return;
+            }
+
+            // The element was already copied (and maybe changed afterwards)
+            if (entry.loadKey() == key) {
+                return;
+            }
+            break;
         }
     }
-    return nullptr;
+
+    LOG_ERROR("Hash table is full");
 }
 
-bool DynamicInsertTable::insert(uint64_t key, void* data) {
-    DynamicInsertTableEntry* headList = nullptr;
-    if (get(key, &headList)) {
+bool InsertTable::internalUpdate(uint64_t key, const void* oldData, uintptr_t newData, void** actualData) {
+    uintptr_t ptr;
+    auto entry = find(key, ptr);
+    if (!entry) {
         return false;
     }
-    return insert(key, data, headList);
-}
 
-bool DynamicInsertTable::insert(uint64_t key, void* data, DynamicInsertTableEntry* headList) {
     while (true) {
-        // Try to insert the element in the insert table
-        if (!headList->table.insert(key, data)) {
+        // The bucket was migrated: Continue in the next table
+        if (isMoved(ptr)) {
+            return forward(key, ptr)->internalUpdate(key, oldData, newData, actualData);
+        }
+
+        // The element does not exist or was deleted
+        if (!isElement(ptr)) {
             return false;
         }
-        auto currentSize = headList->size.fetch_add(1u) + 1;
-
-        // Check if a new head table was allocated in the meantime
-        // The insert has to be repeated in the new head table
-        auto newHeadList = mHeadList.load();
-        if (newHeadList == headList) {
-            // Allocate a new head table and repeat the insert if the current table reached its maximum size
-            if (currentSize >= headList->maximumSize) {
-                headList = allocateHead(headList, headList->table.capacity() * 2u);
-                continue;
-            }
-            return true;
+
+        auto expected = reinterpret_cast<uintptr_t>(oldData);
+        if (ptr != expected) {
+            if (actualData) *actualData = reinterpret_cast<void*>(ptr);
+            return false;
         }
 
-        // Check if an insert took place that in the older tables (up to the previous insert table)
-        for (auto currentList = newHeadList->nextList.load(); currentList && currentList != headList;
-                currentList = currentList->nextList.load()) {
-            if (currentList->table.get(key)) {
-                // The element was found in a newer insert table: Abort the current insertion
-                return false;
-            }
+        // Try to update the pointer
+        if (const_cast<AtomicEntry*>(entry)->updateValue(expected, newData)) {
+            return true;
         }
 
-        // Restart the insert in the newest table
-        headList = newHeadList;
+        // The element was changed, deleted or frozen in the meantime: Check it again
+        ptr = expected;
     }
 }
 
-bool DynamicInsertTable::remove(uint64_t key, const void* oldData, DynamicInsertTableEntry* tailList) {
-    auto insertList = mHeadList.load();
-    auto endList = tailList->nextList.load();
-    LOG_ASSERT(insertList != nullptr, "Head insert list must never be null");
+DynamicInsertTable::DynamicInsertTable(PageManager& pageManager, const MemoryTag& tag, size_t minimumCapacity)
+        : mPageManager(pageManager),
+          mTag(tag),
+          mMinimumCapacity(minimumCapacity),
+          mTable(allocTable(minimumCapacity)),
+          mSize(0u) {
+    LOG_ASSERT(minimumCapacity > 1, "Minimum capacity must be larger than 1");
+    LOG_ASSERT(isPowerOf2(minimumCapacity), "Minimum capacity must be power of 2");
+}
 
-    for (auto currentList = insertList; currentList || currentList == endList;
-            currentList = currentList->nextList.load()) {
-        // Try to remove the element in the insert table
-        void* actualData = nullptr;
-        if (currentList->table.remove(key, oldData, &actualData)) {
-            return true;
-        }
+DynamicInsertTable::~DynamicInsertTable() {
+    auto table = mTable.exchange(nullptr);
+    while (table != nullptr) {
+        auto next = table->next();
+        destroyTable(mPageManager, mTag, table);
+        table = next;
+    }
+}
 
-        // Check if the element does not exist in the current table, retry with the next
-        if (actualData == nullptr) {
-            continue;
-        }
+const void* DynamicInsertTable::get(uint64_t key) const {
+    auto table = mTable.load();
+    helpMigration(table);
+    return table->get(key);
+}
 
-        // Element exists and changed in the meantime
+bool DynamicInsertTable::insert(uint64_t key, void* data) {
+    auto table = mTable.load();
+    helpMigration(table);
+    if (!table->insert(key, data)) {
         return false;
     }
+    auto size = mSize.fetch_add(1u) + 1;
+
+    // Start migrating into a larger table if the current table reached 0.75 of its capacity
+    // The new table is at least twice as large as the number of elements
+    if (table->used() * 4u >= table->capacity() * 3u && !table->migrating()) {
+        auto capacity = std::max(mMinimumCapacity, nextPowerOf2(size * 2u));
+        if (startMigration(table, capacity)) {
+            helpMigration(table);
+        }
+    }
+    return true;
+}
 
-    // Element was not found
-    return false;
+bool DynamicInsertTable::remove(uint64_t key, const void* oldData) {
+    auto table = mTable.load();
+    helpMigration(table);
+    if (!table->remove(key, oldData)) {
+        return false;
+    }
+    mSize.fetch_sub(1u);
+    return true;
 }
 
-DynamicInsertTableEntry* DynamicInsertTable::allocateHead() {
-    auto headList = mHeadList.load();
-    auto headSize = headList->size.load();
+void DynamicInsertTable::resize(size_t expectedInserts) {
+    // Complete any migration still running
+    auto table = mTable.load();
+    while (table->migrating()) {
+        helpMigration(table);
+        table = mTable.load();
+    }
+
+    // Size the table so the current and expected elements occupy at most 0.75 of the capacity
+    auto size = mSize.load();
+    auto capacity = std::max(mMinimumCapacity, nextPowerOf2(((size + expectedInserts) * 4u) / 3u));
+    auto used = table->used();
+    auto deleted = (used > size ? used - size : 0u);
 
-    // If the new capacity is below the threshold multiply it by two
-    auto capacity = std::max(mMinimumCapacity, nextPowerOf2(headSize));
-    if (headSize * 4u >= capacity * 3u) {
-        capacity *= 2u;
+    // Keep the table if it is large enough, not more than 4 times too large and has few deleted elements
+    if (capacity <= table->capacity() && capacity * 4u > table->capacity() && deleted * 4u < table->capacity()) {
+        return;
+    }
+    if (!startMigration(table, capacity)) {
+        return;
+    }
+    while (mTable.load() == table) {
+        helpMigration(table);
     }
-    return allocateHead(headList, capacity);
 }
 
-void DynamicInsertTable::truncate(DynamicInsertTableEntry* endList) {
-    // Truncate the insert hash table and free all tables using the epoch mechanism
-    auto oldList = endList->nextList.exchange(nullptr);
-    while (oldList != nullptr) {
-        auto previousList = oldList->nextList.load();
-        crossbow::allocator::destroy(oldList);
-        oldList = previousList;
+void DynamicInsertTable::helpMigration(InsertTable* table) const {
+    if (!table->migrating()) {
+        return;
     }
+    if (!table->migrate()) {
+        return;
+    }
+
+    // The last chunk was migrated: Replace the table and free it once no reader can reference it
+    __attribute__((unused)) auto res = mTable.compare_exchange_strong(table, table->next());
+    LOG_ASSERT(res, "Only the thread completing the migration replaces the table");
+
+    // The retired table may outlive this object (e.g. when the table is dropped) but never the page manager
+    auto pageManager = &mPageManager;
+    auto tag = mTag;
+    mPageManager.retire([pageManager, tag, table] () {
+        destroyTable(*pageManager, tag, table);
+    });
 }
 
-DynamicInsertTableEntry* DynamicInsertTable::allocateHead(DynamicInsertTableEntry* headList, size_t capacity) {
+bool DynamicInsertTable::startMigration(InsertTable* table, size_t capacity) {
     LOG_ASSERT(isPowerOf2(capacity), "Capacity must be power of 2");
-    auto newHeadList = crossbow::allocator::construct<DynamicInsertTableEntry>(headList, capacity);
+    auto newTable = allocTable(capacity);
 
-    // Set the newly allocated table as new head table
-    // If this fails another hash table was allocated in the meantime by somebody else
-    if (!mHeadList.compare_exchange_strong(headList, newHeadList)) {
-        crossbow::allocator::destroy_now(newHeadList);
-        newHeadList = headList;
+    // If this fails another migration was started in the meantime by somebody else
+    if (!table->startMigration(newTable)) {
+        destroyTable(mPageManager, mTag, newTable);
+        return false;
     }
-    return newHeadList;
+    return true;
+}
+
+InsertTable* DynamicInsertTable::allocTable(size_t capacity) {
+    auto table = crossbow::allocator::construct<InsertTable>(capacity);
+    mPageManager.allocHeap(mTag, InsertTable::memoryUsage(capacity));
+    return table;
+}
+
+void DynamicInsertTable::destroyTable(PageManager& pageManager, const MemoryTag& tag, InsertTable* table) {
+    pageManager.freeHeap(tag, InsertTable::memoryUsage(table->capacity()));
+    crossbow::allocator::destroy_now(table);
 }
 
 } // namespace deltamain
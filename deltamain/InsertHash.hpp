@@ -24,6 +24,7 @@
 #pragma once
 
 #include <util/functional.hpp>
+#include <util/PageManager.hpp>
 
 #include <crossbow/enum_underlying.hpp>
 
@@ -38,7 +39,9 @@ namespace deltamain {
 /**
  * @brief Lock-Free Open-Addressing hash table for associating a pointer with a key
  *
- * Space occupied by deleted keys is never reclaimed.
+ * Space occupied by deleted keys is never reclaimed within the table. Instead the table can be migrated into a new
+ * table: Every bucket is frozen and its live element copied into the target table. Operations encountering a frozen
+ * bucket copy the element themselves (if not already done) and continue in the target table.
  */
 class InsertTable {
 public:
@@ -48,6 +51,29 @@ public:
         return mCapacity;
     }
 
+    /**
+     * @brief Number of bytes allocated by a table with the given capacity
+     */
+    static size_t memoryUsage(size_t capacity);
+
+    /**
+     * @brief Number of buckets claimed by elements (including deleted ones)
+     */
+    size_t used() const {
+        return mUsed.load();
+    }
+
+    /**
+     * @brief The table this table is migrated into or null if no migration was started
+     */
+    InsertTable* next() const {
+        return mNext.load();
+    }
+
+    bool migrating() const {
+        return (mNext.load() != nullptr);
+    }
+
     /**
      * @brief Looks up the element in the hash table
      *
@@ -66,6 +92,13 @@ public:
      */
     const void* get(uint64_t key) const;
 
+    /**
+     * @brief Issues a prefetch for the first bucket the key is probed in
+     */
+    void prefetch(uint64_t key) const {
+        __builtin_prefetch(&mBuckets[mHash(key) % mCapacity]);
+    }
+
     /**
      * @brief Tries to insert the element into the hash table
      *
@@ -99,7 +132,28 @@ public:
      */
     bool remove(uint64_t key, const void* oldData, void** actualData = nullptr);
 
+    /**
+     * @brief Starts migrating this table into the target table
+     *
+     * @param target The empty table to migrate into
+     * @return True if the migration was started, false if another migration was already started
+     */
+    bool startMigration(InsertTable* target);
+
+    /**
+     * @brief Migrates the next chunk of buckets into the target table
+     *
+     * Can be called concurrently by any number of threads. Once all chunks were handed out, callers migrate chunks that
+     * are not finished yet again so a descheduled thread can not stall the migration.
+     *
+     * @return True if the call finished the last outstanding chunk
+     */
+    bool migrate();
+
 private:
+    /// Number of buckets migrated as one unit
+    static constexpr size_t MIGRATION_CHUNK_SIZE = 256u;
+
     /**
      * @brief The potential states a Entry pointer can be tagged with
      */
@@ -109,6 +163,9 @@ private:
 
         /// The entry is deleted and can be reused (actual pointer will be null)
         DELETED = 0x1u,
+
+        /// Flag marking the entry as frozen by a migration (combined with the pointer, FREE or DELETED)
+        MOVED = 0x2u,
     };
 
     /**
@@ -163,19 +220,33 @@ private:
         Entry mEntry;
     };
 
+    static bool isMoved(uintptr_t ptr) {
+        return ((ptr & crossbow::to_underlying(EntryMarker::MOVED)) != 0x0u);
+    }
+
+    static bool isElement(uintptr_t ptr) {
+        return (ptr > (crossbow::to_underlying(EntryMarker::DELETED) | crossbow::to_underlying(EntryMarker::MOVED)));
+    }
+
     /**
-     * @brief Searches the hash table for the element with key and executes the function on the element
+     * @brief Searches the hash table for the bucket of the key
      *
      * @param key The key ID of the entry
-     * @param notFound The value to return when the element was not found
-     * @param fun The function to be executed on the target element, interface must match T fun(AtomicEntry&, void* ptr)
-     * @return The return value of fun or notFound if the element was not found
+     * @param ptr The value loaded from the returned bucket
+     * @return The bucket containing the key, the (free or frozen free) bucket ending the probe sequence or null if the
+     *         table is full
      */
-    template <typename T, typename F>
-    T execOnElement(uint64_t key, T notFound, F fun) const;
+    const AtomicEntry* find(uint64_t key, uintptr_t& ptr) const;
 
-    template <typename T, typename F>
-    T execOnElement(uint64_t key, T notFound, F fun);
+    /**
+     * @brief Copies the element of a frozen bucket into the target table and returns the target table
+     */
+    InsertTable* forward(uint64_t key, uintptr_t ptr) const;
+
+    /**
+     * @brief Inserts the migrated element unless the key is already present in any state
+     */
+    void migrateInsert(uint64_t key, uintptr_t value);
 
     /**
      * @brief Tries to update the existing element
@@ -189,56 +260,110 @@ private:
     std::unique_ptr<AtomicEntry[]> mBuckets;
 
     cuckoo_hash_function mHash;
-};
 
-struct DynamicInsertTableEntry {
-    DynamicInsertTableEntry(DynamicInsertTableEntry* next, uint64_t capacity)
-            : nextList(next),
-              size(0u),
-              maximumSize((capacity * 3u) / 4u),
-              table(capacity) {
-    }
+    /// Number of buckets claimed by elements
+    std::atomic<size_t> mUsed;
 
-    /// Pointer to the last list or null if there is no more page
-    std::atomic<DynamicInsertTableEntry*> nextList;
+    /// Table this table is migrated into
+    std::atomic<InsertTable*> mNext;
 
-    /// Number of elements in the table
-    std::atomic<size_t> size;
+    /// Number of migration chunks
+    size_t mChunks;
 
-    /// Number of elements after which the table is considered to be full (Set to 0.75 of the capacity)
-    const size_t maximumSize;
+    /// Whether the chunk was completely migrated
+    std::unique_ptr<std::atomic<bool>[]> mChunkDone;
 
-    InsertTable table;
+    /// Index of the next chunk to migrate
+    std::atomic<size_t> mMigrateCursor;
+
+    /// Number of chunks already migrated
+    std::atomic<size_t> mMigrated;
 };
 
+/**
+ * @brief Insert table growing in place
+ *
+ * All lookups go to a single InsertTable. When the table fills up (or the garbage collection resizes it) a new table
+ * is allocated and every operation helps migrating a chunk of buckets until the new table replaces the old one. Old
+ * tables are retired to the page manager.
+ */
 class DynamicInsertTable {
 public:
-    DynamicInsertTable(size_t minimumCapacity);
+    /**
+     * @param pageManager Page manager the memory of the tables is accounted to and old tables are retired to
+     * @param tag Owner and category the memory of the tables is accounted for
+     * @param minimumCapacity Minimum number of buckets (must be a power of 2)
+     */
+    DynamicInsertTable(PageManager& pageManager, const MemoryTag& tag, size_t minimumCapacity);
 
     ~DynamicInsertTable();
 
-    const void* get(uint64_t key, DynamicInsertTableEntry** headList = nullptr) const;
+    const void* get(uint64_t key) const;
 
-    void* get(uint64_t key, DynamicInsertTableEntry** headList = nullptr) {
-        return const_cast<void*>(const_cast<const DynamicInsertTable*>(this)->get(key, headList));
+    void* get(uint64_t key) {
+        return const_cast<void*>(const_cast<const DynamicInsertTable*>(this)->get(key));
+    }
+
+    void prefetch(uint64_t key) const {
+        mTable.load()->prefetch(key);
     }
 
     bool insert(uint64_t key, void* data);
 
-    bool insert(uint64_t key, void* data, DynamicInsertTableEntry* headList);
+    bool remove(uint64_t key, const void* oldData);
 
-    bool remove(uint64_t key, const void* oldData, DynamicInsertTableEntry* tailList);
+    /**
+     * @brief Sizes the table for the inserts expected until the next garbage collection
+     *
+     * Called by the garbage collection after it removed the elements merged into the main. Migrates the elements into
+     * a new table when the current one is too small, much too large or contains many deleted elements. The migration
+     * is completed before the function returns.
+     *
+     * @param expectedInserts Number of inserts expected until the next run (usually the inserts since the last run)
+     */
+    void resize(size_t expectedInserts);
 
-    DynamicInsertTableEntry* allocateHead();
+    size_t capacity() const {
+        return mTable.load()->capacity();
+    }
 
-    void truncate(DynamicInsertTableEntry* endList);
+    size_t size() const {
+        return mSize.load();
+    }
 
 private:
-    DynamicInsertTableEntry* allocateHead(DynamicInsertTableEntry* headList, size_t headSize);
+    /**
+     * @brief Migrates a chunk of buckets if a migration of the table is running
+     */
+    void helpMigration(InsertTable* table) const;
+
+    /**
+     * @brief Allocates a table with the given capacity and starts migrating the current table into it
+     *
+     * @return False if a migration was already running
+     */
+    bool startMigration(InsertTable* table, size_t capacity);
+
+    /**
+     * @brief Allocates a new table and accounts its memory to the page manager
+     */
+    InsertTable* allocTable(size_t capacity);
+
+    /**
+     * @brief Frees the table immediately and releases its memory from the page manager
+     */
+    static void destroyTable(PageManager& pageManager, const MemoryTag& tag, InsertTable* table);
+
+    PageManager& mPageManager;
+
+    const MemoryTag mTag;
 
     const size_t mMinimumCapacity;
 
-    std::atomic<DynamicInsertTableEntry*> mHeadList;
+    mutable std::atomic<InsertTable*> mTable;
+
+    /// Number of live elements in the table
+    std::atomic<size_t> mSize;
 };
 
 } // namespace deltamain
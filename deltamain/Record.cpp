@@ -77,7 +77,7 @@ UpdateRecordIterator::UpdateRecordIterator(const UpdateLogEntry* record, uint64_
 
     // Forward version chain if the element was a revert
     auto logEntry = LogEntry::entryFromData(reinterpret_cast<const char*>(mCurrent));
-    if (logEntry->type() == crossbow::to_underlying(RecordType::REVERT)) {
+    if (logEntryRecordType(logEntry) == RecordType::REVERT) {
         next();
     }
 }
@@ -107,7 +107,7 @@ void UpdateRecordIterator::next() {
 
         // Forward version chain if the element was a revert
         auto logEntry = LogEntry::entryFromData(reinterpret_cast<const char*>(entry));
-        if (logEntry->type() != crossbow::to_underlying(RecordType::REVERT)) {
+        if (logEntryRecordType(logEntry) != RecordType::REVERT) {
             break;
         }
     }
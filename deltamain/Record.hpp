@@ -63,6 +63,23 @@ enum RecordType : uint32_t {
     REVERT,
 };
 
+/**
+ * @brief Type of the log entry storing a record of the given type written in the given schema version
+ *
+ * The lower 16 bits of the log entry type store the record type, the upper 16 bits the schema version.
+ */
+inline uint32_t logEntryType(RecordType type, uint32_t schemaVersion) {
+    return crossbow::to_underlying(type) | (schemaVersion << 16);
+}
+
+inline RecordType logEntryRecordType(const LogEntry* entry) {
+    return static_cast<RecordType>(entry->type() & 0xFFFFu);
+}
+
+inline uint32_t logEntrySchemaVersion(const LogEntry* entry) {
+    return (entry->type() >> 16);
+}
+
 enum NewestPointerTag : uintptr_t {
     UPDATE = 0x0u,
     MAIN = 0x1u,
@@ -124,6 +141,10 @@ public:
         return mEntry->version;
     }
 
+    uint32_t schemaVersion() const {
+        return logEntrySchemaVersion(LogEntry::entryFromData(reinterpret_cast<const char*>(mEntry)));
+    }
+
     template <typename Fun>
     int get(uint64_t highestVersion, const commitmanager::SnapshotDescriptor& snapshot, Fun fun, bool isNewest) const;
 
@@ -23,6 +23,8 @@
 
 #include "Table.hpp"
 
+#include <util/PerfCounters.hpp>
+
 #include <config.h>
 
 #include <boost/config.hpp>
@@ -36,16 +38,28 @@ Table<Context>::Table(PageManager& pageManager, const crossbow::string& name, co
         uint64_t insertTableCapacity)
     : mPageManager(pageManager)
     , mTableName(name)
-    , mRecord(std::move(schema))
+    , mSchemas(schema)
     , mTableId(idx)
-    , mInsertTable(insertTableCapacity)
-    , mInsertLog(pageManager)
-    , mUpdateLog(pageManager)
-    , mMainTable(crossbow::allocator::construct<CuckooTable>(pageManager))
+    , mInsertTable(pageManager, MemoryTag(idx, MemoryCategory::INSERT_TABLE), insertTableCapacity)
+    , mInsertLog(pageManager, MemoryTag(idx, MemoryCategory::INSERT_LOG))
+    , mUpdateLog(pageManager, MemoryTag(idx, MemoryCategory::UPDATE_LOG))
+    , mMainTable(crossbow::allocator::construct<CuckooTable>(pageManager, MemoryTag(idx, MemoryCategory::HASH_TABLE)))
     , mPages(crossbow::allocator::construct<PageList>(mInsertLog.begin(), mUpdateLog.begin()))
-    , mContext(mPageManager, mRecord)
+    , mContext(mPageManager, mSchemas)
 {}
 
+template <typename Context>
+Table<Context>::Table(PageManager& pageManager, const crossbow::string& name, const SchemaHistory& schemas,
+        uint64_t idx, uint64_t insertTableCapacity)
+    : Table(pageManager, name, schemas.record(0u).schema(), idx, insertTableCapacity)
+{
+    auto newestVersion = schemas.newestVersion();
+    for (decltype(newestVersion) version = 1u; version <= newestVersion; ++version) {
+        __attribute__((unused)) auto res = mSchemas.addVersion(schemas.record(version).schema());
+        LOG_ASSERT(res == 0, "Schema version of an existing history is invalid");
+    }
+}
+
 template <typename Context>
 Table<Context>::~Table() {
     auto pageList = mPages.load();
@@ -61,30 +75,34 @@ Table<Context>::~Table() {
 
 template <typename Context>
 int Table<Context>::insert(uint64_t key, size_t size, const char* data,
-        const commitmanager::SnapshotDescriptor& snapshot) {
+        const commitmanager::SnapshotDescriptor& snapshot, uint32_t schemaVersion) {
+    if (schemaVersion > mSchemas.newestVersion()) {
+        return error::invalid_schema_change;
+    }
     int ec;
 
     // Check main
     auto mainTable = mMainTable.load();
     if (auto ptr = mainTable->get(key)) {
-        if (internalUpdate<MainRecord>(ptr, size, data, snapshot, RecordType::DELETE, RecordType::DATA, ec)) {
+        if (internalUpdate<MainRecord>(ptr, size, data, snapshot, RecordType::DELETE, RecordType::DATA,
+                schemaVersion, ec)) {
             return ec;
         }
     }
 
     // Check insert log
-    DynamicInsertTableEntry* insertList;
-    if (auto ptr = getFromInsert(key, &insertList)) {
-        if (internalUpdate<InsertRecord>(ptr, size, data, snapshot, RecordType::DELETE, RecordType::DATA, ec)) {
+    if (auto ptr = getFromInsert(key)) {
+        if (internalUpdate<InsertRecord>(ptr, size, data, snapshot, RecordType::DELETE, RecordType::DATA,
+                schemaVersion, ec)) {
             return ec;
         }
 
         // Try to remove the invalid insert record from the hash table and retry from the beginning
-        mInsertTable.remove(key, ptr, insertList);
+        mInsertTable.remove(key, ptr);
     }
 
     // Write into insert log
-    auto logEntry = mInsertLog.append(size + sizeof(InsertLogEntry));
+    auto logEntry = mInsertLog.append(size + sizeof(InsertLogEntry), logEntryType(RecordType::DATA, schemaVersion));
     if (!logEntry) {
         LOG_FATAL("Failed to append to log");
         return error::out_of_memory;
@@ -94,7 +112,7 @@ int Table<Context>::insert(uint64_t key, size_t size, const char* data,
 
     // Try to insert the element in the insert table
     // If the element changed it could be invalidate in the meantime
-    if (!mInsertTable.insert(key, insertEntry, insertList)) {
+    if (!mInsertTable.insert(key, insertEntry)) {
         insertEntry->newest.store(crossbow::to_underlying(NewestPointerTag::INVALID));
         mInsertLog.seal(logEntry);
         return error::not_in_snapshot;
@@ -107,10 +125,11 @@ int Table<Context>::insert(uint64_t key, size_t size, const char* data,
         // entries to be sealed. If the main record is invalid the insert has succeeded because it was already written
         // into the hash table.
         if (auto ptr = newMainTable->get(key)) {
-            if (internalUpdate<MainRecord>(ptr, size, data, snapshot, RecordType::DELETE, RecordType::DATA, ec)) {
+            if (internalUpdate<MainRecord>(ptr, size, data, snapshot, RecordType::DELETE, RecordType::DATA,
+                    schemaVersion, ec)) {
                 insertEntry->newest.store(crossbow::to_underlying(NewestPointerTag::INVALID));
                 mInsertLog.seal(logEntry);
-                mInsertTable.remove(key, insertEntry, insertList);
+                mInsertTable.remove(key, insertEntry);
                 return ec;
             }
         }
@@ -122,13 +141,17 @@ int Table<Context>::insert(uint64_t key, size_t size, const char* data,
 
 template <typename Context>
 int Table<Context>::update(uint64_t key, size_t size, const char* data,
-        const commitmanager::SnapshotDescriptor& snapshot) {
-    return genericUpdate(key, size, data, snapshot, RecordType::DATA);
+        const commitmanager::SnapshotDescriptor& snapshot, uint32_t schemaVersion) {
+    if (schemaVersion > mSchemas.newestVersion()) {
+        return error::invalid_schema_change;
+    }
+    return genericUpdate(key, size, data, snapshot, RecordType::DATA, schemaVersion);
 }
 
 template <typename Context>
 int Table<Context>::remove(uint64_t key, const commitmanager::SnapshotDescriptor& snapshot) {
-    return genericUpdate(key, 0, nullptr, snapshot, RecordType::DELETE);
+    // Deletes have no data so any schema version will do
+    return genericUpdate(key, 0, nullptr, snapshot, RecordType::DELETE, mSchemas.newestVersion());
 }
 
 template <typename Context>
@@ -168,20 +191,20 @@ int Table<Context>::revert(uint64_t key, const commitmanager::SnapshotDescriptor
 
 template <typename Context>
 int Table<Context>::genericUpdate(uint64_t key, size_t size, const char* data,
-        const commitmanager::SnapshotDescriptor& snapshot, RecordType newType) {
+        const commitmanager::SnapshotDescriptor& snapshot, RecordType newType, uint32_t schemaVersion) {
     int ec;
 
     // Check main
     auto mainTable = mMainTable.load();
     if (auto ptr = mainTable->get(key)) {
-        if (internalUpdate<MainRecord>(ptr, size, data, snapshot, RecordType::DATA, newType, ec)) {
+        if (internalUpdate<MainRecord>(ptr, size, data, snapshot, RecordType::DATA, newType, schemaVersion, ec)) {
             return ec;
         }
     }
 
     // Lookup in the insert hash table
     if (auto ptr = getFromInsert(key)) {
-        if (internalUpdate<InsertRecord>(ptr, size, data, snapshot, RecordType::DATA, newType, ec)) {
+        if (internalUpdate<InsertRecord>(ptr, size, data, snapshot, RecordType::DATA, newType, schemaVersion, ec)) {
             return ec;
         }
     }
@@ -192,7 +215,7 @@ int Table<Context>::genericUpdate(uint64_t key, size_t size, const char* data,
     auto newMainTable = mMainTable.load();
     if (newMainTable != mainTable) {
         if (auto ptr = newMainTable->get(key)) {
-            if (internalUpdate<MainRecord>(ptr, size, data, snapshot, RecordType::DATA, newType, ec)) {
+            if (internalUpdate<MainRecord>(ptr, size, data, snapshot, RecordType::DATA, newType, schemaVersion, ec)) {
                 return ec;
             }
         }
@@ -203,8 +226,8 @@ int Table<Context>::genericUpdate(uint64_t key, size_t size, const char* data,
 }
 
 template <typename Context>
-const InsertLogEntry* Table<Context>::getFromInsert(uint64_t key, DynamicInsertTableEntry** headList) const {
-    auto ptr = mInsertTable.get(key, headList);
+const InsertLogEntry* Table<Context>::getFromInsert(uint64_t key) const {
+    auto ptr = mInsertTable.get(key);
     if (!ptr) {
         return nullptr;
     }
@@ -217,30 +240,65 @@ const InsertLogEntry* Table<Context>::getFromInsert(uint64_t key, DynamicInsertT
     return reinterpret_cast<const InsertLogEntry*>(ptr);
 }
 
+template <typename Context>
+int Table<Context>::checkAlterTable(uint32_t schemaVersion, const Schema& schema) {
+    if (!Context::supportsSchemaChanges()) {
+        LOG_ERROR("%1% does not support schema changes", Context::implementationName());
+        return error::invalid_schema_change;
+    }
+
+    std::lock_guard<std::mutex> _(mSchemaMutex);
+    if (schemaVersion != mSchemas.newestVersion()) {
+        return error::invalid_schema_change;
+    }
+    return mSchemas.checkVersion(schema);
+}
+
+template <typename Context>
+int Table<Context>::alterTable(uint32_t schemaVersion, Schema schema) {
+    if (!Context::supportsSchemaChanges()) {
+        LOG_ERROR("%1% does not support schema changes", Context::implementationName());
+        return error::invalid_schema_change;
+    }
+
+    std::lock_guard<std::mutex> _(mSchemaMutex);
+    if (schemaVersion != mSchemas.newestVersion()) {
+        return error::invalid_schema_change;
+    }
+    return mSchemas.addVersion(std::move(schema));
+}
+
 template <typename Context>
 void Table<Context>::runGC(uint64_t minVersion) {
     LOG_TRACE("Starting garbage collection [minVersion = %1%]", minVersion);
 
-    crossbow::allocator _;
+    // Work is measured as the number of main pages cleaned and insert log entries merged into the main
+    PerfCounterScope counters(PerfCounterSource::GC);
+    uint64_t insertCount = 0u;
+
+    ReclamationGuard _;
     auto oldMainTable = mMainTable.load();
     auto mainTableModifier = oldMainTable->modifier();
 
-    PageModifier pageListModifier(mContext, mPageManager, mainTableModifier, minVersion);
+    // The schema history is only read when the modifier is created: Records containing tuples of a schema version added
+    // while the garbage collection is running are rewritten in that version
+    std::unique_lock<std::mutex> schemaLock(mSchemaMutex);
+    PageModifier pageListModifier(mContext, mPageManager, mTableId, mainTableModifier, minVersion);
+    schemaLock.unlock();
 
     auto pageList = crossbow::allocator::construct<PageList>();
     pageList->updateEnd = mUpdateLog.sealedEnd();
 
     std::vector<void*> obsoletePages;
+    std::vector<std::pair<uint64_t, const void*>> mergedInserts;
     auto oldPageList = mPages.load();
+    auto pageCount = oldPageList->pages.size();
     for (auto oldPage: oldPageList->pages) {
         if (pageListModifier.clean(oldPage)) {
             obsoletePages.emplace_back(oldPage);
         }
     }
 
-    // Allocate a new insert hash table head
-    auto insertHeadList = mInsertTable.allocateHead();
-
     auto insBegin = oldPageList->insertEnd;
     auto insEnd = mInsertLog.end();
 
@@ -252,9 +310,12 @@ void Table<Context>::runGC(uint64_t minVersion) {
         if (!insertRecord.valid()) {
             continue;
         }
+        ++insertCount;
 
-        if (!pageListModifier.append(insertRecord)) {
-            mInsertTable.remove(insertRecord.key(), insertRecord.value(), insertHeadList);
+        if (pageListModifier.append(insertRecord)) {
+            mergedInserts.emplace_back(insertRecord.key(), insertRecord.value());
+        } else {
+            mInsertTable.remove(insertRecord.key(), insertRecord.value());
         }
     }
     pageList->pages = pageListModifier.done();
@@ -268,21 +329,22 @@ void Table<Context>::runGC(uint64_t minVersion) {
     pageList->insertEnd = insEnd;
 
     mMainTable.store(mainTableModifier.done());
-    crossbow::allocator::destroy(oldMainTable);
-
     mPages.store(pageList);
-    crossbow::allocator::destroy(oldPageList);
 
-    // Free all obsolete pages from the old main using the epoch mechanism
-    auto& pageManager = mPageManager;
-    crossbow::allocator::invoke([obsoletePages, &pageManager]() {
-        for (auto page : obsoletePages) {
-            pageManager.free(page);
-        }
+    // Free the old structures and all obsolete pages from the old main as soon as the last reader left them
+    mPageManager.retire([oldMainTable, oldPageList] () {
+        crossbow::allocator::destroy_now(oldMainTable);
+        crossbow::allocator::destroy_now(oldPageList);
     });
+    mPageManager.retirePages(std::move(obsoletePages));
+
+    // Remove the inserts now reachable through the new main and size the insert table for the next interval
+    for (auto& insert : mergedInserts) {
+        mInsertTable.remove(insert.first, insert.second);
+    }
+    mInsertTable.resize(insertCount);
 
-    // Truncate the insert hash table and free all tables using the epoch mechanism
-    mInsertTable.truncate(insertHeadList);
+    counters.setWork(insertCount, pageCount);
 
     LOG_TRACE("Completing garbage collection");
 }
@@ -290,7 +352,8 @@ void Table<Context>::runGC(uint64_t minVersion) {
 template <typename Context>
 template <typename Rec>
 bool Table<Context>::internalUpdate(void* ptr, size_t size, const char* data,
-        const commitmanager::SnapshotDescriptor& snapshot, RecordType expectedType, RecordType newType, int& ec) {
+        const commitmanager::SnapshotDescriptor& snapshot, RecordType expectedType, RecordType newType,
+        uint32_t schemaVersion, int& ec) {
     Rec record(ptr, mContext);
     if (!record.valid()) {
         return false;
@@ -298,7 +361,7 @@ bool Table<Context>::internalUpdate(void* ptr, size_t size, const char* data,
 
     // Check if the entry was garbage collected: Follow link in case it is
     if (auto main = newestMainRecord(record.newest())) {
-        return internalUpdate<MainRecord>(main, size, data, snapshot, expectedType, newType, ec);
+        return internalUpdate<MainRecord>(main, size, data, snapshot, expectedType, newType, schemaVersion, ec);
     }
 
     LOG_ASSERT(record.newest() % 8 == crossbow::to_underlying(NewestPointerTag::UPDATE),
@@ -310,7 +373,7 @@ bool Table<Context>::internalUpdate(void* ptr, size_t size, const char* data,
     }
 
     // Write update
-    auto logEntry = mUpdateLog.append(size + sizeof(UpdateLogEntry), newType);
+    auto logEntry = mUpdateLog.append(size + sizeof(UpdateLogEntry), logEntryType(newType, schemaVersion));
     if (!logEntry) {
         LOG_FATAL("Failed to append to log");
         ec = error::out_of_memory;
@@ -328,7 +391,7 @@ bool Table<Context>::internalUpdate(void* ptr, size_t size, const char* data,
         // If the newest pointer points to a main record then the base was garbage collected in the meantime
         // Retry the write again on the new main record.
         if (auto main = newestMainRecord(record.newest())) {
-            return internalUpdate<MainRecord>(main, size, data, snapshot, expectedType, newType, ec);
+            return internalUpdate<MainRecord>(main, size, data, snapshot, expectedType, newType, schemaVersion, ec);
         }
 
         // Another update happened in the meantime
@@ -353,7 +416,7 @@ int Table<Context>::canUpdate(const Rec& record, const commitmanager::SnapshotDe
         auto entry = LogEntry::entryFromData(reinterpret_cast<const char*>(updateIter.value()));
 
         // Check if the entry can be written
-        return (entry->type() == expectedType ? 0 : error::invalid_write);
+        return (logEntryRecordType(entry) == expectedType ? 0 : error::invalid_write);
     }
 
     return record.canUpdate(updateIter.lowestVersion(), snapshot, expectedType);
@@ -405,7 +468,7 @@ bool Table<Context>::internalRevert(void* ptr, const commitmanager::SnapshotDesc
     }
 
     // Write update
-    auto logEntry = mUpdateLog.append(sizeof(UpdateLogEntry), RecordType::REVERT);
+    auto logEntry = mUpdateLog.append(sizeof(UpdateLogEntry), logEntryType(RecordType::REVERT, 0u));
     if (!logEntry) {
         LOG_FATAL("Failed to append to log");
         ec = error::out_of_memory;
@@ -31,6 +31,7 @@
 
 #include <util/CuckooHash.hpp>
 #include <util/Log.hpp>
+#include <util/SchemaHistory.hpp>
 
 #include <tellstore/ErrorCode.hpp>
 #include <tellstore/Record.hpp>
@@ -39,10 +40,12 @@
 
 #include <crossbow/allocator.hpp>
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <atomic>
 #include <functional>
+#include <mutex>
 
 namespace tell {
 namespace commitmanager {
@@ -70,18 +73,45 @@ public:
     Table(PageManager& pageManager, const crossbow::string& name, const Schema& schema, uint64_t idx,
             uint64_t insertTableCapacity);
 
+    /**
+     * @brief Creates an empty table with all schema versions of the given history
+     */
+    Table(PageManager& pageManager, const crossbow::string& name, const SchemaHistory& schemas, uint64_t idx,
+            uint64_t insertTableCapacity);
+
     ~Table();
 
     const crossbow::string& tableName() const {
         return mTableName;
     }
 
+    /**
+     * @brief Record of the newest schema version
+     */
     const Record& record() const {
-        return mRecord;
+        return mSchemas.newestRecord();
     }
 
     const Schema& schema() const {
-        return mRecord.schema();
+        return record().schema();
+    }
+
+    /**
+     * @brief Newest schema version of the table
+     */
+    uint32_t schemaVersion() const {
+        return mSchemas.newestVersion();
+    }
+
+    /**
+     * @brief Schema of the given schema version
+     */
+    const Schema& schema(uint32_t schemaVersion) const {
+        return mSchemas.record(schemaVersion).schema();
+    }
+
+    const SchemaHistory& schemas() const {
+        return mSchemas;
     }
 
     uint64_t tableId() const {
@@ -93,20 +123,67 @@ public:
     }
 
     TableType type() const {
-        return mRecord.schema().type();
+        return schema().type();
     }
 
     template <typename Fun>
     int get(uint64_t key, const commitmanager::SnapshotDescriptor& snapshot, Fun fun) const;
 
-    int insert(uint64_t key, size_t size, const char* data, const commitmanager::SnapshotDescriptor& snapshot);
+    /**
+     * @brief Reads a batch of keys with the same snapshot
+     *
+     * The keys are resolved in groups: The hash buckets, main records and newest update entries of all keys in a group
+     * are prefetched in separate passes before the first key of the group is resolved, overlapping the cache misses of
+     * the independent lookups.
+     *
+     * @param keys The keys to read
+     * @param count Number of keys
+     * @param snapshot Snapshot the keys are read in
+     * @param ec Array receiving the error code of every key
+     * @param fun Function called as fun(index, size, version, isNewest) for every key that was found
+     */
+    template <typename Fun>
+    void get(const uint64_t* keys, size_t count, const commitmanager::SnapshotDescriptor& snapshot, int* ec, Fun fun)
+            const;
 
-    int update(uint64_t key, size_t size, const char* data, const commitmanager::SnapshotDescriptor& snapshot);
+    /**
+     * @brief Inserts the tuple written in the given schema version
+     *
+     * The tuple keeps the schema version until the garbage collection rewrites it, so clients still using an older
+     * version of the table write tuples that are converted like any other tuple of that version.
+     *
+     * @return 0 or error::invalid_schema_change if the table does not know the schema version
+     */
+    int insert(uint64_t key, size_t size, const char* data, const commitmanager::SnapshotDescriptor& snapshot,
+            uint32_t schemaVersion);
+
+    /**
+     * @brief Updates the tuple with data written in the given schema version (see insert)
+     */
+    int update(uint64_t key, size_t size, const char* data, const commitmanager::SnapshotDescriptor& snapshot,
+            uint32_t schemaVersion);
 
     int remove(uint64_t key, const commitmanager::SnapshotDescriptor& snapshot);
 
     int revert(uint64_t key, const commitmanager::SnapshotDescriptor& snapshot);
 
+    /**
+     * @brief Checks if the schema can be added as successor of the given schema version without changing the table
+     *
+     * @return 0 or error::invalid_schema_change if the version is not the newest or the schema is no valid successor
+     */
+    int checkAlterTable(uint32_t schemaVersion, const Schema& schema);
+
+    /**
+     * @brief Adds the schema as successor of the given schema version
+     *
+     * Existing tuples are not touched: Reads convert tuples of older versions to the newest version and the garbage
+     * collection rewrites them in the newest version.
+     *
+     * @return 0 or error::invalid_schema_change if the version is not the newest or the schema is no valid successor
+     */
+    int alterTable(uint32_t schemaVersion, Schema schema);
+
     void runGC(uint64_t minVersion);
 
     /**
@@ -140,21 +217,47 @@ private:
         Log<OrderedLogImpl>::LogIterator updateEnd;
     };
 
-    const InsertLogEntry* getFromInsert(uint64_t key, DynamicInsertTableEntry** headList = nullptr) const;
+    /// Number of keys resolved together by the batched get
+    static constexpr size_t GET_BATCH_SIZE = 8u;
+
+    template <typename Fun>
+    int resolveGet(uint64_t key, const CuckooTable* mainTable, const void* mainPtr,
+            const commitmanager::SnapshotDescriptor& snapshot, Fun fun) const;
+
+    /**
+     * @brief Prefetches the newest update log entry of the main record if it has one
+     */
+    void prefetchNewest(const void* mainPtr) const;
+
+    const InsertLogEntry* getFromInsert(uint64_t key) const;
 
-    InsertLogEntry* getFromInsert(uint64_t key, DynamicInsertTableEntry** headList = nullptr) {
-        return const_cast<InsertLogEntry*>(const_cast<const Table<Context>*>(this)->getFromInsert(key, headList));
+    InsertLogEntry* getFromInsert(uint64_t key) {
+        return const_cast<InsertLogEntry*>(const_cast<const Table<Context>*>(this)->getFromInsert(key));
     }
 
     int genericUpdate(uint64_t key, size_t size, const char* data, const commitmanager::SnapshotDescriptor& snapshot,
-            RecordType type);
+            RecordType type, uint32_t schemaVersion);
 
     template <typename Rec, typename Fun>
     bool internalGet(const void* ptr, const commitmanager::SnapshotDescriptor& snapshot, Fun fun, int& ec) const;
 
+    /**
+     * @brief Reads the tuple from the record converted to the newest schema version
+     */
+    template <typename Rec, typename Fun>
+    int convertedGet(const Rec& record, uint64_t highestVersion, const commitmanager::SnapshotDescriptor& snapshot,
+            Fun fun, bool isNewest) const;
+
+    /**
+     * @brief Copies the tuple in the given schema version to the destination returned by fun in the newest version
+     */
+    template <typename Fun>
+    void readTuple(const char* data, size_t size, uint32_t schemaVersion, uint64_t version, bool isNewest, Fun& fun)
+            const;
+
     template <typename Rec>
     bool internalUpdate(void* ptr, size_t size, const char* data, const commitmanager::SnapshotDescriptor& snapshot,
-            RecordType expectedType, RecordType newType, int& ec);
+            RecordType expectedType, RecordType newType, uint32_t schemaVersion, int& ec);
 
     template <typename Rec>
     int canUpdate(const Rec& record, const commitmanager::SnapshotDescriptor& snapshot, RecordType expectedType);
@@ -165,9 +268,12 @@ private:
     PageManager& mPageManager;
 
     crossbow::string mTableName;
-    Record mRecord;
+    SchemaHistory mSchemas;
     uint64_t mTableId;
 
+    /// Serializes schema changes, the garbage collection only holds it while reading the schema history
+    std::mutex mSchemaMutex;
+
     DynamicInsertTable mInsertTable;
     Log<OrderedLogImpl> mInsertLog;
     Log<OrderedLogImpl> mUpdateLog;
@@ -180,12 +286,59 @@ private:
 template <typename Context>
 template <typename Fun>
 int Table<Context>::get(uint64_t key, const commitmanager::SnapshotDescriptor& snapshot, Fun fun) const {
+    auto mainTable = mMainTable.load();
+    return resolveGet(key, mainTable, mainTable->get(key), snapshot, std::move(fun));
+}
+
+template <typename Context>
+template <typename Fun>
+void Table<Context>::get(const uint64_t* keys, size_t count, const commitmanager::SnapshotDescriptor& snapshot,
+        int* ec, Fun fun) const {
+    const void* mainPtrs[GET_BATCH_SIZE];
+    for (size_t begin = 0; begin < count; begin += GET_BATCH_SIZE) {
+        auto end = std::min(count, begin + GET_BATCH_SIZE);
+        auto mainTable = mMainTable.load();
+
+        // Issue the loads for all hash buckets in the group
+        for (auto i = begin; i < end; ++i) {
+            mainTable->prefetch(keys[i]);
+            mInsertTable.prefetch(keys[i]);
+        }
+
+        // Lookup the main records and prefetch them
+        for (auto i = begin; i < end; ++i) {
+            auto ptr = mainTable->get(keys[i]);
+            if (ptr) {
+                __builtin_prefetch(ptr);
+            }
+            mainPtrs[i - begin] = ptr;
+        }
+
+        // Prefetch the head of the update history of every main record
+        for (auto i = begin; i < end; ++i) {
+            if (mainPtrs[i - begin]) {
+                prefetchNewest(mainPtrs[i - begin]);
+            }
+        }
+
+        for (auto i = begin; i < end; ++i) {
+            ec[i] = resolveGet(keys[i], mainTable, mainPtrs[i - begin], snapshot,
+                    [&fun, i] (size_t size, uint64_t version, bool isNewest) {
+                return fun(i, size, version, isNewest);
+            });
+        }
+    }
+}
+
+template <typename Context>
+template <typename Fun>
+int Table<Context>::resolveGet(uint64_t key, const CuckooTable* mainTable, const void* mainPtr,
+        const commitmanager::SnapshotDescriptor& snapshot, Fun fun) const {
     int ec;
 
     // Check main first
-    auto mainTable = mMainTable.load();
-    if (auto ptr = mainTable->get(key)) {
-        if (internalGet<ConstMainRecord>(ptr, snapshot, fun, ec)) {
+    if (mainPtr) {
+        if (internalGet<ConstMainRecord>(mainPtr, snapshot, fun, ec)) {
             return ec;
         }
     }
@@ -214,6 +367,16 @@ int Table<Context>::get(uint64_t key, const commitmanager::SnapshotDescriptor& s
     return error::not_found;
 }
 
+template <typename Context>
+void Table<Context>::prefetchNewest(const void* mainPtr) const {
+    ConstMainRecord record(mainPtr, mContext);
+    auto newest = record.newest();
+    if (newest != 0x0u && (newest & (crossbow::to_underlying(NewestPointerTag::MAIN)
+            | crossbow::to_underlying(NewestPointerTag::INVALID))) == 0x0u) {
+        __builtin_prefetch(reinterpret_cast<const void*>(newest));
+    }
+}
+
 template <typename Context>
 template <typename... Args>
 std::vector<std::unique_ptr<typename Table<Context>::ScanProcessor>> Table<Context>::Table::startScan(size_t numThreads,
@@ -230,8 +393,8 @@ std::vector<std::unique_ptr<typename Table<Context>::ScanProcessor>> Table<Conte
     for (decltype(numThreads) i = 0; i < numThreads; ++i) {
         const auto& startIter = (i == numThreads - 1 ? insIter : insEnd);
         auto endIdx = beginIdx + numPages / numThreads + (i < mod ? 1 : 0);
-        result.emplace_back(new ScanProcessor(mContext, mRecord, queries, pageList->pages, beginIdx, endIdx, startIter,
-                insEnd, std::forward<Args>(args)...));
+        result.emplace_back(new ScanProcessor(mContext, record(), queries, pageList->pages, beginIdx, endIdx,
+                startIter, insEnd, std::forward<Args>(args)...));
         beginIdx = endIdx;
     }
     return result;
@@ -262,24 +425,68 @@ bool Table<Context>::internalGet(const void* ptr, const commitmanager::SnapshotD
 
         // Check if the entry marks a deletion: Return element not found
         auto entry = LogEntry::entryFromData(reinterpret_cast<const char*>(updateIter.value()));
-        if (entry->type() == crossbow::to_underlying(RecordType::DELETE)) {
+        if (logEntryRecordType(entry) == RecordType::DELETE) {
             ec = (isNewest ? error::not_found : error::not_in_snapshot);
             return true;
         }
 
-        auto size = entry->size() - sizeof(UpdateLogEntry);
-        auto dest = fun(size, updateIter->version, isNewest);
-        memcpy(dest, updateIter->data(), size);
+        readTuple(updateIter->data(), entry->size() - sizeof(UpdateLogEntry), logEntrySchemaVersion(entry),
+                updateIter->version, isNewest, fun);
 
         ec = 0;
         return true;
     }
 
     // Lookup in base
-    ec = record.get(updateIter.lowestVersion(), snapshot, std::move(fun), isNewest);
+    if (record.schemaVersion() == mSchemas.newestVersion()) {
+        ec = record.get(updateIter.lowestVersion(), snapshot, std::move(fun), isNewest);
+    } else {
+        ec = convertedGet(record, updateIter.lowestVersion(), snapshot, std::move(fun), isNewest);
+    }
     return true;
 }
 
+template <typename Context>
+template <typename Rec, typename Fun>
+int Table<Context>::convertedGet(const Rec& record, uint64_t highestVersion,
+        const commitmanager::SnapshotDescriptor& snapshot, Fun fun, bool isNewest) const {
+    // Read the tuple into a temporary buffer first as the size of the converted tuple depends on the tuple
+    std::unique_ptr<char[]> buffer;
+    size_t bufferSize = 0u;
+    uint64_t bufferVersion = 0u;
+    bool bufferNewest = false;
+    auto ec = record.get(highestVersion, snapshot, [&buffer, &bufferSize, &bufferVersion, &bufferNewest]
+            (size_t size, uint64_t version, bool isNewest) {
+        buffer.reset(new char[size]);
+        bufferSize = size;
+        bufferVersion = version;
+        bufferNewest = isNewest;
+        return buffer.get();
+    }, isNewest);
+    if (ec != 0) {
+        return ec;
+    }
+
+    readTuple(buffer.get(), bufferSize, record.schemaVersion(), bufferVersion, bufferNewest, fun);
+    return 0;
+}
+
+template <typename Context>
+template <typename Fun>
+void Table<Context>::readTuple(const char* data, size_t size, uint32_t schemaVersion, uint64_t version,
+        bool isNewest, Fun& fun) const {
+    auto newestVersion = mSchemas.newestVersion();
+    if (schemaVersion == newestVersion) {
+        auto dest = fun(size, version, isNewest);
+        memcpy(dest, data, size);
+        return;
+    }
+
+    auto& converter = mSchemas.converter(schemaVersion, newestVersion);
+    auto dest = fun(converter.convertedSize(data), version, isNewest);
+    converter.convert(data, dest);
+}
+
 template <typename Context>
 class GarbageCollector {
 public:
@@ -27,6 +27,7 @@
 
 #include <tellstore/Record.hpp>
 #include <util/PageManager.hpp>
+#include <util/SchemaHistory.hpp>
 
 #include <crossbow/logger.hpp>
 
@@ -43,8 +44,8 @@ namespace tell {
 namespace store {
 namespace deltamain {
 
-ColumnMapContext::ColumnMapContext(const PageManager& pageManager, const Record& record)
-        : mRecord(record),
+ColumnMapContext::ColumnMapContext(const PageManager& pageManager, const SchemaHistory& schemas)
+        : mRecord(schemas.record(0u)),
           mPageData(reinterpret_cast<uintptr_t>(pageManager.data())),
           mHeaderSize(mRecord.headerSize()),
           mFixedSize(0u) {
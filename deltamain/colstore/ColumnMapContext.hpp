@@ -39,6 +39,7 @@ namespace store {
 
 class PageManager;
 class Record;
+class SchemaHistory;
 
 namespace deltamain {
 
@@ -92,6 +93,15 @@ public:
         return "Delta-Main Rewrite (Column Map)";
     }
 
+    /**
+     * @brief Whether the tables support adding and dropping fields
+     *
+     * The page layout and the generated materialization and scan functions are specific to the initial schema.
+     */
+    static constexpr bool supportsSchemaChanges() {
+        return false;
+    }
+
     /**
      * @brief Calculate the index of the given entry on the page
      */
@@ -99,7 +109,7 @@ public:
         return static_cast<uint32_t>(entry - page->entryData());
     }
 
-    ColumnMapContext(const PageManager& pageManager, const Record& record);
+    ColumnMapContext(const PageManager& pageManager, const SchemaHistory& schemas);
 
     const Record& record() const {
         return mRecord;
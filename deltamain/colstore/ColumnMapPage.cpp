@@ -64,10 +64,11 @@ ColumnMapMainPage::ColumnMapMainPage(const ColumnMapContext& context, uint32_t _
 }
 
 ColumnMapPageModifier::ColumnMapPageModifier(const ColumnMapContext& context, PageManager& pageManager,
-        Modifier& mainTableModifier, uint64_t minVersion)
+        uint64_t tableId, Modifier& mainTableModifier, uint64_t minVersion)
         : mContext(context),
           mRecord(mContext.record()),
           mPageManager(pageManager),
+          mTag(tableId, MemoryCategory::MAIN_PAGE),
           mMainTableModifier(mainTableModifier),
           mMinVersion(minVersion),
           mUpdateStartIdx(0u),
@@ -76,14 +77,14 @@ ColumnMapPageModifier::ColumnMapPageModifier(const ColumnMapContext& context, Pa
           mFillEndIdx(0u),
           mFillIdx(0u),
           mFillSize(0u) {
-    auto page = mPageManager.alloc();
+    auto page = mPageManager.alloc(mTag);
     if (!page) {
         LOG_ERROR("PageManager ran out of space");
         std::terminate();
     }
     mUpdatePage = new (page) ColumnMapMainPage(mContext, mContext.staticCapacity());
 
-    page = mPageManager.alloc();
+    page = mPageManager.alloc(mTag);
     if (!page) {
         LOG_ERROR("PageManager ran out of space");
         std::terminate();
@@ -447,7 +448,7 @@ bool ColumnMapPageModifier::processUpdates(const UpdateLogEntry* newest, uint64_
         // delete can be discarded. In this case the update index counter can simply be decremented by one as a
         // delete only writes the header entry in the fill page.
         if (wasDelete) {
-            LOG_ASSERT(logEntry->type() == crossbow::to_underlying(RecordType::DATA),
+            LOG_ASSERT(logEntryRecordType(logEntry) == RecordType::DATA,
                     "Only data entry can follow a delete");
             LOG_ASSERT(mUpdateIdx > mUpdateEndIdx, "Was delete but no element written");
             if (updateIter->version < mMinVersion) {
@@ -459,7 +460,7 @@ bool ColumnMapPageModifier::processUpdates(const UpdateLogEntry* newest, uint64_
             }
         }
 
-        if (logEntry->type() == crossbow::to_underlying(RecordType::DELETE)) {
+        if (logEntryRecordType(logEntry) == RecordType::DELETE) {
             // The entry this entry marks as deleted can not be read, skip deletion and break
             if (updateIter->version <= mMinVersion) {
                 break;
@@ -494,7 +495,7 @@ void ColumnMapPageModifier::writeUpdate(const UpdateLogEntry* entry) {
     auto logEntry = LogEntry::entryFromData(reinterpret_cast<const char*>(entry));
 
     // Everything stays zero initialized when the entry marks a deletion
-    if (logEntry->type() != crossbow::to_underlying(RecordType::DELETE)) {
+    if (logEntryRecordType(logEntry) != RecordType::DELETE) {
         // Write data into update page
         writeData(entry->data(), logEntry->size() - sizeof(UpdateLogEntry));
     } else {
@@ -597,7 +598,7 @@ void ColumnMapPageModifier::flush() {
         mUpdateIdx = 0u;
     }
 
-    auto page = mPageManager.alloc();
+    auto page = mPageManager.alloc(mTag);
     if (!page) {
         LOG_ERROR("PageManager ran out of space");
         std::terminate();
@@ -228,8 +228,8 @@ struct alignas(8) ColumnMapMainPage {
  */
 class ColumnMapPageModifier {
 public:
-    ColumnMapPageModifier(const ColumnMapContext& context, PageManager& pageManager, Modifier& mainTableModifier,
-            uint64_t minVersion);
+    ColumnMapPageModifier(const ColumnMapContext& context, PageManager& pageManager, uint64_t tableId,
+            Modifier& mainTableModifier, uint64_t minVersion);
 
     /**
      * @brief Rewrite and clean the page from garbage
@@ -362,6 +362,9 @@ private:
 
     PageManager& mPageManager;
 
+    /// Owner and category the main pages are accounted to
+    MemoryTag mTag;
+
     Modifier& mMainTableModifier;
 
     uint64_t mMinVersion;
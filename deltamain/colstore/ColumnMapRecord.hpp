@@ -70,6 +70,15 @@ public:
         return mEntry->version;
     }
 
+    /**
+     * @brief Schema version of the record
+     *
+     * The column map does not support schema changes, all records are stored in the initial schema version.
+     */
+    uint32_t schemaVersion() const {
+        return 0u;
+    }
+
     template <typename Fun>
     int get(uint64_t highestVersion, const commitmanager::SnapshotDescriptor& snapshot, Fun fun, bool isNewest) const;
 
@@ -135,6 +135,7 @@ ColumnMapScanProcessor::ColumnMapScanProcessor(const ColumnMapContext& context,
 }
 
 void ColumnMapScanProcessor::process() {
+    mPageCount += pageEndIdx - pageIdx;
     for (auto i = pageIdx; i < pageEndIdx; ++i) {
         processMainPage(pages[i], 0, pages[i]->count);
     }
@@ -313,6 +314,7 @@ void ColumnMapScanProcessor::evaluateMainQueries(const ColumnMapMainPage* page,
     LOG_ASSERT(mValidFromData.size() == page->count, "Size of valid-from array does not match the page size");
     LOG_ASSERT(mValidToData.size() == page->count, "Size of valid-to array does not match the page size");
 
+    mTupleCount += endIdx - startIdx;
     mColumnScanFun(&mKeyData.front(), &mValidFromData.front(), &mValidToData.front(),
             reinterpret_cast<const char*>(page), startIdx, endIdx, &mResult.front());
 
@@ -356,7 +358,7 @@ uint64_t ColumnMapScanProcessor::processUpdateRecord(const UpdateLogEntry* ptr,
         auto entry = LogEntry::entryFromData(reinterpret_cast<const char*>(updateIter.value()));
 
         // Check if the entry marks a deletion: Skip element
-        if (entry->type() == crossbow::to_underlying(RecordType::DELETE)) {
+        if (logEntryRecordType(entry) == RecordType::DELETE) {
             validTo = updateIter->version;
             continue;
         }
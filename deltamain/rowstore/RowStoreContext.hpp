@@ -31,7 +31,7 @@ namespace tell {
 namespace store {
 
 class PageManager;
-class Record;
+class SchemaHistory;
 
 namespace deltamain {
 
@@ -48,8 +48,23 @@ public:
         return "Delta-Main Rewrite (Row Store)";
     }
 
-    RowStoreContext(const PageManager& /* pageManager */, const Record& /* record */) {
+    /**
+     * @brief Whether the tables support adding and dropping fields
+     */
+    static constexpr bool supportsSchemaChanges() {
+        return true;
     }
+
+    RowStoreContext(const PageManager& /* pageManager */, const SchemaHistory& schemas)
+            : mSchemas(schemas) {
+    }
+
+    const SchemaHistory& schemas() const {
+        return mSchemas;
+    }
+
+private:
+    const SchemaHistory& mSchemas;
 };
 
 } // namespace deltamain
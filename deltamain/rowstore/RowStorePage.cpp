@@ -23,13 +23,18 @@
 
 #include "RowStorePage.hpp"
 
+#include "RowStoreContext.hpp"
+
 #include <config.h>
 #include <util/CuckooHash.hpp>
 #include <util/Log.hpp>
 #include <util/PageManager.hpp>
+#include <util/SchemaHistory.hpp>
 
 #include <crossbow/logger.hpp>
 
+#include <algorithm>
+
 namespace tell {
 namespace store {
 namespace deltamain {
@@ -39,17 +44,18 @@ constexpr uint32_t MAX_DATA_SIZE = TELL_PAGE_SIZE - sizeof(RowStoreMainPage);
 
 } // anonymous namespace
 
-bool RowStoreMainPage::needsCleaning(uint64_t minVersion) const {
+bool RowStoreMainPage::needsCleaning(uint64_t minVersion, uint32_t schemaVersion) const {
     for (auto& ptr : *this) {
         ConstRowStoreRecord record(&ptr);
-        if (record.needsCleaning(minVersion)) {
+        if (record.needsCleaning(minVersion, schemaVersion)) {
             return true;
         }
     }
     return false;
 }
 
-RowStoreMainEntry* RowStoreMainPage::append(uint64_t key, const std::vector<RecordHolder>& elements) {
+RowStoreMainEntry* RowStoreMainPage::append(uint64_t key, uint32_t schemaVersion,
+        const std::vector<RecordHolder>& elements) {
     static_assert(std::is_standard_layout<RowStoreMainEntry>::value, "Record class must be a POD");
 
     auto recordSize = RowStoreMainEntry::serializedSize(elements);
@@ -57,7 +63,7 @@ RowStoreMainEntry* RowStoreMainPage::append(uint64_t key, const std::vector<Reco
         return nullptr;
     }
 
-    auto ptr = RowStoreMainEntry::serialize(data() + mOffset, key, elements);
+    auto ptr = RowStoreMainEntry::serialize(data() + mOffset, key, schemaVersion, elements);
     mOffset += recordSize;
     return ptr;
 }
@@ -76,8 +82,19 @@ RowStoreMainEntry* RowStoreMainPage::append(const RowStoreMainEntry* record) {
     return ptr;
 }
 
+RowStorePageModifier::RowStorePageModifier(const RowStoreContext& context, PageManager& pageManager, uint64_t tableId,
+        Modifier& mainTableModifier, uint64_t minVersion)
+        : mPageManager(pageManager),
+          mTag(tableId, MemoryCategory::MAIN_PAGE),
+          mMainTableModifier(mainTableModifier),
+          mMinVersion(minVersion),
+          mSchemas(context.schemas()),
+          mSchemaVersion(mSchemas.newestVersion()),
+          mFillPage(nullptr) {
+}
+
 bool RowStorePageModifier::clean(RowStoreMainPage* page) {
-    if (!page->needsCleaning(mMinVersion)) {
+    if (!page->needsCleaning(mMinVersion, mSchemaVersion)) {
         mPageList.emplace_back(page);
         return false;
     }
@@ -88,7 +105,7 @@ bool RowStorePageModifier::clean(RowStoreMainPage* page) {
                 "Newest pointer must point to untagged update record");
 
         RowStoreMainEntry* newEntry;
-        if (!oldRecord.needsCleaning(mMinVersion)) {
+        if (!oldRecord.needsCleaning(mMinVersion, mSchemaVersion)) {
             newEntry = internalAppend([this, &oldRecord] () {
                 return mFillPage->append(oldRecord.value());
             });
@@ -100,10 +117,13 @@ bool RowStorePageModifier::clean(RowStoreMainPage* page) {
             }
 
             // Append to page
-            newEntry = internalAppend([this, &oldRecord] () {
-                return mFillPage->append(oldRecord.key(), mElements);
+            auto schemaVersion = convertElements();
+            newEntry = internalAppend([this, &oldRecord, schemaVersion] () {
+                return mFillPage->append(oldRecord.key(), schemaVersion, mElements);
             });
             mElements.clear();
+            mElementVersions.clear();
+            mConvertedElements.clear();
         }
         recycleEntry(oldRecord, newEntry, true);
     }
@@ -117,10 +137,13 @@ bool RowStorePageModifier::append(InsertRecord& oldRecord) {
     }
 
     // Append to page
-    auto newRecord = internalAppend([this, &oldRecord] () {
-        return mFillPage->append(oldRecord.key(), mElements);
+    auto schemaVersion = convertElements();
+    auto newRecord = internalAppend([this, &oldRecord, schemaVersion] () {
+        return mFillPage->append(oldRecord.key(), schemaVersion, mElements);
     });
     mElements.clear();
+    mElementVersions.clear();
+    mConvertedElements.clear();
 
     recycleEntry(oldRecord, newRecord, false);
 
@@ -135,6 +158,7 @@ bool RowStorePageModifier::collectElements(Rec& rec) {
         for (; !updateIter.done(); updateIter.next()) {
             auto entry = LogEntry::entryFromData(reinterpret_cast<const char*>(updateIter.value()));
             mElements.emplace_back(updateIter->version, updateIter->data(), entry->size() - sizeof(UpdateLogEntry));
+            mElementVersions.emplace_back(logEntrySchemaVersion(entry));
 
             // Check if the element is already the oldest readable element
             if (updateIter->version <= mMinVersion) {
@@ -144,10 +168,12 @@ bool RowStorePageModifier::collectElements(Rec& rec) {
 
         // Collect elements from record
         rec.collect(mMinVersion, updateIter.lowestVersion(), mElements);
+        mElementVersions.resize(mElements.size(), rec.schemaVersion());
 
         // Remove last element if it is a delete
         if (!mElements.empty() && mElements.back().size == 0u) {
             mElements.pop_back();
+            mElementVersions.pop_back();
         }
 
         // Invalidate record if the record has no valid elements
@@ -163,6 +189,30 @@ bool RowStorePageModifier::collectElements(Rec& rec) {
     }
 }
 
+uint32_t RowStorePageModifier::convertElements() {
+    // Tuples written in a schema version added after the modifier was created can not be converted back
+    auto schemaVersion = mSchemaVersion;
+    for (auto elementVersion : mElementVersions) {
+        schemaVersion = std::max(schemaVersion, elementVersion);
+    }
+
+    for (size_t i = 0; i < mElements.size(); ++i) {
+        auto& element = mElements[i];
+
+        // Deletes do not have any data to convert
+        if (mElementVersions[i] == schemaVersion || element.size == 0u) {
+            continue;
+        }
+
+        auto& converter = mSchemas.converter(mElementVersions[i], schemaVersion);
+        std::unique_ptr<char[]> data(new char[converter.convertedSize(element.data)]);
+        element.size = converter.convert(element.data, data.get());
+        element.data = data.get();
+        mConvertedElements.emplace_back(std::move(data));
+    }
+    return schemaVersion;
+}
+
 template <typename Rec>
 void RowStorePageModifier::recycleEntry(Rec& oldRecord, RowStoreMainEntry* newRecord, bool replace) {
     LOG_ASSERT(newRecord != nullptr, "Can not recycle an old record to null");
@@ -179,7 +229,7 @@ void RowStorePageModifier::recycleEntry(Rec& oldRecord, RowStoreMainEntry* newRe
 template <typename Fun>
 RowStoreMainEntry* RowStorePageModifier::internalAppend(Fun fun) {
     if (!mFillPage) {
-        auto page = mPageManager.alloc();
+        auto page = mPageManager.alloc(mTag);
         if (!page) {
             LOG_ERROR("PageManager ran out of space");
             std::terminate();
@@ -192,7 +242,7 @@ RowStoreMainEntry* RowStorePageModifier::internalAppend(Fun fun) {
         return newRecord;
     }
 
-    auto page = mPageManager.alloc();
+    auto page = mPageManager.alloc(mTag);
     if (!page) {
         LOG_ERROR("PageManager ran out of space");
         std::terminate();
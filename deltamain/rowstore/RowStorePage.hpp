@@ -30,6 +30,7 @@
 #include <commitmanager/SnapshotDescriptor.hpp>
 
 #include <cstdint>
+#include <memory>
 #include <type_traits>
 #include <vector>
 
@@ -38,6 +39,7 @@ namespace store {
 
 class Modifier;
 class PageManager;
+class SchemaHistory;
 
 namespace deltamain {
 
@@ -119,9 +121,9 @@ public:
         return cend();
     }
 
-    bool needsCleaning(uint64_t minVersion) const;
+    bool needsCleaning(uint64_t minVersion, uint32_t schemaVersion) const;
 
-    RowStoreMainEntry* append(uint64_t key, const std::vector<RecordHolder>& elements);
+    RowStoreMainEntry* append(uint64_t key, uint32_t schemaVersion, const std::vector<RecordHolder>& elements);
 
     RowStoreMainEntry* append(const RowStoreMainEntry* record);
 
@@ -139,13 +141,8 @@ private:
 
 class RowStorePageModifier {
 public:
-    RowStorePageModifier(const RowStoreContext& /* context */, PageManager& pageManager, Modifier& mainTableModifier,
-            uint64_t minVersion)
-            : mPageManager(pageManager),
-              mMainTableModifier(mainTableModifier),
-              mMinVersion(minVersion),
-              mFillPage(nullptr) {
-    }
+    RowStorePageModifier(const RowStoreContext& context, PageManager& pageManager, uint64_t tableId,
+            Modifier& mainTableModifier, uint64_t minVersion);
 
     bool clean(RowStoreMainPage* page);
 
@@ -159,6 +156,13 @@ private:
     template <typename Rec>
     bool collectElements(Rec& rec);
 
+    /**
+     * @brief Converts all collected elements to the newest schema version of the elements and the modifier
+     *
+     * @return The schema version of the converted elements
+     */
+    uint32_t convertElements();
+
     template <typename Rec>
     void recycleEntry(Rec& oldRecord, RowStoreMainEntry* newRecord, bool replace);
 
@@ -167,15 +171,29 @@ private:
 
     PageManager& mPageManager;
 
+    /// Owner and category the main pages are accounted to
+    MemoryTag mTag;
+
     Modifier& mMainTableModifier;
 
     uint64_t mMinVersion;
 
+    const SchemaHistory& mSchemas;
+
+    /// Schema version all records are rewritten to (unless they contain tuples of a version added in the meantime)
+    uint32_t mSchemaVersion;
+
     std::vector<RowStoreMainPage*> mPageList;
 
     RowStoreMainPage* mFillPage;
 
     std::vector<RecordHolder> mElements;
+
+    /// Schema version of every collected element
+    std::vector<uint32_t> mElementVersions;
+
+    /// Buffers holding the converted elements
+    std::vector<std::unique_ptr<char[]>> mConvertedElements;
 };
 
 } // namespace deltamain
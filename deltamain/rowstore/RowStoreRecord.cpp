@@ -29,8 +29,9 @@ namespace tell {
 namespace store {
 namespace deltamain {
 
-RowStoreMainEntry* RowStoreMainEntry::serialize(void* ptr, uint64_t key, const std::vector<RecordHolder>& elements) {
-    auto entry = new (ptr) RowStoreMainEntry(key, elements.size());
+RowStoreMainEntry* RowStoreMainEntry::serialize(void* ptr, uint64_t key, uint32_t schemaVersion,
+        const std::vector<RecordHolder>& elements) {
+    auto entry = new (ptr) RowStoreMainEntry(key, elements.size(), schemaVersion);
 
     auto versions = entry->versionData();
     auto offsets = entry->offsetData();
@@ -50,15 +51,15 @@ RowStoreMainEntry* RowStoreMainEntry::serialize(void* ptr, const RowStoreMainEnt
     // Can not copy the complete record at once as the next field can be modified in the meantime
     // First create a new header and then copy all immutable data fields.
     auto offsets = oldEntry->offsetData();
-    auto entry = new (ptr) RowStoreMainEntry(oldEntry->key, oldEntry->versionCount);
+    auto entry = new (ptr) RowStoreMainEntry(oldEntry->key, oldEntry->versionCount, oldEntry->schemaVersion);
     memcpy(entry->data(), oldEntry->data(), offsets[oldEntry->versionCount] - sizeof(RowStoreMainEntry));
     return entry;
 }
 
 template <typename T>
-bool RowStoreRecordImpl<T>::needsCleaning(uint64_t minVersion) const {
-    // In case the record has pending updates it needs to be cleaned
-    if (mNewest != 0u) {
+bool RowStoreRecordImpl<T>::needsCleaning(uint64_t minVersion, uint32_t schemaVersion) const {
+    // In case the record has pending updates or an old schema version it needs to be cleaned
+    if (mNewest != 0u || mEntry->schemaVersion != schemaVersion) {
         return true;
     }
     // If only one version is in the record it does not need cleaning
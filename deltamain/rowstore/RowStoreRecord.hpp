@@ -67,13 +67,15 @@ struct alignas(8) RowStoreMainEntry {
         return size;
     }
 
-    static RowStoreMainEntry* serialize(void* ptr, uint64_t key, const std::vector<RecordHolder>& elements);
+    static RowStoreMainEntry* serialize(void* ptr, uint64_t key, uint32_t schemaVersion,
+            const std::vector<RecordHolder>& elements);
 
     static RowStoreMainEntry* serialize(void* ptr, const RowStoreMainEntry* oldEntry, uint32_t oldSize);
 
-    RowStoreMainEntry(uint64_t k, uint64_t vc)
+    RowStoreMainEntry(uint64_t k, uint32_t vc, uint32_t sv)
             : key(k),
               versionCount(vc),
+              schemaVersion(sv),
               newest(0x0u) {
     }
 
@@ -94,7 +96,11 @@ struct alignas(8) RowStoreMainEntry {
     }
 
     const uint64_t key;
-    const uint64_t versionCount;
+    const uint32_t versionCount;
+
+    /// Schema version all elements of the entry are stored in
+    const uint32_t schemaVersion;
+
     std::atomic<uintptr_t> newest;
 
 private:
@@ -135,10 +141,19 @@ public:
         return mEntry->versionData()[0];
     }
 
+    uint32_t schemaVersion() const {
+        return mEntry->schemaVersion;
+    }
+
     template <typename Fun>
     int get(uint64_t highestVersion, const commitmanager::SnapshotDescriptor& snapshot, Fun fun, bool isNewest) const;
 
-    bool needsCleaning(uint64_t minVersion) const;
+    /**
+     * @brief Whether the record has to be rewritten by the garbage collection
+     *
+     * Records not stored in the newest schema version are always rewritten.
+     */
+    bool needsCleaning(uint64_t minVersion, uint32_t schemaVersion) const;
 
     void collect(uint64_t minVersion, uint64_t highestVersion, std::vector<RecordHolder>& elements) const;
 
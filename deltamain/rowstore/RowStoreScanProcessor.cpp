@@ -29,32 +29,45 @@
 #include <deltamain/Record.hpp>
 #include <deltamain/Table.hpp>
 
+#include <util/SchemaHistory.hpp>
+
 namespace tell {
 namespace store {
 namespace deltamain {
 
 RowStoreScan::RowStoreScan(Table<RowStoreContext>* table, std::vector<ScanQuery*> queries)
-        : LLVMRowScanBase(table->record(), std::move(queries)),
-          mTable(table) {
+        : RowStoreScan(table, table->schemas().newestVersion(), std::move(queries)) {
+}
+
+RowStoreScan::RowStoreScan(Table<RowStoreContext>* table, uint32_t schemaVersion, std::vector<ScanQuery*> queries)
+        : LLVMRowScanBase(table->schemas().record(schemaVersion), std::move(queries)),
+          mTable(table),
+          mSchemaVersion(schemaVersion) {
 }
 
 std::vector<std::unique_ptr<RowStoreScanProcessor>> RowStoreScan::startScan(size_t numThreads) {
-    return mTable->startScan(numThreads, mQueries, mRowScanFun, mRowMaterializeFuns, mScanAst.numConjunct);
+    return mTable->startScan(numThreads, mQueries, mSchemaVersion, mRowScanFun, mRowMaterializeFuns,
+            mScanAst.numConjunct);
 }
 
-RowStoreScanProcessor::RowStoreScanProcessor(const RowStoreContext& /* context */, const Record& record,
+RowStoreScanProcessor::RowStoreScanProcessor(const RowStoreContext& context, const Record& /* record */,
         const std::vector<ScanQuery*>& queries, const PageList& pages, size_t pageIdx, size_t pageEndIdx,
-        const LogIterator& logIter, const LogIterator& logEnd, RowStoreScan::RowScanFun rowScanFun,
-        const std::vector<RowStoreScan::RowMaterializeFun>& rowMaterializeFuns, uint32_t numConjuncts)
-        : LLVMRowScanProcessorBase(record, queries, rowScanFun, rowMaterializeFuns, numConjuncts),
+        const LogIterator& logIter, const LogIterator& logEnd, uint32_t schemaVersion,
+        RowStoreScan::RowScanFun rowScanFun, const std::vector<RowStoreScan::RowMaterializeFun>& rowMaterializeFuns,
+        uint32_t numConjuncts)
+        : LLVMRowScanProcessorBase(context.schemas().record(schemaVersion), queries, rowScanFun, rowMaterializeFuns,
+                numConjuncts),
           pages(pages),
           pageIdx(pageIdx),
           pageEndIdx(pageEndIdx),
           logIter(logIter),
-          logEnd(logEnd) {
+          logEnd(logEnd),
+          mSchemas(context.schemas()),
+          mSchemaVersion(schemaVersion) {
 }
 
 void RowStoreScanProcessor::process() {
+    mPageCount += pageEndIdx - pageIdx;
     for (auto i = pageIdx; i < pageEndIdx; ++i) {
         for (auto& ptr : *pages[i]) {
             processMainRecord(&ptr);
@@ -103,7 +116,7 @@ void RowStoreScanProcessor::processMainRecord(const RowStoreMainEntry* ptr) {
         }
 
         auto data = reinterpret_cast<const char*>(ptr) + offsets[i];
-        processRowRecord(ptr->key, versions[i], validTo, data, sz);
+        processTuple(ptr->key, versions[i], validTo, data, sz, ptr->schemaVersion);
         validTo = versions[i];
     }
 }
@@ -131,7 +144,8 @@ void RowStoreScanProcessor::processInsertRecord(const InsertLogEntry* ptr) {
     }
 
     auto entry = LogEntry::entryFromData(reinterpret_cast<const char*>(ptr));
-    processRowRecord(ptr->key, ptr->version, validTo, ptr->data(), entry->size() - sizeof(InsertLogEntry));
+    processTuple(ptr->key, ptr->version, validTo, ptr->data(), entry->size() - sizeof(InsertLogEntry),
+            logEntrySchemaVersion(entry));
 }
 
 uint64_t RowStoreScanProcessor::processUpdateRecord(const UpdateLogEntry* ptr, uint64_t baseVersion,
@@ -141,18 +155,37 @@ uint64_t RowStoreScanProcessor::processUpdateRecord(const UpdateLogEntry* ptr, u
         auto entry = LogEntry::entryFromData(reinterpret_cast<const char*>(updateIter.value()));
 
         // Check if the entry marks a deletion: Skip element
-        if (entry->type() == crossbow::to_underlying(RecordType::DELETE)) {
+        if (logEntryRecordType(entry) == RecordType::DELETE) {
             validTo = updateIter->version;
             continue;
         }
 
-        processRowRecord(updateIter->key, updateIter->version, validTo, updateIter->data(),
-                entry->size() - sizeof(UpdateLogEntry));
+        processTuple(updateIter->key, updateIter->version, validTo, updateIter->data(),
+                entry->size() - sizeof(UpdateLogEntry), logEntrySchemaVersion(entry));
         validTo = updateIter->version;
     }
     return updateIter.lowestVersion();
 }
 
+void RowStoreScanProcessor::processTuple(uint64_t key, uint64_t version, uint64_t validTo, const char* data,
+        uint32_t size, uint32_t schemaVersion) {
+    if (schemaVersion == mSchemaVersion) {
+        processRowRecord(key, version, validTo, data, size);
+        return;
+    }
+
+    // Tuples written in a schema version newer than the scan were written after the scan started and can not be
+    // in its snapshot
+    if (schemaVersion > mSchemaVersion) {
+        return;
+    }
+
+    auto& converter = mSchemas.converter(schemaVersion, mSchemaVersion);
+    mConvertBuffer.resize(converter.convertedSize(data));
+    auto convertedSize = converter.convert(data, mConvertBuffer.data());
+    processRowRecord(key, version, validTo, mConvertBuffer.data(), convertedSize);
+}
+
 } // namespace deltamain
 } // namespace store
 } // namespace tell
@@ -36,6 +36,7 @@ namespace tell {
 namespace store {
 
 class Record;
+class SchemaHistory;
 
 namespace deltamain {
 
@@ -63,7 +64,12 @@ public:
     std::vector<std::unique_ptr<RowStoreScanProcessor>> startScan(size_t numThreads);
 
 private:
+    RowStoreScan(Table<RowStoreContext>* table, uint32_t schemaVersion, std::vector<ScanQuery*> queries);
+
     Table<RowStoreContext>* mTable;
+
+    /// Schema version the scan was generated for
+    uint32_t mSchemaVersion;
 };
 
 class RowStoreScanProcessor : public LLVMRowScanProcessorBase {
@@ -73,12 +79,18 @@ public:
 
     RowStoreScanProcessor(const RowStoreContext& context, const Record& record, const std::vector<ScanQuery*>& queries,
             const PageList& pages, size_t pageIdx, size_t pageEndIdx, const LogIterator& logIter,
-            const LogIterator& logEnd, RowStoreScan::RowScanFun rowScanFun,
+            const LogIterator& logEnd, uint32_t schemaVersion, RowStoreScan::RowScanFun rowScanFun,
             const std::vector<RowStoreScan::RowMaterializeFun>& rowMaterializeFuns, uint32_t numConjuncts);
 
     void process();
 
 private:
+    /**
+     * @brief Processes the tuple after converting it to the schema version of the scan
+     */
+    void processTuple(uint64_t key, uint64_t version, uint64_t validTo, const char* data, uint32_t size,
+            uint32_t schemaVersion);
+
     void processMainRecord(const RowStoreMainEntry* ptr);
 
     void processInsertRecord(const InsertLogEntry* ptr);
@@ -90,6 +102,12 @@ private:
     size_t pageEndIdx;
     LogIterator logIter;
     LogIterator logEnd;
+
+    const SchemaHistory& mSchemas;
+    uint32_t mSchemaVersion;
+
+    /// Buffer holding the converted tuple
+    std::vector<char> mConvertBuffer;
 };
 
 } // namespace deltamain
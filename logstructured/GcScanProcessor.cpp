@@ -107,6 +107,7 @@ void GcScanProcessor::process() {
     if (mPageIt == mPageEnd) {
         return;
     }
+    ++mPageCount;
 
     // Advance to the next page if the first page contains no entries
     if (mEntryIt == mEntryEnd && !advancePage()) {
@@ -205,6 +206,7 @@ bool GcScanProcessor::advancePage() {
         if (mPageIt == mPageEnd) {
             return false;
         }
+        ++mPageCount;
         mEntryIt = mPageIt->begin();
         mEntryEnd = mPageIt->end();
 
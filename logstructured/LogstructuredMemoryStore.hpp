@@ -30,6 +30,9 @@
 #include <util/TableManager.hpp>
 #include <util/VersionManager.hpp>
 
+#include <tellstore/ErrorCode.hpp>
+
+#include <crossbow/logger.hpp>
 #include <crossbow/non_copyable.hpp>
 #include <crossbow/string.hpp>
 
@@ -67,6 +70,34 @@ public:
         return mTableManager.createTable(name, schema, idx, mVersionManager, mHashMap);
     }
 
+    /**
+     * @brief Schema changes are not supported: The log entries do not record the schema version of their tuple
+     */
+    int checkAlterTable(uint64_t /* tableId */, uint32_t /* schemaVersion */, const Schema& /* schema */) {
+        LOG_ERROR("%1% does not support schema changes", implementationName());
+        return error::invalid_schema_change;
+    }
+
+    int alterTable(uint64_t tableId, uint32_t schemaVersion, const Schema& schema) {
+        return checkAlterTable(tableId, schemaVersion, schema);
+    }
+
+    /**
+     * @brief Dropping tables is not supported: The hash map is shared by all tables and would still reference the log
+     */
+    int dropTable(uint64_t /* tableId */) {
+        LOG_ERROR("%1% does not support dropping tables", implementationName());
+        return error::unsupported_operation;
+    }
+
+    /**
+     * @brief Truncating tables is not supported: The hash map is shared by all tables and would still reference the log
+     */
+    int truncateTable(uint64_t /* tableId */) {
+        LOG_ERROR("%1% does not support truncating tables", implementationName());
+        return error::unsupported_operation;
+    }
+
     std::vector<const Table*> getTables() const {
         return mTableManager.getTables();
     }
@@ -84,14 +115,20 @@ public:
         return mTableManager.get(tableId, key, snapshot, std::move(fun));
     }
 
+    template <typename Fun>
+    void get(uint64_t tableId, const uint64_t* keys, size_t count, const commitmanager::SnapshotDescriptor& snapshot,
+            int* ec, Fun fun) {
+        mTableManager.get(tableId, keys, count, snapshot, ec, std::move(fun));
+    }
+
     int update(uint64_t tableId, uint64_t key, size_t size, const char* data,
-            const commitmanager::SnapshotDescriptor& snapshot) {
-        return mTableManager.update(tableId, key, size, data, snapshot);
+            const commitmanager::SnapshotDescriptor& snapshot, uint32_t schemaVersion) {
+        return mTableManager.update(tableId, key, size, data, snapshot, schemaVersion);
     }
 
     int insert(uint64_t tableId, uint64_t key, size_t size, const char* data,
-            const commitmanager::SnapshotDescriptor& snapshot) {
-        return mTableManager.insert(tableId, key, size, data, snapshot);
+            const commitmanager::SnapshotDescriptor& snapshot, uint32_t schemaVersion) {
+        return mTableManager.insert(tableId, key, size, data, snapshot, schemaVersion);
     }
 
     int remove(uint64_t tableId, uint64_t key, const commitmanager::SnapshotDescriptor& snapshot) {
@@ -106,6 +143,18 @@ public:
         return mTableManager.scan(tableId, query);
     }
 
+    bool reserveScan(ScanQuery* query) {
+        return mTableManager.reserveScan(query);
+    }
+
+    void releaseScan(ScanQuery* query) {
+        mTableManager.releaseScan(query);
+    }
+
+    int scanReserved(uint64_t tableId, ScanQuery* query) {
+        return mTableManager.scanReserved(tableId, query);
+    }
+
     /**
      * We use this method mostly for test purposes. But
      * it might be handy in the future as well. If possible,
@@ -115,6 +164,13 @@ public:
         mTableManager.forceGC();
     }
 
+    /**
+     * @brief Adds the memory of all pages to the usage by table and category
+     */
+    void collectMemoryUsage(MemoryUsage& usage) const {
+        mPageManager->collectUsage(usage);
+    }
+
 private:
     PageManager::Ptr mPageManager;
     GC mGc;
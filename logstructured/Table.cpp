@@ -122,10 +122,15 @@ Table::Table(PageManager& pageManager, const crossbow::string& tableName, const
           mTableName(tableName),
           mRecord(schema),
           mTableId(tableId),
-          mLog(pageManager) {
+          mLog(pageManager, MemoryTag(tableId, MemoryCategory::LOG)) {
 }
 
-int Table::insert(uint64_t key, size_t size, const char* data, const commitmanager::SnapshotDescriptor& snapshot) {
+int Table::insert(uint64_t key, size_t size, const char* data, const commitmanager::SnapshotDescriptor& snapshot,
+        uint32_t schemaVersion) {
+    if (schemaVersion != 0u) {
+        return error::invalid_schema_change;
+    }
+
     LazyRecordWriter recordWriter(*this, key, data, size, VersionRecordType::DATA, snapshot.version());
     VersionRecordIterator recIter(*this, key);
     LOG_ASSERT(mRecord.schema().type() == TableType::NON_TRANSACTIONAL || snapshot.version() >= minVersion(),
@@ -181,7 +186,11 @@ int Table::insert(uint64_t key, size_t size, const char* data, const commitmanag
     LOG_ASSERT(false, "Must never reach this point");
 }
 
-int Table::update(uint64_t key, size_t size, const char* data, const commitmanager::SnapshotDescriptor& snapshot) {
+int Table::update(uint64_t key, size_t size, const char* data, const commitmanager::SnapshotDescriptor& snapshot,
+        uint32_t schemaVersion) {
+    if (schemaVersion != 0u) {
+        return error::invalid_schema_change;
+    }
     return internalUpdate(key, size, data, snapshot, false);
 }
 
@@ -94,6 +94,17 @@ public:
         return mRecord.schema();
     }
 
+    /**
+     * @brief Schema changes are not supported so the table only has the initial schema version
+     */
+    uint32_t schemaVersion() const {
+        return 0u;
+    }
+
+    const Schema& schema(uint32_t /* schemaVersion */) const {
+        return mRecord.schema();
+    }
+
     uint64_t tableId() const {
         return mTableId;
     }
@@ -110,6 +121,20 @@ public:
     template <typename Fun>
     int get(uint64_t key, const commitmanager::SnapshotDescriptor& snapshot, Fun fun);
 
+    /**
+     * @brief Reads a batch of tuples from the table
+     *
+     * @param keys Keys of the tuples to retrieve
+     * @param count Number of keys
+     * @param snapshot Descriptor containing the versions allowed to read
+     * @param ec Array receiving the error code of every key
+     * @param fun The materilization function taking the index of the key, the size, version and whether the tuple is
+     *   the newest one and returning a pointer where the result will be written
+     */
+    template <typename Fun>
+    void get(const uint64_t* keys, size_t count, const commitmanager::SnapshotDescriptor& snapshot, int* ec,
+            Fun fun);
+
     /**
      * @brief Inserts a tuple into the table
      *
@@ -117,9 +142,11 @@ public:
      * @param size Size of the tuple to insert
      * @param data Pointer to the data of the tuple to insert
      * @param snapshot Descriptor containing the version to write
+     * @param schemaVersion Schema version the tuple was written in, must be the initial version
      * @return Error code or 0 if the tuple was successfully inserted
      */
-    int insert(uint64_t key, size_t size, const char* data, const commitmanager::SnapshotDescriptor& snapshot);
+    int insert(uint64_t key, size_t size, const char* data, const commitmanager::SnapshotDescriptor& snapshot,
+            uint32_t schemaVersion);
 
     /**
      * @brief Updates an already existing tuple in the table
@@ -128,9 +155,11 @@ public:
      * @param size Size of the updated tuple
      * @param data Pointer to the data of the updated tuple
      * @param snapshot Descriptor containing the version to write
+     * @param schemaVersion Schema version the tuple was written in, must be the initial version
      * @return Error code or 0 if the tuple was successfully updated
      */
-    int update(uint64_t key, size_t size, const char* data, const commitmanager::SnapshotDescriptor& snapshot);
+    int update(uint64_t key, size_t size, const char* data, const commitmanager::SnapshotDescriptor& snapshot,
+            uint32_t schemaVersion);
 
     /**
      * @brief Removes an already existing tuple from the table
@@ -212,6 +241,16 @@ int Table::get(uint64_t key, const commitmanager::SnapshotDescriptor& snapshot,
     return (recIter.isNewest() ? error::not_found : error::not_in_snapshot);
 }
 
+template <typename Fun>
+void Table::get(const uint64_t* keys, size_t count, const commitmanager::SnapshotDescriptor& snapshot, int* ec,
+        Fun fun) {
+    for (size_t i = 0; i < count; ++i) {
+        ec[i] = get(keys[i], snapshot, [&fun, i] (size_t size, uint64_t version, bool isNewest) {
+            return fun(i, size, version, isNewest);
+        });
+    }
+}
+
 } // namespace logstructured
 } // namespace store
 } // namespace tell
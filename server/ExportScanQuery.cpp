@@ -0,0 +1,183 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include "ExportScanQuery.hpp"
+
+#include "ServerSocket.hpp"
+
+#include <tellstore/ErrorCode.hpp>
+
+#include <crossbow/logger.hpp>
+
+namespace tell {
+namespace store {
+namespace {
+
+/// Length of a selection without any predicates
+constexpr size_t gSelectionLength = 16u;
+
+std::unique_ptr<char[]> emptySelection() {
+    return std::unique_ptr<char[]>(new char[gSelectionLength]());
+}
+
+} // anonymous namespace
+
+constexpr size_t ExportScanQuery::ROW_GROUP_SIZE;
+
+ExportScanQuery::ExportScanQuery(crossbow::infinio::MessageId messageId,
+        std::unique_ptr<commitmanager::SnapshotDescriptor> snapshot, const Record& record,
+        std::unique_ptr<ColumnarFileWriter> writer, uint32_t bufferLength, ServerSocket& socket)
+        : ScanQuery(ScanQueryType::FULL, emptySelection(), gSelectionLength, nullptr, 0u,
+                std::move(snapshot), record),
+          mMessageId(messageId),
+          mWriter(std::move(writer)),
+          mBufferLength(bufferLength),
+          mSocket(socket) {
+}
+
+ExportScanQuery::~ExportScanQuery() = default;
+
+std::tuple<char*, uint32_t> ExportScanQuery::acquireBuffer() {
+    std::lock_guard<std::mutex> _(mMutex);
+    if (!mFreeBuffers.empty()) {
+        auto buffer = mFreeBuffers.back();
+        mFreeBuffers.pop_back();
+        return std::make_tuple(buffer, mBufferLength);
+    }
+
+    mBuffers.emplace_back(new char[mBufferLength]);
+    return std::make_tuple(mBuffers.back().get(), mBufferLength);
+}
+
+void ExportScanQuery::writeOngoing(const char* start, const char* end, std::error_code& ec) {
+    consume(start, end, ec);
+    releaseBuffer(start);
+}
+
+void ExportScanQuery::writeLast(const char* start, const char* end, std::error_code& ec) {
+    consume(start, end, ec);
+    releaseBuffer(start);
+    processorDone();
+}
+
+void ExportScanQuery::writeLast(std::error_code& ec) {
+    ec = std::error_code();
+    processorDone();
+}
+
+ScanQueryProcessor ExportScanQuery::createProcessor() {
+    processorStarted();
+    return ScanQueryProcessor(this);
+}
+
+void ExportScanQuery::consume(const char* start, const char* end, std::error_code& ec) {
+    ec = std::error_code();
+    if (start == end) {
+        return;
+    }
+
+    auto slot = acquireSlot();
+    auto& builder = slot->builder;
+    while (start < end) {
+        auto key = *reinterpret_cast<const uint64_t*>(start);
+        auto tuple = start + sizeof(uint64_t);
+        builder.add(key, tuple);
+        start = tuple + record().sizeOfTuple(tuple);
+
+        if (builder.rowCount() >= ROW_GROUP_SIZE) {
+            flush(*slot, ec);
+        }
+    }
+    releaseSlot(slot);
+}
+
+ExportScanQuery::RowGroupSlot* ExportScanQuery::acquireSlot() {
+    std::lock_guard<std::mutex> _(mMutex);
+    if (!mFreeSlots.empty()) {
+        auto slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+        return slot;
+    }
+
+    mSlots.emplace_back(new RowGroupSlot(record()));
+    return mSlots.back().get();
+}
+
+void ExportScanQuery::releaseSlot(RowGroupSlot* slot) {
+    std::lock_guard<std::mutex> _(mMutex);
+    mFreeSlots.emplace_back(slot);
+}
+
+void ExportScanQuery::releaseBuffer(const char* buffer) {
+    std::lock_guard<std::mutex> _(mMutex);
+    mFreeBuffers.emplace_back(const_cast<char*>(buffer));
+}
+
+void ExportScanQuery::flush(RowGroupSlot& slot, std::error_code& ec) {
+    if (slot.builder.rowCount() == 0u) {
+        return;
+    }
+
+    slot.builder.serialize(slot.buffer);
+    try {
+        mWriter->append(slot.buffer, slot.builder.rowCount());
+    } catch (const std::system_error& e) {
+        LOG_ERROR("Error while writing export [error = %1%]", e.what());
+        ec = e.code();
+        setError(ec);
+    }
+    slot.builder.clear();
+}
+
+void ExportScanQuery::queryDone() {
+    // All processors are done so the remaining row groups can be flushed without synchronization
+    std::error_code ec;
+    for (auto& slot : mSlots) {
+        flush(*slot, ec);
+    }
+
+    uint64_t rowCount = 0u;
+    try {
+        rowCount = mWriter->close();
+    } catch (const std::system_error& e) {
+        LOG_ERROR("Error while closing export [error = %1%]", e.what());
+        setError(e.code());
+    }
+
+    // The socket destroys the query, do not touch any members afterwards
+    auto socket = &mSocket;
+    auto userId = mMessageId.userId();
+    auto failed = static_cast<bool>(mError);
+    socket->execute([socket, userId, failed, rowCount] () {
+        socket->completeExport(userId, failed, rowCount);
+    });
+}
+
+void ExportScanQuery::setError(const std::error_code& ec) {
+    std::lock_guard<std::mutex> _(mMutex);
+    if (!mError) {
+        mError = ec;
+    }
+}
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,160 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <util/ScanQuery.hpp>
+
+#include <tellstore/ColumnarFile.hpp>
+
+#include <commitmanager/SnapshotDescriptor.hpp>
+
+#include <crossbow/infinio/MessageId.hpp>
+#include <crossbow/non_copyable.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+class ServerSocket;
+
+/**
+ * @brief ScanQuery implementation writing a snapshot of the table into a columnar file
+ *
+ * The export is executed as full scan by all scan threads. Every scan buffer is split into the columns of a row group
+ * builder taken from a shared pool while the buffer is still owned by the scan thread, the buffer is then immediately
+ * reused. Builders are flushed as one large sequential write once they hold a complete row group, partially filled
+ * builders are flushed after the last scan processor finished.
+ *
+ * After the file was closed the result is handed to the socket's processing thread which answers the request and
+ * destroys the query.
+ */
+class ExportScanQuery final : public ScanQuery {
+public:
+    /// Number of rows after which a row group is written to the file
+    static constexpr size_t ROW_GROUP_SIZE = 64u * 1024u;
+
+    ExportScanQuery(crossbow::infinio::MessageId messageId, std::unique_ptr<commitmanager::SnapshotDescriptor> snapshot,
+            const Record& record, std::unique_ptr<ColumnarFileWriter> writer, uint32_t bufferLength,
+            ServerSocket& socket);
+
+    ~ExportScanQuery();
+
+    crossbow::infinio::MessageId messageId() const {
+        return mMessageId;
+    }
+
+    /**
+     * @brief Acquires an unused buffer or allocates a new one
+     */
+    virtual std::tuple<char*, uint32_t> acquireBuffer() final override;
+
+    /**
+     * @brief Adds the tuples in the buffer to a row group and releases the buffer
+     */
+    virtual void writeOngoing(const char* start, const char* end, std::error_code& ec) final override;
+
+    /**
+     * @brief Adds the tuples in the buffer to a row group and marks the scan processor as done
+     */
+    virtual void writeLast(const char* start, const char* end, std::error_code& ec) final override;
+
+    /**
+     * @brief Marks the scan processor as done
+     */
+    virtual void writeLast(std::error_code& ec) final override;
+
+    /**
+     * @brief Create a new ScanQueryProcessor associated with this export
+     *
+     * Increases the number of active ScanQueryProcessor referencing the shared data.
+     */
+    virtual ScanQueryProcessor createProcessor() final override;
+
+private:
+    /**
+     * @brief Row group builder together with the buffer it is serialized into
+     */
+    struct RowGroupSlot {
+        RowGroupSlot(const Record& record)
+                : builder(record) {
+        }
+
+        ColumnarRowGroupBuilder builder;
+        std::vector<char> buffer;
+    };
+
+    void consume(const char* start, const char* end, std::error_code& ec);
+
+    RowGroupSlot* acquireSlot();
+
+    void releaseSlot(RowGroupSlot* slot);
+
+    void releaseBuffer(const char* buffer);
+
+    /**
+     * @brief Writes the row group of the slot to the file and clears the builder
+     */
+    void flush(RowGroupSlot& slot, std::error_code& ec);
+
+    /**
+     * @brief Flushes the remaining row groups and completes the export after all ScanQueryProcessor are done
+     */
+    virtual void queryDone() final override;
+
+    void setError(const std::error_code& ec);
+
+    crossbow::infinio::MessageId mMessageId;
+
+    std::unique_ptr<ColumnarFileWriter> mWriter;
+
+    uint32_t mBufferLength;
+
+    ServerSocket& mSocket;
+
+    std::mutex mMutex;
+
+    /// All buffers allocated by the export
+    std::vector<std::unique_ptr<char[]>> mBuffers;
+
+    /// Buffers not in use by any scan processor
+    std::vector<char*> mFreeBuffers;
+
+    /// All row group slots allocated by the export
+    std::vector<std::unique_ptr<RowGroupSlot>> mSlots;
+
+    /// Row group slots not in use by any scan thread
+    std::vector<RowGroupSlot*> mFreeSlots;
+
+    /// First error encountered while writing the file
+    std::error_code mError;
+};
+
+} // namespace store
+} // namespace tell
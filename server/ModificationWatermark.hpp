@@ -0,0 +1,77 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Counts the modifications applied to every table
+ *
+ * Clients caching tuples compare the counter of a table before and after reading from the cache: Any modification that
+ * was applied since the tuple was cached changes the counter and invalidates the cached tuple.
+ *
+ * The counter has to be increased after the modification has been applied to the storage and read before a tuple is
+ * read from the storage. Tables are mapped onto a fixed number of counters, tables sharing a counter only invalidate
+ * each other's cached tuples more often.
+ */
+class ModificationWatermark {
+public:
+    ModificationWatermark() {
+        for (auto& counter : mCounter) {
+            counter.value.store(0u);
+        }
+    }
+
+    /**
+     * @brief Marks the table as modified
+     */
+    void increment(uint64_t tableId) {
+        mCounter[tableId % COUNTER_COUNT].value.fetch_add(1u);
+    }
+
+    /**
+     * @brief The current modification counter of the table
+     */
+    uint64_t get(uint64_t tableId) const {
+        return mCounter[tableId % COUNTER_COUNT].value.load();
+    }
+
+private:
+    static constexpr size_t COUNTER_COUNT = 1024;
+
+    /// Counters are placed on separate cache lines to prevent writes to different tables from contending
+    struct alignas(64) Counter {
+        std::atomic<uint64_t> value;
+    };
+
+    std::array<Counter, COUNTER_COUNT> mCounter;
+};
+
+} // namespace store
+} // namespace tell
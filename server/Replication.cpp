@@ -0,0 +1,470 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include "Replication.hpp"
+#include "ModificationWatermark.hpp"
+
+#include <tellstore/ErrorCode.hpp>
+
+#include <crossbow/alignment.hpp>
+#include <crossbow/byte_buffer.hpp>
+#include <crossbow/enum_underlying.hpp>
+#include <crossbow/logger.hpp>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+namespace tell {
+namespace store {
+namespace {
+
+/// Number of attempts a replica makes to connect to the primary (one per second)
+constexpr int gConnectAttempts = 60;
+
+std::system_error socketError(const char* what) {
+    return std::system_error(errno, std::system_category(), what);
+}
+
+bool sendAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        auto res = ::send(fd, data, length, MSG_NOSIGNAL);
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += res;
+        length -= static_cast<size_t>(res);
+    }
+    return true;
+}
+
+bool receiveAll(int fd, char* data, size_t length) {
+    while (length > 0) {
+        auto res = ::recv(fd, data, length, 0);
+        if (res < 0 && errno == EINTR) {
+            continue;
+        }
+        if (res <= 0) {
+            return false;
+        }
+        data += res;
+        length -= static_cast<size_t>(res);
+    }
+    return true;
+}
+
+int connectTo(const crossbow::string& address) {
+    auto pos = address.rfind(':');
+    if (pos == crossbow::string::npos) {
+        throw std::invalid_argument("Replication address must have the form host:port");
+    }
+    std::string host(address.data(), pos);
+    std::string port(address.data() + pos + 1, address.size() - pos - 1);
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    for (auto attempt = 0; attempt < gConnectAttempts; ++attempt) {
+        addrinfo* result;
+        if (auto res = getaddrinfo(host.c_str(), port.c_str(), &hints, &result)) {
+            throw std::invalid_argument(gai_strerror(res));
+        }
+        for (auto i = result; i != nullptr; i = i->ai_next) {
+            auto fd = ::socket(i->ai_family, i->ai_socktype, i->ai_protocol);
+            if (fd < 0) {
+                continue;
+            }
+            if (::connect(fd, i->ai_addr, i->ai_addrlen) == 0) {
+                freeaddrinfo(result);
+                return fd;
+            }
+            ::close(fd);
+        }
+        freeaddrinfo(result);
+
+        LOG_INFO("Waiting for primary at %1%", address);
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+    throw socketError("Unable to connect to primary");
+}
+
+} // anonymous namespace
+
+constexpr size_t ReplicationLog::MAX_BUFFERED_BYTES;
+
+ReplicationLog::ReplicationLog(uint16_t port, size_t numReplicas)
+        : mListenSocket(::socket(AF_INET6, SOCK_STREAM, 0)),
+          mQueuedBytes(0u),
+          mSenderWaiting(false),
+          mShutdown(false),
+          mReplicatedVersion(0u) {
+    if (mListenSocket < 0) {
+        throw socketError("Unable to create replication socket");
+    }
+
+    int enable = 1;
+    setsockopt(mListenSocket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in6 address;
+    memset(&address, 0, sizeof(address));
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(port);
+    if (::bind(mListenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+            || ::listen(mListenSocket, static_cast<int>(numReplicas)) != 0) {
+        auto error = socketError("Unable to listen on replication port");
+        ::close(mListenSocket);
+        throw error;
+    }
+
+    LOG_INFO("Waiting for %1% replicas on port %2%", numReplicas, port);
+    while (mReplicas.size() < numReplicas) {
+        auto fd = ::accept(mListenSocket, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw socketError("Unable to accept replica");
+        }
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        mReplicas.emplace_back(fd);
+        LOG_INFO("Replica %1% connected", mReplicas.size());
+    }
+
+    mSender = std::thread([this] () {
+        run();
+    });
+}
+
+ReplicationLog::~ReplicationLog() {
+    {
+        std::unique_lock<decltype(mMutex)> _(mMutex);
+        mShutdown.store(true);
+    }
+    mDataCondition.notify_all();
+    mSpaceCondition.notify_all();
+    mSender.join();
+
+    // The sender drains the queue before it exits, only records appended concurrently to the shutdown remain
+    char* record;
+    while (mRecords.try_pop(record)) {
+        delete[] record;
+    }
+
+    for (auto fd : mReplicas) {
+        ::close(fd);
+    }
+    ::close(mListenSocket);
+}
+
+void ReplicationLog::publishCreateTable(uint64_t tableId, const crossbow::string& name, const Schema& schema) {
+    auto nameLength = crossbow::align(sizeof(uint32_t) + name.size(), 8u);
+    auto length = static_cast<uint32_t>(nameLength + schema.serializedLength());
+    append(ReplicationRecordType::CREATE_TABLE, tableId, 0u, 0u, 0u, length, [nameLength, &name, &schema]
+            (crossbow::buffer_writer& writer) {
+        writer.write<uint32_t>(static_cast<uint32_t>(name.size()));
+        writer.write(name.data(), name.size());
+        writer.set(0, nameLength - sizeof(uint32_t) - name.size());
+        schema.serialize(writer);
+    });
+}
+
+void ReplicationLog::publishAlterTable(uint64_t tableId, uint32_t schemaVersion, const Schema& schema) {
+    auto length = static_cast<uint32_t>(schema.serializedLength());
+    append(ReplicationRecordType::ALTER_TABLE, tableId, 0u, 0u, schemaVersion, length, [&schema]
+            (crossbow::buffer_writer& writer) {
+        schema.serialize(writer);
+    });
+}
+
+void ReplicationLog::publishTable(ReplicationRecordType type, uint64_t tableId) {
+    append(type, tableId, 0u, 0u, 0u, 0u, [] (crossbow::buffer_writer& /* writer */) {
+    });
+}
+
+void ReplicationLog::publishModification(ReplicationRecordType type, uint64_t tableId, uint64_t key,
+        uint64_t version, uint32_t schemaVersion, size_t size, const char* data) {
+    append(type, tableId, key, version, schemaVersion, static_cast<uint32_t>(size), [size, data]
+            (crossbow::buffer_writer& writer) {
+        writer.write(data, size);
+    });
+}
+
+void ReplicationLog::publishVersion(const commitmanager::SnapshotDescriptor& snapshot) {
+    // Most snapshots do not advance the version: Check without acquiring the lock first
+    auto baseVersion = snapshot.baseVersion();
+    if (baseVersion <= mReplicatedVersion.load()) {
+        return;
+    }
+
+    append(ReplicationRecordType::VERSION, 0u, snapshot.lowestActiveVersion(), baseVersion, 0u, 0u,
+            [] (crossbow::buffer_writer& /* writer */) {
+    });
+}
+
+template <typename Fun>
+void ReplicationLog::append(ReplicationRecordType type, uint64_t tableId, uint64_t key, uint64_t version,
+        uint32_t schemaVersion, uint32_t length, Fun fun) {
+    auto recordLength = sizeof(ReplicationRecordHeader) + crossbow::align(length, 8u);
+
+    // Only block when the sender fell behind
+    if (mQueuedBytes.load() >= MAX_BUFFERED_BYTES) {
+        std::unique_lock<decltype(mMutex)> lock(mMutex);
+        mSpaceCondition.wait(lock, [this] () {
+            return mShutdown.load() || mQueuedBytes.load() < MAX_BUFFERED_BYTES;
+        });
+    }
+
+    // Version records are only appended when they advance the version
+    if (type == ReplicationRecordType::VERSION) {
+        auto replicatedVersion = mReplicatedVersion.load();
+        do {
+            if (version <= replicatedVersion) {
+                return;
+            }
+        } while (!mReplicatedVersion.compare_exchange_weak(replicatedVersion, version));
+    }
+
+    auto record = new char[recordLength];
+    auto header = reinterpret_cast<ReplicationRecordHeader*>(record);
+    header->type = crossbow::to_underlying(type);
+    header->schemaVersion = static_cast<uint16_t>(schemaVersion);
+    header->length = length;
+    header->tableId = tableId;
+    header->key = key;
+    header->version = version;
+
+    crossbow::buffer_writer writer(record + sizeof(ReplicationRecordHeader),
+            recordLength - sizeof(ReplicationRecordHeader));
+    fun(writer);
+    writer.set(0, static_cast<size_t>(record + recordLength - writer.data()));
+
+    mQueuedBytes.fetch_add(recordLength);
+    mRecords.push(record);
+
+    // The sender announces that it waits before checking the queue a last time, so either it sees the record or
+    // this thread sees the announcement
+    if (mSenderWaiting.load()) {
+        std::unique_lock<decltype(mMutex)> _(mMutex);
+        mDataCondition.notify_one();
+    }
+}
+
+void ReplicationLog::takeRecords(std::vector<char>& buffer) {
+    char* record;
+    size_t taken = 0u;
+    while (mRecords.try_pop(record)) {
+        auto header = reinterpret_cast<const ReplicationRecordHeader*>(record);
+        auto recordLength = sizeof(ReplicationRecordHeader) + crossbow::align(header->length, 8u);
+        buffer.insert(buffer.end(), record, record + recordLength);
+        delete[] record;
+        taken += recordLength;
+    }
+    if (taken == 0u) {
+        return;
+    }
+
+    mQueuedBytes.fetch_sub(taken);
+    std::unique_lock<decltype(mMutex)> _(mMutex);
+    mSpaceCondition.notify_all();
+}
+
+void ReplicationLog::run() {
+    std::vector<char> buffer;
+    while (true) {
+        buffer.clear();
+        takeRecords(buffer);
+        if (buffer.empty()) {
+            std::unique_lock<decltype(mMutex)> lock(mMutex);
+            mSenderWaiting.store(true);
+            mDataCondition.wait(lock, [this] () {
+                return mShutdown.load() || !mRecords.empty();
+            });
+            mSenderWaiting.store(false);
+            lock.unlock();
+
+            takeRecords(buffer);
+            if (buffer.empty()) {
+                return;
+            }
+        }
+
+        for (auto i = mReplicas.begin(); i != mReplicas.end();) {
+            if (!sendAll(*i, buffer.data(), buffer.size())) {
+                LOG_ERROR("Dropping replica after send failed [error = %1%]", strerror(errno));
+                ::close(*i);
+                i = mReplicas.erase(i);
+                continue;
+            }
+            ++i;
+        }
+    }
+}
+
+ReplicationApplier::ReplicationApplier(Storage& storage, ModificationWatermark& watermark,
+        const crossbow::string& primary)
+        : mStorage(storage),
+          mWatermark(watermark),
+          mSocket(connectTo(primary)),
+          mAppliedVersion(0u),
+          mLowestActiveVersion(0u) {
+    LOG_INFO("Replicating from primary at %1%", primary);
+    mThread = std::thread([this] () {
+        run();
+    });
+}
+
+ReplicationApplier::~ReplicationApplier() {
+    ::shutdown(mSocket, SHUT_RDWR);
+    mThread.join();
+    ::close(mSocket);
+}
+
+bool ReplicationApplier::covers(const commitmanager::SnapshotDescriptor& snapshot) const {
+    // Transactional snapshots may read committed versions between the base version and their own version
+    auto highestVersion = (snapshot.version() > snapshot.baseVersion() ? snapshot.version() - 1
+                                                                      : snapshot.baseVersion());
+    return (highestVersion <= mAppliedVersion.load());
+}
+
+void ReplicationApplier::run() {
+    std::vector<char> payload;
+    while (true) {
+        ReplicationRecordHeader header;
+        if (!receiveAll(mSocket, reinterpret_cast<char*>(&header), sizeof(header))) {
+            break;
+        }
+        payload.resize(crossbow::align(header.length, 8u));
+        if (!receiveAll(mSocket, payload.data(), payload.size())) {
+            break;
+        }
+        apply(header, payload.data());
+    }
+    LOG_INFO("Replication stream from primary closed at version %1%", mAppliedVersion.load());
+}
+
+void ReplicationApplier::apply(const ReplicationRecordHeader& header, const char* payload) {
+    // Concurrently published version records may arrive out of order: Only advance to the largest version
+    if (header.type == crossbow::to_underlying(ReplicationRecordType::VERSION)) {
+        if (header.version > mAppliedVersion.load()) {
+            mLowestActiveVersion = header.key;
+            mAppliedVersion.store(header.version);
+        }
+        return;
+    }
+
+    if (header.type == crossbow::to_underlying(ReplicationRecordType::CREATE_TABLE)) {
+        crossbow::buffer_reader reader(payload, header.length);
+        auto nameLength = reader.read<uint32_t>();
+        crossbow::string name(reader.read(nameLength), nameLength);
+        reader.align(8u);
+        auto schema = Schema::deserialize(reader);
+
+        uint64_t tableId;
+        if (!mStorage.createTable(name, schema, tableId) || tableId != header.tableId) {
+            LOG_ERROR("Replicating table %1% failed", name);
+        }
+        return;
+    }
+
+    if (header.type == crossbow::to_underlying(ReplicationRecordType::ALTER_TABLE)) {
+        crossbow::buffer_reader reader(payload, header.length);
+        auto schema = Schema::deserialize(reader);
+
+        // The header carries the version of the new schema, which succeeds the previous version
+        auto ec = (header.schemaVersion == 0u ? error::invalid_schema_change
+                : mStorage.alterTable(header.tableId, header.schemaVersion - 1u, schema));
+        if (ec != 0) {
+            LOG_ERROR("Replicating schema change of table %1% failed [error = %2%]", header.tableId,
+                    error::make_error_code(static_cast<error::errors>(ec)).message());
+            return;
+        }
+        mWatermark.increment(header.tableId);
+        return;
+    }
+
+    if (header.type == crossbow::to_underlying(ReplicationRecordType::DROP_TABLE)
+            || header.type == crossbow::to_underlying(ReplicationRecordType::TRUNCATE_TABLE)) {
+        auto drop = (header.type == crossbow::to_underlying(ReplicationRecordType::DROP_TABLE));
+        auto ec = (drop ? mStorage.dropTable(header.tableId) : mStorage.truncateTable(header.tableId));
+        if (ec != 0) {
+            LOG_ERROR("Replicating %1% of table %2% failed [error = %3%]", (drop ? "drop" : "truncation"),
+                    header.tableId, error::make_error_code(static_cast<error::errors>(ec)).message());
+            return;
+        }
+        mWatermark.increment(header.tableId);
+        return;
+    }
+
+    LOG_ASSERT(header.version != 0u, "Modification without version");
+    commitmanager::SnapshotDescriptor::BlockType descriptor = 0x0u;
+    auto snapshot = commitmanager::SnapshotDescriptor::create(mLowestActiveVersion, header.version - 1,
+            header.version, reinterpret_cast<const char*>(&descriptor));
+
+    int ec;
+    switch (header.type) {
+    case crossbow::to_underlying(ReplicationRecordType::INSERT): {
+        ec = mStorage.insert(header.tableId, header.key, header.length, payload, *snapshot, header.schemaVersion);
+    } break;
+
+    case crossbow::to_underlying(ReplicationRecordType::UPDATE): {
+        ec = mStorage.update(header.tableId, header.key, header.length, payload, *snapshot, header.schemaVersion);
+    } break;
+
+    case crossbow::to_underlying(ReplicationRecordType::REMOVE): {
+        ec = mStorage.remove(header.tableId, header.key, *snapshot);
+    } break;
+
+    case crossbow::to_underlying(ReplicationRecordType::REVERT): {
+        ec = mStorage.revert(header.tableId, header.key, *snapshot);
+    } break;
+
+    default: {
+        LOG_ERROR("Unknown replication record type %1%", header.type);
+        return;
+    }
+    }
+
+    if (ec != 0) {
+        LOG_ERROR("Replica diverged from primary on key %1% in table %2% [error = %3%]", header.key, header.tableId,
+                error::make_error_code(static_cast<error::errors>(ec)).message());
+        return;
+    }
+    mWatermark.increment(header.tableId);
+}
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,258 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include "Storage.hpp"
+
+#include <tellstore/Record.hpp>
+
+#include <commitmanager/SnapshotDescriptor.hpp>
+
+#include <crossbow/non_copyable.hpp>
+#include <crossbow/string.hpp>
+
+#include <tbb/concurrent_queue.h>
+#include <tbb/spin_rw_mutex.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+class ModificationWatermark;
+
+/**
+ * @brief Types of the records in the replication stream
+ */
+enum class ReplicationRecordType : uint16_t {
+    CREATE_TABLE = 0x1u,
+    INSERT,
+    UPDATE,
+    REMOVE,
+    REVERT,
+
+    /// All modifications of versions up to the base version precede the record in the stream
+    VERSION,
+
+    ALTER_TABLE,
+    DROP_TABLE,
+    TRUNCATE_TABLE,
+};
+
+/**
+ * @brief Header of every record in the replication stream
+ *
+ * The header is followed by the record's payload padded to 8 bytes: The tuple data for inserts and updates, the
+ * length prefixed table name (padded to 8 bytes) followed by the serialized schema for table creations and the
+ * serialized new schema for schema changes. The version record stores the lowest active version in the key field and
+ * the base version in the version field.
+ * Table drops and truncations have no payload.
+ *
+ * Inserts and updates store the schema version the tuple was written in, schema changes the version of the new schema.
+ */
+struct ReplicationRecordHeader {
+    uint16_t type;
+    uint16_t schemaVersion;
+    uint32_t length;
+    uint64_t tableId;
+    uint64_t key;
+    uint64_t version;
+};
+
+/**
+ * @brief Streams the modifications applied on the primary to the read replicas
+ *
+ * Modifications are appended to the stream after they were applied to the storage but before the client is notified,
+ * so they precede the commit of their transaction. Any snapshot whose base version is larger than the last version
+ * record therefore proves that all modifications up to its base version are in the stream and is published as new
+ * version record.
+ *
+ * Replicas have to connect before the primary accepts requests: The stream starts with the first table creation and
+ * a replica joining later could not rebuild the tables.
+ *
+ * Records are appended to a lock-free queue so the network threads do not serialize on a common lock. The queue is
+ * FIFO, a record therefore always follows the records appended before its append started. Concurrent version
+ * records may be reordered, replicas only advance to the largest version seen.
+ *
+ * A modification applied to a table before a schema change, drop or truncation must not be appended after the record
+ * of the table operation, otherwise the replica applies it to the new table. Both are therefore applied and published
+ * under a ReplicationOrderGuard.
+ */
+class ReplicationLog : crossbow::non_copyable, crossbow::non_movable {
+    friend class ReplicationOrderGuard;
+
+public:
+    /**
+     * @brief Listens for replicas on the given port and blocks until the given number of replicas connected
+     */
+    ReplicationLog(uint16_t port, size_t numReplicas);
+
+    ~ReplicationLog();
+
+    void publishCreateTable(uint64_t tableId, const crossbow::string& name, const Schema& schema);
+
+    /**
+     * @brief Publishes the schema change adding the given schema version
+     */
+    void publishAlterTable(uint64_t tableId, uint32_t schemaVersion, const Schema& schema);
+
+    /**
+     * @brief Publishes an operation on the table without payload (drop or truncate)
+     */
+    void publishTable(ReplicationRecordType type, uint64_t tableId);
+
+    void publishModification(ReplicationRecordType type, uint64_t tableId, uint64_t key, uint64_t version,
+            uint32_t schemaVersion, size_t size, const char* data);
+
+    /**
+     * @brief Publishes a version record if the snapshot advances the replicated version
+     */
+    void publishVersion(const commitmanager::SnapshotDescriptor& snapshot);
+
+private:
+    /// Number of unsent bytes after which modifications block until the sender caught up
+    static constexpr size_t MAX_BUFFERED_BYTES = 64 * 1024 * 1024;
+
+    template <typename Fun>
+    void append(ReplicationRecordType type, uint64_t tableId, uint64_t key, uint64_t version, uint32_t schemaVersion,
+            uint32_t length, Fun fun);
+
+    void run();
+
+    /**
+     * @brief Moves all queued records into the buffer
+     */
+    void takeRecords(std::vector<char>& buffer);
+
+    int mListenSocket;
+
+    /// Sockets of the connected replicas (only accessed by the sender thread after construction)
+    std::vector<int> mReplicas;
+
+    /// Records not yet taken by the sender (every record is a header followed by its padded payload)
+    tbb::concurrent_queue<char*> mRecords;
+
+    /// Number of bytes in the queue
+    std::atomic<size_t> mQueuedBytes;
+
+    /// Whether the sender is about to wait for new records
+    std::atomic<bool> mSenderWaiting;
+
+    /// Only acquired by threads waiting for records or space and the threads waking them
+    std::mutex mMutex;
+
+    /// Notified when records were appended while the sender is waiting or when the log shuts down
+    std::condition_variable mDataCondition;
+
+    /// Notified when the sender took the queued records
+    std::condition_variable mSpaceCondition;
+
+    std::atomic<bool> mShutdown;
+
+    /// Held shared by modifications and exclusively by table operations (see ReplicationOrderGuard)
+    tbb::spin_rw_mutex mOrderMutex;
+
+    /// Base version of the last version record
+    std::atomic<uint64_t> mReplicatedVersion;
+
+    std::thread mSender;
+};
+
+/**
+ * @brief Orders the records of table operations against the records of modifications
+ *
+ * Modifications hold the guard shared from applying the modification to the storage until their record was published,
+ * schema changes, drops and truncations hold it exclusively. The record of a table operation therefore follows the
+ * records of all modifications applied before it and precedes the records of all modifications applied after it.
+ *
+ * The guard does nothing without replication log.
+ */
+class ReplicationOrderGuard : crossbow::non_copyable, crossbow::non_movable {
+public:
+    ReplicationOrderGuard(ReplicationLog* log, bool tableOperation) {
+        if (log) {
+            mLock.acquire(log->mOrderMutex, tableOperation);
+        }
+    }
+
+private:
+    tbb::spin_rw_mutex::scoped_lock mLock;
+};
+
+/**
+ * @brief Applies the replication stream of a primary to the local storage
+ *
+ * Records are applied in stream order by a single thread. Modifications are executed with a snapshot that can read
+ * every version below the modification's version: The primary already validated them and conflicting modifications
+ * appear in the stream in version order.
+ */
+class ReplicationApplier : crossbow::non_copyable, crossbow::non_movable {
+public:
+    /**
+     * @brief Connects to the primary and starts applying its stream
+     *
+     * @param primary Address of the primary's replication port (host:port)
+     */
+    ReplicationApplier(Storage& storage, ModificationWatermark& watermark, const crossbow::string& primary);
+
+    ~ReplicationApplier();
+
+    /**
+     * @brief Version up to which all modifications were applied
+     */
+    uint64_t appliedVersion() const {
+        return mAppliedVersion.load();
+    }
+
+    /**
+     * @brief Whether all versions readable by the snapshot were applied
+     */
+    bool covers(const commitmanager::SnapshotDescriptor& snapshot) const;
+
+private:
+    void run();
+
+    void apply(const ReplicationRecordHeader& header, const char* payload);
+
+    Storage& mStorage;
+
+    ModificationWatermark& mWatermark;
+
+    int mSocket;
+
+    std::atomic<uint64_t> mAppliedVersion;
+
+    /// Lowest active version of the last version record (only accessed by the apply thread)
+    uint64_t mLowestActiveVersion;
+
+    std::thread mThread;
+};
+
+} // namespace store
+} // namespace tell
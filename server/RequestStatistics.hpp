@@ -0,0 +1,131 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <tellstore/MessageTypes.hpp>
+#include <tellstore/Statistics.hpp>
+
+#include <crossbow/enum_underlying.hpp>
+
+#include <tbb/concurrent_unordered_map.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Latency histograms of the requests handled by one network thread
+ *
+ * Every network thread records into its own instance so recording does not need any synchronization. The STATS request
+ * collects the histograms of all network threads concurrently to the recording threads.
+ */
+class RequestStatistics {
+public:
+    /**
+     * @brief Records the processing time of a request not associated with a table
+     */
+    void recordRequest(uint32_t messageType, uint64_t duration) {
+        if (messageType < mRequests.size()) {
+            mRequests[messageType].record(duration);
+        }
+    }
+
+    /**
+     * @brief Records the processing time of a request on the given table
+     *
+     * The histogram of a table is only created if the table exists and less than the maximum number of tables are
+     * tracked, otherwise the request is only recorded by its type.
+     *
+     * @param tableExists Function with the signature () -> bool checking if the table exists
+     */
+    template <typename Fun>
+    void recordRequest(uint32_t messageType, uint64_t tableId, uint64_t duration, Fun tableExists) {
+        recordRequest(messageType, duration);
+
+        auto i = mTables.find(tableId);
+        if (i == mTables.end()) {
+            if (mTables.size() >= MAX_TABLE_COUNT || !tableExists()) {
+                return;
+            }
+            i = mTables.insert(std::make_pair(tableId, std::make_shared<LatencyHistogram>())).first;
+        }
+        i->second->record(duration);
+    }
+
+    /**
+     * @brief Records the duration of a phase of a scan
+     */
+    void recordScanPhase(ScanPhase phase, uint64_t duration) {
+        auto index = crossbow::to_underlying(phase);
+        if (index < mScanPhases.size()) {
+            mScanPhases[index].record(duration);
+        }
+    }
+
+    /**
+     * @brief Adds the current content of all histograms to the statistics
+     */
+    void collect(ServerStatistics& statistics) const {
+        collectAll(statistics, StatisticsKind::REQUEST, mRequests);
+        collectAll(statistics, StatisticsKind::SCAN_PHASE, mScanPhases);
+        for (auto& entry : mTables) {
+            entry.second->collect(statistics.distribution(StatisticsKind::TABLE, entry.first));
+        }
+    }
+
+private:
+    static constexpr size_t REQUEST_TYPE_COUNT = crossbow::to_underlying(RequestType::TRUNCATE_TABLE) + 1u;
+    static constexpr size_t SCAN_PHASE_COUNT = crossbow::to_underlying(ScanPhase::DRAIN) + 1u;
+
+    /// Maximum number of tables a histogram is kept for (the map can not shrink while it is traversed concurrently)
+    static constexpr size_t MAX_TABLE_COUNT = 1024u;
+
+    template <size_t Size>
+    static void collectAll(ServerStatistics& statistics, StatisticsKind kind,
+            const std::array<LatencyHistogram, Size>& histograms) {
+        LatencyDistribution distribution;
+        for (size_t i = 0; i < histograms.size(); ++i) {
+            histograms[i].collect(distribution);
+            if (distribution.count() != 0u) {
+                statistics.distribution(kind, i).merge(distribution);
+                distribution = LatencyDistribution();
+            }
+        }
+    }
+
+    /// Histograms indexed by the request type
+    std::array<LatencyHistogram, REQUEST_TYPE_COUNT> mRequests;
+
+    /// Histograms indexed by the scan phase
+    std::array<LatencyHistogram, SCAN_PHASE_COUNT> mScanPhases;
+
+    /// Histograms by table ID (the map supports concurrent insertion and traversal)
+    tbb::concurrent_unordered_map<uint64_t, std::shared_ptr<LatencyHistogram>> mTables;
+};
+
+} // namespace store
+} // namespace tell
@@ -22,8 +22,11 @@
  */
 #pragma once
 
+#include <crossbow/string.hpp>
+
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 
 namespace tell {
 namespace store {
@@ -38,6 +41,9 @@ struct ServerConfig {
     /// Number of network threads to process requests on
     int numNetworkThreads = 2;
 
+    /// Size of the network buffers (upper bound for the length of a single request or response)
+    uint32_t bufferLength = 128 * 1024;
+
     /// Size of the buffers used in scans
     uint32_t scanBufferLength = 0x100000;
 
@@ -45,11 +51,42 @@ struct ServerConfig {
     uint32_t scanBufferCount = 256;
 
     /// Maximum number of scan buffers that are in flight on a socket at the same time
-    /// This limit might be exceeded by a small factor
     uint64_t maxInflightScanBuffer = 16;
 
+    /// Maximum number of scan buffers a scan writes before yielding the network thread to other requests (0 for no
+    /// limit)
+    uint32_t scanFlushBudget = 4;
+
+    /// Number of scan buffers batch scans leave to interactive scans (capped at half of the scan buffers)
+    uint32_t scanBufferReserve = 32;
+
+    /// Maximum number of scan buffers a single scan holds at the same time (capped at the number of scan buffers),
+    /// further output of the scan is parked in private memory until its buffers were written
+    uint32_t scanQueryBuffers = 32;
+
+    /// Maximum amount of parked output in bytes a single scan can accumulate before it is aborted
+    uint64_t scanSpillLimit = 0x10000000;
+
+    /// Maximum number of scans a single client connection can have active at the same time (0 for no limit)
+    size_t maxScansPerClient = 32;
+
     /// Maximum number of messages per batch
     size_t maxBatchSize = 16;
+
+    /// Cores the network threads are pinned to (empty if the threads are not pinned)
+    std::vector<unsigned> networkCores;
+
+    /// Port the primary streams its modifications to read replicas on (0 if replication is disabled)
+    uint16_t replicationPort = 0;
+
+    /// Number of read replicas the primary waits for before accepting requests
+    size_t numReplicas = 1;
+
+    /// Replication address (host:port) of the primary this server is a read replica of (empty if not a replica)
+    crossbow::string replicateFrom;
+
+    /// Directory export files are written into (empty if exports are disabled)
+    crossbow::string exportDirectory;
 };
 
 } // namespace store
@@ -25,10 +25,13 @@
 #include "ServerConfig.hpp"
 #include "ServerSocket.hpp"
 
+#include <tellstore/Statistics.hpp>
+
 #include <crossbow/logger.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
-#include <thread>
 
 namespace tell {
 namespace store {
@@ -36,6 +39,9 @@ namespace store {
 ScanBufferManager::ScanBufferManager(crossbow::infinio::InfinibandService& service, const ServerConfig& config)
         : mScanBufferCount(config.scanBufferCount),
           mScanBufferLength(config.scanBufferLength),
+          mScanBufferReserve(std::min(config.scanBufferReserve, config.scanBufferCount / 2u)),
+          mQueryBufferLimit(std::max(std::min(config.scanQueryBuffers, config.scanBufferCount), 1u)),
+          mSpillLimit(config.scanSpillLimit),
           mRegion(service.allocateMemoryRegion(static_cast<size_t>(mScanBufferCount)
                 * static_cast<size_t>(mScanBufferLength), IBV_ACCESS_LOCAL_WRITE)),
           mBufferStack(mScanBufferCount, crossbow::infinio::InfinibandBuffer::INVALID_ID) {
@@ -46,7 +52,11 @@ ScanBufferManager::ScanBufferManager(crossbow::infinio::InfinibandService& servi
     }
 }
 
-std::tuple<char*, uint32_t> ScanBufferManager::acquireBuffer() {
+std::tuple<char*, uint32_t> ScanBufferManager::acquireBuffer(ScanPriority priority) {
+    if (!admit(priority)) {
+        return std::make_tuple(nullptr, 0u);
+    }
+
     uint16_t id;
     if (!mBufferStack.pop(id)) {
         return std::make_tuple(nullptr, 0u);
@@ -56,8 +66,33 @@ std::tuple<char*, uint32_t> ScanBufferManager::acquireBuffer() {
     return std::make_tuple(reinterpret_cast<char*>(data), mScanBufferLength);
 }
 
+void ScanBufferManager::waitForBuffer(std::shared_ptr<ScanBufferWaiter> waiter, ScanPriority priority) {
+    auto& waiters = (priority == ScanPriority::INTERACTIVE ? mInteractiveWaiters : mBatchWaiters);
+    waiters.push(std::move(waiter));
+
+    // A buffer might have been released before the waiter was registered
+    if (mBufferStack.size() != 0u && admit(priority)) {
+        notifyWaiter(waiters);
+    }
+}
+
 void ScanBufferManager::releaseBuffer(uint16_t id) {
     while (!mBufferStack.push(id));
+
+    // Batch scans are only woken up if the buffer is not part of the reserve
+    if (!notifyWaiter(mInteractiveWaiters) && admit(ScanPriority::BATCH)) {
+        notifyWaiter(mBatchWaiters);
+    }
+}
+
+void ScanBufferManager::releaseBuffer(const char* data) {
+    auto offset = reinterpret_cast<size_t>(data - mRegion.address());
+    releaseBuffer(static_cast<uint16_t>(offset / static_cast<size_t>(mScanBufferLength)));
+}
+
+void ScanBufferManager::collectUsage(MemoryUsage& usage) const {
+    auto used = static_cast<uint64_t>(mScanBufferCount - mBufferStack.size());
+    usage.add(0u, MemoryCategory::SCAN_BUFFER, used * static_cast<uint64_t>(mScanBufferLength));
 }
 
 crossbow::infinio::InfinibandBuffer ScanBufferManager::getBuffer(const char* data, uint32_t length) {
@@ -66,79 +101,209 @@ crossbow::infinio::InfinibandBuffer ScanBufferManager::getBuffer(const char* dat
     return mRegion.acquireBuffer(id, offset, length);
 }
 
+bool ScanBufferManager::notifyWaiter(tbb::concurrent_queue<std::shared_ptr<ScanBufferWaiter>>& waiters) {
+    std::shared_ptr<ScanBufferWaiter> waiter;
+    while (waiters.try_pop(waiter)) {
+        if (waiter->notify()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 ServerScanQuery::ServerScanQuery(uint16_t scanId, ScanQueryType queryType, std::unique_ptr<char[]> selectionData,
         size_t selectionLength, std::unique_ptr<char[]> queryData, size_t queryLength,
         std::unique_ptr<commitmanager::SnapshotDescriptor> snapshot, const Record& record,
         ScanBufferManager& scanBufferManager, crossbow::infinio::RemoteMemoryRegion destRegion, ServerSocket& socket)
         : ScanQuery(queryType, std::move(selectionData), selectionLength, std::move(queryData), queryLength,
                 std::move(snapshot), record),
-          mActive(0u),
+          mStartTime(std::chrono::steady_clock::now()),
+          mExecutionStart(0),
+          mExecutionEnd(0),
           mScanId(scanId),
           mProgressRequest(true),
+          mFlushScheduled(false),
+          mBuffersHeld(0u),
+          mSpilled(0u),
+          mSpillExceeded(false),
+          mFailed(false),
+          mError(error::server_overlad),
+          mAborted(false),
+          mWaitingForBuffer(false),
           mScanBufferManager(scanBufferManager),
           mDestRegion(std::move(destRegion)),
           mSocket(socket),
-          mOffset(0u) {
+          mOffset(0u),
+          mWrapOffset(0u),
+          mOffsetRead(0u) {
+    // Flush the query as soon as a buffer is available for its parked output
+    mBufferWaiter = std::make_shared<ScanBufferWaiter>([this] () {
+        mWaitingForBuffer.store(false);
+        if (!mFlushScheduled.exchange(true)) {
+            mSocket.scheduleScanFlush(mScanId);
+        }
+    });
 }
 
-void ServerScanQuery::requestProgress(size_t offsetRead) {
+ServerScanQuery::~ServerScanQuery() {
+    mBufferWaiter->disarm();
+
+    // Return all buffers that were never written back to the pool
+    PendingWrite write;
+    while (mSendQueue.try_pop(write)) {
+        mPending.emplace_back(write);
+    }
+    for (auto& write : mPending) {
+        if (write.start != nullptr) {
+            releaseBuffer(write.start);
+        }
+    }
+}
+
+bool ServerScanQuery::requestProgress(size_t offsetRead) {
+    // The client released the destination region up to the given offset
+    if (offsetRead > mOffsetRead) {
+        mOffsetRead = offsetRead;
+    }
+
+    auto blocked = flushPending();
+
     // Check if data was written since the last request otherwise queue the progress update
-    // We can not block on the lock as the scan thread might loop until there is space left in the send queue but the
-    // network thread is blocked on the lock and unable to process the completion queue to make space on it
-    typename decltype(mSendMutex)::scoped_lock lock;
-    if (lock.try_acquire(mSendMutex) && mOffset > offsetRead) {
-        mSocket.writeScanProgress(mScanId, false, mOffset);
+    if (mOffset > offsetRead) {
+        mProgressRequest = false;
+        mSocket.writeScanProgress(mScanId, false, mOffset, mWrapOffset);
     } else {
         mProgressRequest = true;
     }
+    return blocked;
 }
 
-void ServerScanQuery::completeScan() {
-    typename decltype(mSendMutex)::scoped_lock _(mSendMutex);
+bool ServerScanQuery::flushPending() {
+    // Allow the scan threads to schedule another flush before draining the send queue
+    mFlushScheduled.store(false);
+
+    PendingWrite write;
+    while (mSendQueue.try_pop(write)) {
+        mPending.emplace_back(write);
+    }
+
+    if (!mFailed.load() && mSpillExceeded.load()) {
+        LOG_ERROR("Scan %1% exceeded the spill limit", mScanId);
+        fail(error::server_overlad);
+    }
+    if (mFailed.load()) {
+        discardPending();
+        return false;
+    }
+
+    auto offset = mOffset;
+    auto blocked = false;
+    auto budget = mSocket.scanFlushBudget();
+    uint32_t written = 0u;
+    while (!mPending.empty()) {
+        if (!mSocket.canWriteScanBuffer()) {
+            blocked = true;
+            break;
+        }
+
+        // Yield to the other events of the network thread once the budget is exhausted and continue afterwards
+        if (budget != 0u && written == budget) {
+            if (!mFlushScheduled.exchange(true)) {
+                mSocket.scheduleScanFlush(mScanId);
+            }
+            break;
+        }
 
-    mSocket.writeScanProgress(mScanId, true, mOffset);
+        auto write = mPending.front();
+        std::error_code ec;
+        if (!tryWrite(write.start, write.length, write.status, ec)) {
+            break;
+        }
+        mPending.pop_front();
+        ++written;
+
+        if (ec) {
+            LOG_ERROR("Error while sending scan buffer [error = %1% %2%]", ec, ec.message());
+
+            // The final write still has to complete the aborted query
+            if (write.status == ScanStatusIndicator::DONE) {
+                mPending.emplace_front(write);
+            }
+            fail(error::scan_write_failed);
+            discardPending();
+            return false;
+        }
+    }
+
+    // TODO Offset might not be accurate (requests in flight may fail)
+    if (mProgressRequest && mOffset > offset) {
+        mProgressRequest = false;
+        mSocket.writeScanProgress(mScanId, false, mOffset, mWrapOffset);
+    }
+
+    return blocked;
+}
+
+void ServerScanQuery::completeScan() {
+    mSocket.writeScanProgress(mScanId, true, mOffset, mWrapOffset);
 }
 
 std::tuple<char*, uint32_t> ServerScanQuery::acquireBuffer() {
-    return mScanBufferManager.acquireBuffer();
+    // Take a buffer from the pool as long as the query did not use up its share and the pool is not exhausted (or only
+    // the reserve is left for batch scans)
+    if (!mFailed.load()) {
+        if (++mBuffersHeld <= mScanBufferManager.queryBufferLimit()) {
+            auto buffer = mScanBufferManager.acquireBuffer(priority());
+            if (std::get<0>(buffer) != nullptr) {
+                return buffer;
+            }
+        }
+        --mBuffersHeld;
+    }
+
+    // Park the output in a spill buffer instead of waiting for the pool, the processing thread copies it into a pool
+    // buffer when it is written
+    auto length = mScanBufferManager.scanBufferLength();
+    if (mSpilled.fetch_add(length) + length > mScanBufferManager.spillLimit() && !mSpillExceeded.exchange(true)) {
+        // Let the processing thread abort the query
+        if (!mFlushScheduled.exchange(true)) {
+            mSocket.scheduleScanFlush(mScanId);
+        }
+    }
+    return std::make_tuple(new char[length], length);
 }
 
 void ServerScanQuery::writeOngoing(const char* start, const char* end, std::error_code& ec) {
-    typename decltype(mSendMutex)::scoped_lock _(mSendMutex);
-    doWrite(start, end, ScanStatusIndicator::ONGOING, ec);
+    ec = std::error_code();
+    if (mFailed.load()) {
+        releaseBuffer(start);
+        return;
+    }
+    enqueueWrite(start, end, ScanStatusIndicator::ONGOING);
 }
 
 void ServerScanQuery::writeLast(const char* start, const char* end, std::error_code& ec) {
-    typename decltype(mSendMutex)::scoped_lock _(mSendMutex);
-
-    --mActive;
-    auto status = (mActive == 0 ? ScanStatusIndicator::DONE : ScanStatusIndicator::ONGOING);
-    doWrite(start, end, status, ec);
-
-    if (ec == crossbow::infinio::error::out_of_range && mActive == 0) {
-        auto userId = (static_cast<uint32_t>(mScanId) << 16) | static_cast<uint32_t>(ScanStatusIndicator::DONE);
-        crossbow::infinio::ScatterGatherBuffer buffer(crossbow::infinio::InfinibandBuffer::INVALID_ID);
-
-        std::error_code ec2;
-        mSocket.writeScanBuffer(buffer, mDestRegion, mOffset, userId, ec2);
+    ec = std::error_code();
+    if (mFailed.load()) {
+        releaseBuffer(start);
+    } else {
+        enqueueWrite(start, end, ScanStatusIndicator::ONGOING);
     }
+    processorDone();
 }
 
 void ServerScanQuery::writeLast(std::error_code& ec) {
-    typename decltype(mSendMutex)::scoped_lock _(mSendMutex);
-
-    --mActive;
-    if (mActive == 0) {
-        auto userId = (static_cast<uint32_t>(mScanId) << 16) | static_cast<uint32_t>(ScanStatusIndicator::DONE);
-        crossbow::infinio::ScatterGatherBuffer buffer(crossbow::infinio::InfinibandBuffer::INVALID_ID);
-
-        mSocket.writeScanBuffer(buffer, mDestRegion, mOffset, userId, ec);
-    }
+    ec = std::error_code();
+    processorDone();
 }
 
 ScanQueryProcessor ServerScanQuery::createProcessor() {
-    typename decltype(mSendMutex)::scoped_lock _(mSendMutex);
-    ++mActive;
+    processorStarted();
+
+    // Only the first processor marks the start of the execution
+    std::chrono::steady_clock::rep expected = 0;
+    mExecutionStart.compare_exchange_strong(expected, std::chrono::steady_clock::now().time_since_epoch().count());
+
     ScanQueryProcessor processor(this);
     if (queryType() == ScanQueryType::AGGREGATION) {
         processor.initAggregationRecord();
@@ -146,31 +311,119 @@ ScanQueryProcessor ServerScanQuery::createProcessor() {
     return processor;
 }
 
-void ServerScanQuery::doWrite(const char* start, const char* end, ScanStatusIndicator status, std::error_code& ec) {
-    LOG_ASSERT(end > start, "Invalid buffer");
+void ServerScanQuery::enqueueWrite(const char* start, const char* end, ScanStatusIndicator status) {
+    LOG_ASSERT(end >= start, "Invalid buffer");
+    mSendQueue.push(PendingWrite(start, static_cast<uint32_t>(end - start), status));
+
+    // Only schedule a flush if none is pending already
+    if (!mFlushScheduled.exchange(true)) {
+        mSocket.scheduleScanFlush(mScanId);
+    }
+}
+
+void ServerScanQuery::queryDone() {
+    // The last processor signals the end of the scan with an empty write
+    // All buffers of the other processors were enqueued before they decremented the counter so the final write is
+    // guaranteed to be the last one in the send queue.
+    mExecutionEnd.store(std::chrono::steady_clock::now().time_since_epoch().count());
+    enqueueWrite(nullptr, nullptr, ScanStatusIndicator::DONE);
+}
+
+bool ServerScanQuery::bufferWritten() {
+    return (--mBuffersHeld == 0u && mAborted);
+}
+
+void ServerScanQuery::releaseBuffer(const char* start) {
+    if (mScanBufferManager.isPoolBuffer(start)) {
+        mScanBufferManager.releaseBuffer(start);
+        --mBuffersHeld;
+    } else {
+        delete[] start;
+        mSpilled -= mScanBufferManager.scanBufferLength();
+    }
+}
+
+void ServerScanQuery::fail(error::errors ec) {
+    LOG_ASSERT(!mFailed.load(), "Scan already failed");
+    mError = ec;
+    mFailed.store(true);
+}
+
+void ServerScanQuery::discardPending() {
+    PendingWrite write;
+    while (mSendQueue.try_pop(write)) {
+        mPending.emplace_back(write);
+    }
+
+    for (auto& write : mPending) {
+        if (write.status == ScanStatusIndicator::DONE) {
+            mAborted = true;
+        } else if (write.start != nullptr) {
+            releaseBuffer(write.start);
+        }
+    }
+    mPending.clear();
+
+    // Buffers still in flight are accounted to the scan ID so the scan can only be released after they completed
+    if (mAborted && mBuffersHeld.load() == 0u) {
+        mSocket.abortScan(mScanId);
+    }
+}
+
+bool ServerScanQuery::tryWrite(const char* start, uint32_t length, ScanStatusIndicator status, std::error_code& ec) {
+    auto regionLength = mDestRegion.length();
+    LOG_ASSERT(length <= regionLength, "Buffer is larger than the destination region");
+
+    // Skip the remaining space in the region if the buffer does not fit and wrap around
+    auto offset = mOffset;
+    auto position = offset % regionLength;
+    if (position + length > regionLength) {
+        offset += regionLength - position;
+        position = 0u;
+    }
+
+    // Check if the client released enough space
+    if (offset + length > mOffsetRead + regionLength) {
+        return false;
+    }
 
     auto userId = (static_cast<uint32_t>(mScanId) << 16) | static_cast<uint32_t>(status);
 
-    auto length = static_cast<uint32_t>(end - start);
-    auto buffer = mScanBufferManager.getBuffer(start, length);
+    if (start == nullptr) {
+        crossbow::infinio::ScatterGatherBuffer buffer(crossbow::infinio::InfinibandBuffer::INVALID_ID);
+        mSocket.writeScanBuffer(buffer, mDestRegion, position, userId, ec);
+    } else {
+        if (!mScanBufferManager.isPoolBuffer(start)) {
+            // Copy the parked output into a pool buffer or wait until one is released
+            char* data;
+            std::tie(data, std::ignore) = mScanBufferManager.acquireBuffer(priority());
+            if (data == nullptr) {
+                if (!mWaitingForBuffer.exchange(true)) {
+                    mScanBufferManager.waitForBuffer(mBufferWaiter, priority());
+                }
+                return false;
+            }
+            ++mBuffersHeld;
+            memcpy(data, start, length);
+            releaseBuffer(start);
+            start = data;
+        }
 
-    mSocket.writeScanBuffer(buffer, mDestRegion, mOffset, userId, ec);
+        auto buffer = mScanBufferManager.getBuffer(start, length);
+        mSocket.writeScanBuffer(buffer, mDestRegion, position, userId, ec);
+        if (ec) {
+            releaseBuffer(start);
+        }
+    }
     if (ec) {
-        mScanBufferManager.releaseBuffer(buffer.id());
-        return;
+        return true;
     }
-    mOffset += length;
 
-    // TODO Offset might not be accurate (requests in flight may fail)
-    if (mProgressRequest) {
-        mProgressRequest = false;
-        auto offset = mOffset;
-        auto socket = &mSocket;
-        auto scanId = mScanId;
-        mSocket.execute([socket, offset, scanId] () {
-            socket->writeScanProgress(scanId, false, offset);
-        });
+    if (offset != mOffset) {
+        mWrapOffset = mOffset;
     }
+    mOffset = offset + length;
+    return true;
 }
 
 } // namespace store
@@ -24,6 +24,8 @@
 
 #include <util/ScanQuery.hpp>
 
+#include <tellstore/ErrorCode.hpp>
+
 #include <crossbow/fixed_size_stack.hpp>
 #include <crossbow/infinio/InfinibandBuffer.hpp>
 #include <crossbow/infinio/InfinibandService.hpp>
@@ -31,15 +33,22 @@
 #include <crossbow/infinio/MessageId.hpp>
 #include <crossbow/non_copyable.hpp>
 
-#include <tbb/spin_mutex.h>
+#include <tbb/concurrent_queue.h>
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <system_error>
 #include <tuple>
 
 namespace tell {
 namespace store {
 
+class MemoryUsage;
 struct ServerConfig;
 class ServerSocket;
 
@@ -57,6 +66,46 @@ enum class ScanStatusIndicator : uint16_t {
     DONE,
 };
 
+/**
+ * @brief Callback notified when a scan buffer was released to the pool
+ *
+ * The owner disarms the waiter before it is destroyed, the pool skips disarmed waiters.
+ */
+class ScanBufferWaiter : crossbow::non_copyable, crossbow::non_movable {
+public:
+    explicit ScanBufferWaiter(std::function<void()> fun)
+            : mFun(std::move(fun)) {
+    }
+
+    /**
+     * @brief Invokes the callback
+     *
+     * @return False if the waiter was disarmed
+     */
+    bool notify() {
+        std::lock_guard<std::mutex> _(mMutex);
+        if (!mFun) {
+            return false;
+        }
+        mFun();
+        return true;
+    }
+
+    /**
+     * @brief Disarms the waiter
+     *
+     * Blocks until a concurrent notification completed.
+     */
+    void disarm() {
+        std::lock_guard<std::mutex> _(mMutex);
+        mFun = nullptr;
+    }
+
+private:
+    std::mutex mMutex;
+    std::function<void()> mFun;
+};
+
 /**
  * @brief Buffer pool for sharing scan buffers between all scans
  */
@@ -66,31 +115,124 @@ public:
 
     /**
      * @brief Acquires a new buffer from the pool
+     *
+     * Batch scans only get a buffer if more than the reserved number of buffers are available.
+     */
+    std::tuple<char*, uint32_t> acquireBuffer(ScanPriority priority);
+
+    /**
+     * @brief Whether a new scan of the given priority is admitted with the current number of available buffers
+     */
+    bool admit(ScanPriority priority) const {
+        return (priority == ScanPriority::INTERACTIVE || mBufferStack.size() > mScanBufferReserve);
+    }
+
+    /**
+     * @brief Registers the waiter to be notified once a buffer of the given priority can be acquired
+     *
+     * Every released buffer notifies one waiter (interactive waiters first). The waiter is notified immediately if a
+     * buffer is available at the time of registration.
      */
-    std::tuple<char*, uint32_t> acquireBuffer();
+    void waitForBuffer(std::shared_ptr<ScanBufferWaiter> waiter, ScanPriority priority);
 
     /**
      * @brief Release a buffer to the pool
      */
     void releaseBuffer(uint16_t id);
 
+    /**
+     * @brief Release the buffer containing the data pointer to the pool
+     */
+    void releaseBuffer(const char* data);
+
+    /**
+     * @brief Whether the data pointer belongs to a buffer of the pool
+     */
+    bool isPoolBuffer(const char* data) const {
+        auto address = reinterpret_cast<uintptr_t>(data);
+        auto begin = static_cast<uintptr_t>(mRegion.address());
+        return (address >= begin
+                && address < begin + static_cast<size_t>(mScanBufferCount) * static_cast<size_t>(mScanBufferLength));
+    }
+
     /**
      * @brief Get the InfinibandBuffer associated with the data pointer
      */
     crossbow::infinio::InfinibandBuffer getBuffer(const char* data, uint32_t length);
 
+    /**
+     * @brief Length of a single scan buffer
+     */
+    uint32_t scanBufferLength() const {
+        return mScanBufferLength;
+    }
+
+    /**
+     * @brief Maximum number of buffers a single scan holds at the same time
+     */
+    uint32_t queryBufferLimit() const {
+        return mQueryBufferLimit;
+    }
+
+    /**
+     * @brief Maximum amount of parked output a single scan can accumulate
+     */
+    uint64_t spillLimit() const {
+        return mSpillLimit;
+    }
+
+    /**
+     * @brief Adds the memory of the scan buffers currently in use to the usage
+     */
+    void collectUsage(MemoryUsage& usage) const;
+
 private:
+    /**
+     * @brief Notifies the first armed waiter in the queue
+     *
+     * @return Whether a waiter was notified
+     */
+    static bool notifyWaiter(tbb::concurrent_queue<std::shared_ptr<ScanBufferWaiter>>& waiters);
+
     uint16_t mScanBufferCount;
 
     uint32_t mScanBufferLength;
 
+    uint32_t mScanBufferReserve;
+
+    uint32_t mQueryBufferLimit;
+
+    uint64_t mSpillLimit;
+
     crossbow::infinio::AllocatedMemoryRegion mRegion;
 
     crossbow::fixed_size_stack<uint16_t> mBufferStack;
+
+    /// Interactive scans waiting for a buffer
+    tbb::concurrent_queue<std::shared_ptr<ScanBufferWaiter>> mInteractiveWaiters;
+
+    /// Batch scans waiting for a buffer
+    tbb::concurrent_queue<std::shared_ptr<ScanBufferWaiter>> mBatchWaiters;
 };
 
 /**
  * @brief ScanQuery implementation sending the scan data over the network
+ *
+ * The destination region on the client is used as a ring buffer: All offsets are logical offsets increasing
+ * monotonically over the lifetime of the scan, the physical position in the region is the offset modulo the region
+ * length. A buffer is never split across the end of the region, if it does not fit into the remaining space the rest of
+ * the region is skipped and the write wraps around to the beginning of the region.
+ *
+ * The scan threads never write to the network themselves: Completed buffers are handed to the query's send queue and
+ * the socket's processing thread writes them as soon as the client released enough space (credit based flow control)
+ * and the socket accepts more in-flight writes. A slow client only lets the buffers of its own query pile up while the
+ * scan threads continue with the remaining queries.
+ *
+ * A query holds at most a limited number of buffers from the shared pool. Once the limit is reached or the pool is
+ * exhausted the scan threads never wait: The output of the query is parked in private memory and the processing thread
+ * copies it into a pool buffer when it is written. Parking more output than the spill limit aborts the query with
+ * server_overlad, failing writes abort it with scan_write_failed. An aborted query discards its output and answers the
+ * scan with an error response once all its processors are done.
  */
 class ServerScanQuery final : public ScanQuery {
 public:
@@ -100,14 +242,34 @@ public:
             ScanBufferManager& scanBufferManager, crossbow::infinio::RemoteMemoryRegion destRegion,
             ServerSocket& socket);
 
+    ~ServerScanQuery();
+
     /**
      * @brief Request a progress update from the client
      *
+     * Grants the server credit to write up to the given offset plus the length of the destination region and flushes
+     * any queued buffers that fit into the released space.
+     *
+     * Must be called from the socket's processing thread.
+     *
+     * @param offsetRead The amount of data the client already released
+     * @return True if the socket did not accept all writes (see flushPending())
+     */
+    bool requestProgress(size_t offsetRead);
+
+    /**
+     * @brief Writes the queued buffers to the client
+     *
+     * Stops when either the client has not released enough space or the socket does not accept any more in-flight
+     * writes. After writing the socket's scan flush budget the remaining buffers are flushed in a new event scheduled
+     * on the socket's processing thread.
+     *
      * Must be called from the socket's processing thread.
      *
-     * @param offsetRead The amount of data the client already received
+     * @return True if the socket did not accept all writes and the query has to be flushed again as soon as in-flight
+     *         writes completed
      */
-    void requestProgress(size_t offsetRead);
+    bool flushPending();
 
     /**
      * @brief The scan completed and all in-flight packages have been received by the client
@@ -117,7 +279,25 @@ public:
     void completeScan();
 
     /**
-     * @brief Acquires a new buffer from the pool
+     * @brief A pool buffer of the query was written and released to the pool
+     *
+     * Must be called from the socket's processing thread.
+     *
+     * @return True if the query was aborted and the last of its buffers completed (see ServerSocket::abortScan())
+     */
+    bool bufferWritten();
+
+    /**
+     * @brief Error the query was aborted with
+     *
+     * Must be called from the socket's processing thread.
+     */
+    error::errors error() const {
+        return mError;
+    }
+
+    /**
+     * @brief Acquires a new buffer from the pool or a private spill buffer if the query can not take one from the pool
      */
     virtual std::tuple<char*, uint32_t> acquireBuffer() final override;
 
@@ -162,25 +342,140 @@ public:
      */
     virtual ScanQueryProcessor createProcessor() final override;
 
+    /**
+     * @brief Time at which the scan request was received
+     */
+    std::chrono::steady_clock::time_point startTime() const {
+        return mStartTime;
+    }
+
+    /**
+     * @brief Time at which the first scan thread started processing the query
+     *
+     * Only valid after the scan completed.
+     */
+    std::chrono::steady_clock::time_point executionStartTime() const {
+        return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(mExecutionStart.load()));
+    }
+
+    /**
+     * @brief Time at which the last scan thread finished processing the query
+     *
+     * Only valid after the scan completed.
+     */
+    std::chrono::steady_clock::time_point executionEndTime() const {
+        return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(mExecutionEnd.load()));
+    }
+
 private:
     /**
-     * @brief Writes the buffer to the client
+     * @brief Buffer waiting to be written to the client
+     */
+    struct PendingWrite {
+        PendingWrite()
+                : PendingWrite(nullptr, 0u, ScanStatusIndicator::ONGOING) {
+        }
+
+        PendingWrite(const char* start, uint32_t length, ScanStatusIndicator status)
+                : start(start),
+                  length(length),
+                  status(status) {
+        }
+
+        const char* start;
+        uint32_t length;
+        ScanStatusIndicator status;
+    };
+
+    /**
+     * @brief Hands the buffer to the send queue and schedules the queue to be flushed by the socket's processing thread
      *
-     * @param start Begin pointer to the buffer containing the tuples
-     * @param end End pointer to the buffer containing the tuples
+     * @param start Begin pointer to the buffer containing the tuples (or nullptr for an empty write)
+     * @param end End pointer to the buffer containing the tuples (or nullptr for an empty write)
      * @param status Indicator if the scan is still progressing
-     * @param ec Error in case the write fails
      */
-    void doWrite(const char* start, const char* end, ScanStatusIndicator status, std::error_code& ec);
+    void enqueueWrite(const char* start, const char* end, ScanStatusIndicator status);
+
+    /**
+     * @brief Enqueues the final write after all ScanQueryProcessor are done
+     */
+    virtual void queryDone() final override;
 
-    /// Number of currently active ScanQueryProcessor
-    uint32_t mActive;
+    /**
+     * @brief Returns the buffer to the pool or frees it if it is a spill buffer
+     */
+    void releaseBuffer(const char* start);
+
+    /**
+     * @brief Aborts the query with the given error
+     *
+     * Discards all queued buffers and answers the scan with an error response once the final write was enqueued.
+     *
+     * Must be called from the socket's processing thread.
+     */
+    void fail(error::errors ec);
+
+    /**
+     * @brief Discards the queued buffers of an aborted query
+     *
+     * Must be called from the socket's processing thread.
+     */
+    void discardPending();
+
+    /**
+     * @brief Tries to write the buffer into the destination region
+     *
+     * Spill buffers are copied into a pool buffer first, if the pool is exhausted the query waits for a buffer to be
+     * released.
+     *
+     * Must be called from the socket's processing thread.
+     *
+     * @return False if the client has not released enough space to write the buffer or no pool buffer is available
+     */
+    bool tryWrite(const char* start, uint32_t length, ScanStatusIndicator status, std::error_code& ec);
+
+    /// Time at which the scan request was received
+    std::chrono::steady_clock::time_point mStartTime;
+
+    /// Ticks of the time at which the first ScanQueryProcessor was created (0 if none was created yet)
+    std::atomic<std::chrono::steady_clock::rep> mExecutionStart;
+
+    /// Ticks of the time at which the last ScanQueryProcessor finished
+    std::atomic<std::chrono::steady_clock::rep> mExecutionEnd;
 
     /// Scan ID of the starting process on the remote host
     uint16_t mScanId;
 
     /// Whether the client requested a progress update
-    std::atomic<bool> mProgressRequest;
+    bool mProgressRequest;
+
+    /// Whether a flush of the send queue is already scheduled on the socket's processing thread
+    std::atomic<bool> mFlushScheduled;
+
+    /// Number of pool buffers held by the query (acquired and not yet released after their write completed)
+    std::atomic<uint32_t> mBuffersHeld;
+
+    /// Amount of parked output in spill buffers
+    std::atomic<uint64_t> mSpilled;
+
+    /// Whether the parked output exceeded the spill limit
+    std::atomic<bool> mSpillExceeded;
+
+    /// Whether the query is aborted and discards its output
+    std::atomic<bool> mFailed;
+
+    /// Error the query was aborted with (only accessed by the socket's processing thread)
+    error::errors mError;
+
+    /// Whether the aborted query discarded its final write and waits for its in-flight buffers to complete (only
+    /// accessed by the socket's processing thread)
+    bool mAborted;
+
+    /// Whether the query is registered as waiter at the buffer pool
+    std::atomic<bool> mWaitingForBuffer;
+
+    /// Waiter scheduling a flush of the query when a pool buffer is released
+    std::shared_ptr<ScanBufferWaiter> mBufferWaiter;
 
     /// Buffer pool to acquire scan buffer from
     ScanBufferManager& mScanBufferManager;
@@ -191,11 +486,22 @@ private:
     /// Connection to the remote host
     ServerSocket& mSocket;
 
-    /// Mutex used to serialize writes over the connection
-    tbb::spin_mutex mSendMutex;
+    /// Queue the scan threads hand their completed buffers to
+    tbb::concurrent_queue<PendingWrite> mSendQueue;
+
+    /// Buffers taken from the send queue waiting for credit or socket capacity (only accessed by the socket's
+    /// processing thread)
+    std::deque<PendingWrite> mPending;
 
-    /// Current offset into the destination region
+    /// Logical offset up to which data was written into the destination region
     size_t mOffset;
+
+    /// Logical offset at which the remaining space of the region was skipped the last time the write wrapped around (0
+    /// if the write never wrapped around)
+    size_t mWrapOffset;
+
+    /// Logical offset up to which the client released the destination region
+    size_t mOffsetRead;
 };
 
 } // namespace store
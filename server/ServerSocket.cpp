@@ -24,6 +24,9 @@
 #include "ServerSocket.hpp"
 
 #include <util/PageManager.hpp>
+#include <util/PerfCounters.hpp>
+#include <util/Reclamation.hpp>
+#include <util/ThreadAffinity.hpp>
 
 #include <tellstore/ErrorCode.hpp>
 #include <tellstore/MessageTypes.hpp>
@@ -32,26 +35,229 @@
 #include <crossbow/infinio/InfinibandBuffer.hpp>
 #include <crossbow/logger.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
 namespace tell {
 namespace store {
+namespace {
 
-void ServerSocket::writeScanProgress(uint16_t scanId, bool done, size_t offset) {
-    uint32_t messageLength = 2 * sizeof(size_t);
-    writeResponse(crossbow::infinio::MessageId(scanId, true), ResponseType::SCAN, messageLength, [done, offset]
-            (crossbow::buffer_writer& message, std::error_code& /* ec */) {
+/**
+ * @brief Single point operation contained in a batch request
+ */
+struct BatchOperation {
+    BatchOperation(uint32_t t, uint32_t version, uint64_t tid, uint64_t k, uint32_t length, const char* d)
+            : type(t),
+              schemaVersion(version),
+              tableId(tid),
+              key(k),
+              dataLength(length),
+              data(d) {
+    }
+
+    uint32_t type;
+    uint32_t schemaVersion;
+    uint64_t tableId;
+    uint64_t key;
+    uint32_t dataLength;
+    const char* data;
+};
+
+/**
+ * @brief Executes a run of get operations on the same table and appends their results
+ *
+ * Gets whose tuple does not fit into the remaining response space fail with error::response_too_large.
+ *
+ * @param remaining Space left in the response for tuples, reduced by the tuples appended
+ */
+void batchGet(Storage& storage, const BatchOperation* operations, size_t count,
+        const commitmanager::SnapshotDescriptor& snapshot, std::vector<char>& results, size_t& remaining) {
+    std::vector<uint64_t> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        keys.emplace_back(operations[i].key);
+    }
+
+    // The result header of an operation has to precede its tuple: The storage reports the keys in order so the headers
+    // of all keys up to the current one are appended right before its tuple is written
+    std::vector<size_t> resultOffsets;
+    resultOffsets.reserve(count);
+    auto appendHeaders = [&results, &resultOffsets] (size_t last) {
+        while (resultOffsets.size() <= last) {
+            resultOffsets.emplace_back(results.size());
+            results.resize(results.size() + sizeof(uint64_t));
+        }
+    };
+
+    // Tuples not fitting into the response are copied into a scratch buffer and dropped
+    std::vector<char> discarded;
+    std::vector<size_t> overflows;
+
+    std::vector<int> ec(count);
+    storage.get(operations->tableId, keys.data(), count, snapshot, ec.data(),
+            [&results, &resultOffsets, &appendHeaders, &remaining, &discarded, &overflows]
+            (size_t idx, size_t size, uint64_t version, bool isNewest) {
+        LOG_ASSERT(idx >= resultOffsets.size(), "Keys reported out of order");
+        appendHeaders(idx);
+
+        auto resultLength = 2 * sizeof(uint64_t) + crossbow::align(size, 8u);
+        if (resultLength > remaining) {
+            overflows.emplace_back(idx);
+            discarded.resize(size);
+            return discarded.data();
+        }
+        remaining -= resultLength;
+
+        auto offset = results.size();
+        results.resize(offset + resultLength);
+
+        crossbow::buffer_writer message(results.data() + offset, results.size() - offset);
+        message.write<uint64_t>(version);
+        message.write<uint8_t>(isNewest ? 0x1u : 0x0u);
+        message.set(0, sizeof(uint32_t) - sizeof(uint8_t));
+        message.write<uint32_t>(size);
+        return message.data();
+    });
+    appendHeaders(count - 1);
+
+    for (auto idx : overflows) {
+        ec[idx] = error::response_too_large;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        auto result = results.data() + resultOffsets[i];
+        *reinterpret_cast<uint32_t*>(result) = static_cast<uint32_t>(ec[i]);
+        *reinterpret_cast<uint32_t*>(result + sizeof(uint32_t)) = (ec[i] == 0 ? 0x1u : 0x0u);
+    }
+}
+
+/**
+ * @brief Whether the request modifies the storage
+ */
+bool isModification(uint32_t messageType) {
+    switch (messageType) {
+    case crossbow::to_underlying(RequestType::CREATE_TABLE):
+    case crossbow::to_underlying(RequestType::ALTER_TABLE):
+    case crossbow::to_underlying(RequestType::DROP_TABLE):
+    case crossbow::to_underlying(RequestType::TRUNCATE_TABLE):
+    case crossbow::to_underlying(RequestType::UPDATE):
+    case crossbow::to_underlying(RequestType::INSERT):
+    case crossbow::to_underlying(RequestType::REMOVE):
+    case crossbow::to_underlying(RequestType::REVERT):
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Resolves the file name sent by the client against the export directory of the server
+ *
+ * Only plain file names are accepted: Absolute paths, names containing a path separator and the relative directory
+ * entries are rejected so the export can not write outside of the directory.
+ *
+ * @return False if exports are disabled or the name is not a plain file name
+ */
+bool resolveExportPath(const crossbow::string& directory, const crossbow::string& name, crossbow::string& path) {
+    if (directory.empty() || name.empty() || name == "." || name == "..") {
+        return false;
+    }
+    if (name.find('/') != crossbow::string::npos || name.find('\0') != crossbow::string::npos) {
+        return false;
+    }
+
+    path = directory;
+    if (path[path.size() - 1] != '/') {
+        path += '/';
+    }
+    path += name;
+    return true;
+}
+
+} // anonymous namespace
+
+void ServerSocket::writeScanProgress(uint16_t scanId, bool done, size_t offset, size_t wrapOffset) {
+    uint32_t messageLength = 3 * sizeof(size_t);
+    writeResponse(crossbow::infinio::MessageId(scanId, true), ResponseType::SCAN, messageLength,
+            [done, offset, wrapOffset] (crossbow::buffer_writer& message, std::error_code& /* ec */) {
         message.write<uint8_t>(done ? 0x1u : 0x0u);
         message.set(0, sizeof(size_t) - sizeof(uint8_t));
         message.write<size_t>(offset);
+        message.write<size_t>(wrapOffset);
+    });
+}
+
+bool ServerSocket::requestScanProgress(uint16_t scanId, size_t offsetRead) {
+    auto i = mScans.find(scanId);
+    if (i == mScans.end()) {
+        return false;
+    }
+
+    if (i->second->requestProgress(offsetRead)) {
+        queueScanFlush(scanId);
+    }
+    return true;
+}
+
+void ServerSocket::flushScan(uint16_t scanId) {
+    auto i = mScans.find(scanId);
+    if (i == mScans.end()) {
+        return;
+    }
+
+    if (i->second->flushPending()) {
+        queueScanFlush(scanId);
+    }
+}
+
+void ServerSocket::abortScan(uint16_t scanId) {
+    execute([this, scanId] () {
+        auto i = mScans.find(scanId);
+        if (i == mScans.end()) {
+            return;
+        }
+
+        auto ec = i->second->error();
+        LOG_DEBUG("Scan with ID %1% aborted [error = %2%]", scanId, ec);
+        writeErrorResponse(crossbow::infinio::MessageId(scanId, true), ec);
+        mScans.erase(i);
     });
 }
 
 void ServerSocket::onRequest(crossbow::infinio::MessageId messageId, uint32_t messageType,
         crossbow::buffer_reader& request) {
-#ifdef NDEBUG
-#else
     LOG_TRACE("MID %1%] Handling request of type %2%", messageId.userId(), messageType);
     auto startTime = std::chrono::steady_clock::now();
-#endif
+
+    // Read replicas only apply the modifications streamed from their primary
+    if (manager().replica() && isModification(messageType)) {
+        writeErrorResponse(messageId, error::read_only_replica);
+        return;
+    }
+
+    // Requests operating on a single table carry the table ID in the first 8 bytes
+    auto hasTable = false;
+    uint64_t tableId = 0u;
+    switch (messageType) {
+    case crossbow::to_underlying(RequestType::GET):
+    case crossbow::to_underlying(RequestType::UPDATE):
+    case crossbow::to_underlying(RequestType::INSERT):
+    case crossbow::to_underlying(RequestType::REMOVE):
+    case crossbow::to_underlying(RequestType::REVERT):
+    case crossbow::to_underlying(RequestType::SCAN):
+    case crossbow::to_underlying(RequestType::EXPORT_TABLE):
+    case crossbow::to_underlying(RequestType::ALTER_TABLE):
+    case crossbow::to_underlying(RequestType::DROP_TABLE):
+    case crossbow::to_underlying(RequestType::TRUNCATE_TABLE): {
+        if (request.canRead(sizeof(uint64_t))) {
+            hasTable = true;
+            memcpy(&tableId, request.data(), sizeof(uint64_t));
+        }
+    } break;
+    }
 
     switch (messageType) {
 
@@ -99,17 +305,53 @@ void ServerSocket::onRequest(crossbow::infinio::MessageId messageId, uint32_t me
         // TODO Implement commit logic
     } break;
 
+    case crossbow::to_underlying(RequestType::BATCH): {
+        handleBatch(messageId, request);
+    } break;
+
+    case crossbow::to_underlying(RequestType::WATERMARK): {
+        handleWatermark(messageId, request);
+    } break;
+
+    case crossbow::to_underlying(RequestType::STATS): {
+        handleStats(messageId, request);
+    } break;
+
+    case crossbow::to_underlying(RequestType::MEMORY_USAGE): {
+        handleMemoryUsage(messageId, request);
+    } break;
+
+    case crossbow::to_underlying(RequestType::EXPORT_TABLE): {
+        handleExportTable(messageId, request);
+    } break;
+
+    case crossbow::to_underlying(RequestType::ALTER_TABLE): {
+        handleAlterTable(messageId, request);
+    } break;
+
+    case crossbow::to_underlying(RequestType::DROP_TABLE): {
+        handleDropTable(messageId, request);
+    } break;
+
+    case crossbow::to_underlying(RequestType::TRUNCATE_TABLE): {
+        handleTruncateTable(messageId, request);
+    } break;
+
     default: {
         writeErrorResponse(messageId, error::unkown_request);
     } break;
     }
 
-#ifdef NDEBUG
-#else
     auto endTime = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime);
+    if (hasTable) {
+        mStatistics.recordRequest(messageType, tableId, duration.count(), [this, tableId] () {
+            return (mStorage.getTable(tableId) != nullptr);
+        });
+    } else {
+        mStatistics.recordRequest(messageType, duration.count());
+    }
     LOG_TRACE("MID %1%] Handling request took %2%ns", messageId.userId(), duration.count());
-#endif
 }
 
 void ServerSocket::handleCreateTable(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request) {
@@ -128,6 +370,10 @@ void ServerSocket::handleCreateTable(crossbow::infinio::MessageId messageId, cro
         return;
     }
 
+    if (auto replicationLog = manager().replicationLog()) {
+        replicationLog->publishCreateTable(tableId, tableName, schema);
+    }
+
     uint32_t messageLength = sizeof(uint64_t);
     writeResponse(messageId, ResponseType::CREATE_TABLE, messageLength, [tableId]
             (crossbow::buffer_writer& message, std::error_code& /* ec */) {
@@ -135,21 +381,90 @@ void ServerSocket::handleCreateTable(crossbow::infinio::MessageId messageId, cro
     });
 }
 
+void ServerSocket::handleAlterTable(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request) {
+    auto tableId = request.read<uint64_t>();
+    auto schemaVersion = request.read<uint32_t>();
+    auto validateOnly = (request.read<uint32_t>() != 0x0u);
+    auto schema = Schema::deserialize(request);
+
+    if (validateOnly) {
+        writeModificationResponse(messageId, tableId, mStorage.checkAlterTable(tableId, schemaVersion, schema));
+        return;
+    }
+
+    int ec;
+    {
+        ReplicationOrderGuard _(manager().replicationLog(), true);
+        ec = mStorage.alterTable(tableId, schemaVersion, schema);
+        if (ec == 0) {
+            if (auto replicationLog = manager().replicationLog()) {
+                replicationLog->publishAlterTable(tableId, schemaVersion + 1u, schema);
+            }
+        }
+    }
+
+    // The modification response invalidates the tuples of the table in the read caches of the clients
+    writeModificationResponse(messageId, tableId, ec);
+}
+
+void ServerSocket::handleDropTable(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request) {
+    auto tableId = request.read<uint64_t>();
+
+    int ec;
+    {
+        ReplicationOrderGuard _(manager().replicationLog(), true);
+        ec = mStorage.dropTable(tableId);
+        if (ec == 0) {
+            if (auto replicationLog = manager().replicationLog()) {
+                replicationLog->publishTable(ReplicationRecordType::DROP_TABLE, tableId);
+            }
+        }
+    }
+
+    writeModificationResponse(messageId, tableId, ec);
+}
+
+void ServerSocket::handleTruncateTable(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request) {
+    auto tableId = request.read<uint64_t>();
+
+    int ec;
+    {
+        ReplicationOrderGuard _(manager().replicationLog(), true);
+        ec = mStorage.truncateTable(tableId);
+        if (ec == 0) {
+            if (auto replicationLog = manager().replicationLog()) {
+                replicationLog->publishTable(ReplicationRecordType::TRUNCATE_TABLE, tableId);
+            }
+        }
+    }
+
+    writeModificationResponse(messageId, tableId, ec);
+}
+
 void ServerSocket::handleGetTables(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request) {
+    // Keeps dropped tables alive until the response is written
+    ReclamationGuard _;
     auto tables = mStorage.getTables();
 
+    // The schema versions are fixed up front so a concurrent schema change can not change the message length
+    std::vector<uint32_t> schemaVersions;
+    schemaVersions.reserve(tables.size());
+
     uint32_t messageLength = sizeof(uint64_t);
     for (auto table : tables) {
+        schemaVersions.emplace_back(table->schemaVersion());
         messageLength += sizeof(uint64_t) + sizeof(uint32_t);
         messageLength += table->tableName().size();
         messageLength = crossbow::align(messageLength, 8u);
-        messageLength += table->schema().serializedLength();
+        messageLength += sizeof(uint64_t);
+        messageLength += table->schema(schemaVersions.back()).serializedLength();
     }
 
-    writeResponse(messageId, ResponseType::GET_TABLES, messageLength, [&tables]
+    writeResponse(messageId, ResponseType::GET_TABLES, messageLength, [&tables, &schemaVersions]
             (crossbow::buffer_writer& message, std::error_code& /* ec */) {
         message.write<uint64_t>(tables.size());
-        for (auto table : tables) {
+        for (decltype(tables.size()) i = 0u; i < tables.size(); ++i) {
+            auto table = tables[i];
             message.write<uint64_t>(table->tableId());
 
             auto& tableName = table->tableName();
@@ -157,8 +472,9 @@ void ServerSocket::handleGetTables(crossbow::infinio::MessageId messageId, cross
             message.write(tableName.data(), tableName.size());
             message.align(8u);
 
-            auto& schema = table->schema();
-            schema.serialize(message);
+            message.write<uint32_t>(schemaVersions[i]);
+            message.align(8u);
+            table->schema(schemaVersions[i]).serialize(message);
         }
     });
 }
@@ -168,6 +484,7 @@ void ServerSocket::handleGetTable(crossbow::infinio::MessageId messageId, crossb
     crossbow::string tableName(request.read(tableNameLength), tableNameLength);
 
     uint64_t tableId = 0x0u;
+    ReclamationGuard _;
     auto table = mStorage.getTable(tableName, tableId);
 
     if (!table) {
@@ -175,12 +492,15 @@ void ServerSocket::handleGetTable(crossbow::infinio::MessageId messageId, crossb
         return;
     }
 
-    auto& schema = table->schema();
+    auto schemaVersion = table->schemaVersion();
+    auto& schema = table->schema(schemaVersion);
 
-    uint32_t messageLength = sizeof(uint64_t) + schema.serializedLength();
-    writeResponse(messageId, ResponseType::GET_TABLE, messageLength, [tableId, &schema]
+    uint32_t messageLength = 2 * sizeof(uint64_t) + schema.serializedLength();
+    writeResponse(messageId, ResponseType::GET_TABLE, messageLength, [tableId, schemaVersion, &schema]
             (crossbow::buffer_writer& message, std::error_code& /* ec */) {
         message.write<uint64_t>(tableId);
+        message.write<uint32_t>(schemaVersion);
+        message.align(8u);
         schema.serialize(message);
     });
 }
@@ -190,13 +510,16 @@ void ServerSocket::handleGet(crossbow::infinio::MessageId messageId, crossbow::b
     auto key = request.read<uint64_t>();
     handleSnapshot(messageId, request, [this, messageId, tableId, key]
             (const commitmanager::SnapshotDescriptor& snapshot) {
-        auto ec = mStorage.get(tableId, key, snapshot, [this, messageId]
+        // The modification counter has to be read before the tuple is read from the storage
+        auto watermark = manager().watermark().get(tableId);
+        auto ec = mStorage.get(tableId, key, snapshot, [this, messageId, watermark]
                 (size_t size, uint64_t version, bool isNewest) {
             char* data = nullptr;
-            // Message size is 8 bytes version plus 8 bytes (isNewest, size) and data
-            uint32_t messageLength = 2 * sizeof(uint64_t) + size;
-            writeResponse(messageId, ResponseType::GET, messageLength, [size, version, isNewest, &data]
+            // Message size is 8 bytes watermark and 8 bytes version plus 8 bytes (isNewest, size) and data
+            uint32_t messageLength = 3 * sizeof(uint64_t) + size;
+            writeResponse(messageId, ResponseType::GET, messageLength, [size, watermark, version, isNewest, &data]
                     (crossbow::buffer_writer& message, std::error_code& /* ec */) {
+                message.write<uint64_t>(watermark);
                 message.write<uint64_t>(version);
                 message.write<uint8_t>(isNewest ? 0x1u : 0x0u);
                 message.set(0, sizeof(uint32_t) - sizeof(uint8_t));
@@ -217,15 +540,23 @@ void ServerSocket::handleUpdate(crossbow::infinio::MessageId messageId, crossbow
     auto tableId = request.read<uint64_t>();
     auto key = request.read<uint64_t>();
 
-    request.advance(sizeof(uint32_t));
+    auto schemaVersion = request.read<uint32_t>();
     auto dataLength = request.read<uint32_t>();
     auto data = request.read(dataLength);
     request.align(8u);
 
-    handleSnapshot(messageId, request, [this, messageId, tableId, key, dataLength, data]
+    handleSnapshot(messageId, request, [this, messageId, tableId, key, schemaVersion, dataLength, data]
             (const commitmanager::SnapshotDescriptor& snapshot) {
-        auto ec = mStorage.update(tableId, key, dataLength, data, snapshot);
-        writeModificationResponse(messageId, ec);
+        int ec;
+        {
+            ReplicationOrderGuard _(manager().replicationLog(), false);
+            ec = mStorage.update(tableId, key, dataLength, data, snapshot, schemaVersion);
+            if (ec == 0) {
+                replicate(crossbow::to_underlying(RequestType::UPDATE), tableId, key, snapshot, schemaVersion,
+                        dataLength, data);
+            }
+        }
+        writeModificationResponse(messageId, tableId, ec);
     });
 }
 
@@ -233,15 +564,23 @@ void ServerSocket::handleInsert(crossbow::infinio::MessageId messageId, crossbow
     auto tableId = request.read<uint64_t>();
     auto key = request.read<uint64_t>();
 
-    request.advance(sizeof(uint32_t));
+    auto schemaVersion = request.read<uint32_t>();
     auto dataLength = request.read<uint32_t>();
     auto data = request.read(dataLength);
     request.align(8u);
 
-    handleSnapshot(messageId, request, [this, messageId, tableId, key, dataLength, data]
+    handleSnapshot(messageId, request, [this, messageId, tableId, key, schemaVersion, dataLength, data]
             (const commitmanager::SnapshotDescriptor& snapshot) {
-        auto ec = mStorage.insert(tableId, key, dataLength, data, snapshot);
-        writeModificationResponse(messageId, ec);
+        int ec;
+        {
+            ReplicationOrderGuard _(manager().replicationLog(), false);
+            ec = mStorage.insert(tableId, key, dataLength, data, snapshot, schemaVersion);
+            if (ec == 0) {
+                replicate(crossbow::to_underlying(RequestType::INSERT), tableId, key, snapshot, schemaVersion,
+                        dataLength, data);
+            }
+        }
+        writeModificationResponse(messageId, tableId, ec);
     });
 }
 
@@ -251,8 +590,15 @@ void ServerSocket::handleRemove(crossbow::infinio::MessageId messageId, crossbow
 
     handleSnapshot(messageId, request, [this, messageId, tableId, key]
             (const commitmanager::SnapshotDescriptor& snapshot) {
-        auto ec = mStorage.remove(tableId, key, snapshot);
-        writeModificationResponse(messageId, ec);
+        int ec;
+        {
+            ReplicationOrderGuard _(manager().replicationLog(), false);
+            ec = mStorage.remove(tableId, key, snapshot);
+            if (ec == 0) {
+                replicate(crossbow::to_underlying(RequestType::REMOVE), tableId, key, snapshot, 0u);
+            }
+        }
+        writeModificationResponse(messageId, tableId, ec);
     });
 }
 
@@ -262,8 +608,162 @@ void ServerSocket::handleRevert(crossbow::infinio::MessageId messageId, crossbow
 
     handleSnapshot(messageId, request, [this, messageId, tableId, key]
             (const commitmanager::SnapshotDescriptor& snapshot) {
-        auto ec = mStorage.revert(tableId, key, snapshot);
-        writeModificationResponse(messageId, ec);
+        int ec;
+        {
+            ReplicationOrderGuard _(manager().replicationLog(), false);
+            ec = mStorage.revert(tableId, key, snapshot);
+            if (ec == 0) {
+                replicate(crossbow::to_underlying(RequestType::REVERT), tableId, key, snapshot, 0u);
+            }
+        }
+        writeModificationResponse(messageId, tableId, ec);
+    });
+}
+
+void ServerSocket::handleBatch(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request) {
+    auto operationCount = request.read<uint32_t>();
+    request.advance(sizeof(uint32_t));
+
+    std::vector<BatchOperation> operations;
+    operations.reserve(operationCount);
+    for (decltype(operationCount) i = 0; i < operationCount; ++i) {
+        auto type = request.read<uint16_t>();
+        auto schemaVersion = request.read<uint16_t>();
+        auto dataLength = request.read<uint32_t>();
+        auto tableId = request.read<uint64_t>();
+        auto key = request.read<uint64_t>();
+        auto data = request.read(dataLength);
+        request.align(8u);
+        operations.emplace_back(type, schemaVersion, tableId, key, dataLength, data);
+    }
+
+    handleSnapshot(messageId, request, [this, messageId, &operations]
+            (const commitmanager::SnapshotDescriptor& snapshot) {
+        // Every operation has a result header: Batches whose headers alone exceed the response are rejected before
+        // executing any of their operations
+        auto headerLength = sizeof(uint64_t) + operations.size() * sizeof(uint64_t);
+        if (headerLength > manager().maxResponseLength()) {
+            writeErrorResponse(messageId, error::response_too_large);
+            return;
+        }
+        auto remaining = manager().maxResponseLength() - headerLength;
+
+        // The results are collected before writing the response as the size of the tuples is only known after the get
+        std::vector<char> results(sizeof(uint64_t));
+        results.reserve(headerLength);
+        *reinterpret_cast<uint64_t*>(results.data()) = operations.size();
+
+        for (size_t i = 0; i < operations.size();) {
+            auto& operation = operations[i];
+
+            // Consecutive gets on the same table are resolved together so the storage can overlap their lookups
+            if (operation.type == crossbow::to_underlying(RequestType::GET)) {
+                auto end = i + 1;
+                while (end < operations.size() && operations[end].type == operation.type
+                        && operations[end].tableId == operation.tableId) {
+                    ++end;
+                }
+                batchGet(mStorage, operations.data() + i, end - i, snapshot, results, remaining);
+                i = end;
+                continue;
+            }
+
+            auto resultOffset = results.size();
+            results.resize(resultOffset + sizeof(uint64_t));
+
+            int ec;
+            if (manager().replica() && isModification(operation.type)) {
+                ec = error::read_only_replica;
+            } else {
+                ReplicationOrderGuard _(manager().replicationLog(), false);
+                switch (operation.type) {
+                case crossbow::to_underlying(RequestType::UPDATE): {
+                    ec = mStorage.update(operation.tableId, operation.key, operation.dataLength, operation.data,
+                            snapshot, operation.schemaVersion);
+                } break;
+
+                case crossbow::to_underlying(RequestType::INSERT): {
+                    ec = mStorage.insert(operation.tableId, operation.key, operation.dataLength, operation.data,
+                            snapshot, operation.schemaVersion);
+                } break;
+
+                case crossbow::to_underlying(RequestType::REMOVE): {
+                    ec = mStorage.remove(operation.tableId, operation.key, snapshot);
+                } break;
+
+                case crossbow::to_underlying(RequestType::REVERT): {
+                    ec = mStorage.revert(operation.tableId, operation.key, snapshot);
+                } break;
+
+                default: {
+                    ec = error::unkown_request;
+                } break;
+                }
+
+                if (ec == 0) {
+                    replicate(operation.type, operation.tableId, operation.key, snapshot, operation.schemaVersion,
+                            operation.dataLength, operation.data);
+                }
+            }
+
+            if (ec == 0) {
+                manager().watermark().increment(operation.tableId);
+            }
+
+            auto result = results.data() + resultOffset;
+            *reinterpret_cast<uint32_t*>(result) = static_cast<uint32_t>(ec);
+            *reinterpret_cast<uint32_t*>(result + sizeof(uint32_t)) = 0x0u;
+            ++i;
+        }
+
+        uint32_t messageLength = results.size();
+        writeResponse(messageId, ResponseType::BATCH, messageLength, [&results]
+                (crossbow::buffer_writer& message, std::error_code& /* ec */) {
+            message.write(results.data(), results.size());
+        });
+    });
+}
+
+void ServerSocket::handleWatermark(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request) {
+    auto tableCount = request.read<uint32_t>();
+    request.advance(sizeof(uint32_t));
+    auto tableIds = reinterpret_cast<const uint64_t*>(request.read(tableCount * sizeof(uint64_t)));
+
+    uint32_t messageLength = tableCount * sizeof(uint64_t);
+    writeResponse(messageId, ResponseType::WATERMARK, messageLength, [this, tableCount, tableIds]
+            (crossbow::buffer_writer& message, std::error_code& /* ec */) {
+        auto& watermark = manager().watermark();
+        for (decltype(tableCount) i = 0; i < tableCount; ++i) {
+            message.write<uint64_t>(watermark.get(tableIds[i]));
+        }
+    });
+}
+
+void ServerSocket::handleStats(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& /* request */) {
+    auto statistics = manager().collectStatistics();
+
+    // Drop the least used tables if the statistics do not fit into a single message
+    if (auto dropped = statistics.truncateTables(manager().maxResponseLength())) {
+        LOG_WARN("Statistics of %1% tables do not fit into the stats response", dropped);
+    }
+
+    uint32_t messageLength = statistics.serializedLength();
+    writeResponse(messageId, ResponseType::STATS, messageLength, [&statistics]
+            (crossbow::buffer_writer& message, std::error_code& /* ec */) {
+        statistics.serialize(message);
+    });
+}
+
+void ServerSocket::handleMemoryUsage(crossbow::infinio::MessageId messageId,
+        crossbow::buffer_reader& /* request */) {
+    MemoryUsage usage;
+    mStorage.collectMemoryUsage(usage);
+    manager().scanBufferManager().collectUsage(usage);
+
+    uint32_t messageLength = usage.serializedLength();
+    writeResponse(messageId, ResponseType::MEMORY_USAGE, messageLength, [&usage]
+            (crossbow::buffer_writer& message, std::error_code& /* ec */) {
+        usage.serialize(message);
     });
 }
 
@@ -277,11 +777,25 @@ void ServerSocket::handleScan(crossbow::infinio::MessageId messageId, crossbow::
     auto remoteKey = request.read<uint32_t>();
     crossbow::infinio::RemoteMemoryRegion remoteRegion(remoteAddress, remoteLength, remoteKey);
 
+    // The remote region is used as ring buffer and must be able to hold at least one complete scan buffer
+    if (remoteLength < manager().scanBufferManager().scanBufferLength()) {
+        writeErrorResponse(messageId, error::invalid_scan);
+        return;
+    }
+
     auto selectionLength = request.read<uint32_t>();
     if (selectionLength % 8u != 0u || selectionLength < 16u) {
         writeErrorResponse(messageId, error::invalid_scan);
         return;
     }
+
+    // Reject the scan if the client already has its share of scans running or if batch scans would eat into the scan
+    // buffers reserved for interactive scans
+    if ((mMaxScans != 0u && mScans.size() >= mMaxScans)
+            || !manager().scanBufferManager().admit(scanPriority(queryType))) {
+        writeErrorResponse(messageId, error::server_overlad);
+        return;
+    }
     auto selectionData = request.read(selectionLength);
     std::unique_ptr<char[]> selection(new char[selectionLength]);
     memcpy(selection.get(), selectionData, selectionLength);
@@ -302,7 +816,12 @@ void ServerSocket::handleScan(crossbow::infinio::MessageId messageId, crossbow::
         auto scanSnapshot = commitmanager::SnapshotDescriptor::create(snapshot.lowestActiveVersion(),
                 snapshot.baseVersion(), snapshot.version(), snapshot.data());
 
+        ReclamationGuard _;
         auto table = mStorage.getTable(tableId);
+        if (!table) {
+            writeErrorResponse(messageId, error::invalid_table);
+            return;
+        }
 
         std::unique_ptr<ServerScanQuery> scanData(new ServerScanQuery(scanId, queryType, std::move(selection),
                 selectionLength, std::move(query), queryLength, std::move(scanSnapshot), table->record(),
@@ -327,14 +846,84 @@ void ServerSocket::handleScanProgress(crossbow::infinio::MessageId messageId, cr
 
     auto offsetRead = request.read<size_t>();
 
-    auto i = mScans.find(scanId);
-    if (i == mScans.end()) {
+    if (!requestScanProgress(scanId, offsetRead)) {
         LOG_DEBUG("Scan progress with invalid scan ID");
         writeErrorResponse(messageId, error::invalid_scan);
+    }
+}
+
+void ServerSocket::handleExportTable(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request) {
+    auto tableId = request.read<uint64_t>();
+    auto nameLength = request.read<uint32_t>();
+    crossbow::string name(request.read(nameLength), nameLength);
+
+    request.align(sizeof(uint64_t));
+    handleSnapshot(messageId, request, [this, messageId, tableId, &name]
+            (const commitmanager::SnapshotDescriptor& snapshot) {
+        crossbow::string path;
+        if (!resolveExportPath(manager().exportDirectory(), name, path)) {
+            LOG_ERROR("Rejected export to file %1% outside of the export directory", name);
+            writeErrorResponse(messageId, error::export_failed);
+            return;
+        }
+
+        ReclamationGuard _;
+        auto table = mStorage.getTable(tableId);
+        if (!table) {
+            writeErrorResponse(messageId, error::invalid_table);
+            return;
+        }
+
+        std::unique_ptr<ColumnarFileWriter> writer;
+        try {
+            writer.reset(new ColumnarFileWriter(path, table->schema()));
+        } catch (const std::system_error& e) {
+            LOG_ERROR("Unable to create export file %1% [error = %2%]", path, e.what());
+            writeErrorResponse(messageId, error::export_failed);
+            return;
+        }
+
+        // Copy snapshot descriptor
+        auto exportSnapshot = commitmanager::SnapshotDescriptor::create(snapshot.lowestActiveVersion(),
+                snapshot.baseVersion(), snapshot.version(), snapshot.data());
+
+        std::unique_ptr<ExportScanQuery> exportData(new ExportScanQuery(messageId, std::move(exportSnapshot),
+                table->record(), std::move(writer), manager().scanBufferManager().scanBufferLength(), *this));
+        auto exportDataPtr = exportData.get();
+        auto res = mExports.emplace(messageId.userId(), std::move(exportData));
+        if (!res.second) {
+            writeErrorResponse(messageId, error::invalid_scan);
+            return;
+        }
+
+        auto ec = mStorage.scan(tableId, exportDataPtr);
+        if (ec) {
+            writeErrorResponse(messageId, static_cast<error::errors>(ec));
+            mExports.erase(res.first);
+        }
+    });
+}
+
+void ServerSocket::completeExport(uint64_t exportId, bool failed, uint64_t rowCount) {
+    auto i = mExports.find(exportId);
+    if (i == mExports.end()) {
+        LOG_ERROR("Export completed with invalid export ID");
         return;
     }
+    auto messageId = i->second->messageId();
+    mExports.erase(i);
 
-    i->second->requestProgress(offsetRead);
+    if (failed) {
+        writeErrorResponse(messageId, error::export_failed);
+        return;
+    }
+
+    LOG_DEBUG("Export finished [rows = %1%]", rowCount);
+    uint32_t messageLength = sizeof(uint64_t);
+    writeResponse(messageId, ResponseType::EXPORT_TABLE, messageLength, [rowCount]
+            (crossbow::buffer_writer& message, std::error_code& /* ec */) {
+        message.write<uint64_t>(rowCount);
+    });
 }
 
 void ServerSocket::onWrite(uint32_t userId, uint16_t bufferId, const std::error_code& ec) {
@@ -349,24 +938,40 @@ void ServerSocket::onWrite(uint32_t userId, uint16_t bufferId, const std::error_
         scanBufferManager.releaseBuffer(bufferId);
     }
 
-    mInflightScanBuffer -= 1u;
+    LOG_ASSERT(mInflightScanBuffer > 0u, "No scan buffer in flight");
+    --mInflightScanBuffer;
 
+    auto scanId = static_cast<uint16_t>((userId >> 16) & 0xFFFFu);
     auto status = static_cast<uint16_t>(userId & 0xFFFFu);
     switch (status) {
     case crossbow::to_underlying(ScanStatusIndicator::ONGOING): {
-        // Nothing to do
+        // The buffer is no longer held by the scan (the scan is already gone if it was aborted)
+        auto i = mScans.find(scanId);
+        if (i != mScans.end() && i->second->bufferWritten()) {
+            abortScan(scanId);
+        }
     } break;
 
     case crossbow::to_underlying(ScanStatusIndicator::DONE): {
-        auto scanId = static_cast<uint16_t>((userId >> 16) & 0xFFFFu);
         auto i = mScans.find(scanId);
         if (i == mScans.end()) {
             LOG_ERROR("Scan progress with invalid scan ID");
-            return;
+            break;
         }
 
         LOG_DEBUG("Scan with ID %1% finished", scanId);
         i->second->completeScan();
+
+        auto& scan = *i->second;
+        auto endTime = std::chrono::steady_clock::now();
+        if (scan.executionStartTime() != std::chrono::steady_clock::time_point()) {
+            mStatistics.recordScanPhase(ScanPhase::QUEUED, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    scan.executionStartTime() - scan.startTime()).count());
+            mStatistics.recordScanPhase(ScanPhase::EXECUTION, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    scan.executionEndTime() - scan.executionStartTime()).count());
+            mStatistics.recordScanPhase(ScanPhase::DRAIN, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    endTime - scan.executionEndTime()).count());
+        }
         mScans.erase(i);
     } break;
 
@@ -374,6 +979,13 @@ void ServerSocket::onWrite(uint32_t userId, uint16_t bufferId, const std::error_
         LOG_ERROR("Scan progress with invalid status");
     } break;
     }
+
+    // Resume scans waiting for the socket to accept more writes
+    while (!mScanFlushQueue.empty() && canWriteScanBuffer()) {
+        auto scanId = mScanFlushQueue.front();
+        mScanFlushQueue.pop_front();
+        flushScan(scanId);
+    }
 }
 
 template <typename Fun>
@@ -401,15 +1013,73 @@ void ServerSocket::handleSnapshot(crossbow::infinio::MessageId messageId, crossb
             }
             i = res.first;
         }
-        f(*i->second);
+        if (admitSnapshot(messageId, *i->second)) {
+            f(*i->second);
+        }
     } else if (hasDescriptor) {
         auto snapshot = commitmanager::SnapshotDescriptor::deserialize(message);
-        f(*snapshot);
+        if (admitSnapshot(messageId, *snapshot)) {
+            f(*snapshot);
+        }
     } else {
         writeErrorResponse(messageId, error::invalid_snapshot);
     }
 }
 
+bool ServerSocket::admitSnapshot(crossbow::infinio::MessageId messageId,
+        const commitmanager::SnapshotDescriptor& snapshot) {
+    if (auto replica = manager().replica()) {
+        if (!replica->covers(snapshot)) {
+            writeErrorResponse(messageId, error::not_replicated);
+            return false;
+        }
+    } else if (auto replicationLog = manager().replicationLog()) {
+        replicationLog->publishVersion(snapshot);
+    }
+    return true;
+}
+
+void ServerSocket::replicate(uint32_t requestType, uint64_t tableId, uint64_t key,
+        const commitmanager::SnapshotDescriptor& snapshot, uint32_t schemaVersion, size_t size /* = 0u */,
+        const char* data /* = nullptr */) {
+    auto replicationLog = manager().replicationLog();
+    if (!replicationLog) {
+        return;
+    }
+
+    ReplicationRecordType type;
+    switch (requestType) {
+    case crossbow::to_underlying(RequestType::INSERT): {
+        type = ReplicationRecordType::INSERT;
+    } break;
+
+    case crossbow::to_underlying(RequestType::UPDATE): {
+        type = ReplicationRecordType::UPDATE;
+    } break;
+
+    case crossbow::to_underlying(RequestType::REMOVE): {
+        type = ReplicationRecordType::REMOVE;
+    } break;
+
+    case crossbow::to_underlying(RequestType::REVERT): {
+        type = ReplicationRecordType::REVERT;
+    } break;
+
+    default: {
+        LOG_ASSERT(false, "Request type is no modification");
+        return;
+    }
+    }
+    replicationLog->publishModification(type, tableId, key, snapshot.version(), schemaVersion, size, data);
+}
+
+void ServerSocket::queueScanFlush(uint16_t scanId) {
+    if (std::find(mScanFlushQueue.begin(), mScanFlushQueue.end(), scanId) != mScanFlushQueue.end()) {
+        return;
+    }
+    mScanFlushQueue.emplace_back(scanId);
+}
+
 void ServerSocket::removeSnapshot(uint64_t version) {
     auto i = mSnapshots.find(version);
     if (i == mSnapshots.end()) {
@@ -418,10 +1088,11 @@ void ServerSocket::removeSnapshot(uint64_t version) {
     mSnapshots.erase(i);
 }
 
-void ServerSocket::writeModificationResponse(crossbow::infinio::MessageId messageId, int ec) {
+void ServerSocket::writeModificationResponse(crossbow::infinio::MessageId messageId, uint64_t tableId, int ec) {
     if (ec) {
         writeErrorResponse(messageId, static_cast<error::errors>(ec));
     } else {
+        manager().watermark().increment(tableId);
         writeResponse(messageId, ResponseType::MODIFICATION, 0, []
                 (crossbow::buffer_writer& /* message */, std::error_code& /* ec */) {
         });
@@ -433,11 +1104,39 @@ ServerManager::ServerManager(crossbow::infinio::InfinibandService& service, Stor
         : Base(service, config.port),
           mStorage(storage),
           mMaxBatchSize(config.maxBatchSize),
+          mMaxResponseLength(config.bufferLength - RESPONSE_HEADER_LENGTH),
           mScanBufferManager(service, config),
-          mMaxInflightScanBuffer(config.maxInflightScanBuffer) {
+          mMaxInflightScanBuffer(config.maxInflightScanBuffer),
+          mScanFlushBudget(config.scanFlushBudget),
+          mMaxScansPerClient(config.maxScansPerClient),
+          mExportDirectory(config.exportDirectory) {
+    if (!config.replicateFrom.empty()) {
+        mReplica.reset(new ReplicationApplier(storage, mWatermark, config.replicateFrom));
+    } else if (config.replicationPort != 0) {
+        mReplicationLog.reset(new ReplicationLog(config.replicationPort, config.numReplicas));
+    }
+
     for (decltype(config.numNetworkThreads) i = 0; i < config.numNetworkThreads; ++i) {
         mProcessors.emplace_back(service.createProcessor());
+        mStatistics.emplace_back(new RequestStatistics());
+
+        // Pin the network thread from within its own event loop
+        if (!config.networkCores.empty()) {
+            auto cores = config.networkCores;
+            mProcessors.back()->execute([cores, i] () {
+                pinCurrentThread(cores, static_cast<size_t>(i));
+            });
+        }
+    }
+}
+
+ServerStatistics ServerManager::collectStatistics() const {
+    ServerStatistics statistics;
+    for (auto& threadStatistics : mStatistics) {
+        threadStatistics->collect(statistics);
     }
+    perfCounters->collect(statistics);
+    return statistics;
 }
 
 ServerSocket* ServerManager::createConnection(crossbow::infinio::InfinibandSocket socket,
@@ -451,9 +1150,11 @@ ServerSocket* ServerManager::createConnection(crossbow::infinio::InfinibandSocke
     }
     auto thread = *reinterpret_cast<const uint64_t*>(&data[handshake.size()]);
     auto& processor = *mProcessors.at(thread % mProcessors.size());
+    auto& statistics = *mStatistics.at(thread % mStatistics.size());
 
     LOG_INFO("%1%] New client connection on processor %2%", socket->remoteAddress(), thread);
-    return new ServerSocket(*this, mStorage, processor, std::move(socket), mMaxBatchSize, mMaxInflightScanBuffer);
+    return new ServerSocket(*this, mStorage, processor, std::move(socket), statistics, mMaxBatchSize,
+            mMaxInflightScanBuffer, mScanFlushBudget, mMaxScansPerClient);
 }
 
 } // namespace store
@@ -22,6 +22,10 @@
  */
 #pragma once
 
+#include "ExportScanQuery.hpp"
+#include "ModificationWatermark.hpp"
+#include "Replication.hpp"
+#include "RequestStatistics.hpp"
 #include "ServerConfig.hpp"
 #include "ServerScanQuery.hpp"
 #include "Storage.hpp"
@@ -30,10 +34,11 @@
 
 #include <crossbow/byte_buffer.hpp>
 #include <crossbow/infinio/RpcServer.hpp>
+#include <crossbow/logger.hpp>
 #include <crossbow/string.hpp>
 
-#include <atomic>
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <unordered_map>
 #include <system_error>
@@ -53,11 +58,15 @@ class ServerSocket : public crossbow::infinio::RpcServerSocket<ServerManager, Se
 
 public:
     ServerSocket(ServerManager& manager, Storage& storage, crossbow::infinio::InfinibandProcessor& processor,
-            crossbow::infinio::InfinibandSocket socket, size_t maxBatchSize, uint64_t maxInflightScanBuffer)
+            crossbow::infinio::InfinibandSocket socket, RequestStatistics& statistics, size_t maxBatchSize,
+            uint64_t maxInflightScanBuffer, uint32_t scanFlushBudget, size_t maxScans)
             : Base(manager, processor, std::move(socket), crossbow::string(), maxBatchSize),
               mStorage(storage),
+              mStatistics(statistics),
               mMaxInflightScanBuffer(maxInflightScanBuffer),
-              mInflightScanBuffer(0u) {
+              mInflightScanBuffer(0u),
+              mScanFlushBudget(scanFlushBudget),
+              mMaxScans(maxScans) {
     }
 
     /**
@@ -68,18 +77,34 @@ public:
         mSocket->processor()->execute(std::move(fun));
     }
 
+    /**
+     * @brief Whether the socket accepts more scan buffer writes without exceeding the in-flight limit
+     *
+     * Must only be called from within the socket's processing thread.
+     */
+    bool canWriteScanBuffer() const {
+        return (mInflightScanBuffer < mMaxInflightScanBuffer);
+    }
+
+    /**
+     * @brief Maximum number of scan buffers a scan writes in one go before it has to reschedule the remaining writes
+     *
+     * Rescheduled writes are queued behind the events already waiting in the event loop so point operations on the
+     * same network thread are not delayed by a long burst of scan writes (0 for no limit).
+     */
+    uint32_t scanFlushBudget() const {
+        return mScanFlushBudget;
+    }
+
     /**
      * @brief Writes the buffer into the scan destination region
+     *
+     * Must only be called from within the socket's processing thread.
      */
     template <typename Buffer>
     void writeScanBuffer(Buffer& buffer, crossbow::infinio::RemoteMemoryRegion& destRegion, size_t offset,
             uint32_t userId, std::error_code& ec) {
-        // Wait in case the network is overloaded
-        // For performance reasons this is not really thread safe but as the number of threads accessing this variable
-        // is bounded and small (2-4) the actual limit will not be exceeded by much.
-        while (mInflightScanBuffer >= mMaxInflightScanBuffer) {
-            std::this_thread::yield();
-        }
+        LOG_ASSERT(canWriteScanBuffer(), "Too many scan buffers in flight");
 
         ec = std::error_code();
         mSocket->write(buffer, destRegion, offset, userId, ec);
@@ -90,16 +115,77 @@ public:
         ++mInflightScanBuffer;
     }
 
+    /**
+     * @brief Schedules the send queue of the scan to be flushed from within the socket's processing thread
+     *
+     * Can be called from any thread.
+     *
+     * @param scanId ID associated with the scan
+     */
+    void scheduleScanFlush(uint16_t scanId) {
+        execute([this, scanId] () {
+            flushScan(scanId);
+        });
+    }
+
     /**
      * @brief Notifies the client of the scan progress
      *
      * Must only be called from within the socket's processing thread.
      *
+     * The scan progress response has the following format:
+     * - 1 byte:  Whether the scan has completed
+     * - 7 bytes: Padding
+     * - 8 bytes: Logical offset up to which data was written into the scan destination region
+     * - 8 bytes: Logical offset at which the server last skipped the remaining space of the region and wrapped around
+     *
      * @param scanId ID associated with the scan
      * @param done Whether the scan has completed
      * @param offset Amount of data written into the scan destination region
+     * @param wrapOffset Offset at which the write last wrapped around
+     */
+    void writeScanProgress(uint16_t scanId, bool done, size_t offset, size_t wrapOffset);
+
+    /**
+     * @brief Grants the scan credit up to the given offset and requests a progress update
+     *
+     * Must only be called from within the socket's processing thread.
+     *
+     * @param scanId ID associated with the scan
+     * @param offsetRead Offset up to which the client released the scan destination region
+     * @return False if no scan with the given ID exists
      */
-    void writeScanProgress(uint16_t scanId, bool done, size_t offset);
+    bool requestScanProgress(uint16_t scanId, size_t offsetRead);
+
+    /**
+     * @brief Writes the queued buffers of the scan to the client
+     *
+     * Must only be called from within the socket's processing thread.
+     *
+     * @param scanId ID associated with the scan
+     */
+    void flushScan(uint16_t scanId);
+
+    /**
+     * @brief Answers the scan with an error response and releases the scan
+     *
+     * Must only be called from within the socket's processing thread. The scan is released in a new event as the caller
+     * might still reference it.
+     *
+     * @param scanId ID associated with the scan
+     */
+    void abortScan(uint16_t scanId);
+
+    /**
+     * @brief Answers the export request and releases the export
+     *
+     * Must only be called from within the socket's processing thread.
+     *
+     * @param exportId ID associated with the export (user ID of the request's message ID)
+     * @param failed Whether writing the export file failed
+     * @param rowCount Number of rows written to the file
+     */
+    void completeExport(uint64_t exportId, bool failed, uint64_t rowCount);
 
 private:
     friend Base;
@@ -119,6 +205,43 @@ private:
      */
     void handleCreateTable(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request);
 
+    /**
+     * The alter table request has the following format:
+     * - 8 bytes: The table ID of the table to alter
+     * - 4 bytes: The schema version the new schema succeeds (must be the newest version of the table)
+     * - 4 bytes: Whether the schema change is only validated without altering the table
+     * - x bytes: The new table schema
+     *
+     * Fields are matched by name with the current schema of the table. Tuples stored in older schema versions are
+     * converted when they are read and rewritten by the garbage collection. Modifications keep the schema version they
+     * were sent with, so clients still using the old schema can write while the table is altered.
+     *
+     * The response is a modification response.
+     */
+    void handleAlterTable(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request);
+
+    /**
+     * The drop table request has the following format:
+     * - 8 bytes: The table ID of the table to drop
+     *
+     * The table name can be reused as soon as the response was sent, the pages of the table are released in bulk once
+     * no running request references the table anymore.
+     *
+     * The response is a modification response.
+     */
+    void handleDropTable(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request);
+
+    /**
+     * The truncate table request has the following format:
+     * - 8 bytes: The table ID of the table to truncate
+     *
+     * The table keeps its ID and all schema versions. The outcome of modifications running concurrently with the
+     * truncation is undefined, but replicas apply them to the same table instance as the primary.
+     *
+     * The response is a modification response.
+     */
+    void handleTruncateTable(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request);
+
     /**
      * The response consists of the following format:
      * - 8 bytes: Number of elements in the list
@@ -127,7 +250,9 @@ private:
      *   - 4 bytes: Length of the table name
      *   - x bytes: The table name
      *   - y bytes: Variable padding to make message 8 byte aligned
-     *   - x bytes: The table schema
+     *   - 4 bytes: The newest schema version of the table
+     *   - 4 bytes: Padding
+     *   - x bytes: The table schema of the newest version
      */
     void handleGetTables(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request);
 
@@ -138,6 +263,9 @@ private:
      *
      * The response consists of the following format:
      * - 8 bytes: The table ID of the table or 0 when the table does not exist
+     * - 4 bytes: The newest schema version of the table
+     * - 4 bytes: Padding
+     * - x bytes: The table schema of the newest version
      */
     void handleGetTable(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request);
 
@@ -148,6 +276,7 @@ private:
      * - x bytes: Snapshot descriptor
      *
      * The response consists of the following format:
+     * - 8 bytes: The modification counter of the table read before the tuple was read (see ModificationWatermark)
      * - 8 bytes: The version of the tuple
      * - 1 byte:  Whether the tuple is the newest one
      * - 1 byte:  Whether the tuple was found
@@ -162,7 +291,7 @@ private:
      * The update request has the following format:
      * - 8 bytes: The table ID of the requested tuple
      * - 8 bytes: The key of the requested tuple
-     * - 4 bytes: Padding
+     * - 4 bytes: The schema version the tuple's data was written in
      * - 4 bytes: Length of the tuple's data field
      * - x bytes: The tuple's data
      * - x bytes: Snapshot descriptor
@@ -176,7 +305,7 @@ private:
      * The insert request has the following format:
      * - 8 bytes: The table ID of the requested tuple
      * - 8 bytes: The key of the requested tuple
-     * - 4 bytes: Padding
+     * - 4 bytes: The schema version the tuple's data was written in
      * - 4 bytes: Length of the tuple's data field
      * - x bytes: The tuple's data
      * - x bytes: Snapshot descriptor
@@ -208,13 +337,74 @@ private:
      */
     void handleRevert(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request);
 
+    /**
+     * The batch request has the following format:
+     * - 4 bytes: Number of operations in the batch
+     * - 4 bytes: Padding
+     * - For every operation in the batch
+     *   - 2 bytes: The request type of the operation (get, update, insert, remove or revert)
+     *   - 2 bytes: The schema version the tuple's data was written in (0 for get, remove and revert)
+     *   - 4 bytes: Length of the tuple's data field (0 for get, remove and revert)
+     *   - 8 bytes: The table ID of the requested tuple
+     *   - 8 bytes: The key of the requested tuple
+     *   - x bytes: The tuple's data
+     *   - y bytes: Variable padding to make the operation 8 byte aligned
+     * - x bytes: Snapshot descriptor (shared by all operations)
+     *
+     * The response consists of the following format:
+     * - 8 bytes: Number of results
+     * - For every operation in the batch
+     *   - 4 bytes: The error code of the operation (0 on success)
+     *   - 4 bytes: Whether a tuple follows (successful get)
+     *   If a tuple follows:
+     *   - 8 bytes: The version of the tuple
+     *   - 1 byte:  Whether the tuple is the newest one
+     *   - 3 bytes: Padding
+     *   - 4 bytes: Length of the tuple's data field
+     *   - x bytes: The tuple's data
+     *   - y bytes: Variable padding to make the result 8 byte aligned
+     *
+     * The response never exceeds the maximum response length: Gets whose tuple does not fit anymore fail with
+     * error::response_too_large and a batch whose result headers alone do not fit is rejected as a whole.
+     */
+    void handleBatch(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request);
+
+    /**
+     * The watermark request has the following format:
+     * - 4 bytes: Number of tables
+     * - 4 bytes: Padding
+     * - 8 bytes: For every table the table ID
+     *
+     * The response consists of the following format:
+     * - 8 bytes: For every table the modification counter of the table
+     */
+    void handleWatermark(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request);
+
+    /**
+     * The stats request has no content.
+     *
+     * The response consists of the latency histograms of all network threads merged together and the hardware
+     * performance counters of the scan and garbage collection threads if enabled (see ServerStatistics for the format).
+     * The statistics of the tables with the fewest requests are left out if the response does not fit into a single
+     * message.
+     */
+    void handleStats(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request);
+
+    /**
+     * The memory usage request has no content.
+     *
+     * The response consists of the memory in use by every table and category (see MemoryUsage for the format). Pages
+     * not owned by any table are reported with table ID 0.
+     */
+    void handleMemoryUsage(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request);
+
     /**
      * The scan request has the following format:
      * - 8 bytes: The table ID of the requested tuple
      * - 1 byte:  The type of the query data
      * - 7 bytes: Padding
      * - 8 bytes: The address of the remote memory region
-     * - 8 bytes: Length of the remote memory region
+     * - 8 bytes: Length of the remote memory region (must be at least the length of a scan buffer)
      * - 4 bytes: The access key of the remote memory region
      * - 4 bytes: Length of the selection's data field
      * - x bytes: The selection's data (8 byte aligned)
@@ -228,10 +418,28 @@ private:
 
     /**
      * The scan progress request has the following format:
-     * - 8 bytes: Offset the client read up to
+     * - 8 bytes: Logical offset up to which the client released the remote memory region
+     *
+     * The remote memory region is used as a ring buffer, the server writes at most one region length past the released
+     * offset.
      */
     void handleScanProgress(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request);
 
+    /**
+     * The export table request has the following format:
+     * - 8 bytes: The table ID of the table to export
+     * - 4 bytes: Length of the file name
+     * - x bytes: The file name of the columnar file relative to the server's export directory
+     * - y bytes: Variable padding to make message 8 byte aligned
+     * - x bytes: Snapshot descriptor
+     *
+     * The table is scanned by all scan threads and written into a columnar file (see ColumnarFileWriter). File names
+     * that are empty, "." or ".." or contain a path separator are rejected with error::export_failed. The response is
+     * sent after the file was closed and consists of the following format:
+     * - 8 bytes: The number of rows written to the file
+     */
+    void handleExportTable(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& request);
+
     virtual void onWrite(uint32_t userId, uint16_t bufferId, const std::error_code& ec) final override;
 
     /**
@@ -261,6 +469,30 @@ private:
     template <typename Fun>
     void handleSnapshot(crossbow::infinio::MessageId messageId, crossbow::buffer_reader& message, Fun f);
 
+    /**
+     * @brief Checks the snapshot against the replication state before a request is executed
+     *
+     * A primary publishes the snapshot's base version to the replication stream. A read replica rejects the snapshot
+     * with an error response unless it has applied every version the snapshot can read.
+     *
+     * @return Whether the request can be executed with the snapshot
+     */
+    bool admitSnapshot(crossbow::infinio::MessageId messageId, const commitmanager::SnapshotDescriptor& snapshot);
+
+    /**
+     * @brief Appends a successful modification to the replication stream if the server is a primary
+     *
+     * Has to be called before the client is notified about the modification.
+     */
+    void replicate(uint32_t requestType, uint64_t tableId, uint64_t key,
+            const commitmanager::SnapshotDescriptor& snapshot, uint32_t schemaVersion, size_t size = 0u,
+            const char* data = nullptr);
+
+    /**
+     * @brief Queues the scan to be flushed again as soon as in-flight scan buffers completed
+     */
+    void queueScanFlush(uint16_t scanId);
+
     /**
      * @brief Removes the snapshot from the cache
      */
@@ -268,16 +500,30 @@ private:
 
     /**
      * @brief Writes the result of the modification response back to the client
+     *
+     * Increments the modification counter of the table if the modification succeeded.
      */
-    void writeModificationResponse(crossbow::infinio::MessageId messageId, int ec);
+    void writeModificationResponse(crossbow::infinio::MessageId messageId, uint64_t tableId, int ec);
 
     Storage& mStorage;
 
+    /// Latency histograms of the network thread the socket belongs to
+    RequestStatistics& mStatistics;
+
     /// Maximum number of scan buffers that are in flight on the socket at the same time
     uint64_t mMaxInflightScanBuffer;
 
     /// Current number of scan buffers that are in flight
-    std::atomic<uint64_t> mInflightScanBuffer;
+    uint64_t mInflightScanBuffer;
+
+    /// Maximum number of scan buffers written by a scan before yielding to other events
+    uint32_t mScanFlushBudget;
+
+    /// Maximum number of scans the client can have active at the same time (0 for no limit)
+    size_t mMaxScans;
+
+    /// Scans waiting for the socket to accept more scan buffer writes
+    std::deque<uint16_t> mScanFlushQueue;
 
     // TODO Replace with google dense map (SnapshotDescriptor has no copy / default constructor)
     /// Snapshot cache mapping the version number to the snapshot descriptor
@@ -286,6 +532,9 @@ private:
     /// Map from Scan ID to the shared data class associated with the scan
     /// The Connection has the ownership because we can only free this after all RDMA writes have been processed
     std::unordered_map<uint16_t, std::unique_ptr<ServerScanQuery>> mScans;
+
+    /// Map from the user ID of the request to the exports in progress
+    std::unordered_map<uint64_t, std::unique_ptr<ExportScanQuery>> mExports;
 };
 
 class ServerManager : public crossbow::infinio::RpcServerManager<ServerManager, ServerSocket> {
@@ -304,14 +553,70 @@ private:
         return mScanBufferManager;
     }
 
+    ModificationWatermark& watermark() {
+        return mWatermark;
+    }
+
+    /**
+     * @brief Maximum length of the payload of a single response
+     */
+    uint32_t maxResponseLength() const {
+        return mMaxResponseLength;
+    }
+
+    /**
+     * @brief Directory export files are written into (empty if exports are disabled)
+     */
+    const crossbow::string& exportDirectory() const {
+        return mExportDirectory;
+    }
+
+    /**
+     * @brief The replication stream if the server is a primary or null
+     */
+    ReplicationLog* replicationLog() {
+        return mReplicationLog.get();
+    }
+
+    /**
+     * @brief The applier of the primary's stream if the server is a read replica or null
+     */
+    const ReplicationApplier* replica() const {
+        return mReplica.get();
+    }
+
+    /**
+     * @brief Merges the latency histograms of all network threads
+     */
+    ServerStatistics collectStatistics() const;
+
     Storage& mStorage;
 
+    /// Space reserved in a network buffer for the header of the response
+    static constexpr uint32_t RESPONSE_HEADER_LENGTH = 64u;
+
     size_t mMaxBatchSize;
 
+    uint32_t mMaxResponseLength;
+
     ScanBufferManager mScanBufferManager;
     uint64_t mMaxInflightScanBuffer;
+    uint32_t mScanFlushBudget;
+    size_t mMaxScansPerClient;
+
+    crossbow::string mExportDirectory;
+
+    ModificationWatermark mWatermark;
+
+    std::unique_ptr<ReplicationLog> mReplicationLog;
+
+    /// Declared after the watermark as the applier increments it until it is destroyed
+    std::unique_ptr<ReplicationApplier> mReplica;
 
     std::vector<std::unique_ptr<crossbow::infinio::InfinibandProcessor>> mProcessors;
+
+    /// Latency histograms of every network thread (indexed the same as the processors)
+    std::vector<std::unique_ptr<RequestStatistics>> mStatistics;
 };
 
 } // namespace store
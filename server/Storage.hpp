@@ -32,20 +32,22 @@
 #error "Unknown implementation"
 #endif
 
+#include <util/PartitionedStore.hpp>
+
 namespace tell {
 namespace store {
 
 #if defined USE_DELTA_MAIN_REWRITE
 #if defined USE_ROW_STORE
-using Storage = DeltaMainRewriteRowStore;
+using Storage = PartitionedStore<DeltaMainRewriteRowStore>;
 #elif defined USE_COLUMN_MAP
-using Storage = DeltaMainRewriteColumnStore;
+using Storage = PartitionedStore<DeltaMainRewriteColumnStore>;
 #else
 #error "Unknown implementation"
 #endif
 
 #elif defined USE_LOGSTRUCTURED_MEMORY
-using Storage = LogstructuredMemoryStore;
+using Storage = PartitionedStore<LogstructuredMemoryStore>;
 
 #else
 #error "Unknown implementation"
@@ -24,7 +24,10 @@
 #include "ServerSocket.hpp"
 #include "Storage.hpp"
 
+#include <util/LLVMJIT.hpp>
+#include <util/PerfCounters.hpp>
 #include <util/StorageConfig.hpp>
+#include <util/ThreadAffinity.hpp>
 
 #include <crossbow/allocator.hpp>
 #include <crossbow/infinio/InfinibandService.hpp>
@@ -32,12 +35,19 @@
 #include <crossbow/program_options.hpp>
 
 #include <iostream>
+#include <stdexcept>
 
 int main(int argc, const char** argv) {
     tell::store::StorageConfig storageConfig;
     tell::store::ServerConfig serverConfig;
     bool help = false;
     crossbow::string logLevel("DEBUG");
+    bool perfMap = false;
+    crossbow::string jitDumpDirectory;
+    bool perfCounters = false;
+    crossbow::string networkCores;
+    crossbow::string scanCores;
+    crossbow::string gcCores;
 
     auto opts = crossbow::program_options::create_options(argv[0],
             crossbow::program_options::value<'h'>("help", &help),
@@ -50,6 +60,40 @@ int main(int argc, const char** argv) {
             crossbow::program_options::value<-2>("scan-threads", &storageConfig.numScanThreads,
                     crossbow::program_options::tag::ignore_short<true>{}),
             crossbow::program_options::value<-3>("gc-interval", &storageConfig.gcInterval,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-4>("perf-map", &perfMap,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-5>("jit-dump", &jitDumpDirectory,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-6>("perf-counters", &perfCounters,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-7>("interactive-scan-threads", &storageConfig.numInteractiveScanThreads,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-8>("scan-buffer-reserve", &serverConfig.scanBufferReserve,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-9>("client-scans", &serverConfig.maxScansPerClient,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-10>("scan-flush-budget", &serverConfig.scanFlushBudget,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-11>("network-cores", &networkCores,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-12>("scan-cores", &scanCores,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-13>("gc-cores", &gcCores,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-14>("partitions", &storageConfig.numPartitions,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-15>("replication-port", &serverConfig.replicationPort,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-16>("replicas", &serverConfig.numReplicas,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-17>("replicate-from", &serverConfig.replicateFrom,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-18>("scan-query-buffers", &serverConfig.scanQueryBuffers,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-19>("scan-spill-limit", &serverConfig.scanSpillLimit,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-20>("export-directory", &serverConfig.exportDirectory,
                     crossbow::program_options::tag::ignore_short<true>{}));
 
     try {
@@ -65,10 +109,27 @@ int main(int argc, const char** argv) {
         return 0;
     }
 
+    try {
+        serverConfig.networkCores = tell::store::parseCoreList(networkCores);
+        storageConfig.scanCores = tell::store::parseCoreList(scanCores);
+        storageConfig.gcCores = tell::store::parseCoreList(gcCores);
+    } catch (std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (storageConfig.numPartitions == 0u) {
+        std::cerr << "Number of partitions must be greater than 0" << std::endl;
+        return 1;
+    }
+    if (serverConfig.replicationPort != 0 && !serverConfig.replicateFrom.empty()) {
+        std::cerr << "A read replica can not stream to other replicas" << std::endl;
+        return 1;
+    }
+
     crossbow::infinio::InfinibandLimits infinibandLimits;
     infinibandLimits.receiveBufferCount = 1024;
     infinibandLimits.sendBufferCount = 256;
-    infinibandLimits.bufferLength = 128 * 1024;
+    infinibandLimits.bufferLength = serverConfig.bufferLength;
     infinibandLimits.sendQueueLength = 128;
     infinibandLimits.completionQueueLength = 2048;
 
@@ -80,8 +141,50 @@ int main(int argc, const char** argv) {
     LOG_INFO("--- Network Threads: %1%", serverConfig.numNetworkThreads);
     LOG_INFO("--- GC Interval: %1%s", storageConfig.gcInterval);
     LOG_INFO("--- Total Memory: %1%GB", double(storageConfig.totalMemory) / double(1024 * 1024 * 1024));
+    LOG_INFO("--- Partitions: %1%", storageConfig.numPartitions);
     LOG_INFO("--- Scan Threads: %1%", storageConfig.numScanThreads);
+    LOG_INFO("--- Interactive Scan Threads: %1%", storageConfig.numInteractiveScanThreads);
+    LOG_INFO("--- Scan Buffer Reserve: %1%", serverConfig.scanBufferReserve);
+    LOG_INFO("--- Scan Buffers per Query: %1%", serverConfig.scanQueryBuffers);
+    LOG_INFO("--- Scan Spill Limit: %1%MB", double(serverConfig.scanSpillLimit) / double(1024 * 1024));
+    LOG_INFO("--- Scans per Client: %1%", serverConfig.maxScansPerClient);
+    LOG_INFO("--- Scan Flush Budget: %1%", serverConfig.scanFlushBudget);
+    if (!networkCores.empty()) {
+        LOG_INFO("--- Network Cores: %1%", networkCores);
+    }
+    if (!scanCores.empty()) {
+        LOG_INFO("--- Scan Cores: %1%", scanCores);
+    }
+    if (!gcCores.empty()) {
+        LOG_INFO("--- GC Cores: %1%", gcCores);
+    }
     LOG_INFO("--- Hash Map Capacity: %1%", storageConfig.hashMapCapacity);
+    if (serverConfig.replicationPort != 0) {
+        LOG_INFO("--- Replication Port: %1%", serverConfig.replicationPort);
+        LOG_INFO("--- Replicas: %1%", serverConfig.numReplicas);
+    }
+    if (!serverConfig.replicateFrom.empty()) {
+        LOG_INFO("--- Replicate From: %1%", serverConfig.replicateFrom);
+    }
+    if (!serverConfig.exportDirectory.empty()) {
+        LOG_INFO("--- Export Directory: %1%", serverConfig.exportDirectory);
+    }
+    LOG_INFO("--- JIT Perf Map: %1%", perfMap);
+    if (!jitDumpDirectory.empty()) {
+        LOG_INFO("--- JIT Dump Directory: %1%", jitDumpDirectory);
+    }
+    LOG_INFO("--- Performance Counters: %1%", perfCounters);
+
+    // Configure the JIT before any scan is compiled
+    if (perfMap) {
+        tell::store::llvmCompiler->enablePerfMap();
+    }
+    tell::store::llvmCompiler->setDumpDirectory(std::string(jitDumpDirectory.c_str(), jitDumpDirectory.size()));
+
+    // Measure hardware counters around scans and garbage collection
+    if (perfCounters) {
+        tell::store::perfCounters->enable();
+    }
 
     // Initialize allocator
     crossbow::allocator::init();
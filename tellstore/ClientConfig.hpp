@@ -42,7 +42,10 @@ struct ClientConfig {
     ClientConfig()
             : maxPendingResponses(48ull),
               maxBatchSize(16ull),
-              numNetworkThreads(2ull) {
+              numNetworkThreads(2ull),
+              fiberPoolSize(16ull),
+              maxFiberPoolSize(256ull),
+              readCacheCapacity(0x10000ull) {
         infinibandConfig.receiveBufferCount = 256;
         infinibandConfig.sendBufferCount = 256;
         infinibandConfig.bufferLength = 128 * 1024;
@@ -67,6 +70,18 @@ struct ClientConfig {
 
     /// Number of network threads to process transactions on
     size_t numNetworkThreads;
+
+    /// Number of fibers started ahead of time on every network thread
+    size_t fiberPoolSize;
+
+    /// Maximum number of fibers running on every network thread (transactions exceeding this limit are queued)
+    size_t maxFiberPoolSize;
+
+    /// Maximum number of tuples in the read cache of every network thread
+    size_t readCacheCapacity;
+
+    /// Names of the read-mostly tables whose tuples are cached in the read cache
+    std::vector<crossbow::string> readCacheTables;
 };
 
 std::vector<crossbow::infinio::Endpoint> ClientConfig::parseTellStore(const crossbow::string& host) {
@@ -24,7 +24,10 @@
 
 #include <tellstore/ClientConfig.hpp>
 #include <tellstore/ClientSocket.hpp>
+#include <tellstore/FiberPool.hpp>
 #include <tellstore/GenericTuple.hpp>
+#include <tellstore/Partitioner.hpp>
+#include <tellstore/ReadCache.hpp>
 #include <tellstore/ScanMemory.hpp>
 #include <tellstore/Table.hpp>
 #include <tellstore/TransactionType.hpp>
@@ -43,11 +46,13 @@
 #include <atomic>
 #include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <system_error>
 #include <thread>
 #include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace tell {
@@ -55,6 +60,7 @@ namespace store {
 
 struct ClientConfig;
 class BaseClientProcessor;
+class ClientBatch;
 class Record;
 
 /**
@@ -69,7 +75,9 @@ public:
 
     ClientHandle(BaseClientProcessor& processor, crossbow::infinio::Fiber& fiber)
             : mProcessor(processor),
-              mFiber(fiber) {
+              mFiber(fiber),
+              mCacheSnapshot(nullptr),
+              mCacheVersion(0u) {
     }
 
     crossbow::infinio::Fiber& fiber() {
@@ -83,6 +91,45 @@ public:
 
     Table createTable(const crossbow::string& name, Schema schema);
 
+    /**
+     * @brief Replaces the schema of the table with the given schema
+     *
+     * Fields are matched by name: Fields missing in the new schema are dropped, new fields are NULL (zero respectively
+     * empty if NOT NULL) in all existing tuples. Existing fields must keep their type and NULL constraint. The table is
+     * not rewritten, the storage converts old tuples lazily. The partitioning of the table is kept, the partitioning of
+     * the new schema is ignored.
+     *
+     * Tuples are tagged with the schema version of the table they were written with, so clients still using the old
+     * table keep working and their tuples are converted to the new schema. The schema change only succeeds if the
+     * table is the newest version: Concurrent schema changes of the same table fail on all but one client.
+     *
+     * The schema change is validated on all shards before any shard is altered. Throws std::system_error if the
+     * schema change is invalid, the table is outdated or the schema change is not supported by the storage.
+     *
+     * @return The table with the new schema
+     */
+    Table alterTable(const Table& table, Schema schema);
+
+    /**
+     * @brief Removes the table and all its tuples
+     *
+     * The table name can be reused immediately, the memory of the table is released in bulk without deleting every
+     * tuple.
+     *
+     * Throws std::system_error if the table does not exist or dropping is not supported by the storage.
+     */
+    void dropTable(const Table& table);
+
+    /**
+     * @brief Removes all tuples from the table
+     *
+     * The table keeps its ID and schema, the memory of the removed tuples is released in bulk. Modifications running
+     * concurrently with the truncation may or may not survive it.
+     *
+     * Throws std::system_error if the table does not exist or truncating is not supported by the storage.
+     */
+    void truncateTable(const Table& table);
+
     std::shared_ptr<GetTablesResponse> getTables();
 
     std::shared_ptr<GetTableResponse> getTable(const crossbow::string& name);
@@ -92,6 +139,18 @@ public:
     std::shared_ptr<GetResponse> get(const Table& table, uint64_t key,
             const commitmanager::SnapshotDescriptor& snapshot);
 
+    /**
+     * @brief Reads the tuple through the processor's read cache
+     *
+     * Falls back to a regular get if the table is not configured to be cached. Every get response carries the table's
+     * modification counter on the shard, the first read of a table on a shard in a snapshot always goes to the shard
+     * and subsequent reads of cached tuples do not require a round trip.
+     *
+     * Throws std::system_error if the tuple could not be read.
+     */
+    std::shared_ptr<const Tuple> getCached(const Table& table, uint64_t key,
+            const commitmanager::SnapshotDescriptor& snapshot);
+
     std::shared_ptr<ModificationResponse> insert(const Table& table, uint64_t key, uint64_t version, GenericTuple data);
 
     std::shared_ptr<ModificationResponse> insert(const Table& table, uint64_t key, uint64_t version,
@@ -126,9 +185,54 @@ public:
             ScanMemoryManager& memoryManager, ScanQueryType queryType, uint32_t selectionLength, const char* selection,
             uint32_t queryLength, const char* query);
 
+    /**
+     * @brief Starts a batch of point operations sharing the given snapshot
+     *
+     * The snapshot has to outlive the batch.
+     */
+    std::unique_ptr<ClientBatch> startBatch(const commitmanager::SnapshotDescriptor& snapshot);
+
+    /**
+     * @brief The request latency histograms of all storage nodes merged together
+     */
+    ServerStatistics stats();
+
+    /**
+     * @brief The memory in use on all storage nodes by table and category
+     */
+    MemoryUsage memoryUsage();
+
+    /**
+     * @brief Exports the table at the snapshot into a columnar file on every storage node
+     *
+     * Every storage node writes the tuples it stores to a columnar file (see ColumnarFileWriter). The file name is
+     * relative to the server's export directory and must not contain a path separator.
+     *
+     * Throws std::system_error if the export failed on any storage node.
+     *
+     * @return Total number of rows exported by all storage nodes
+     */
+    uint64_t exportTable(const Table& table, const crossbow::string& fileName,
+            const commitmanager::SnapshotDescriptor& snapshot);
+
 private:
+    /// Watermark of a shard from which no response was received in the current snapshot
+    static constexpr uint64_t UNKNOWN_WATERMARK = std::numeric_limits<uint64_t>::max();
+
+    /**
+     * @brief The modification counters of the table on every shard received in the given snapshot
+     */
+    std::vector<uint64_t>& cacheWatermark(const Table& table, const commitmanager::SnapshotDescriptor& snapshot);
+
     BaseClientProcessor& mProcessor;
     crossbow::infinio::Fiber& mFiber;
+
+    /// Snapshot the cache watermarks were received in
+    const commitmanager::SnapshotDescriptor* mCacheSnapshot;
+    uint64_t mCacheVersion;
+
+    /// Modification counters of every shard for all tables read through the cache in the current snapshot
+    std::unordered_map<uint64_t, std::vector<uint64_t>> mCacheWatermarks;
 };
 
 /**
@@ -144,6 +248,12 @@ public:
 
     Table createTable(crossbow::infinio::Fiber& fiber, const crossbow::string& name, Schema schema);
 
+    Table alterTable(crossbow::infinio::Fiber& fiber, const Table& table, Schema schema);
+
+    void dropTable(crossbow::infinio::Fiber& fiber, const Table& table);
+
+    void truncateTable(crossbow::infinio::Fiber& fiber, const Table& table);
+
     std::shared_ptr<GetTablesResponse> getTables(crossbow::infinio::Fiber& fiber) {
         return mTellStoreSocket.at(0)->getTables(fiber);
     }
@@ -152,66 +262,267 @@ public:
         return mTellStoreSocket.at(0)->getTable(fiber, name);
     }
 
-    std::shared_ptr<GetResponse> get(crossbow::infinio::Fiber& fiber, uint64_t tableId, uint64_t key,
+    std::shared_ptr<GetResponse> get(crossbow::infinio::Fiber& fiber, const Table& table, uint64_t key,
             const commitmanager::SnapshotDescriptor& snapshot) {
-        return shard(key)->get(fiber, tableId, key, snapshot);
+        return shard(table, key)->get(fiber, table.tableId(), key, snapshot);
     }
 
-    std::shared_ptr<ModificationResponse> insert(crossbow::infinio::Fiber& fiber, uint64_t tableId, uint64_t key,
+    std::shared_ptr<ModificationResponse> insert(crossbow::infinio::Fiber& fiber, const Table& table, uint64_t key,
             const commitmanager::SnapshotDescriptor& snapshot, const AbstractTuple& tuple) {
-        return shard(key)->insert(fiber, tableId, key, snapshot, tuple);
+        mReadCache.invalidate(table.tableId(), key);
+        return shard(table, key)->insert(fiber, table.tableId(), table.schemaVersion(), key, snapshot, tuple);
     }
 
-    std::shared_ptr<ModificationResponse> update(crossbow::infinio::Fiber& fiber, uint64_t tableId, uint64_t key,
+    std::shared_ptr<ModificationResponse> update(crossbow::infinio::Fiber& fiber, const Table& table, uint64_t key,
             const commitmanager::SnapshotDescriptor& snapshot, const AbstractTuple& tuple) {
-        return shard(key)->update(fiber, tableId, key, snapshot, tuple);
+        mReadCache.invalidate(table.tableId(), key);
+        return shard(table, key)->update(fiber, table.tableId(), table.schemaVersion(), key, snapshot, tuple);
     }
 
-    std::shared_ptr<ModificationResponse> remove(crossbow::infinio::Fiber& fiber, uint64_t tableId, uint64_t key,
+    std::shared_ptr<ModificationResponse> remove(crossbow::infinio::Fiber& fiber, const Table& table, uint64_t key,
             const commitmanager::SnapshotDescriptor& snapshot) {
-        return shard(key)->remove(fiber, tableId, key, snapshot);
+        mReadCache.invalidate(table.tableId(), key);
+        return shard(table, key)->remove(fiber, table.tableId(), key, snapshot);
     }
 
-    std::shared_ptr<ModificationResponse> revert(crossbow::infinio::Fiber& fiber, uint64_t tableId, uint64_t key,
+    std::shared_ptr<ModificationResponse> revert(crossbow::infinio::Fiber& fiber, const Table& table, uint64_t key,
             const commitmanager::SnapshotDescriptor& snapshot) {
-        return shard(key)->revert(fiber, tableId, key, snapshot);
+        mReadCache.invalidate(table.tableId(), key);
+        return shard(table, key)->revert(fiber, table.tableId(), key, snapshot);
     }
 
-    std::shared_ptr<ScanIterator> scan(crossbow::infinio::Fiber& fiber, uint64_t tableId,
-            const commitmanager::SnapshotDescriptor& snapshot, Record record, ScanMemoryManager& memoryManager,
+    /**
+     * @brief Starts a scan on all shards that can hold keys matching the partition selection of the query
+     */
+    std::shared_ptr<ScanIterator> scan(crossbow::infinio::Fiber& fiber, const Table& table,
+            const commitmanager::SnapshotDescriptor& snapshot, ScanMemoryManager& memoryManager,
             ScanQueryType queryType, uint32_t selectionLength, const char* selection, uint32_t queryLength,
             const char* query);
 
+    /**
+     * @brief Fetches the request latency histograms from every shard and merges them
+     */
+    ServerStatistics stats(crossbow::infinio::Fiber& fiber);
+
+    /**
+     * @brief Fetches the memory usage from every shard and sums it up
+     */
+    MemoryUsage memoryUsage(crossbow::infinio::Fiber& fiber);
+
+    /**
+     * @brief Starts the export on every shard and waits until all of them completed
+     */
+    uint64_t exportTable(crossbow::infinio::Fiber& fiber, const Table& table, const crossbow::string& fileName,
+            const commitmanager::SnapshotDescriptor& snapshot);
+
+    std::shared_ptr<BatchResponse> batch(crossbow::infinio::Fiber& fiber, size_t shardIndex,
+            const BatchOperations& operations, const commitmanager::SnapshotDescriptor& snapshot) {
+        return mTellStoreSocket.at(shardIndex)->batch(fiber, operations, snapshot);
+    }
+
+    /**
+     * @brief Number of shards the processor is connected to
+     */
+    size_t shardCount() const {
+        return mTellStoreSocket.size();
+    }
+
+    /**
+     * @brief Maximum length of a request message sent to a shard
+     */
+    uint32_t maxRequestLength() const {
+        return mMaxRequestLength;
+    }
+
+    /**
+     * @brief Index of the shard responsible for the given key of the table
+     */
+    size_t shardIndex(const Table& table, uint64_t key) {
+        return partitioner(table).shardOf(key);
+    }
+
+    /**
+     * @brief The partitioner distributing the keys of the table among the shards
+     *
+     * The partitioner is created from the table's partition specification when the table is first accessed.
+     */
+    const Partitioner& partitioner(const Table& table);
+
+    /**
+     * @brief The cache of tuples from read-mostly tables
+     */
+    ReadCache& readCache() {
+        return mReadCache;
+    }
+
+    /**
+     * @brief The pool of fibers executing the transactions of this processor
+     */
+    const FiberPool& fiberPool() const {
+        return mFiberPool;
+    }
+
 protected:
     BaseClientProcessor(crossbow::infinio::InfinibandService& service, const ClientConfig& config,
             uint64_t processorNum);
 
     ~BaseClientProcessor() = default;
 
+    /**
+     * @brief Executes the function in a fiber from the processor's fiber pool
+     *
+     * Starting a new fiber for every transaction takes ~500us, reusing pooled fibers avoids this cost.
+     */
     template <typename Fun>
     void executeFiber(Fun fun) {
-        // TODO Starting a fiber without the fiber cache takes ~500us - Investigate why
-        mProcessor->executeFiber(std::move(fun));
+        mProcessor->execute([this, fun] () mutable {
+            mFiberPool.execute(std::move(fun));
+        });
     }
 
 private:
     /**
      * @brief The socket associated with the shard for the given table and key
      */
-    store::ClientSocket* shard(uint64_t key) {
-        return mTellStoreSocket.at(key % mTellStoreSocket.size()).get();
+    store::ClientSocket* shard(const Table& table, uint64_t key) {
+        return mTellStoreSocket.at(shardIndex(table, key)).get();
     }
 
     std::unique_ptr<crossbow::infinio::InfinibandProcessor> mProcessor;
 
+    FiberPool mFiberPool;
+
     commitmanager::ClientSocket mCommitManagerSocket;
     std::vector<std::unique_ptr<store::ClientSocket>> mTellStoreSocket;
 
+    /// Partitioner of every table accessed by this processor
+    std::unordered_map<uint64_t, std::unique_ptr<Partitioner>> mPartitioner;
+
+    ReadCache mReadCache;
+
+    /// Space reserved in a network buffer for the header of the request
+    static constexpr uint32_t REQUEST_HEADER_LENGTH = 64u;
+
+    uint32_t mMaxRequestLength;
+
     uint64_t mProcessorNum;
 
     uint16_t mScanId;
 };
 
+/**
+ * @brief Collects point operations and sends them packed into one request per shard
+ *
+ * Operations are serialized into a per-shard buffer when they are added. The batch is sent with a single request per
+ * shard on send() or as soon as the first result is requested. A shard whose operations would exceed the maximum
+ * request length is sent early and continues in a new request. All operations share the snapshot of the batch and only
+ * transactional tables are supported.
+ *
+ * After reset() the batch can be reused for further operations, the per-shard buffers keep their memory.
+ */
+class ClientBatch : crossbow::non_copyable, crossbow::non_movable {
+public:
+    /**
+     * @brief Lightweight handle to the result of a single operation in the batch
+     *
+     * The handle is only valid until the batch is reset or destroyed.
+     */
+    class Future {
+    public:
+        /**
+         * @brief Waits until the result of the operation is available
+         *
+         * @return True if the operation succeeded
+         */
+        bool waitForResult();
+
+        /**
+         * @brief The error of the operation
+         *
+         * Must only be called after waitForResult().
+         */
+        const std::error_code& error() const;
+
+        /**
+         * @brief Waits for and returns the tuple of a get operation
+         *
+         * Throws a std::system_error if the operation failed.
+         */
+        std::unique_ptr<Tuple> get();
+
+    private:
+        friend class ClientBatch;
+
+        Future(ClientBatch* batch, size_t shard, size_t request, uint32_t index)
+                : mBatch(batch),
+                  mShard(shard),
+                  mRequest(request),
+                  mIndex(index) {
+        }
+
+        ClientBatch* mBatch;
+        size_t mShard;
+        size_t mRequest;
+        uint32_t mIndex;
+    };
+
+    ClientBatch(BaseClientProcessor& processor, crossbow::infinio::Fiber& fiber,
+            const commitmanager::SnapshotDescriptor& snapshot);
+
+    Future get(const Table& table, uint64_t key);
+
+    Future insert(const Table& table, uint64_t key, GenericTuple data);
+
+    Future insert(const Table& table, uint64_t key, const AbstractTuple& tuple);
+
+    Future update(const Table& table, uint64_t key, GenericTuple data);
+
+    Future update(const Table& table, uint64_t key, const AbstractTuple& tuple);
+
+    Future remove(const Table& table, uint64_t key);
+
+    Future revert(const Table& table, uint64_t key);
+
+    /**
+     * @brief Sends all collected operations with one request per shard
+     */
+    void send();
+
+    /**
+     * @brief Clears all operations and results so the batch can be reused
+     */
+    void reset();
+
+private:
+    Future append(RequestType type, const Table& table, uint64_t key, const AbstractTuple* tuple);
+
+    /**
+     * @brief Sends the operations collected for the shard as one request
+     */
+    void flush(size_t shard);
+
+    /**
+     * @brief The response of the given request to the shard (sends the batch if it was not yet sent)
+     */
+    BatchResponse& response(size_t shard, size_t request);
+
+    BaseClientProcessor& mProcessor;
+    crossbow::infinio::Fiber& mFiber;
+    const commitmanager::SnapshotDescriptor& mSnapshot;
+
+    /// Maximum length of the serialized operations in a single request
+    uint32_t mMaxOperationsLength;
+
+    /// Operations collected for every shard and not yet sent
+    std::vector<BatchOperations> mOperations;
+
+    /// Responses of the requests already sent to every shard
+    std::vector<std::vector<std::shared_ptr<BatchResponse>>> mResponses;
+
+    /// Whether the batch was already sent
+    bool mSent;
+};
+
 /**
  * @brief Class managing all running TellStore fibers and its associated context
  */
@@ -27,6 +27,7 @@
 #include <tellstore/GenericTuple.hpp>
 #include <tellstore/Record.hpp>
 #include <tellstore/ScanMemory.hpp>
+#include <tellstore/Statistics.hpp>
 #include <tellstore/Table.hpp>
 
 #include <crossbow/byte_buffer.hpp>
@@ -40,6 +41,7 @@
 #include <memory>
 #include <system_error>
 #include <tuple>
+#include <vector>
 
 namespace tell {
 namespace commitmanager {
@@ -132,6 +134,15 @@ class GetResponse final : public crossbow::infinio::RpcResponseResult<GetRespons
 public:
     using Base::Base;
 
+    /**
+     * @brief Modification counter of the table on the shard read before the tuple was read
+     *
+     * Only valid after the response completed successfully.
+     */
+    uint64_t watermark() const {
+        return mWatermark;
+    }
+
 private:
     friend Base;
 
@@ -142,6 +153,8 @@ private:
     }
 
     void processResponse(crossbow::buffer_reader& message);
+
+    uint64_t mWatermark = 0u;
 };
 
 /**
@@ -165,8 +178,221 @@ private:
     void processResponse(crossbow::buffer_reader& message);
 };
 
+/**
+ * @brief Buffer collecting the serialized point operations of a Batch request
+ *
+ * The buffer keeps its memory when cleared so it can be reused for subsequent batches without allocating.
+ */
+class BatchOperations {
+public:
+    BatchOperations()
+            : mCount(0u) {
+    }
+
+    /**
+     * @brief Number of operations in the batch
+     */
+    uint32_t count() const {
+        return mCount;
+    }
+
+    bool empty() const {
+        return (mCount == 0u);
+    }
+
+    const std::vector<char>& data() const {
+        return mData;
+    }
+
+    /**
+     * @brief Length of the serialized operation with the given tuple
+     */
+    static uint32_t operationLength(const AbstractTuple* tuple);
+
+    /**
+     * @brief Appends the operation to the batch
+     *
+     * @param type Type of the operation
+     * @param tableId The table ID of the requested tuple
+     * @param schemaVersion The schema version the tuple's data was written in
+     * @param key The key of the requested tuple
+     * @param tuple The tuple's data (nullptr for get, remove and revert)
+     * @return The index of the operation in the batch
+     */
+    uint32_t append(RequestType type, uint64_t tableId, uint32_t schemaVersion, uint64_t key,
+            const AbstractTuple* tuple);
+
+    /**
+     * @brief Removes all operations from the batch while keeping the memory
+     */
+    void clear() {
+        mData.clear();
+        mCount = 0u;
+    }
+
+private:
+    std::vector<char> mData;
+
+    uint32_t mCount;
+};
+
+/**
+ * @brief Response for a Batch request
+ *
+ * Contains the results of all operations in the batch. The results are indexed by the position of the operation in the
+ * batch.
+ */
+class BatchResponse final : public crossbow::infinio::RpcResponseResult<BatchResponse, void> {
+    using Base = crossbow::infinio::RpcResponseResult<BatchResponse, void>;
+
+public:
+    BatchResponse(crossbow::infinio::Fiber& fiber, uint32_t count)
+            : Base(fiber) {
+        mResults.reserve(count);
+    }
+
+    /**
+     * @brief The error of the operation at the given position (only valid after the response completed)
+     */
+    const std::error_code& operationError(uint32_t index) const {
+        return mResults.at(index).error;
+    }
+
+    /**
+     * @brief Moves the tuple returned by the get operation at the given position out of the response
+     */
+    std::unique_ptr<Tuple> operationTuple(uint32_t index) {
+        return std::move(mResults.at(index).tuple);
+    }
+
+private:
+    friend Base;
+
+    struct OperationResult {
+        OperationResult(std::error_code e, std::unique_ptr<Tuple> t)
+                : error(std::move(e)),
+                  tuple(std::move(t)) {
+        }
+
+        std::error_code error;
+        std::unique_ptr<Tuple> tuple;
+    };
+
+    static constexpr ResponseType MessageType = ResponseType::BATCH;
+
+    static const std::error_category& errorCategory() {
+        return error::get_error_category();
+    }
+
+    void processResponse(crossbow::buffer_reader& message);
+
+    std::vector<OperationResult> mResults;
+};
+
+/**
+ * @brief Response for a Watermark request
+ *
+ * Contains the modification counter of every requested table in the order of the request.
+ */
+class WatermarkResponse final
+        : public crossbow::infinio::RpcResponseResult<WatermarkResponse, std::vector<uint64_t>> {
+    using Base = crossbow::infinio::RpcResponseResult<WatermarkResponse, std::vector<uint64_t>>;
+
+public:
+    WatermarkResponse(crossbow::infinio::Fiber& fiber, uint32_t count)
+            : Base(fiber),
+              mCount(count) {
+    }
+
+private:
+    friend Base;
+
+    static constexpr ResponseType MessageType = ResponseType::WATERMARK;
+
+    static const std::error_category& errorCategory() {
+        return error::get_error_category();
+    }
+
+    void processResponse(crossbow::buffer_reader& message);
+
+    uint32_t mCount;
+};
+
+/**
+ * @brief Response for a Stats request
+ *
+ * Contains the latency histograms of all network threads of the server merged together.
+ */
+class StatsResponse final : public crossbow::infinio::RpcResponseResult<StatsResponse, ServerStatistics> {
+    using Base = crossbow::infinio::RpcResponseResult<StatsResponse, ServerStatistics>;
+
+public:
+    using Base::Base;
+
+private:
+    friend Base;
+
+    static constexpr ResponseType MessageType = ResponseType::STATS;
+
+    static const std::error_category& errorCategory() {
+        return error::get_error_category();
+    }
+
+    void processResponse(crossbow::buffer_reader& message);
+};
+
+/**
+ * @brief Response for a MemoryUsage request
+ *
+ * Contains the memory in use on the server by table and category.
+ */
+class MemoryUsageResponse final : public crossbow::infinio::RpcResponseResult<MemoryUsageResponse, MemoryUsage> {
+    using Base = crossbow::infinio::RpcResponseResult<MemoryUsageResponse, MemoryUsage>;
+
+public:
+    using Base::Base;
+
+private:
+    friend Base;
+
+    static constexpr ResponseType MessageType = ResponseType::MEMORY_USAGE;
+
+    static const std::error_category& errorCategory() {
+        return error::get_error_category();
+    }
+
+    void processResponse(crossbow::buffer_reader& message);
+};
+
+/**
+ * @brief Response for an Export-Table request
+ *
+ * Contains the number of rows written into the export file.
+ */
+class ExportTableResponse final : public crossbow::infinio::RpcResponseResult<ExportTableResponse, uint64_t> {
+    using Base = crossbow::infinio::RpcResponseResult<ExportTableResponse, uint64_t>;
+
+public:
+    using Base::Base;
+
+private:
+    friend Base;
+
+    static constexpr ResponseType MessageType = ResponseType::EXPORT_TABLE;
+
+    static const std::error_category& errorCategory() {
+        return error::get_error_category();
+    }
+
+    void processResponse(crossbow::buffer_reader& message);
+};
+
 /**
  * @brief Response for a Scan request
+ *
+ * The scan memory is used as a ring buffer by the remote server. Offsets are logical offsets increasing monotonically
+ * over the lifetime of the scan. The server may only write into space released by the client, released space is
+ * advertised to the server in batches.
  */
 class ScanResponse final : public crossbow::infinio::RpcResponse, public std::enable_shared_from_this<ScanResponse> {
 public:
@@ -187,10 +413,18 @@ public:
     /**
      * @brief Returns the next available data chunk written by the remote server
      *
+     * The chunk never crosses the end of the scan memory, data wrapping around is returned in a subsequent chunk. The
+     * chunk stays valid until it is released with releaseChunk().
+     *
      * @return Tuple containing the start and end pointer to the next available chunk
      */
     std::tuple<const char*, const char*> nextChunk();
 
+    /**
+     * @brief Releases all chunks returned by nextChunk() so the remote server can reuse the memory
+     */
+    void releaseChunk();
+
 private:
     friend class ClientSocket;
 
@@ -211,8 +445,17 @@ private:
     /// Amount of data read by the client
     size_t mOffsetRead;
 
+    /// Amount of data released by the client
+    size_t mOffsetReleased;
+
+    /// Amount of released data advertised to the remote server
+    size_t mOffsetAdvertised;
+
     /// Amount of data written by the remote server
     size_t mOffsetWritten;
+
+    /// Offset at which the remote server last skipped the remaining space in the scan memory and wrapped around
+    size_t mWrapOffset;
 };
 
 /**
@@ -247,6 +490,8 @@ public:
     /**
      * @brief Returns the current chunk of elements and advances the iterator to the next chunk
      *
+     * The chunk stays valid until the next call to hasNext(), next() or nextChunk().
+     *
      * @return Tuple containing the start and end pointer to the current chunk
      */
     std::tuple<const char*, const char*> nextChunk();
@@ -281,6 +526,9 @@ private:
 
     std::error_code mError;
 
+    /// Response the current chunk belongs to
+    ScanResponse* mChunkResponse;
+
     const char* mChunkPos;
 
     const char* mChunkEnd;
@@ -303,6 +551,18 @@ public:
     std::shared_ptr<CreateTableResponse> createTable(crossbow::infinio::Fiber& fiber, const crossbow::string& name,
             const Schema& schema);
 
+    /**
+     * @brief Adds the schema as successor of the given schema version
+     *
+     * With validateOnly set the storage only checks if the schema change would succeed without altering the table.
+     */
+    std::shared_ptr<ModificationResponse> alterTable(crossbow::infinio::Fiber& fiber, uint64_t tableId,
+            uint32_t schemaVersion, const Schema& schema, bool validateOnly);
+
+    std::shared_ptr<ModificationResponse> dropTable(crossbow::infinio::Fiber& fiber, uint64_t tableId);
+
+    std::shared_ptr<ModificationResponse> truncateTable(crossbow::infinio::Fiber& fiber, uint64_t tableId);
+
     std::shared_ptr<GetTablesResponse> getTables(crossbow::infinio::Fiber& fiber);
 
     std::shared_ptr<GetTableResponse> getTable(crossbow::infinio::Fiber& fiber, const crossbow::string& name);
@@ -310,11 +570,13 @@ public:
     std::shared_ptr<GetResponse> get(crossbow::infinio::Fiber& fiber, uint64_t tableId, uint64_t key,
             const commitmanager::SnapshotDescriptor& snapshot);
 
-    std::shared_ptr<ModificationResponse> insert(crossbow::infinio::Fiber& fiber, uint64_t tableId, uint64_t key,
-            const commitmanager::SnapshotDescriptor& snapshot, const AbstractTuple& tuple);
+    std::shared_ptr<ModificationResponse> insert(crossbow::infinio::Fiber& fiber, uint64_t tableId,
+            uint32_t schemaVersion, uint64_t key, const commitmanager::SnapshotDescriptor& snapshot,
+            const AbstractTuple& tuple);
 
-    std::shared_ptr<ModificationResponse> update(crossbow::infinio::Fiber& fiber, uint64_t tableId, uint64_t key,
-            const commitmanager::SnapshotDescriptor& snapshot, const AbstractTuple& tuple);
+    std::shared_ptr<ModificationResponse> update(crossbow::infinio::Fiber& fiber, uint64_t tableId,
+            uint32_t schemaVersion, uint64_t key, const commitmanager::SnapshotDescriptor& snapshot,
+            const AbstractTuple& tuple);
 
     std::shared_ptr<ModificationResponse> remove(crossbow::infinio::Fiber& fiber, uint64_t tableId, uint64_t key,
             const commitmanager::SnapshotDescriptor& snapshot);
@@ -322,6 +584,19 @@ public:
     std::shared_ptr<ModificationResponse> revert(crossbow::infinio::Fiber& fiber, uint64_t tableId, uint64_t key,
             const commitmanager::SnapshotDescriptor& snapshot);
 
+    std::shared_ptr<BatchResponse> batch(crossbow::infinio::Fiber& fiber, const BatchOperations& operations,
+            const commitmanager::SnapshotDescriptor& snapshot);
+
+    std::shared_ptr<WatermarkResponse> watermark(crossbow::infinio::Fiber& fiber,
+            const std::vector<uint64_t>& tableIds);
+
+    std::shared_ptr<StatsResponse> stats(crossbow::infinio::Fiber& fiber);
+
+    std::shared_ptr<MemoryUsageResponse> memoryUsage(crossbow::infinio::Fiber& fiber);
+
+    std::shared_ptr<ExportTableResponse> exportTable(crossbow::infinio::Fiber& fiber, uint64_t tableId,
+            const crossbow::string& fileName, const commitmanager::SnapshotDescriptor& snapshot);
+
     void scanStart(uint16_t scanId, std::shared_ptr<ScanResponse> response, uint64_t tableId, ScanQueryType queryType,
             uint32_t selectionLength, const char* selection, uint32_t queryLength, const char* query,
             const commitmanager::SnapshotDescriptor& snapshot);
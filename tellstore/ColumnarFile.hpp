@@ -0,0 +1,314 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <tellstore/Record.hpp>
+
+#include <crossbow/non_copyable.hpp>
+#include <crossbow/string.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Encoding of the values in a column chunk
+ */
+enum class ColumnEncoding : uint32_t {
+    /// Values are stored uncompressed
+    PLAIN = 0x0u,
+};
+
+/**
+ * @brief Header preceding the data of every column in a row group
+ *
+ * The minimum and maximum are only valid for fixed size columns containing at least one non-NULL value. They are
+ * stored as int64_t for integer columns and as double for floating point columns.
+ */
+struct ColumnChunkHeader {
+    /// The column contains NULL values
+    static constexpr uint32_t HAS_NULLS = 0x1u;
+
+    /// The minimum and maximum are valid
+    static constexpr uint32_t HAS_MIN_MAX = 0x2u;
+
+    uint32_t encoding;
+    uint32_t flags;
+
+    /// Length of the column data following the header
+    uint64_t length;
+
+    char min[8];
+    char max[8];
+};
+
+/**
+ * @brief Entry of the row group directory in the file footer
+ */
+struct RowGroupInfo {
+    uint64_t offset;
+    uint64_t length;
+    uint64_t rowCount;
+};
+
+/**
+ * @brief Accumulates tuples in the record format and serializes them as a columnar row group
+ *
+ * A row group has the following format:
+ * - 8 bytes: Number of rows
+ * - 8 bytes: For every row the key
+ * - For every field (in the order of the field IDs of the record):
+ *   - x bytes: Column chunk header
+ *   If the field can be NULL:
+ *   - 1 byte:  For every row whether the value is NULL
+ *   - y bytes: Variable padding to make the chunk 8 byte aligned
+ *   If the field is fixed size:
+ *   - x bytes: For every row the value (zero if NULL)
+ *   - y bytes: Variable padding to make the chunk 8 byte aligned
+ *   If the field is variable size:
+ *   - 4 bytes: For every row and one past the last row the offset of the value relative to the start of the data
+ *   - y bytes: Variable padding to make the chunk 8 byte aligned
+ *   - x bytes: The data of all values
+ *   - y bytes: Variable padding to make the chunk 8 byte aligned
+ */
+class ColumnarRowGroupBuilder : crossbow::non_copyable, crossbow::non_movable {
+public:
+    /**
+     * @brief Creates a builder for tuples of the record
+     *
+     * The record must outlive the builder.
+     */
+    ColumnarRowGroupBuilder(const Record& record);
+
+    /**
+     * @brief Number of rows added since the builder was last cleared
+     */
+    size_t rowCount() const {
+        return mKeys.size();
+    }
+
+    /**
+     * @brief Splits the tuple into the column chunks
+     */
+    void add(uint64_t key, const char* tuple);
+
+    /**
+     * @brief Serializes the row group into the buffer (replacing its content)
+     */
+    void serialize(std::vector<char>& buffer) const;
+
+    /**
+     * @brief Removes all rows while keeping the allocated memory
+     */
+    void clear();
+
+private:
+    struct Column {
+        Column()
+                : hasNulls(false),
+                  hasMinMax(false) {
+        }
+
+        std::vector<char> nulls;
+        std::vector<char> values;
+        std::vector<uint32_t> offsets;
+        bool hasNulls;
+        bool hasMinMax;
+        char min[8];
+        char max[8];
+    };
+
+    void updateMinMax(Column& column, FieldType type, const char* data);
+
+    const Record& mRecord;
+
+    std::vector<uint64_t> mKeys;
+
+    std::vector<Column> mColumns;
+};
+
+/**
+ * @brief Writes row groups into a columnar file
+ *
+ * The file has the following format:
+ * - 8 bytes: The file magic
+ * - For every row group:
+ *   - x bytes: The row group (see ColumnarRowGroupBuilder)
+ * - x bytes: The table schema
+ * - y bytes: Variable padding to make the footer 8 byte aligned
+ * - 8 bytes: Number of row groups
+ * - For every row group:
+ *   - 8 bytes: Offset of the row group in the file
+ *   - 8 bytes: Length of the row group
+ *   - 8 bytes: Number of rows in the row group
+ * - 8 bytes: Length of the footer (from the start of the schema to the footer length)
+ * - 8 bytes: The file magic
+ *
+ * Row groups can be appended concurrently by multiple threads: Every append reserves the space in the file and writes
+ * the complete row group in one sequential write. The order of the row groups is unspecified.
+ */
+class ColumnarFileWriter : crossbow::non_copyable, crossbow::non_movable {
+public:
+    /**
+     * @brief Creates (or truncates) the file at the given path
+     *
+     * Throws std::system_error if the file can not be created.
+     */
+    ColumnarFileWriter(const crossbow::string& path, Schema schema);
+
+    ~ColumnarFileWriter();
+
+    /**
+     * @brief Appends the serialized row group to the file
+     *
+     * Throws std::system_error if the write fails.
+     */
+    void append(const std::vector<char>& rowGroup, uint64_t rowCount);
+
+    /**
+     * @brief Writes the footer and closes the file
+     *
+     * Throws std::system_error if the write fails.
+     *
+     * @return Total number of rows in the file
+     */
+    uint64_t close();
+
+private:
+    void write(const char* data, size_t length, uint64_t offset);
+
+    int mFd;
+
+    Schema mSchema;
+
+    std::mutex mMutex;
+
+    /// End of the data reserved by the row groups
+    uint64_t mOffset;
+
+    uint64_t mRowCount;
+
+    std::vector<RowGroupInfo> mRowGroups;
+};
+
+/**
+ * @brief View on a row group of a columnar file
+ */
+class ColumnarRowGroup {
+public:
+    ColumnarRowGroup(const Record& record, const char* data, size_t length);
+
+    uint64_t rowCount() const {
+        return mRowCount;
+    }
+
+    uint64_t key(uint64_t row) const {
+        return mKeys[row];
+    }
+
+    const ColumnChunkHeader& columnHeader(Record::id_t id) const {
+        return *mColumns[id].header;
+    }
+
+    /**
+     * @brief Size of the row materialized in the record format
+     */
+    uint32_t tupleSize(uint64_t row) const;
+
+    /**
+     * @brief Materializes the row in the record format
+     *
+     * @param row Index of the row in the row group
+     * @param dest Destination buffer (must hold at least tupleSize(row) bytes)
+     */
+    void materialize(uint64_t row, char* dest) const;
+
+private:
+    struct Column {
+        const ColumnChunkHeader* header;
+        const char* nulls;
+        const char* values;
+        const uint32_t* offsets;
+        const char* heap;
+    };
+
+    const Record* mRecord;
+
+    uint64_t mRowCount;
+
+    const uint64_t* mKeys;
+
+    std::vector<Column> mColumns;
+};
+
+/**
+ * @brief Reads a columnar file written by the ColumnarFileWriter
+ *
+ * The file is mapped into memory, row groups are views into the mapping.
+ */
+class ColumnarFileReader : crossbow::non_copyable, crossbow::non_movable {
+public:
+    /**
+     * @brief Opens the file at the given path
+     *
+     * Throws std::system_error if the file can not be mapped and std::runtime_error if it is no valid columnar file.
+     */
+    ColumnarFileReader(const crossbow::string& path);
+
+    ~ColumnarFileReader();
+
+    const Record& record() const {
+        return mRecord;
+    }
+
+    size_t rowGroupCount() const {
+        return mRowGroups.size();
+    }
+
+    uint64_t rowCount() const {
+        return mRowCount;
+    }
+
+    ColumnarRowGroup rowGroup(size_t idx) const {
+        auto& info = mRowGroups.at(idx);
+        return ColumnarRowGroup(mRecord, mData + info.offset, info.length);
+    }
+
+private:
+    const char* mData;
+
+    size_t mLength;
+
+    Record mRecord;
+
+    uint64_t mRowCount;
+
+    std::vector<RowGroupInfo> mRowGroups;
+};
+
+} // namespace store
+} // namespace tell
@@ -66,6 +66,27 @@ enum errors {
 
     /// Write operation unable to complete.
     invalid_write,
+
+    /// Write operation sent to a read replica.
+    read_only_replica,
+
+    /// Replica did not yet apply all versions readable by the snapshot.
+    not_replicated,
+
+    /// Export file could not be written.
+    export_failed,
+
+    /// Schema change was invalid or is not supported by the storage.
+    invalid_schema_change,
+
+    /// Operation is not supported by the storage.
+    unsupported_operation,
+
+    /// Scan data could not be written to the client.
+    scan_write_failed,
+
+    /// Result does not fit into the response message.
+    response_too_large,
 };
 
 /**
@@ -112,6 +133,27 @@ public:
         case invalid_write:
             return "Write operation unable to complete";
 
+        case read_only_replica:
+            return "Write operation not allowed on a read replica";
+
+        case not_replicated:
+            return "Snapshot not yet replicated";
+
+        case export_failed:
+            return "Export file could not be written";
+
+        case invalid_schema_change:
+            return "Schema change was invalid or is not supported";
+
+        case unsupported_operation:
+            return "Operation is not supported by the storage";
+
+        case scan_write_failed:
+            return "Scan data could not be written to the client";
+
+        case response_too_large:
+            return "Result does not fit into the response message";
+
         default:
             return "tell.store.server error";
         }
@@ -0,0 +1,152 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <crossbow/infinio/Fiber.hpp>
+#include <crossbow/infinio/InfinibandService.hpp>
+#include <crossbow/non_copyable.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Pool of long running fibers executing client functions on one InfinibandProcessor
+ *
+ * Starting a new fiber is expensive as it requires the allocation and setup of a new stack. The pool keeps finished
+ * fibers parked and hands new functions directly to them. The pool grows on demand up to the maximum number of fibers,
+ * functions submitted while all fibers are busy are queued until one of the fibers finishes.
+ *
+ * Except for the statistics and shutdown all functions must only be called from within the processor's thread.
+ */
+class FiberPool : crossbow::non_copyable, crossbow::non_movable {
+public:
+    using Function = std::function<void(crossbow::infinio::Fiber&)>;
+
+    /**
+     * @brief Creates the pool and starts the initial fibers on the processor
+     *
+     * @param processor The processor to execute the fibers on
+     * @param initialSize Number of fibers to start ahead of time
+     * @param maxSize Maximum number of fibers in the pool
+     */
+    FiberPool(crossbow::infinio::InfinibandProcessor& processor, size_t initialSize, size_t maxSize);
+
+    /**
+     * @brief Executes the function in an idle fiber from the pool
+     *
+     * Starts a new fiber if no fiber is idle and the pool has not yet reached its maximum size, otherwise the function is
+     * queued until a fiber becomes idle.
+     */
+    void execute(Function fun);
+
+    /**
+     * @brief Terminates all idle fibers and lets busy fibers terminate as soon as they finish
+     *
+     * Can be called from any thread.
+     */
+    void shutdown();
+
+    /**
+     * @brief Number of fibers currently in the pool
+     */
+    size_t size() const {
+        return mSize.load();
+    }
+
+    /**
+     * @brief Number of functions that were handed to an idle fiber
+     */
+    uint64_t hits() const {
+        return mHits.load();
+    }
+
+    /**
+     * @brief Number of functions that required a new fiber to be started
+     */
+    uint64_t misses() const {
+        return mMisses.load();
+    }
+
+    /**
+     * @brief Number of functions that had to wait for a fiber because the pool reached its maximum size
+     */
+    uint64_t waits() const {
+        return mWaits.load();
+    }
+
+private:
+    /**
+     * @brief State of a fiber in the pool
+     */
+    struct Worker {
+        Worker(crossbow::infinio::Fiber& f)
+                : fiber(f) {
+        }
+
+        crossbow::infinio::Fiber& fiber;
+
+        /// Function handed to the worker while it was idle
+        Function fun;
+    };
+
+    /**
+     * @brief Starts a new fiber in the pool
+     */
+    void spawn();
+
+    /**
+     * @brief Main loop of every fiber in the pool
+     */
+    void run(crossbow::infinio::Fiber& fiber);
+
+    crossbow::infinio::InfinibandProcessor& mProcessor;
+
+    size_t mMaxSize;
+
+    /// Whether the pool was shut down
+    bool mShutdown;
+
+    /// Fibers waiting for a new function
+    std::vector<Worker*> mIdle;
+
+    /// Functions waiting for an idle fiber
+    std::deque<Function> mQueue;
+
+    std::atomic<size_t> mSize;
+
+    std::atomic<uint64_t> mHits;
+
+    std::atomic<uint64_t> mMisses;
+
+    std::atomic<uint64_t> mWaits;
+};
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,281 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <tellstore/AbstractTuple.hpp>
+#include <tellstore/ColumnarFile.hpp>
+#include <tellstore/Record.hpp>
+
+#include <crossbow/non_copyable.hpp>
+#include <crossbow/string.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Format of a file loaded by the importer
+ */
+enum class ImportFormat : uint8_t {
+    /// Delimiter separated text with one row per line
+    CSV = 0x1u,
+
+    /// Fixed size rows consisting of the 8 byte key followed by the tuple in the record format
+    BINARY,
+
+    /// Columnar file written by a table export
+    COLUMNAR,
+};
+
+/**
+ * @brief Options controlling how an import file is interpreted
+ */
+struct ImportConfig {
+    ImportConfig()
+            : format(ImportFormat::CSV),
+              delimiter(','),
+              header(false),
+              keyColumn("key") {
+    }
+
+    ImportFormat format;
+
+    /// Delimiter between the fields of a CSV row
+    char delimiter;
+
+    /// Whether the first line of a CSV file names the columns
+    bool header;
+
+    /// Name of the CSV column containing the key (only used with a header)
+    crossbow::string keyColumn;
+};
+
+/**
+ * @brief Tuple that is already serialized in the record format
+ */
+class SerializedTuple : public AbstractTuple {
+public:
+    SerializedTuple(const char* data, size_t size)
+            : mData(data),
+              mSize(size) {
+    }
+
+    virtual size_t size() const final override {
+        return mSize;
+    }
+
+    virtual void serialize(char* dest) const final override {
+        memcpy(dest, mData, mSize);
+    }
+
+private:
+    const char* mData;
+    size_t mSize;
+};
+
+/**
+ * @brief Read only memory mapping of a local file
+ */
+class MappedFile : crossbow::non_copyable, crossbow::non_movable {
+public:
+    /**
+     * @brief Maps the file at the given path
+     *
+     * Throws std::system_error if the file can not be mapped.
+     */
+    MappedFile(const crossbow::string& path);
+
+    ~MappedFile();
+
+    const char* data() const {
+        return mData;
+    }
+
+    size_t size() const {
+        return mSize;
+    }
+
+private:
+    const char* mData;
+    size_t mSize;
+};
+
+/**
+ * @brief Sequence of rows from one chunk of an import file
+ */
+class ImportCursor {
+public:
+    virtual ~ImportCursor();
+
+    /**
+     * @brief Converts the next row into the record format
+     *
+     * The tuple data is only valid until the next invocation.
+     *
+     * Throws std::invalid_argument if the row can not be converted.
+     *
+     * @param key Key of the row
+     * @param data Tuple of the row in the record format
+     * @param size Size of the tuple
+     * @return False if the chunk contains no more rows
+     */
+    virtual bool next(uint64_t& key, const char*& data, size_t& size) = 0;
+};
+
+/**
+ * @brief Import file split into chunks that can be converted independently
+ *
+ * The file is mapped into memory and must not be modified while it is imported.
+ */
+class ImportSource : crossbow::non_copyable, crossbow::non_movable {
+public:
+    /**
+     * @brief Opens the import file
+     *
+     * Throws std::system_error if the file can not be opened and std::invalid_argument if the file does not match the
+     * record.
+     *
+     * @param path Path to the file
+     * @param record Record of the table the rows are imported into
+     * @param config Options of the import
+     * @param chunkCount Number of chunks the file should be split into (columnar files are split by row group)
+     */
+    static std::unique_ptr<ImportSource> open(const crossbow::string& path, const Record& record,
+            const ImportConfig& config, size_t chunkCount);
+
+    virtual ~ImportSource();
+
+    virtual size_t chunkCount() const = 0;
+
+    /**
+     * @brief Creates a cursor over the rows of the chunk
+     *
+     * Cursors of different chunks can be used concurrently.
+     */
+    virtual std::unique_ptr<ImportCursor> chunk(size_t idx) const = 0;
+};
+
+/**
+ * @brief Converts the rows of a CSV file into the record format
+ *
+ * Every line contains one row. Empty fields are NULL, fields can be enclosed in double quotes (with embedded quotes
+ * escaped by doubling them) but must not span multiple lines. The delimiter and line ends are located 16 bytes at a
+ * time with SSE2 where available.
+ *
+ * Without a header the first column contains the key followed by the values in the order of the record's field IDs.
+ */
+class CsvImportSource : public ImportSource {
+public:
+    CsvImportSource(const crossbow::string& path, const Record& record, const ImportConfig& config,
+            size_t chunkCount);
+
+    virtual size_t chunkCount() const final override {
+        return mChunkCount;
+    }
+
+    virtual std::unique_ptr<ImportCursor> chunk(size_t idx) const final override;
+
+    /// Column that does not map to any field
+    static constexpr int32_t SKIP_COLUMN = -2;
+
+    /// Column containing the key
+    static constexpr int32_t KEY_COLUMN = -1;
+
+private:
+    class Cursor;
+
+    /**
+     * @brief Start of the first line beginning at or after the offset
+     */
+    const char* lineStart(size_t offset) const;
+
+    const Record& mRecord;
+
+    MappedFile mFile;
+
+    char mDelimiter;
+
+    /// Start of the first row (after the header)
+    const char* mBegin;
+
+    size_t mChunkCount;
+
+    /// Field ID of every column (or one of the special column values)
+    std::vector<int32_t> mColumns;
+};
+
+/**
+ * @brief Reads fixed size rows in the record format
+ *
+ * Every row consists of the 8 byte key followed by the tuple padded to 8 bytes. The tuples are passed on without
+ * copying, as rows must have the same size only records without variable sized fields are supported.
+ */
+class BinaryImportSource : public ImportSource {
+public:
+    BinaryImportSource(const crossbow::string& path, const Record& record, size_t chunkCount);
+
+    virtual size_t chunkCount() const final override {
+        return mChunkCount;
+    }
+
+    virtual std::unique_ptr<ImportCursor> chunk(size_t idx) const final override;
+
+private:
+    class Cursor;
+
+    MappedFile mFile;
+
+    size_t mRowSize;
+
+    size_t mRowCount;
+
+    size_t mChunkCount;
+};
+
+/**
+ * @brief Reads the rows of a columnar file (see ColumnarFileWriter) with one chunk per row group
+ */
+class ColumnarImportSource : public ImportSource {
+public:
+    ColumnarImportSource(const crossbow::string& path, const Record& record);
+
+    virtual size_t chunkCount() const final override {
+        return mReader.rowGroupCount();
+    }
+
+    virtual std::unique_ptr<ImportCursor> chunk(size_t idx) const final override;
+
+private:
+    class Cursor;
+
+    ColumnarFileReader mReader;
+};
+
+} // namespace store
+} // namespace tell
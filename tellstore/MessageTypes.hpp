@@ -50,6 +50,14 @@ enum class RequestType : uint32_t {
     SCAN,
     SCAN_PROGRESS,
     COMMIT,
+    BATCH,
+    WATERMARK,
+    STATS,
+    MEMORY_USAGE,
+    EXPORT_TABLE,
+    ALTER_TABLE,
+    DROP_TABLE,
+    TRUNCATE_TABLE,
 };
 
 /**
@@ -63,6 +71,11 @@ enum class ResponseType : uint32_t {
     MODIFICATION,
     SCAN,
     COMMIT,
+    BATCH,
+    WATERMARK,
+    STATS,
+    MEMORY_USAGE,
+    EXPORT_TABLE,
 };
 
 } // namespace store
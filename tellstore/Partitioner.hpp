@@ -0,0 +1,209 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <tellstore/StdTypes.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace crossbow {
+class buffer_reader;
+class buffer_writer;
+} // namespace crossbow
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Describes how the keys of a table are distributed among the shards
+ *
+ * The specification is part of the table schema and as such stored with the table metadata on every shard.
+ *
+ * - HASH: Keys are assigned to shard key % shardCount (the default)
+ * - CONSISTENT_HASH: Every shard owns a number of virtual nodes on a hash ring, keys are assigned to the shard owning
+ *   the next virtual node on the ring. Adding a shard only moves the keys now owned by the new shard.
+ * - RANGE: Keys are assigned by range, the bounds contain the first key of every shard except the first one in
+ *   ascending order. Growing the cluster only moves the keys of the range that is split.
+ *
+ * The format is like follows (aligned to 4 bytes):
+ * - 1 byte: Partition type
+ * - 3 bytes: Padding
+ * - 4 bytes: Number of virtual nodes per shard
+ * - 4 bytes: Number of range bounds
+ * - Alignment to 8 bytes if bounds are present
+ * - 8 bytes: For every range bound
+ */
+class PartitionSpec {
+public:
+    static PartitionSpec hash() {
+        return PartitionSpec(PartitionType::HASH, 0u, {});
+    }
+
+    static PartitionSpec consistentHash(uint32_t virtualNodes) {
+        return PartitionSpec(PartitionType::CONSISTENT_HASH, virtualNodes, {});
+    }
+
+    static PartitionSpec range(std::vector<uint64_t> bounds) {
+        return PartitionSpec(PartitionType::RANGE, 0u, std::move(bounds));
+    }
+
+    static PartitionSpec deserialize(crossbow::buffer_reader& reader);
+
+    PartitionSpec()
+            : mType(PartitionType::HASH),
+              mVirtualNodes(0u) {
+    }
+
+    PartitionType type() const {
+        return mType;
+    }
+
+    uint32_t virtualNodes() const {
+        return mVirtualNodes;
+    }
+
+    const std::vector<uint64_t>& bounds() const {
+        return mBounds;
+    }
+
+    bool operator==(const PartitionSpec& other) const {
+        return mType == other.mType && mVirtualNodes == other.mVirtualNodes && mBounds == other.mBounds;
+    }
+
+    bool operator!=(const PartitionSpec& other) const {
+        return !(*this == other);
+    }
+
+    /**
+     * @brief Length of the serialized specification starting at the given (8 byte aligned) offset
+     */
+    size_t serializedLength(size_t offset) const;
+
+    void serialize(crossbow::buffer_writer& writer) const;
+
+private:
+    PartitionSpec(PartitionType type, uint32_t virtualNodes, std::vector<uint64_t> bounds)
+            : mType(type),
+              mVirtualNodes(virtualNodes),
+              mBounds(std::move(bounds)) {
+    }
+
+    PartitionType mType;
+    uint32_t mVirtualNodes;
+    std::vector<uint64_t> mBounds;
+};
+
+/**
+ * @brief Maps keys of a table to shards according to the table's partition specification
+ */
+class Partitioner {
+public:
+    /**
+     * @brief Creates the partitioner for the given specification and number of shards
+     *
+     * Throws std::invalid_argument if the specification can not be applied to the number of shards.
+     */
+    static std::unique_ptr<Partitioner> create(const PartitionSpec& spec, size_t shardCount);
+
+    virtual ~Partitioner();
+
+    size_t shardCount() const {
+        return mShardCount;
+    }
+
+    /**
+     * @brief Index of the shard responsible for the given key
+     */
+    virtual size_t shardOf(uint64_t key) const = 0;
+
+    /**
+     * @brief Marks all shards that can hold keys matching the scan partition selection
+     *
+     * The selection matches all keys where (key >> shift) % modulo == number, a modulo of 0 matches every key. Shards
+     * that can not hold any matching key do not have to take part in the scan.
+     *
+     * @param shards Vector that is resized to the number of shards with an entry per shard
+     */
+    virtual void shardsOf(uint16_t shift, uint32_t modulo, uint32_t number, std::vector<bool>& shards) const;
+
+protected:
+    Partitioner(size_t shardCount)
+            : mShardCount(shardCount) {
+    }
+
+    size_t mShardCount;
+};
+
+/**
+ * @brief Assigns keys by key % shardCount
+ */
+class HashPartitioner : public Partitioner {
+public:
+    HashPartitioner(size_t shardCount)
+            : Partitioner(shardCount) {
+    }
+
+    virtual size_t shardOf(uint64_t key) const final override {
+        return (key % mShardCount);
+    }
+
+    virtual void shardsOf(uint16_t shift, uint32_t modulo, uint32_t number,
+            std::vector<bool>& shards) const final override;
+};
+
+/**
+ * @brief Assigns keys to the shard owning the next virtual node on the hash ring
+ */
+class ConsistentHashPartitioner : public Partitioner {
+public:
+    ConsistentHashPartitioner(size_t shardCount, uint32_t virtualNodes);
+
+    virtual size_t shardOf(uint64_t key) const final override;
+
+private:
+    /// Position of every virtual node on the ring and the shard owning it (sorted by position)
+    std::vector<std::pair<uint64_t, uint32_t>> mRing;
+};
+
+/**
+ * @brief Assigns keys by contiguous key ranges
+ */
+class RangePartitioner : public Partitioner {
+public:
+    RangePartitioner(size_t shardCount, std::vector<uint64_t> bounds);
+
+    virtual size_t shardOf(uint64_t key) const final override;
+
+    virtual void shardsOf(uint16_t shift, uint32_t modulo, uint32_t number,
+            std::vector<bool>& shards) const final override;
+
+private:
+    std::vector<uint64_t> mBounds;
+};
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,139 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <tellstore/Table.hpp>
+
+#include <crossbow/non_copyable.hpp>
+#include <crossbow/string.hpp>
+
+#include <boost/functional/hash.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Client side cache of the newest tuples of read-mostly tables
+ *
+ * Every entry is tagged with the shard's modification counter of the table that was fetched before the tuple was read
+ * from the shard. Only tuples that were the newest version at the time of the read are cached. A cached tuple is still
+ * the newest version as long as the modification counter of the table did not change, the entry is then valid for all
+ * snapshots containing the tuple's version in their read set.
+ *
+ * The cache evicts the least recently used entry when the capacity is exceeded.
+ *
+ * All functions must only be called from within the processor's thread.
+ */
+class ReadCache : crossbow::non_copyable, crossbow::non_movable {
+public:
+    struct Entry {
+        Entry(std::shared_ptr<const Tuple> _tuple, uint64_t _watermark)
+                : tuple(std::move(_tuple)),
+                  watermark(_watermark) {
+        }
+
+        std::shared_ptr<const Tuple> tuple;
+
+        /// Modification counter of the table on the tuple's shard before the tuple was read
+        uint64_t watermark;
+    };
+
+    /**
+     * @param capacity Maximum number of cached tuples
+     * @param tables Names of the tables whose tuples are cached
+     */
+    ReadCache(size_t capacity, const std::vector<crossbow::string>& tables)
+            : mCapacity(capacity),
+              mTableNames(tables.begin(), tables.end()),
+              mHits(0u),
+              mMisses(0u) {
+    }
+
+    /**
+     * @brief Whether tuples of the table are cached
+     */
+    bool isCached(const Table& table);
+
+    /**
+     * @brief Looks up the cached tuple and marks it as recently used
+     *
+     * @return The entry or nullptr if the tuple is not cached
+     */
+    const Entry* lookup(uint64_t tableId, uint64_t key);
+
+    void insert(uint64_t tableId, uint64_t key, std::shared_ptr<const Tuple> tuple, uint64_t watermark);
+
+    void invalidate(uint64_t tableId, uint64_t key);
+
+    size_t size() const {
+        return mEntries.size();
+    }
+
+    uint64_t hits() const {
+        return mHits;
+    }
+
+    uint64_t misses() const {
+        return mMisses;
+    }
+
+    void recordHit() {
+        ++mHits;
+    }
+
+    void recordMiss() {
+        ++mMisses;
+    }
+
+private:
+    using Key = std::pair<uint64_t, uint64_t>;
+    using LruList = std::list<std::pair<Key, Entry>>;
+
+    size_t mCapacity;
+
+    /// Names of the tables configured to be cached
+    std::unordered_set<crossbow::string> mTableNames;
+
+    /// Cached decision for every table ID whether the table is cached
+    std::unordered_map<uint64_t, bool> mTables;
+
+    /// Entries ordered from most to least recently used
+    LruList mLru;
+
+    std::unordered_map<Key, LruList::iterator, boost::hash<Key>> mEntries;
+
+    uint64_t mHits;
+    uint64_t mMisses;
+};
+
+} // namespace store
+} // namespace tell
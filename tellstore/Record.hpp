@@ -24,6 +24,7 @@
 #pragma once
 
 #include <tellstore/GenericTuple.hpp>
+#include <tellstore/Partitioner.hpp>
 #include <tellstore/StdTypes.hpp>
 
 #include <crossbow/logger.hpp>
@@ -298,6 +299,7 @@ public:
 *   - string - aligned to 2
 *   - For each column:
 *       - 2 byte: column id
+* - The partition specification of the table (see PartitionSpec)
 */
 class Schema {
 public:
@@ -309,6 +311,7 @@ private:
     std::vector<Field> mFixedSizeFields;
     std::vector<Field> mVarSizeFields;
     IndexMap mIndexes;
+    PartitionSpec mPartitioning;
 public:
     Schema() = default;
 
@@ -323,6 +326,14 @@ public:
     Schema& operator=(const Schema&) = default;
 
     bool addField(FieldType type, const crossbow::string& name, bool notNull);
+
+    /**
+     * @brief Removes the field with the given name
+     *
+     * The IDs of all following fields shift by one. Fails if the field does not exist or the schema has indexes.
+     */
+    bool removeField(const crossbow::string& name);
+
     template<class Name, class Fields>
     void addIndex(Name&& name, Fields&& fields) {
         mIndexes.emplace(std::forward<Name>(name), std::forward<Fields>(fields));
@@ -356,6 +367,17 @@ public:
         return mIndexes;
     }
 
+    /**
+     * @brief How the keys of the table are distributed among the shards
+     */
+    const PartitionSpec& partitioning() const {
+        return mPartitioning;
+    }
+
+    void setPartitioning(PartitionSpec partitioning) {
+        mPartitioning = std::move(partitioning);
+    }
+
     uint32_t fieldCount() const {
         return mFixedSizeFields.size() + mVarSizeFields.size();
     }
@@ -0,0 +1,380 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <tellstore/StdTypes.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace crossbow {
+class buffer_reader;
+class buffer_writer;
+} // namespace crossbow
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Layout of the buckets of a latency histogram
+ *
+ * Values are recorded with a relative precision of 1/16: Every power of two is split into 16 linear sub-buckets (values
+ * smaller than 16 get a bucket each). Values larger than 2^41 are recorded in the last bucket.
+ */
+struct LatencyBuckets {
+    static constexpr uint32_t SUB_BUCKET_BITS = 4u;
+    static constexpr uint32_t SUB_BUCKET_COUNT = (1u << SUB_BUCKET_BITS);
+    static constexpr uint32_t MAX_EXPONENT = 40u;
+    static constexpr uint32_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2u) * SUB_BUCKET_COUNT;
+
+    /**
+     * @brief Index of the bucket the value belongs to
+     */
+    static uint32_t bucketOf(uint64_t value) {
+        if (value < SUB_BUCKET_COUNT) {
+            return static_cast<uint32_t>(value);
+        }
+        auto exponent = static_cast<uint32_t>(63 - __builtin_clzll(value));
+        if (exponent > MAX_EXPONENT) {
+            return BUCKET_COUNT - 1u;
+        }
+        auto subBucket = static_cast<uint32_t>(value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1u);
+        return (exponent - SUB_BUCKET_BITS + 1u) * SUB_BUCKET_COUNT + subBucket;
+    }
+
+    /**
+     * @brief Smallest value recorded in the bucket
+     */
+    static uint64_t lowerBound(uint32_t bucket) {
+        if (bucket < SUB_BUCKET_COUNT) {
+            return bucket;
+        }
+        auto exponent = bucket / SUB_BUCKET_COUNT + SUB_BUCKET_BITS - 1u;
+        auto subBucket = bucket % SUB_BUCKET_COUNT;
+        return static_cast<uint64_t>(SUB_BUCKET_COUNT + subBucket) << (exponent - SUB_BUCKET_BITS);
+    }
+
+    /**
+     * @brief Largest value recorded in the bucket
+     */
+    static uint64_t upperBound(uint32_t bucket) {
+        if (bucket + 1u >= BUCKET_COUNT) {
+            return std::numeric_limits<uint64_t>::max();
+        }
+        return lowerBound(bucket + 1u) - 1u;
+    }
+};
+
+class LatencyDistribution;
+
+/**
+ * @brief Histogram recording latencies in nanoseconds
+ *
+ * The histogram is designed for a single writer: Recording only uses relaxed loads and stores, other threads can read
+ * the histogram concurrently while it is being updated.
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram() {
+        for (auto& bucket : mBuckets) {
+            bucket.store(0u, std::memory_order_relaxed);
+        }
+    }
+
+    void record(uint64_t value) {
+        auto& bucket = mBuckets[LatencyBuckets::bucketOf(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Adds the current content of the histogram to the distribution
+     */
+    void collect(LatencyDistribution& distribution) const;
+
+private:
+    std::array<std::atomic<uint64_t>, LatencyBuckets::BUCKET_COUNT> mBuckets;
+};
+
+/**
+ * @brief Mergeable snapshot of the content of one or more latency histograms
+ *
+ * The serialized format only contains the non-empty buckets:
+ * - 4 bytes: Number of non-empty buckets
+ * - 4 bytes: Padding
+ * - For every non-empty bucket:
+ *   - 8 bytes: Index of the bucket
+ *   - 8 bytes: Number of values in the bucket
+ */
+class LatencyDistribution {
+public:
+    static LatencyDistribution deserialize(crossbow::buffer_reader& reader);
+
+    LatencyDistribution()
+            : mBuckets(LatencyBuckets::BUCKET_COUNT, 0u),
+              mCount(0u) {
+    }
+
+    void add(uint32_t bucket, uint64_t count) {
+        mBuckets.at(bucket) += count;
+        mCount += count;
+    }
+
+    void merge(const LatencyDistribution& other);
+
+    /**
+     * @brief Number of recorded values
+     */
+    uint64_t count() const {
+        return mCount;
+    }
+
+    /**
+     * @brief Upper bound of the value below which the given fraction (between 0 and 1) of values fall
+     */
+    uint64_t percentile(double fraction) const;
+
+    /**
+     * @brief Approximate mean of all values (based on the center of the buckets)
+     */
+    double mean() const;
+
+    size_t serializedLength() const;
+
+    void serialize(crossbow::buffer_writer& writer) const;
+
+private:
+    std::vector<uint64_t> mBuckets;
+    uint64_t mCount;
+};
+
+/**
+ * @brief Category of a latency histogram collected by the server
+ */
+enum class StatisticsKind : uint32_t {
+    /// Processing time of requests by RequestType
+    REQUEST = 0x1u,
+
+    /// Processing time of requests (get, modifications and scan) on a table by table ID
+    TABLE,
+
+    /// Duration of the phases of a scan by ScanPhase
+    SCAN_PHASE,
+};
+
+/**
+ * @brief Phases of a scan on the server
+ */
+enum class ScanPhase : uint32_t {
+    /// From the scan request until the scan threads start processing the query
+    QUEUED = 0x1u,
+
+    /// From the start of processing until all scan threads finished the query
+    EXECUTION,
+
+    /// From the end of processing until the client received all data
+    DRAIN,
+};
+
+/**
+ * @brief Work on the server the hardware performance counters are attributed to
+ */
+enum class PerfCounterSource : uint32_t {
+    /// Invocations of a scan processor (includes the scan based garbage collection of the log-structured store)
+    SCAN = 0x1u,
+
+    /// Garbage collection runs of the delta-main stores on a single table
+    GC,
+};
+
+/**
+ * @brief Hardware performance counters summed up over a number of measured units of work
+ */
+struct PerfCounterSample {
+    /// Number of measured units of work
+    uint64_t runs = 0u;
+
+    uint64_t cycles = 0u;
+
+    uint64_t instructions = 0u;
+
+    /// Last level cache read misses
+    uint64_t llcMisses = 0u;
+
+    /// Data TLB read misses
+    uint64_t dtlbMisses = 0u;
+
+    /// Number of tuples processed by the measured work
+    uint64_t tuples = 0u;
+
+    /// Number of pages processed by the measured work
+    uint64_t pages = 0u;
+
+    PerfCounterSample& operator+=(const PerfCounterSample& other);
+
+    PerfCounterSample& operator-=(const PerfCounterSample& other);
+
+    /**
+     * @brief The counter value normalized by the number of processed tuples (0 if no tuple was processed)
+     */
+    double perTuple(uint64_t value) const {
+        return (tuples == 0u ? 0.0 : static_cast<double>(value) / static_cast<double>(tuples));
+    }
+
+    /**
+     * @brief The counter value normalized by the number of processed pages (0 if no page was processed)
+     */
+    double perPage(uint64_t value) const {
+        return (pages == 0u ? 0.0 : static_cast<double>(value) / static_cast<double>(pages));
+    }
+};
+
+/**
+ * @brief Merged latency distributions and hardware performance counters of a server
+ *
+ * The serialized format has the following layout:
+ * - 4 bytes: Number of distributions
+ * - 4 bytes: Padding
+ * - For every distribution:
+ *   - 4 bytes: The kind of the distribution
+ *   - 4 bytes: Padding
+ *   - 8 bytes: The ID of the distribution (request type, table ID or scan phase)
+ *   - x bytes: The distribution
+ * - 4 bytes: Number of performance counter samples
+ * - 4 bytes: Padding
+ * - For every sample:
+ *   - 4 bytes: The source of the sample
+ *   - 4 bytes: Padding
+ *   - 56 bytes: Runs, cycles, instructions, LLC misses, dTLB misses, tuples and pages
+ */
+class ServerStatistics {
+public:
+    using Key = std::pair<StatisticsKind, uint64_t>;
+
+    static ServerStatistics deserialize(crossbow::buffer_reader& reader);
+
+    const std::map<Key, LatencyDistribution>& distributions() const {
+        return mDistributions;
+    }
+
+    /**
+     * @brief The distribution with the given kind and ID (created if it does not exist)
+     */
+    LatencyDistribution& distribution(StatisticsKind kind, uint64_t id) {
+        return mDistributions[std::make_pair(kind, id)];
+    }
+
+    const std::map<PerfCounterSource, PerfCounterSample>& perfCounters() const {
+        return mPerfCounters;
+    }
+
+    /**
+     * @brief The performance counters of the given source (created if it does not exist)
+     */
+    PerfCounterSample& perfCounter(PerfCounterSource source) {
+        return mPerfCounters[source];
+    }
+
+    void merge(const ServerStatistics& other);
+
+    /**
+     * @brief Drops the table distributions with the fewest recorded requests until the serialized length does not
+     *        exceed the limit
+     *
+     * @return Number of dropped table distributions
+     */
+    size_t truncateTables(size_t maxLength);
+
+    size_t serializedLength() const;
+
+    void serialize(crossbow::buffer_writer& writer) const;
+
+private:
+    std::map<Key, LatencyDistribution> mDistributions;
+
+    std::map<PerfCounterSource, PerfCounterSample> mPerfCounters;
+};
+
+/**
+ * @brief Memory in use by owner (table ID, 0 for memory not owned by a table) and category
+ *
+ * The serialized format has the following layout:
+ * - 4 bytes: Number of entries
+ * - 4 bytes: Padding
+ * - For every entry:
+ *   - 8 bytes: The table ID
+ *   - 1 byte:  The memory category
+ *   - 7 bytes: Padding
+ *   - 8 bytes: Number of bytes
+ */
+class MemoryUsage {
+public:
+    using Key = std::pair<uint64_t, MemoryCategory>;
+
+    static MemoryUsage deserialize(crossbow::buffer_reader& reader);
+
+    const std::map<Key, uint64_t>& entries() const {
+        return mEntries;
+    }
+
+    void add(uint64_t tableId, MemoryCategory category, uint64_t bytes) {
+        mEntries[std::make_pair(tableId, category)] += bytes;
+    }
+
+    /**
+     * @brief Number of bytes the table uses in the given category
+     */
+    uint64_t get(uint64_t tableId, MemoryCategory category) const {
+        auto i = mEntries.find(std::make_pair(tableId, category));
+        return (i == mEntries.end() ? 0u : i->second);
+    }
+
+    /**
+     * @brief Number of bytes the table uses in all categories
+     */
+    uint64_t table(uint64_t tableId) const;
+
+    /**
+     * @brief Number of bytes used by all tables in the given category
+     */
+    uint64_t category(MemoryCategory category) const;
+
+    void merge(const MemoryUsage& other);
+
+    size_t serializedLength() const {
+        return 2 * sizeof(uint32_t) + mEntries.size() * 3 * sizeof(uint64_t);
+    }
+
+    void serialize(crossbow::buffer_writer& writer) const;
+
+private:
+    std::map<Key, uint64_t> mEntries;
+};
+
+} // namespace store
+} // namespace tell
@@ -32,6 +32,27 @@ enum class TableType : uint8_t {
     NON_TRANSACTIONAL,
 };
 
+enum class PartitionType : uint8_t {
+    HASH = 0,
+    CONSISTENT_HASH,
+    RANGE,
+};
+
+/**
+ * @brief Kind of memory accounted by the storage
+ */
+enum class MemoryCategory : uint8_t {
+    FREE = 0,
+    UNTAGGED,
+    MAIN_PAGE,
+    INSERT_LOG,
+    UPDATE_LOG,
+    HASH_TABLE,
+    LOG,
+    SCAN_BUFFER,
+    INSERT_TABLE,
+};
+
 enum class FieldType
     : uint16_t {
     NOTYPE = 0,
@@ -23,12 +23,11 @@
 #pragma once
 
 #include <tellstore/Record.hpp>
+#include <tellstore/TupleBinding.hpp>
 
 #include <crossbow/non_copyable.hpp>
 #include <crossbow/string.hpp>
 
-#include <boost/any.hpp>
-
 #include <cstdint>
 #include <memory>
 #include <stdexcept>
@@ -85,17 +84,20 @@ private:
 class Table {
 public:
     Table()
-            : mTableId(0x0u) {
+            : mTableId(0x0u),
+              mSchemaVersion(0x0u) {
     }
 
     Table(uint64_t tableId, Schema schema)
             : mTableId(tableId),
+              mSchemaVersion(0x0u),
               mRecord(std::move(schema)) {
     }
 
-    Table(uint64_t tableId, crossbow::string tableName, Schema schema)
+    Table(uint64_t tableId, crossbow::string tableName, Schema schema, uint32_t schemaVersion = 0x0u)
             : mTableId(tableId),
               mTableName(std::move(tableName)),
+              mSchemaVersion(schemaVersion),
               mRecord(std::move(schema)) {
     }
 
@@ -103,6 +105,16 @@ public:
         return mTableId;
     }
 
+    /**
+     * @brief Version of the schema in the storage
+     *
+     * Tuples written through this table are tagged with the version so the storage converts them when the table was
+     * altered in the meantime.
+     */
+    uint32_t schemaVersion() const {
+        return mSchemaVersion;
+    }
+
     const crossbow::string& tableName() const {
         return mTableName;
     }
@@ -115,6 +127,16 @@ public:
         return mRecord.schema().type();
     }
 
+    /**
+     * @brief Resolves the typed binding of the given field
+     *
+     * The binding should be resolved once and then be reused to access the field in many tuples.
+     */
+    template <typename T>
+    TypedField<T> bind(const crossbow::string& name) const {
+        return TypedField<T>(mRecord, name);
+    }
+
     template <typename T>
     T field(const crossbow::string& name, const char* data) const;
 
@@ -123,60 +145,17 @@ public:
 private:
     uint64_t mTableId;
     crossbow::string mTableName;
+    uint32_t mSchemaVersion;
     Record mRecord;
 };
 
 template <typename T>
 T Table::field(const crossbow::string& name, const char* data) const {
-    Record::id_t id;
-    if (!mRecord.idOf(name, id)) {
-        throw std::logic_error("Field not found");
-    }
-
-    bool isNull = false;
-    FieldType type;
-    auto field = mRecord.data(data, id, isNull, &type);
-    if (isNull) {
+    TypedField<T> field(mRecord, name);
+    if (field.isNull(data)) {
         throw std::logic_error("Field is null");
     }
-
-    boost::any value;
-    switch (type) {
-
-    case FieldType::SMALLINT: {
-        value = *reinterpret_cast<const int16_t*>(field);
-    } break;
-
-    case FieldType::INT: {
-        value = *reinterpret_cast<const int32_t*>(field);
-    } break;
-
-    case FieldType::BIGINT: {
-        value = *reinterpret_cast<const int64_t*>(field);
-    } break;
-
-    case FieldType::FLOAT: {
-        value = *reinterpret_cast<const float*>(field);
-    } break;
-
-    case FieldType::DOUBLE: {
-        value = *reinterpret_cast<const double*>(field);
-    } break;
-
-    case FieldType::TEXT:
-    case FieldType::BLOB: {
-        auto offsetData = reinterpret_cast<const uint32_t*>(field);
-        auto offset = offsetData[0];
-        auto length = offsetData[1] - offset;
-        value = crossbow::string(data + offset, length);
-    } break;
-
-    default: {
-        throw std::logic_error("Invalid field type");
-    } break;
-    }
-
-    return boost::any_cast<T>(value);
+    return field.get(data);
 }
 
 } // namespace store
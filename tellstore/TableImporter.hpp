@@ -0,0 +1,82 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <tellstore/ImportSource.hpp>
+
+#include <crossbow/non_copyable.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace tell {
+namespace store {
+
+class ClientHandle;
+class Table;
+
+/**
+ * @brief Loads the rows of an import file into a table with batched inserts
+ *
+ * The chunks of the source are independent from each other and can be imported by concurrent transactions (one chunk
+ * per transaction). The rows are already converted into the record format by the source and inserted through a
+ * ClientBatch without any further serialization.
+ */
+class TableImporter : crossbow::non_copyable, crossbow::non_movable {
+public:
+    /// Default size of the inserts sent in one batch (the batch has to fit into one message buffer per shard)
+    static constexpr size_t DEFAULT_BATCH_BYTES = 64 * 1024;
+
+    TableImporter(const ImportSource& source, const Table& table, size_t batchBytes = DEFAULT_BATCH_BYTES);
+
+    /**
+     * @brief Imports all rows of the chunk in a single transaction
+     *
+     * Throws std::invalid_argument if a row can not be converted and std::system_error if an insert failed, in both
+     * cases the rows inserted so far are reverted before the transaction is committed so the chunk can be imported
+     * again.
+     *
+     * @return Number of rows imported from the chunk
+     */
+    uint64_t importChunk(ClientHandle& handle, size_t idx);
+
+    /**
+     * @brief Number of rows imported by all chunks so far
+     */
+    uint64_t rowCount() const {
+        return mRowCount.load();
+    }
+
+private:
+    const ImportSource& mSource;
+
+    const Table& mTable;
+
+    size_t mBatchBytes;
+
+    std::atomic<uint64_t> mRowCount;
+};
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,281 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <tellstore/AbstractTuple.hpp>
+#include <tellstore/Record.hpp>
+#include <tellstore/StdTypes.hpp>
+
+#include <crossbow/string.hpp>
+
+#include <boost/utility/string_ref.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Maps a C++ type to the field types it can be bound to
+ *
+ * Fixed size types are read and written in place, variable size types are read through the offset table of the
+ * record. The string_ref binding returns a view into the record data, the crossbow::string binding a copy.
+ */
+template <typename T>
+struct FieldTypeTraits;
+
+template <typename T>
+struct FixedFieldTypeTraits {
+    static constexpr bool fixedSize = true;
+
+    static T read(const char* data, uint32_t offset) {
+        return *reinterpret_cast<const T*>(data + offset);
+    }
+
+    static void write(char* data, uint32_t offset, T value) {
+        *reinterpret_cast<T*>(data + offset) = value;
+    }
+};
+
+template <>
+struct FieldTypeTraits<int16_t> : FixedFieldTypeTraits<int16_t> {
+    static bool matches(FieldType type) {
+        return (type == FieldType::SMALLINT);
+    }
+};
+
+template <>
+struct FieldTypeTraits<int32_t> : FixedFieldTypeTraits<int32_t> {
+    static bool matches(FieldType type) {
+        return (type == FieldType::INT);
+    }
+};
+
+template <>
+struct FieldTypeTraits<int64_t> : FixedFieldTypeTraits<int64_t> {
+    static bool matches(FieldType type) {
+        return (type == FieldType::BIGINT);
+    }
+};
+
+template <>
+struct FieldTypeTraits<float> : FixedFieldTypeTraits<float> {
+    static bool matches(FieldType type) {
+        return (type == FieldType::FLOAT);
+    }
+};
+
+template <>
+struct FieldTypeTraits<double> : FixedFieldTypeTraits<double> {
+    static bool matches(FieldType type) {
+        return (type == FieldType::DOUBLE);
+    }
+};
+
+template <>
+struct FieldTypeTraits<boost::string_ref> {
+    static constexpr bool fixedSize = false;
+
+    static bool matches(FieldType type) {
+        return (type == FieldType::TEXT || type == FieldType::BLOB);
+    }
+
+    static boost::string_ref read(const char* data, uint32_t offset) {
+        auto offsetData = reinterpret_cast<const uint32_t*>(data + offset);
+        return boost::string_ref(data + offsetData[0], offsetData[1] - offsetData[0]);
+    }
+};
+
+template <>
+struct FieldTypeTraits<crossbow::string> {
+    static constexpr bool fixedSize = false;
+
+    static bool matches(FieldType type) {
+        return FieldTypeTraits<boost::string_ref>::matches(type);
+    }
+
+    static crossbow::string read(const char* data, uint32_t offset) {
+        auto value = FieldTypeTraits<boost::string_ref>::read(data, offset);
+        return crossbow::string(value.data(), value.size());
+    }
+};
+
+/**
+ * @brief Position of a single field inside the records of a table
+ *
+ * Resolving the binding requires a name lookup in the record, afterwards all accesses only use the precomputed
+ * offsets.
+ */
+class FieldBinding {
+public:
+    FieldBinding()
+            : mId(0u),
+              mType(FieldType::NOTYPE),
+              mOffset(0u),
+              mNullIdx(0u),
+              mNullable(false) {
+    }
+
+    FieldBinding(const Record& record, Record::id_t id);
+
+    Record::id_t id() const {
+        return mId;
+    }
+
+    FieldType type() const {
+        return mType;
+    }
+
+    uint32_t offset() const {
+        return mOffset;
+    }
+
+    bool isNullable() const {
+        return mNullable;
+    }
+
+    uint16_t nullIdx() const {
+        return mNullIdx;
+    }
+
+    bool isNull(const char* data) const {
+        return (mNullable && data[mNullIdx] != 0);
+    }
+
+protected:
+    static Record::id_t resolve(const Record& record, const crossbow::string& name);
+
+    Record::id_t mId;
+    FieldType mType;
+    uint32_t mOffset;
+    uint16_t mNullIdx;
+    bool mNullable;
+};
+
+/**
+ * @brief Field binding checked against the C++ type used to access the field
+ *
+ * Throws std::logic_error if the field does not exist or the type does not match the schema.
+ */
+template <typename T>
+class TypedField : public FieldBinding {
+public:
+    using value_type = T;
+    using Traits = FieldTypeTraits<T>;
+
+    TypedField() = default;
+
+    TypedField(const Record& record, const crossbow::string& name)
+            : TypedField(record, resolve(record, name)) {
+    }
+
+    TypedField(const Record& record, Record::id_t id)
+            : FieldBinding(record, id) {
+        if (!Traits::matches(mType)) {
+            throw std::logic_error("Invalid field type");
+        }
+    }
+
+    /**
+     * @brief Reads the value of the field from the record
+     *
+     * The data pointer can either point to the data of a Tuple or to a tuple in a scan chunk.
+     */
+    T get(const char* data) const {
+        return Traits::read(data, mOffset);
+    }
+};
+
+/**
+ * @brief Typed tuple serializing directly into the destination buffer
+ *
+ * The writer keeps a preinitialized copy of the fixed size part of the record and references to the variable sized
+ * values, this allows the writer to be reused for many tuples without any allocations. The referenced variable sized
+ * data must stay valid until the tuple was serialized.
+ *
+ * All NOT NULL fields have to be set before the tuple is serialized, fields not set are NULL.
+ */
+class TupleWriter : public AbstractTuple {
+public:
+    TupleWriter(const Record& record);
+
+    virtual ~TupleWriter();
+
+    template <typename T>
+    void set(const TypedField<T>& field, const T& value) {
+        setValue(field, value, std::integral_constant<bool, TypedField<T>::Traits::fixedSize>());
+    }
+
+    void setNull(const FieldBinding& field);
+
+    /**
+     * @brief Resets all fields to NULL
+     */
+    void clear();
+
+    virtual size_t size() const override;
+
+    virtual void serialize(char* dest) const override;
+
+private:
+    template <typename T>
+    void setValue(const TypedField<T>& field, T value, std::true_type /* fixedSize */) {
+        TypedField<T>::Traits::write(mStatic.data(), field.offset(), value);
+        markSet(field);
+    }
+
+    template <typename T>
+    void setValue(const TypedField<T>& field, const T& value, std::false_type /* fixedSize */) {
+        auto& entry = mVariable[field.id() - mRecord.fixedSizeFieldCount()];
+        mHeapSize = mHeapSize - entry.size() + value.size();
+        entry = boost::string_ref(value.data(), value.size());
+        markSet(field);
+    }
+
+    void markSet(const FieldBinding& field) {
+        if (field.isNullable()) {
+            mStatic[field.nullIdx()] = 0;
+        }
+        mSet[field.id()] = 1;
+    }
+
+    const Record& mRecord;
+
+    /// Header and fixed size fields of the record
+    std::vector<char> mStatic;
+
+    /// Values of the variable sized fields
+    std::vector<boost::string_ref> mVariable;
+
+    /// Marker for every field if it was set
+    std::vector<char> mSet;
+
+    /// Combined size of all variable sized values
+    size_t mHeapSize;
+};
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,49 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include "BenchmarkRunner.hpp"
+
+namespace tell {
+namespace store {
+
+void BenchmarkResult::print(std::ostream& out) const {
+    auto seconds = static_cast<double>(duration.count()) / 1e9;
+    auto throughput = (seconds > 0.0 ? static_cast<double>(numOperations) / seconds : 0.0);
+
+    out << "{\"benchmark\":\"" << name << "\""
+        << ",\"threads\":" << numThreads
+        << ",\"operations\":" << numOperations
+        << ",\"seconds\":" << seconds
+        << ",\"ops_per_sec\":" << static_cast<uint64_t>(throughput)
+        << ",\"ns_per_op\":{"
+        << "\"mean\":" << latency.mean()
+        << ",\"p50\":" << latency.percentile(0.5)
+        << ",\"p90\":" << latency.percentile(0.9)
+        << ",\"p99\":" << latency.percentile(0.99)
+        << ",\"p999\":" << latency.percentile(0.999)
+        << ",\"max\":" << latency.percentile(1.0)
+        << "}}" << std::endl;
+}
+
+} // namespace store
+} // namespace tell
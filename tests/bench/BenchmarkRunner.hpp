@@ -0,0 +1,187 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <tellstore/Statistics.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Outcome of a single benchmark run
+ */
+struct BenchmarkResult {
+    std::string name;
+
+    size_t numThreads;
+
+    /// Number of operations executed by all threads
+    uint64_t numOperations;
+
+    /// Wall clock time from the start of the first until the end of the last thread
+    std::chrono::nanoseconds duration;
+
+    /// Distribution of the average latency of an operation in every sample (in ns)
+    LatencyDistribution latency;
+
+    /**
+     * @brief Writes the result as a single line JSON object
+     */
+    void print(std::ostream& out) const;
+};
+
+/**
+ * @brief Per-thread accumulators the benchmarks write their results into so the compiler can not drop the operations
+ *
+ * Every accumulator is padded to its own cache line to prevent the threads from contending on the writes.
+ */
+class ThreadChecksums {
+public:
+    ThreadChecksums(size_t numThreads)
+            : mChecksums(new Checksum[numThreads]) {
+    }
+
+    uint64_t& operator[](size_t thread) {
+        return mChecksums[thread].value;
+    }
+
+private:
+    struct alignas(64) Checksum {
+        uint64_t value = 0u;
+    };
+
+    std::unique_ptr<Checksum[]> mChecksums;
+};
+
+/**
+ * @brief Executes multi-threaded microbenchmarks and reports their throughput and latency
+ *
+ * All threads are started before the clock starts and wait on a common start signal. Every thread executes the
+ * operations in samples of a fixed number of operations, the average latency of an operation in a sample is recorded in
+ * a latency histogram so that the clock is not read for every single operation.
+ */
+class BenchmarkRunner {
+public:
+    BenchmarkRunner(std::ostream& out, std::string filter, uint32_t sampleSize)
+            : mOut(out),
+              mFilter(std::move(filter)),
+              mSampleSize(sampleSize) {
+    }
+
+    /**
+     * @brief Whether the benchmark (or group of benchmarks) with the given name was selected to run
+     *
+     * A benchmark is selected if the filter is a prefix of its name or its name is a prefix of the filter.
+     */
+    bool enabled(const std::string& name) const {
+        auto length = std::min(name.size(), mFilter.size());
+        return (name.compare(0, length, mFilter, 0, length) == 0);
+    }
+
+    /**
+     * @brief Executes the function numOperations times on every thread and reports the result
+     *
+     * Does nothing if the benchmark was not selected by the filter.
+     *
+     * @param name Name of the benchmark
+     * @param numThreads Number of threads executing the operations concurrently
+     * @param numOperations Number of operations every thread executes
+     * @param fun Function with the signature (size_t thread, uint64_t operation)
+     */
+    template <typename Fun>
+    void run(const std::string& name, size_t numThreads, uint64_t numOperations, Fun fun);
+
+private:
+    std::ostream& mOut;
+
+    std::string mFilter;
+
+    uint32_t mSampleSize;
+};
+
+template <typename Fun>
+void BenchmarkRunner::run(const std::string& name, size_t numThreads, uint64_t numOperations, Fun fun) {
+    if (!enabled(name)) {
+        return;
+    }
+
+    std::unique_ptr<LatencyHistogram[]> histograms(new LatencyHistogram[numThreads]);
+    std::atomic<size_t> ready(0u);
+    std::atomic<bool> start(false);
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+    for (size_t thread = 0; thread < numThreads; ++thread) {
+        threads.emplace_back([this, thread, numOperations, &fun, &histograms, &ready, &start] () {
+            auto& histogram = histograms[thread];
+
+            ++ready;
+            while (!start.load()) {
+            }
+
+            for (uint64_t i = 0; i < numOperations; i += mSampleSize) {
+                auto end = std::min(i + mSampleSize, numOperations);
+                auto sampleStart = std::chrono::steady_clock::now();
+                for (auto j = i; j < end; ++j) {
+                    fun(thread, j);
+                }
+                auto sampleEnd = std::chrono::steady_clock::now();
+                auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(sampleEnd - sampleStart);
+                histogram.record(static_cast<uint64_t>(duration.count()) / (end - i));
+            }
+        });
+    }
+
+    while (ready.load() != numThreads) {
+    }
+    auto startTime = std::chrono::steady_clock::now();
+    start.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto endTime = std::chrono::steady_clock::now();
+
+    BenchmarkResult result;
+    result.name = name;
+    result.numThreads = numThreads;
+    result.numOperations = numThreads * numOperations;
+    result.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime);
+    for (size_t thread = 0; thread < numThreads; ++thread) {
+        histograms[thread].collect(result.latency);
+    }
+
+    result.print(mOut);
+}
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,358 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include "BenchmarkRunner.hpp"
+
+#include <deltamain/InsertHash.hpp>
+#include <util/CuckooHash.hpp>
+#include <util/Log.hpp>
+#include <util/OpenAddressingHash.hpp>
+#include <util/PageManager.hpp>
+
+#include <tellstore/GenericTuple.hpp>
+#include <tellstore/Record.hpp>
+#include <tellstore/TupleBinding.hpp>
+
+#include <crossbow/allocator.hpp>
+#include <crossbow/logger.hpp>
+#include <crossbow/program_options.hpp>
+#include <crossbow/string.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <vector>
+
+using namespace tell::store;
+
+namespace {
+
+struct BenchmarkConfig {
+    /// Number of threads executing the benchmark
+    size_t numThreads = 4u;
+
+    /// Number of operations executed by every thread
+    uint64_t numOperations = 1000000u;
+
+    /// Size of the page manager backing every benchmark
+    size_t memory = 0x80000000ull;
+};
+
+/**
+ * @brief Number of keys modified in one Cuckoo table rebuild
+ */
+constexpr uint64_t gCuckooRebuildSize = 1024u;
+
+/**
+ * @brief Size of the payload of every entry appended to the log
+ */
+constexpr uint32_t gLogEntrySize = 32u;
+
+/**
+ * @brief Unique non-zero key of an operation executed by a thread
+ */
+uint64_t uniqueKey(size_t thread, uint64_t operation) {
+    return (static_cast<uint64_t>(thread) << 40) | (operation + 1);
+}
+
+/**
+ * @brief Scrambles the operation number into a key in the range [1, numKeys]
+ */
+uint64_t scrambledKey(uint64_t operation, uint64_t numKeys) {
+    return ((operation * 0x9E3779B97F4A7C15ull) % numKeys) + 1;
+}
+
+void benchmarkPageManager(BenchmarkRunner& runner, const BenchmarkConfig& config) {
+    if (!runner.enabled("pagemanager.")) {
+        return;
+    }
+
+    auto pageManager = PageManager::construct(config.memory);
+
+    // Allocating a page clears the complete page, execute less operations
+    auto numOperations = std::max(config.numOperations / 1024u, uint64_t(1u));
+    runner.run("pagemanager.alloc_free", config.numThreads, numOperations,
+            [&pageManager] (size_t /* thread */, uint64_t /* operation */) {
+        auto page = pageManager->alloc();
+        if (!page) {
+            throw std::bad_alloc();
+        }
+        pageManager->free(page);
+    });
+}
+
+void benchmarkLog(BenchmarkRunner& runner, const BenchmarkConfig& config) {
+    if (!runner.enabled("log.")) {
+        return;
+    }
+
+    auto pageManager = PageManager::construct(config.memory);
+    Log<OrderedLogImpl> log(*pageManager);
+
+    runner.run("log.append_seal", config.numThreads, config.numOperations,
+            [&log] (size_t thread, uint64_t operation) {
+        auto entry = log.append(gLogEntrySize);
+        if (!entry) {
+            throw std::bad_alloc();
+        }
+        auto key = uniqueKey(thread, operation);
+        memcpy(entry->data(), &key, sizeof(key));
+        log.seal(entry);
+    });
+
+    using Iterator = decltype(log.begin());
+    std::vector<Iterator> iterators(config.numThreads, log.begin());
+    ThreadChecksums checksums(config.numThreads);
+    runner.run("log.iterate", config.numThreads, config.numOperations,
+            [&log, &iterators, &checksums] (size_t thread, uint64_t /* operation */) {
+        auto& i = iterators[thread];
+        if (i == log.end()) {
+            i = log.begin();
+        }
+        checksums[thread] += i->size();
+        ++i;
+    });
+}
+
+void benchmarkCuckooTable(BenchmarkRunner& runner, const BenchmarkConfig& config) {
+    if (!runner.enabled("cuckoo.")) {
+        return;
+    }
+
+    auto pageManager = PageManager::construct(config.memory);
+
+    auto numKeys = config.numOperations;
+    auto table = crossbow::allocator::construct<CuckooTable>(*pageManager);
+    {
+        auto modifier = table->modifier();
+        for (uint64_t key = 1; key <= numKeys; ++key) {
+            modifier.insert(key, reinterpret_cast<void*>(key), false);
+        }
+        auto oldTable = table;
+        table = modifier.done();
+        crossbow::allocator::destroy_now(oldTable);
+    }
+
+    ThreadChecksums checksums(config.numThreads);
+    runner.run("cuckoo.get", config.numThreads, config.numOperations,
+            [table, numKeys, &checksums] (size_t thread, uint64_t operation) {
+        checksums[thread] += reinterpret_cast<uint64_t>(table->get(scrambledKey(operation, numKeys)));
+    });
+    table->destroy();
+    crossbow::allocator::destroy_now(table);
+
+    // Every thread rebuilds its own table by replacing a batch of keys through a modifier
+    std::vector<CuckooTable*> tables(config.numThreads, nullptr);
+    for (auto& t : tables) {
+        t = crossbow::allocator::construct<CuckooTable>(*pageManager);
+    }
+    auto numRebuilds = std::max(config.numOperations / gCuckooRebuildSize, uint64_t(1u));
+    runner.run("cuckoo.rebuild", config.numThreads, numRebuilds,
+            [&tables, &pageManager] (size_t thread, uint64_t operation) {
+        ReclamationGuard _;
+        auto& t = tables[thread];
+        auto modifier = t->modifier();
+        for (uint64_t i = 0; i < gCuckooRebuildSize; ++i) {
+            auto key = (((operation * gCuckooRebuildSize) + i) % (16 * gCuckooRebuildSize)) + 1;
+            modifier.insert(key, reinterpret_cast<void*>(key), true);
+        }
+        auto oldTable = t;
+        t = modifier.done();
+        pageManager->retire([oldTable] () {
+            crossbow::allocator::destroy_now(oldTable);
+        });
+    });
+    pageManager->reclaim();
+    for (auto t : tables) {
+        t->destroy();
+        crossbow::allocator::destroy_now(t);
+    }
+}
+
+void benchmarkOpenAddressingTable(BenchmarkRunner& runner, const BenchmarkConfig& config) {
+    if (!runner.enabled("openaddressing.")) {
+        return;
+    }
+
+    constexpr uint64_t tableId = 1u;
+    OpenAddressingTable table(2 * config.numThreads * config.numOperations);
+
+    runner.run("openaddressing.insert", config.numThreads, config.numOperations,
+            [&table] (size_t thread, uint64_t operation) {
+        auto key = uniqueKey(thread, operation);
+        table.insert(tableId, key, reinterpret_cast<void*>(key));
+    });
+
+    ThreadChecksums checksums(config.numThreads);
+    runner.run("openaddressing.get", config.numThreads, config.numOperations,
+            [&table, &checksums] (size_t thread, uint64_t operation) {
+        auto key = uniqueKey(thread, operation);
+        checksums[thread] += reinterpret_cast<uint64_t>(table.get(tableId, key));
+    });
+
+    runner.run("openaddressing.erase", config.numThreads, config.numOperations,
+            [&table] (size_t thread, uint64_t operation) {
+        auto key = uniqueKey(thread, operation);
+        table.erase(tableId, key, reinterpret_cast<void*>(key));
+    });
+}
+
+void benchmarkDynamicInsertTable(BenchmarkRunner& runner, const BenchmarkConfig& config) {
+    if (!runner.enabled("insertable.")) {
+        return;
+    }
+
+    // The page manager only serves as reclaimer for the replaced tables
+    auto pageManager = PageManager::construct(TELL_PAGE_SIZE);
+    deltamain::DynamicInsertTable table(*pageManager, MemoryTag(), 1024u);
+
+    runner.run("insertable.insert", config.numThreads, config.numOperations,
+            [&table] (size_t thread, uint64_t operation) {
+        ReclamationGuard _;
+        auto key = uniqueKey(thread, operation);
+        table.insert(key, reinterpret_cast<void*>(key << 3));
+    });
+
+    ThreadChecksums checksums(config.numThreads);
+    runner.run("insertable.get", config.numThreads, config.numOperations,
+            [&table, &checksums] (size_t thread, uint64_t operation) {
+        ReclamationGuard _;
+        auto key = uniqueKey(thread, operation);
+        checksums[thread] += reinterpret_cast<uint64_t>(table.get(key));
+    });
+
+    runner.run("insertable.erase", config.numThreads, config.numOperations,
+            [&table] (size_t thread, uint64_t operation) {
+        ReclamationGuard _;
+        auto key = uniqueKey(thread, operation);
+        auto data = table.get(key);
+        table.remove(key, data);
+    });
+}
+
+void benchmarkRecord(BenchmarkRunner& runner, const BenchmarkConfig& config) {
+    if (!runner.enabled("record.")) {
+        return;
+    }
+
+    Schema schema(TableType::TRANSACTIONAL);
+    schema.addField(FieldType::INT, "number", true);
+    schema.addField(FieldType::BIGINT, "largenumber", true);
+    schema.addField(FieldType::DOUBLE, "real", true);
+    schema.addField(FieldType::TEXT, "text1", true);
+    schema.addField(FieldType::TEXT, "text2", false);
+    Record record(schema);
+
+    TypedField<int32_t> number(record, "number");
+    TypedField<int64_t> largenumber(record, "largenumber");
+    TypedField<double> real(record, "real");
+    TypedField<crossbow::string> text1(record, "text1");
+    TypedField<crossbow::string> text2(record, "text2");
+
+    crossbow::string text1Value("Bacon ipsum dolor amet");
+    crossbow::string text2Value("Chuck pork loin ham hock");
+
+    // Every thread reuses its writer as all fields are overwritten by every operation
+    std::vector<std::unique_ptr<TupleWriter>> writers;
+    std::vector<std::unique_ptr<char[]>> buffers;
+    for (size_t i = 0; i < config.numThreads; ++i) {
+        writers.emplace_back(new TupleWriter(record));
+        buffers.emplace_back(new char[1024]);
+    }
+
+    runner.run("record.tuple_writer", config.numThreads, config.numOperations,
+            [&] (size_t thread, uint64_t operation) {
+        auto& writer = *writers[thread];
+        writer.set(number, static_cast<int32_t>(operation));
+        writer.set(largenumber, static_cast<int64_t>(operation));
+        writer.set(real, static_cast<double>(operation));
+        writer.set(text1, text1Value);
+        writer.set(text2, text2Value);
+        writer.serialize(buffers[thread].get());
+    });
+
+    runner.run("record.generic_tuple", config.numThreads, config.numOperations,
+            [&] (size_t /* thread */, uint64_t operation) {
+        GenericTuple tuple({
+            std::make_pair(crossbow::string("number"), boost::any(static_cast<int32_t>(operation))),
+            std::make_pair(crossbow::string("largenumber"), boost::any(static_cast<int64_t>(operation))),
+            std::make_pair(crossbow::string("real"), boost::any(static_cast<double>(operation))),
+            std::make_pair(crossbow::string("text1"), boost::any(text1Value)),
+            std::make_pair(crossbow::string("text2"), boost::any(text2Value))
+        });
+        size_t size;
+        std::unique_ptr<char[]> data(record.create(tuple, size));
+    });
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    BenchmarkConfig config;
+    crossbow::string filter;
+    uint32_t sampleSize = 64u;
+    bool help = false;
+    crossbow::string logLevel("WARN");
+
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'l'>("log-level", &logLevel),
+            crossbow::program_options::value<'t'>("threads", &config.numThreads),
+            crossbow::program_options::value<'n'>("operations", &config.numOperations),
+            crossbow::program_options::value<'m'>("memory", &config.memory),
+            crossbow::program_options::value<'f'>("filter", &filter),
+            crossbow::program_options::value<'s'>("sample", &sampleSize));
+
+    try {
+        crossbow::program_options::parse(opts, argc, argv);
+    } catch (crossbow::program_options::argument_not_found e) {
+        std::cerr << e.what() << std::endl << std::endl;
+        crossbow::program_options::print_help(std::cout, opts);
+        return 1;
+    }
+
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    crossbow::allocator::init();
+
+    crossbow::logger::logger->config.level = crossbow::logger::logLevelFromString(logLevel);
+
+    if (config.numThreads == 0u || config.numOperations == 0u || sampleSize == 0u) {
+        std::cerr << "Threads, operations and sample size must be larger than zero" << std::endl;
+        return 1;
+    }
+
+    BenchmarkRunner runner(std::cout, std::string(filter.c_str(), filter.size()), sampleSize);
+    benchmarkPageManager(runner, config);
+    benchmarkLog(runner, config);
+    benchmarkCuckooTable(runner, config);
+    benchmarkOpenAddressingTable(runner, config);
+    benchmarkDynamicInsertTable(runner, config);
+    benchmarkRecord(runner, config);
+
+    return 0;
+}
@@ -23,8 +23,15 @@
 
 #include <deltamain/InsertHash.hpp>
 
+#include <util/PageManager.hpp>
+
+#include <tellstore/Statistics.hpp>
+
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <vector>
+
 using namespace tell::store;
 using namespace tell::store::deltamain;
 
@@ -140,7 +147,8 @@ TEST_F(InsertTableTest, updateChanged) {
  * @test Check if resizing works correctly
  */
 TEST(DynamicInsertTableTest, resize) {
-    DynamicInsertTable table(4u);
+    auto pageManager = PageManager::construct(TELL_PAGE_SIZE);
+    DynamicInsertTable table(*pageManager, MemoryTag(1u, MemoryCategory::INSERT_TABLE), 4u);
     uint64_t element1 = 0x1u;
     uint64_t element2 = 0x2u;
     uint64_t element3 = 0x3u;
@@ -163,4 +171,81 @@ TEST(DynamicInsertTableTest, resize) {
     EXPECT_EQ(&element5, table.get(140u));
 }
 
+
+/**
+ * @class DynamicInsertTable
+ * @test Check if elements stay reachable while the table grows through several migrations
+ */
+TEST(DynamicInsertTableTest, growWhileRemoving) {
+    auto pageManager = PageManager::construct(TELL_PAGE_SIZE);
+    DynamicInsertTable table(*pageManager, MemoryTag(1u, MemoryCategory::INSERT_TABLE), 4u);
+    std::vector<uint64_t> elements(1000u);
+
+    for (uint64_t i = 0; i < elements.size(); ++i) {
+        EXPECT_TRUE(table.insert(i + 1, &elements[i]));
+        if (i % 2 == 0) {
+            EXPECT_TRUE(table.remove(i + 1, &elements[i]));
+        }
+    }
+    EXPECT_EQ(500u, table.size());
+    EXPECT_LE(1024u, table.capacity());
+
+    for (uint64_t i = 0; i < elements.size(); ++i) {
+        EXPECT_EQ(i % 2 == 0 ? nullptr : &elements[i], table.get(i + 1));
+    }
+}
+
+/**
+ * @class DynamicInsertTable
+ * @test Check if resizing drops deleted elements and shrinks the table to the expected number of inserts
+ */
+TEST(DynamicInsertTableTest, resizeAfterGc) {
+    auto pageManager = PageManager::construct(TELL_PAGE_SIZE);
+    DynamicInsertTable table(*pageManager, MemoryTag(1u, MemoryCategory::INSERT_TABLE), 4u);
+    std::vector<uint64_t> elements(1000u);
+
+    for (uint64_t i = 0; i < elements.size(); ++i) {
+        EXPECT_TRUE(table.insert(i + 1, &elements[i]));
+    }
+    for (uint64_t i = 0; i < elements.size() - 10u; ++i) {
+        EXPECT_TRUE(table.remove(i + 1, &elements[i]));
+    }
+
+    table.resize(20u);
+    EXPECT_EQ(64u, table.capacity());
+    EXPECT_EQ(10u, table.size());
+    for (uint64_t i = 0; i < elements.size(); ++i) {
+        EXPECT_EQ(i < elements.size() - 10u ? nullptr : &elements[i], table.get(i + 1));
+    }
+
+    // A table large enough for the expected inserts is kept
+    table.resize(20u);
+    EXPECT_EQ(64u, table.capacity());
+}
+
+/**
+ * @class DynamicInsertTable
+ * @test Check if the memory of the table is accounted to the page manager
+ */
+TEST(DynamicInsertTableTest, memoryUsage) {
+    auto pageManager = PageManager::construct(TELL_PAGE_SIZE);
+    std::vector<uint64_t> elements(100u);
+    {
+        DynamicInsertTable table(*pageManager, MemoryTag(1u, MemoryCategory::INSERT_TABLE), 4u);
+
+        MemoryUsage usage;
+        pageManager->collectUsage(usage);
+        EXPECT_EQ(InsertTable::memoryUsage(4u), usage.get(1u, MemoryCategory::INSERT_TABLE));
+
+        for (uint64_t i = 0; i < elements.size(); ++i) {
+            EXPECT_TRUE(table.insert(i + 1, &elements[i]));
+        }
+
+        // Retired tables are accounted until they are reclaimed
+        MemoryUsage grownUsage;
+        pageManager->collectUsage(grownUsage);
+        EXPECT_LE(InsertTable::memoryUsage(table.capacity()), grownUsage.get(1u, MemoryCategory::INSERT_TABLE));
+    }
+}
+
 }
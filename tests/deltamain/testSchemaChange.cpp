@@ -0,0 +1,237 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <config.h>
+
+#include <deltamain/Table.hpp>
+
+#include "../DummyCommitManager.hpp"
+
+#include <util/PageManager.hpp>
+
+#include <tellstore/ErrorCode.hpp>
+#include <tellstore/GenericTuple.hpp>
+#include <tellstore/Record.hpp>
+
+#include <commitmanager/SnapshotDescriptor.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using namespace tell;
+using namespace tell::store;
+using namespace tell::store::deltamain;
+
+namespace {
+
+class SchemaChangeTest : public ::testing::Test {
+protected:
+    SchemaChangeTest()
+            : mPageManager(PageManager::construct(16 * TELL_PAGE_SIZE)),
+              mSchema(TableType::TRANSACTIONAL) {
+        mSchema.addField(FieldType::INT, "number", true);
+        mSchema.addField(FieldType::TEXT, "text", true);
+        mSchema.addField(FieldType::BIGINT, "largenumber", false);
+    }
+
+    std::vector<char> createTuple(const Record& record, const GenericTuple& tuple) {
+        auto size = record.sizeOfTuple(tuple);
+        std::vector<char> result(size, 0);
+        EXPECT_TRUE(record.create(result.data(), tuple, size));
+        return result;
+    }
+
+    template <typename Context>
+    void insert(Table<Context>& table, uint64_t key, const GenericTuple& tuple) {
+        auto tx = mCommitManager.startTx();
+        auto data = createTuple(table.record(), tuple);
+        EXPECT_EQ(0, table.insert(key, data.size(), data.data(), *tx, table.schemaVersion()));
+        tx.commit();
+    }
+
+    /**
+     * @brief Writes the tuple in the original schema regardless of the newest schema version of the table
+     */
+    int writeInitialVersion(Table<RowStoreContext>& table, uint64_t key, int32_t number, bool update) {
+        auto tx = mCommitManager.startTx();
+        auto data = createTuple(Record(mSchema), GenericTuple({
+                std::make_pair<crossbow::string, boost::any>("number", number),
+                std::make_pair<crossbow::string, boost::any>("text", crossbow::string("Pastrami"))
+        }));
+        auto ec = (update ? table.update(key, data.size(), data.data(), *tx, 0u)
+                          : table.insert(key, data.size(), data.data(), *tx, 0u));
+        tx.commit();
+        return ec;
+    }
+
+    /**
+     * @brief Assert that the element has the given number and the added field is NULL in the newest schema
+     */
+    void assertElement(Table<RowStoreContext>& table, uint64_t key, int32_t expectedNumber) {
+        auto tx = mCommitManager.startTx(true);
+        std::vector<char> dest;
+        EXPECT_EQ(0, table.get(key, *tx, [&dest] (size_t size, uint64_t /* version */, bool /* isNewest */) {
+            dest.resize(size);
+            return dest.data();
+        }));
+
+        auto& record = table.record();
+        ASSERT_EQ(record.sizeOfTuple(dest.data()), dest.size());
+
+        Record::id_t id;
+        bool isNull = false;
+        ASSERT_TRUE(record.idOf("number", id));
+        EXPECT_EQ(expectedNumber, *reinterpret_cast<const int32_t*>(record.data(dest.data(), id, isNull)));
+
+        ASSERT_TRUE(record.idOf("fraction", id));
+        record.data(dest.data(), id, isNull);
+        EXPECT_TRUE(isNull);
+    }
+
+    Schema alteredSchema() {
+        auto schema = mSchema;
+        EXPECT_TRUE(schema.removeField("text"));
+        EXPECT_TRUE(schema.addField(FieldType::DOUBLE, "fraction", false));
+        return schema;
+    }
+
+    PageManager::Ptr mPageManager;
+    Schema mSchema;
+
+    DummyCommitManager mCommitManager;
+};
+
+/**
+ * @class Table
+ * @test Check if tuples in the main, the insert log and the update log are read in the newest schema after a schema
+ *       change and are rewritten by the garbage collection
+ */
+TEST_F(SchemaChangeTest, rowStore) {
+    Table<RowStoreContext> table(*mPageManager, "testTable", mSchema, 1, 1024);
+
+    insert(table, 1u, GenericTuple({
+            std::make_pair<crossbow::string, boost::any>("number", int32_t(12)),
+            std::make_pair<crossbow::string, boost::any>("text", crossbow::string("Bacon ipsum"))
+    }));
+    insert(table, 2u, GenericTuple({
+            std::make_pair<crossbow::string, boost::any>("number", int32_t(13)),
+            std::make_pair<crossbow::string, boost::any>("text", crossbow::string("dolor amet"))
+    }));
+    table.runGC(0u);
+    insert(table, 3u, GenericTuple({
+            std::make_pair<crossbow::string, boost::any>("number", int32_t(14)),
+            std::make_pair<crossbow::string, boost::any>("text", crossbow::string("Short loin"))
+    }));
+    {
+        auto tx = mCommitManager.startTx();
+        auto data = createTuple(table.record(), GenericTuple({
+                std::make_pair<crossbow::string, boost::any>("number", int32_t(15)),
+                std::make_pair<crossbow::string, boost::any>("text", crossbow::string("pork belly"))
+        }));
+        EXPECT_EQ(0, table.update(2u, data.size(), data.data(), *tx, table.schemaVersion()));
+        tx.commit();
+    }
+
+    ASSERT_EQ(0, table.alterTable(0u, alteredSchema()));
+    EXPECT_EQ(1u, table.schemas().newestVersion());
+    EXPECT_EQ(3u, table.record().fieldCount());
+
+    assertElement(table, 1u, 12);
+    assertElement(table, 2u, 15);
+    assertElement(table, 3u, 14);
+
+    table.runGC(std::numeric_limits<uint64_t>::max() - 1);
+
+    assertElement(table, 1u, 12);
+    assertElement(table, 2u, 15);
+    assertElement(table, 3u, 14);
+}
+
+/**
+ * @class Table
+ * @test Check if the column map rejects schema changes
+ */
+TEST_F(SchemaChangeTest, columnMap) {
+    Table<ColumnMapContext> table(*mPageManager, "testTable", mSchema, 1, 1024);
+
+    EXPECT_EQ(error::invalid_schema_change, table.checkAlterTable(0u, alteredSchema()));
+    EXPECT_EQ(error::invalid_schema_change, table.alterTable(0u, alteredSchema()));
+    EXPECT_EQ(0u, table.schemas().newestVersion());
+}
+
+/**
+ * @class Table
+ * @test Check if tuples written in an older schema version after the schema change are converted when read and when
+ *       rewritten by the garbage collection
+ */
+TEST_F(SchemaChangeTest, writeOlderVersion) {
+    Table<RowStoreContext> table(*mPageManager, "testTable", mSchema, 1, 1024);
+
+    EXPECT_EQ(0, writeInitialVersion(table, 1u, 12, false));
+    table.runGC(0u);
+
+    ASSERT_EQ(0, table.alterTable(0u, alteredSchema()));
+
+    // Update the tuple in the main and insert a new one into the log with the original schema
+    EXPECT_EQ(0, writeInitialVersion(table, 1u, 13, true));
+    EXPECT_EQ(0, writeInitialVersion(table, 2u, 14, false));
+
+    assertElement(table, 1u, 13);
+    assertElement(table, 2u, 14);
+
+    table.runGC(std::numeric_limits<uint64_t>::max() - 1);
+
+    assertElement(table, 1u, 13);
+    assertElement(table, 2u, 14);
+}
+
+/**
+ * @class Table
+ * @test Check if writes in an unknown schema version and schema changes of an outdated schema version are rejected
+ */
+TEST_F(SchemaChangeTest, rejectUnknownVersion) {
+    Table<RowStoreContext> table(*mPageManager, "testTable", mSchema, 1, 1024);
+
+    {
+        auto tx = mCommitManager.startTx();
+        auto data = createTuple(Record(alteredSchema()), GenericTuple({
+                std::make_pair<crossbow::string, boost::any>("number", int32_t(12))
+        }));
+        EXPECT_EQ(error::invalid_schema_change, table.insert(1u, data.size(), data.data(), *tx, 1u));
+        tx.commit();
+    }
+
+    EXPECT_EQ(0, table.checkAlterTable(0u, alteredSchema()));
+    EXPECT_EQ(0u, table.schemaVersion());
+
+    ASSERT_EQ(0, table.alterTable(0u, alteredSchema()));
+    EXPECT_EQ(1u, table.schemaVersion());
+
+    EXPECT_EQ(error::invalid_schema_change, table.checkAlterTable(0u, mSchema));
+    EXPECT_EQ(error::invalid_schema_change, table.alterTable(0u, mSchema));
+    EXPECT_EQ(1u, table.schemaVersion());
+}
+
+} // anonymous namespace
@@ -0,0 +1,158 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <tellstore/ClientConfig.hpp>
+#include <tellstore/ClientManager.hpp>
+#include <tellstore/ImportSource.hpp>
+#include <tellstore/TableImporter.hpp>
+#include <tellstore/TransactionRunner.hpp>
+
+#include <crossbow/logger.hpp>
+#include <crossbow/program_options.hpp>
+#include <crossbow/string.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+
+using namespace tell;
+using namespace tell::store;
+
+int main(int argc, const char** argv) {
+    crossbow::string commitManagerHost;
+    crossbow::string tellStoreHost;
+    crossbow::string tableName;
+    crossbow::string inputPath;
+    crossbow::string format("csv");
+    crossbow::string delimiter(",");
+    crossbow::string keyColumn("key");
+    size_t batchBytes = TableImporter::DEFAULT_BATCH_BYTES;
+    size_t numChunks = 0u;
+    tell::store::ClientConfig clientConfig;
+    bool header = false;
+    bool help = false;
+    crossbow::string logLevel("INFO");
+
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'l'>("log-level", &logLevel),
+            crossbow::program_options::value<'c'>("commit-manager", &commitManagerHost),
+            crossbow::program_options::value<'s'>("server", &tellStoreHost),
+            crossbow::program_options::value<'t'>("table", &tableName),
+            crossbow::program_options::value<'i'>("input", &inputPath),
+            crossbow::program_options::value<'f'>("format", &format),
+            crossbow::program_options::value<'d'>("delimiter", &delimiter),
+            crossbow::program_options::value<'k'>("key-column", &keyColumn),
+            crossbow::program_options::value<'b'>("batch-size", &batchBytes),
+            crossbow::program_options::value<'n'>("chunks", &numChunks),
+            crossbow::program_options::value<-1>("network-threads", &clientConfig.numNetworkThreads,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-2>("header", &header,
+                    crossbow::program_options::tag::ignore_short<true>{}));
+
+    try {
+        crossbow::program_options::parse(opts, argc, argv);
+    } catch (crossbow::program_options::argument_not_found e) {
+        std::cerr << e.what() << std::endl << std::endl;
+        crossbow::program_options::print_help(std::cout, opts);
+        return 1;
+    }
+
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    ImportConfig importConfig;
+    if (format == "csv") {
+        importConfig.format = ImportFormat::CSV;
+    } else if (format == "binary") {
+        importConfig.format = ImportFormat::BINARY;
+    } else if (format == "columnar") {
+        importConfig.format = ImportFormat::COLUMNAR;
+    } else {
+        std::cerr << "Unknown format " << format << std::endl;
+        return 1;
+    }
+    if (delimiter.size() != 1u) {
+        std::cerr << "Delimiter must be a single character" << std::endl;
+        return 1;
+    }
+    importConfig.delimiter = delimiter[0];
+    importConfig.header = header;
+    importConfig.keyColumn = keyColumn;
+
+    if (numChunks == 0u) {
+        numChunks = 4u * clientConfig.numNetworkThreads;
+    }
+
+    clientConfig.commitManager = ClientConfig::parseCommitManager(commitManagerHost);
+    clientConfig.tellStore = ClientConfig::parseTellStore(tellStoreHost);
+
+    crossbow::logger::logger->config.level = crossbow::logger::logLevelFromString(logLevel);
+
+    LOG_INFO("Starting TellStore importer");
+    LOG_INFO("--- Commit Manager: %1%", clientConfig.commitManager);
+    for (auto& ep : clientConfig.tellStore) {
+        LOG_INFO("--- TellStore Shards: %1%", ep);
+    }
+    LOG_INFO("--- Network Threads: %1%", clientConfig.numNetworkThreads);
+    LOG_INFO("--- Table: %1%", tableName);
+    LOG_INFO("--- Input: %1% (%2%)", inputPath, format);
+    LOG_INFO("--- Batch Size: %1%B", batchBytes);
+
+    ClientManager<void> manager(clientConfig);
+
+    Table table;
+    TransactionRunner::executeBlocking(manager, [&tableName, &table] (ClientHandle& handle) {
+        table = handle.getTable(tableName)->get();
+    });
+
+    int result = 0;
+    try {
+        auto source = ImportSource::open(inputPath, table.record(), importConfig, numChunks);
+        TableImporter importer(*source, table, batchBytes);
+        LOG_INFO("Importing %1% chunk(s)", source->chunkCount());
+
+        auto startTime = std::chrono::steady_clock::now();
+        MultiTransactionRunner<void> runner(manager);
+        for (size_t i = 0u; i < source->chunkCount(); ++i) {
+            runner.execute(i % clientConfig.numNetworkThreads, [&importer, i] (ClientHandle& handle) {
+                importer.importChunk(handle, i);
+            });
+        }
+        runner.wait();
+        auto endTime = std::chrono::steady_clock::now();
+
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+        LOG_INFO("Imported %1% rows in %2%ms", importer.rowCount(), duration.count());
+    } catch (const std::exception& e) {
+        LOG_ERROR("Import failed [error = %1%]", e.what());
+        result = 1;
+    }
+
+    LOG_INFO("Shutting down the TellStore importer");
+    manager.shutdown();
+    return result;
+}
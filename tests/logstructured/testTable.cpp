@@ -105,7 +105,7 @@ protected:
  * @test Check if an insert followed by a get returns the inserted element
  */
 TEST_F(TableTest, insertGet) {
-    EXPECT_EQ(0, mTable.insert(1, mField.size(), mField.c_str(), *mTx));
+    EXPECT_EQ(0, mTable.insert(1, mField.size(), mField.c_str(), *mTx, 0u));
 
     assertElement(1, *mTx, mField, true);
     mTx.commit();
@@ -123,7 +123,7 @@ TEST_F(TableTest, insertGetMultiple) {
     };
 
     for (auto& e : elements) {
-        EXPECT_EQ(0, mTable.insert(e.first, e.second.size(), e.second.c_str(), *mTx));
+        EXPECT_EQ(0, mTable.insert(e.first, e.second.size(), e.second.c_str(), *mTx, 0u));
     }
 
     for (auto& e : elements) {
@@ -139,9 +139,9 @@ TEST_F(TableTest, insertGetMultiple) {
 TEST_F(TableTest, insertUpdateGet) {
     std::string fieldNew = "Test Field Update";
 
-    EXPECT_EQ(0, mTable.insert(1, mField.size(), mField.c_str(), *mTx));
+    EXPECT_EQ(0, mTable.insert(1, mField.size(), mField.c_str(), *mTx, 0u));
 
-    EXPECT_EQ(0, mTable.update(1, fieldNew.size(), fieldNew.c_str(), *mTx));
+    EXPECT_EQ(0, mTable.update(1, fieldNew.size(), fieldNew.c_str(), *mTx, 0u));
     assertElement(1, *mTx, fieldNew, true);
     mTx.commit();
 }
@@ -151,7 +151,7 @@ TEST_F(TableTest, insertUpdateGet) {
  * @test Check if an insert followed by a remove returns no element in the same transaction
  */
 TEST_F(TableTest, insertRemoveGetSameTransaction) {
-    EXPECT_EQ(0, mTable.insert(1, mField.size(), mField.c_str(), *mTx));
+    EXPECT_EQ(0, mTable.insert(1, mField.size(), mField.c_str(), *mTx, 0u));
 
     EXPECT_EQ(0, mTable.remove(1, *mTx));
 
@@ -169,7 +169,7 @@ TEST_F(TableTest, insertRemoveGetSameTransaction) {
  * @test Check if an insert followed by a remove returns no element
  */
 TEST_F(TableTest, insertRemoveGet) {
-    EXPECT_EQ(0, mTable.insert(1, mField.size(), mField.c_str(), *mTx));
+    EXPECT_EQ(0, mTable.insert(1, mField.size(), mField.c_str(), *mTx, 0u));
 
     // Commit insert transaction
     mTx.commit();
@@ -197,11 +197,11 @@ TEST_F(TableTest, insertRemoveGet) {
 TEST_F(TableTest, insertRemoveInsertGet) {
     std::string field2 = "Test Field 2";
 
-    EXPECT_EQ(0, mTable.insert(1, mField.size(), mField.c_str(), *mTx));
+    EXPECT_EQ(0, mTable.insert(1, mField.size(), mField.c_str(), *mTx, 0u));
 
     EXPECT_EQ(0, mTable.remove(1, *mTx));
 
-    EXPECT_EQ(0, mTable.insert(1, field2.size(), field2.c_str(), *mTx));
+    EXPECT_EQ(0, mTable.insert(1, field2.size(), field2.c_str(), *mTx, 0u));
 
     assertElement(1, *mTx, field2, true);
     mTx.commit();
@@ -215,7 +215,7 @@ TEST_F(TableTest, insertUpdateRevert) {
     std::string fieldNew = "Test Field Update";
 
     // Insert first element
-    EXPECT_EQ(0, mTable.insert(1, mField.size(), mField.c_str(), *mTx));
+    EXPECT_EQ(0, mTable.insert(1, mField.size(), mField.c_str(), *mTx, 0u));
 
     // Commit insert transaction
     mTx.commit();
@@ -224,7 +224,7 @@ TEST_F(TableTest, insertUpdateRevert) {
     auto tx2 = mCommitManager.startTx();
 
     // Update element
-    EXPECT_EQ(0, mTable.update(1, fieldNew.size(), fieldNew.c_str(), *tx2));
+    EXPECT_EQ(0, mTable.update(1, fieldNew.size(), fieldNew.c_str(), *tx2, 0u));
     assertElement(1, *tx2, fieldNew, true);
 
     // Revert element
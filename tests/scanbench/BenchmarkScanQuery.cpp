@@ -0,0 +1,120 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include "BenchmarkScanQuery.hpp"
+
+#include <crossbow/alignment.hpp>
+
+namespace tell {
+namespace store {
+
+void ScanLatch::countDown() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (--mCount == 0u) {
+        mCondition.notify_all();
+    }
+}
+
+void ScanLatch::wait() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait(lock, [this] () {
+        return mCount == 0u;
+    });
+}
+
+constexpr uint32_t BenchmarkScanQuery::BUFFER_LENGTH;
+
+BenchmarkScanQuery::BenchmarkScanQuery(ScanQueryType queryType, std::unique_ptr<char[]> selectionData,
+        size_t selectionLength, std::unique_ptr<char[]> queryData, size_t queryLength,
+        std::unique_ptr<commitmanager::SnapshotDescriptor> snapshot, const Record& record, ScanLatch& latch)
+        : ScanQuery(queryType, std::move(selectionData), selectionLength, std::move(queryData), queryLength,
+                std::move(snapshot), record),
+          mLatch(latch),
+          mSubmitTime(std::chrono::steady_clock::now()),
+          mExecutionStart(0),
+          mExecutionEnd(0),
+          mTupleCount(0u),
+          mByteCount(0u) {
+}
+
+std::tuple<char*, uint32_t> BenchmarkScanQuery::acquireBuffer() {
+    std::unique_lock<std::mutex> lock(mBufferMutex);
+    if (mFreeBuffers.empty()) {
+        mBuffers.emplace_back(new char[BUFFER_LENGTH]);
+        return std::make_tuple(mBuffers.back().get(), BUFFER_LENGTH);
+    }
+    auto buffer = mFreeBuffers.back();
+    mFreeBuffers.pop_back();
+    return std::make_tuple(buffer, BUFFER_LENGTH);
+}
+
+void BenchmarkScanQuery::writeOngoing(const char* start, const char* end, std::error_code& ec) {
+    ec = std::error_code();
+    consume(start, end);
+}
+
+void BenchmarkScanQuery::writeLast(const char* start, const char* end, std::error_code& ec) {
+    ec = std::error_code();
+    consume(start, end);
+    processorDone();
+}
+
+void BenchmarkScanQuery::writeLast(std::error_code& ec) {
+    ec = std::error_code();
+    processorDone();
+}
+
+ScanQueryProcessor BenchmarkScanQuery::createProcessor() {
+    processorStarted();
+
+    // Only the first processor marks the start of the execution
+    std::chrono::steady_clock::rep expected = 0;
+    mExecutionStart.compare_exchange_strong(expected, std::chrono::steady_clock::now().time_since_epoch().count());
+
+    ScanQueryProcessor processor(this);
+    if (queryType() == ScanQueryType::AGGREGATION) {
+        processor.initAggregationRecord();
+    }
+    return processor;
+}
+
+void BenchmarkScanQuery::consume(const char* start, const char* end) {
+    uint64_t tupleCount = 0u;
+    for (auto pos = start; pos < end; ++tupleCount) {
+        pos += ScanQueryProcessor::TUPLE_OVERHEAD;
+        pos += crossbow::align(record().sizeOfTuple(pos), 8u);
+    }
+    mTupleCount += tupleCount;
+    mByteCount += static_cast<uint64_t>(end - start);
+
+    std::unique_lock<std::mutex> lock(mBufferMutex);
+    mFreeBuffers.emplace_back(const_cast<char*>(start));
+}
+
+void BenchmarkScanQuery::queryDone() {
+    mExecutionEnd.store(std::chrono::steady_clock::now().time_since_epoch().count());
+    mLatch.countDown();
+}
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,142 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <util/ScanQuery.hpp>
+
+#include <crossbow/non_copyable.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Latch the benchmark waits on until all queries of a batch completed
+ */
+class ScanLatch : crossbow::non_copyable, crossbow::non_movable {
+public:
+    ScanLatch(size_t count)
+            : mCount(count) {
+    }
+
+    void countDown();
+
+    void wait();
+
+private:
+    size_t mCount;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+};
+
+/**
+ * @brief Scan query writing its results into in-memory buffers instead of a remote region
+ *
+ * The results are only counted and the buffers immediately reused. Records the time the query was submitted, the time
+ * the first processor started and the time the last processor finished.
+ */
+class BenchmarkScanQuery final : public ScanQuery {
+public:
+    static constexpr uint32_t BUFFER_LENGTH = 256u * 1024u;
+
+    BenchmarkScanQuery(ScanQueryType queryType, std::unique_ptr<char[]> selectionData, size_t selectionLength,
+            std::unique_ptr<char[]> queryData, size_t queryLength,
+            std::unique_ptr<commitmanager::SnapshotDescriptor> snapshot, const Record& record, ScanLatch& latch);
+
+    /**
+     * @brief Marks the time the query is submitted to the storage
+     */
+    void submit() {
+        mSubmitTime = std::chrono::steady_clock::now();
+    }
+
+    std::chrono::steady_clock::time_point submitTime() const {
+        return mSubmitTime;
+    }
+
+    std::chrono::steady_clock::time_point executionStartTime() const {
+        return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(mExecutionStart.load()));
+    }
+
+    std::chrono::steady_clock::time_point executionEndTime() const {
+        return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(mExecutionEnd.load()));
+    }
+
+    /**
+     * @brief Number of result tuples written by all processors
+     */
+    uint64_t tupleCount() const {
+        return mTupleCount.load();
+    }
+
+    /**
+     * @brief Number of result bytes written by all processors
+     */
+    uint64_t byteCount() const {
+        return mByteCount.load();
+    }
+
+    virtual std::tuple<char*, uint32_t> acquireBuffer() final override;
+
+    virtual void writeOngoing(const char* start, const char* end, std::error_code& ec) final override;
+
+    virtual void writeLast(const char* start, const char* end, std::error_code& ec) final override;
+
+    virtual void writeLast(std::error_code& ec) final override;
+
+    virtual ScanQueryProcessor createProcessor() final override;
+
+private:
+    /**
+     * @brief Counts the tuples in the buffer and returns the buffer to the pool
+     */
+    void consume(const char* start, const char* end);
+
+    virtual void queryDone() final override;
+
+    ScanLatch& mLatch;
+
+    std::chrono::steady_clock::time_point mSubmitTime;
+
+    std::atomic<std::chrono::steady_clock::rep> mExecutionStart;
+    std::atomic<std::chrono::steady_clock::rep> mExecutionEnd;
+
+    std::atomic<uint64_t> mTupleCount;
+    std::atomic<uint64_t> mByteCount;
+
+    std::mutex mBufferMutex;
+    std::vector<std::unique_ptr<char[]>> mBuffers;
+    std::vector<char*> mFreeBuffers;
+};
+
+} // namespace store
+} // namespace tell
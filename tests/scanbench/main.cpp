@@ -0,0 +1,568 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <config.h>
+
+#include "BenchmarkScanQuery.hpp"
+
+#include "../DummyCommitManager.hpp"
+
+#include <deltamain/DeltaMainRewriteStore.hpp>
+#include <logstructured/LogstructuredMemoryStore.hpp>
+#include <util/PerfCounters.hpp>
+#include <util/StorageConfig.hpp>
+
+#include <tellstore/Record.hpp>
+#include <tellstore/Statistics.hpp>
+#include <tellstore/TupleBinding.hpp>
+
+#include <crossbow/allocator.hpp>
+#include <crossbow/byte_buffer.hpp>
+#include <crossbow/enum_underlying.hpp>
+#include <crossbow/logger.hpp>
+#include <crossbow/program_options.hpp>
+#include <crossbow/string.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tell::store;
+
+namespace {
+
+struct ScanBenchmarkConfig {
+    /// Number of tuples in the fact table
+    uint64_t numTuples = 1000000u;
+
+    /// Number of INT columns in the fact table
+    uint32_t numIntColumns = 16u;
+
+    /// Number of DOUBLE columns in the fact table
+    uint32_t numDoubleColumns = 8u;
+
+    /// Length of the TEXT column in the fact table
+    uint32_t textLength = 32u;
+
+    /// Number of times every batch of concurrent queries is executed
+    uint32_t repetitions = 3u;
+
+    /// Number of threads loading the fact table
+    size_t numLoadThreads = 4u;
+
+    /// Whether to report the hardware performance counters of the scan threads
+    bool perfCounters = false;
+
+    /// Numbers of concurrent queries to sweep
+    std::vector<size_t> concurrency;
+
+    /// Numbers of scan threads to sweep
+    std::vector<size_t> scanThreads;
+
+    /// Selectivities of the queries
+    std::vector<double> selectivities;
+
+    /// Query types issued round-robin
+    std::vector<ScanQueryType> queryTypes;
+};
+
+const char* queryTypeName(ScanQueryType queryType) {
+    switch (queryType) {
+    case ScanQueryType::FULL:
+        return "full";
+    case ScanQueryType::PROJECTION:
+        return "projection";
+    case ScanQueryType::AGGREGATION:
+        return "aggregation";
+    }
+    return "unknown";
+}
+
+ScanQueryType queryTypeFromName(const std::string& name) {
+    if (name == "full") {
+        return ScanQueryType::FULL;
+    } else if (name == "projection") {
+        return ScanQueryType::PROJECTION;
+    } else if (name == "aggregation") {
+        return ScanQueryType::AGGREGATION;
+    }
+    throw std::invalid_argument("Unknown query type " + name);
+}
+
+/**
+ * @brief Splits a comma separated list into its elements
+ */
+template <typename T, typename Fun>
+std::vector<T> parseList(const crossbow::string& list, Fun fun) {
+    std::vector<T> result;
+    std::istringstream stream(std::string(list.c_str(), list.size()));
+    std::string element;
+    while (std::getline(stream, element, ',')) {
+        if (!element.empty()) {
+            result.emplace_back(fun(element));
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Scan benchmark against a wide synthetic fact table
+ *
+ * The fact table has the columns i0 to iN (INT), d0 to dM (DOUBLE) and text (TEXT). Column i0 contains the key of the
+ * tuple so a predicate on i0 selects an exact fraction of the table.
+ */
+template <typename Storage>
+class ScanBenchmark {
+public:
+    ScanBenchmark(const StorageConfig& storageConfig, const ScanBenchmarkConfig& config);
+
+    void load();
+
+    /**
+     * @brief Executes the given number of concurrent queries and reports the per-query and per-batch results
+     */
+    void runBatch(size_t numQueries, uint32_t repetition);
+
+private:
+    static Schema schema(const ScanBenchmarkConfig& config);
+
+    Record::id_t fieldId(const crossbow::string& name) const;
+
+    std::unique_ptr<BenchmarkScanQuery> createQuery(ScanQueryType queryType, double selectivity,
+            const tell::commitmanager::SnapshotDescriptor& snapshot, ScanLatch& latch) const;
+
+    const StorageConfig& mStorageConfig;
+    const ScanBenchmarkConfig& mConfig;
+    Storage mStorage;
+    DummyCommitManager mCommitManager;
+    uint64_t mTableId;
+    const Record* mRecord;
+};
+
+template <typename Storage>
+ScanBenchmark<Storage>::ScanBenchmark(const StorageConfig& storageConfig, const ScanBenchmarkConfig& config)
+        : mStorageConfig(storageConfig),
+          mConfig(config),
+          mStorage(storageConfig),
+          mTableId(0u),
+          mRecord(nullptr) {
+    if (!mStorage.createTable("facttable", schema(config), mTableId)) {
+        throw std::runtime_error("Unable to create fact table");
+    }
+    mRecord = &mStorage.getTable(mTableId)->record();
+}
+
+template <typename Storage>
+void ScanBenchmark<Storage>::load() {
+    std::vector<TypedField<int32_t>> intFields;
+    for (uint32_t i = 0; i < mConfig.numIntColumns; ++i) {
+        intFields.emplace_back(*mRecord, "i" + crossbow::to_string(i));
+    }
+    std::vector<TypedField<double>> doubleFields;
+    for (uint32_t i = 0; i < mConfig.numDoubleColumns; ++i) {
+        doubleFields.emplace_back(*mRecord, "d" + crossbow::to_string(i));
+    }
+    TypedField<crossbow::string> textField(*mRecord, "text");
+    crossbow::string text(mConfig.textLength, 'f');
+
+    auto numTuples = mConfig.numTuples;
+    auto numThreads = std::max(mConfig.numLoadThreads, size_t(1u));
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+    for (size_t thread = 0; thread < numThreads; ++thread) {
+        auto begin = (numTuples * thread) / numThreads;
+        auto end = (numTuples * (thread + 1)) / numThreads;
+        threads.emplace_back([this, &intFields, &doubleFields, &textField, &text, begin, end] () {
+            std::vector<char> tuple;
+            for (auto batch = begin; batch < end; batch += 1000u) {
+                auto tx = mCommitManager.startTx();
+                for (auto key = batch; key < std::min(batch + 1000u, end); ++key) {
+                    TupleWriter writer(*mRecord);
+                    for (decltype(intFields.size()) i = 0; i < intFields.size(); ++i) {
+                        auto value = (i == 0 ? key : (key * 0x9E3779B1u + i) % 1000000u);
+                        writer.set(intFields[i], static_cast<int32_t>(value));
+                    }
+                    for (decltype(doubleFields.size()) i = 0; i < doubleFields.size(); ++i) {
+                        writer.set(doubleFields[i], static_cast<double>(key) * 0.5 + static_cast<double>(i));
+                    }
+                    writer.set(textField, text);
+                    tuple.resize(writer.size());
+                    writer.serialize(tuple.data());
+
+                    if (auto ec = mStorage.insert(mTableId, key, tuple.size(), tuple.data(), tx, 0u)) {
+                        throw std::runtime_error("Loading tuple " + std::to_string(key) + " failed with error "
+                                + std::to_string(ec));
+                    }
+                }
+                tx.commit();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+template <typename Storage>
+void ScanBenchmark<Storage>::runBatch(size_t numQueries, uint32_t repetition) {
+    auto tx = mCommitManager.startTx(true);
+    ScanLatch latch(numQueries);
+
+    std::vector<std::unique_ptr<BenchmarkScanQuery>> queries;
+    std::vector<std::pair<ScanQueryType, double>> parameters;
+    for (size_t i = 0; i < numQueries; ++i) {
+        auto queryType = mConfig.queryTypes[i % mConfig.queryTypes.size()];
+        auto selectivity = mConfig.selectivities[(i / mConfig.queryTypes.size()) % mConfig.selectivities.size()];
+        queries.emplace_back(createQuery(queryType, selectivity, tx, latch));
+        parameters.emplace_back(queryType, selectivity);
+    }
+
+    auto countersBefore = perfCounters->total(PerfCounterSource::SCAN);
+
+    // Submit all queries as fast as possible so the scan manager can share them in as few scans as possible
+    auto startTime = std::chrono::steady_clock::now();
+    for (auto& query : queries) {
+        query->submit();
+        while (mStorage.scan(mTableId, query.get()) == error::server_overlad) {
+            std::this_thread::yield();
+        }
+    }
+    latch.wait();
+    auto endTime = std::chrono::steady_clock::now();
+    tx.commit();
+
+    uint64_t totalTuples = 0u;
+    uint64_t totalBytes = 0u;
+    std::chrono::nanoseconds maxPrepare(0);
+    LatencyDistribution latency;
+    for (size_t i = 0; i < numQueries; ++i) {
+        auto& query = *queries[i];
+        auto queryLatency = std::chrono::duration_cast<std::chrono::nanoseconds>(query.executionEndTime()
+                - query.submitTime());
+        auto queueDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(query.executionStartTime()
+                - query.submitTime()) - query.prepareDuration();
+        auto executionDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(query.executionEndTime()
+                - query.executionStartTime());
+
+        std::cout << "{\"type\":\"query\""
+                  << ",\"storage\":\"" << Storage::implementationName() << "\""
+                  << ",\"scan_threads\":" << mStorageConfig.numScanThreads
+                  << ",\"concurrency\":" << numQueries
+                  << ",\"repetition\":" << repetition
+                  << ",\"query\":" << i
+                  << ",\"kind\":\"" << queryTypeName(parameters[i].first) << "\""
+                  << ",\"selectivity\":" << parameters[i].second
+                  << ",\"latency_ns\":" << queryLatency.count()
+                  << ",\"queue_ns\":" << std::max(queueDuration.count(), decltype(queueDuration.count())(0))
+                  << ",\"compile_ns\":" << query.prepareDuration().count()
+                  << ",\"execution_ns\":" << executionDuration.count()
+                  << ",\"tuples\":" << query.tupleCount()
+                  << ",\"bytes\":" << query.byteCount()
+                  << "}" << std::endl;
+
+        totalTuples += query.tupleCount();
+        totalBytes += query.byteCount();
+        maxPrepare = std::max(maxPrepare, query.prepareDuration());
+        latency.add(LatencyBuckets::bucketOf(static_cast<uint64_t>(queryLatency.count())), 1u);
+    }
+
+    auto seconds = std::chrono::duration<double>(endTime - startTime).count();
+    std::cout << "{\"type\":\"batch\""
+              << ",\"storage\":\"" << Storage::implementationName() << "\""
+              << ",\"scan_threads\":" << mStorageConfig.numScanThreads
+              << ",\"interactive_threads\":" << mStorageConfig.numInteractiveScanThreads
+              << ",\"concurrency\":" << numQueries
+              << ",\"repetition\":" << repetition
+              << ",\"seconds\":" << seconds
+              << ",\"tuples_per_sec\":" << static_cast<uint64_t>(static_cast<double>(totalTuples) / seconds)
+              << ",\"bytes_per_sec\":" << static_cast<uint64_t>(static_cast<double>(totalBytes) / seconds)
+              << ",\"compile_ns_max\":" << maxPrepare.count()
+              << ",\"latency_ns\":{"
+              << "\"mean\":" << latency.mean()
+              << ",\"p50\":" << latency.percentile(0.5)
+              << ",\"p90\":" << latency.percentile(0.9)
+              << ",\"p99\":" << latency.percentile(0.99)
+              << ",\"max\":" << latency.percentile(1.0)
+              << "}";
+    if (mConfig.perfCounters) {
+        // Scan processors are measured per shared scan so the counters cover all queries of the batch
+        auto counters = perfCounters->total(PerfCounterSource::SCAN);
+        counters -= countersBefore;
+        std::cout << ",\"perf\":{"
+                  << "\"processors\":" << counters.runs
+                  << ",\"tuples\":" << counters.tuples
+                  << ",\"pages\":" << counters.pages
+                  << ",\"ipc\":" << (counters.cycles == 0u ? 0.0
+                          : static_cast<double>(counters.instructions) / static_cast<double>(counters.cycles))
+                  << ",\"cycles_per_tuple\":" << counters.perTuple(counters.cycles)
+                  << ",\"instructions_per_tuple\":" << counters.perTuple(counters.instructions)
+                  << ",\"llc_misses_per_tuple\":" << counters.perTuple(counters.llcMisses)
+                  << ",\"dtlb_misses_per_tuple\":" << counters.perTuple(counters.dtlbMisses)
+                  << ",\"cycles_per_page\":" << counters.perPage(counters.cycles)
+                  << ",\"llc_misses_per_page\":" << counters.perPage(counters.llcMisses)
+                  << ",\"dtlb_misses_per_page\":" << counters.perPage(counters.dtlbMisses)
+                  << "}";
+    }
+    std::cout << "}" << std::endl;
+}
+
+template <typename Storage>
+Schema ScanBenchmark<Storage>::schema(const ScanBenchmarkConfig& config) {
+    Schema schema(TableType::TRANSACTIONAL);
+    for (uint32_t i = 0; i < config.numIntColumns; ++i) {
+        schema.addField(FieldType::INT, "i" + crossbow::to_string(i), true);
+    }
+    for (uint32_t i = 0; i < config.numDoubleColumns; ++i) {
+        schema.addField(FieldType::DOUBLE, "d" + crossbow::to_string(i), true);
+    }
+    schema.addField(FieldType::TEXT, "text", true);
+    return schema;
+}
+
+template <typename Storage>
+Record::id_t ScanBenchmark<Storage>::fieldId(const crossbow::string& name) const {
+    Record::id_t id;
+    if (!mRecord->idOf(name, id)) {
+        throw std::logic_error("Field " + std::string(name.c_str(), name.size()) + " not found");
+    }
+    return id;
+}
+
+template <typename Storage>
+std::unique_ptr<BenchmarkScanQuery> ScanBenchmark<Storage>::createQuery(ScanQueryType queryType, double selectivity,
+        const tell::commitmanager::SnapshotDescriptor& snapshot, ScanLatch& latch) const {
+    // Selection: i0 >= numTuples * (1 - selectivity)
+    uint32_t selectionLength = 32;
+    std::unique_ptr<char[]> selection(new char[selectionLength]);
+
+    crossbow::buffer_writer selectionWriter(selection.get(), selectionLength);
+    selectionWriter.write<uint32_t>(0x1u); // Number of columns
+    selectionWriter.write<uint16_t>(0x1u); // Number of conjuncts
+    selectionWriter.write<uint16_t>(0x0u); // Partition shift
+    selectionWriter.write<uint32_t>(0x0u); // Partition key
+    selectionWriter.write<uint32_t>(0x0u); // Partition value
+    selectionWriter.write<uint16_t>(fieldId("i0"));
+    selectionWriter.write<uint16_t>(0x1u);
+    selectionWriter.align(sizeof(uint64_t));
+    selectionWriter.write<uint8_t>(crossbow::to_underlying(PredicateType::GREATER_EQUAL));
+    selectionWriter.write<uint8_t>(0x0u);
+    selectionWriter.align(sizeof(uint32_t));
+    selectionWriter.write<int32_t>(static_cast<int32_t>(static_cast<double>(mConfig.numTuples) * (1.0 - selectivity)));
+
+    std::unique_ptr<char[]> query;
+    uint32_t queryLength = 0u;
+    switch (queryType) {
+    case ScanQueryType::FULL: {
+    } break;
+
+    case ScanQueryType::PROJECTION: {
+        std::vector<Record::id_t> fields;
+        fields.emplace_back(fieldId("i0"));
+        if (mConfig.numIntColumns > 1) {
+            fields.emplace_back(fieldId("i1"));
+        }
+        if (mConfig.numDoubleColumns > 0) {
+            fields.emplace_back(fieldId("d0"));
+        }
+        std::sort(fields.begin(), fields.end());
+
+        queryLength = static_cast<uint32_t>(fields.size() * sizeof(uint16_t));
+        query.reset(new char[queryLength]);
+        crossbow::buffer_writer queryWriter(query.get(), queryLength);
+        for (auto field : fields) {
+            queryWriter.write<uint16_t>(field);
+        }
+    } break;
+
+    case ScanQueryType::AGGREGATION: {
+        auto aggregationField = fieldId(mConfig.numIntColumns > 1 ? "i1" : "i0");
+        std::vector<std::pair<Record::id_t, AggregationType>> aggregations;
+        aggregations.emplace_back(aggregationField, AggregationType::SUM);
+        aggregations.emplace_back(aggregationField, AggregationType::MIN);
+        aggregations.emplace_back(aggregationField, AggregationType::MAX);
+        aggregations.emplace_back(aggregationField, AggregationType::CNT);
+        if (mConfig.numDoubleColumns > 0) {
+            aggregations.emplace_back(fieldId("d0"), AggregationType::SUM);
+        }
+
+        queryLength = static_cast<uint32_t>(aggregations.size() * 2 * sizeof(uint16_t));
+        query.reset(new char[queryLength]);
+        crossbow::buffer_writer queryWriter(query.get(), queryLength);
+        for (auto& aggregation : aggregations) {
+            queryWriter.write<uint16_t>(aggregation.first);
+            queryWriter.write<uint16_t>(crossbow::to_underlying(aggregation.second));
+        }
+    } break;
+    }
+
+    auto scanSnapshot = tell::commitmanager::SnapshotDescriptor::create(snapshot.lowestActiveVersion(),
+            snapshot.baseVersion(), snapshot.version(), snapshot.data());
+    return std::unique_ptr<BenchmarkScanQuery>(new BenchmarkScanQuery(queryType, std::move(selection),
+            selectionLength, std::move(query), queryLength, std::move(scanSnapshot), *mRecord, latch));
+}
+
+template <typename Storage>
+void executeStorage(StorageConfig storageConfig, const ScanBenchmarkConfig& config) {
+    for (auto scanThreads : config.scanThreads) {
+        storageConfig.numScanThreads = scanThreads;
+        ScanBenchmark<Storage> benchmark(storageConfig, config);
+
+        auto startTime = std::chrono::steady_clock::now();
+        benchmark.load();
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        std::cout << "{\"type\":\"load\""
+                  << ",\"storage\":\"" << Storage::implementationName() << "\""
+                  << ",\"scan_threads\":" << scanThreads
+                  << ",\"tuples\":" << config.numTuples
+                  << ",\"seconds\":" << seconds
+                  << "}" << std::endl;
+
+        // Run a warmup batch so first-touch effects do not distort the first measurement
+        benchmark.runBatch(1u, 0u);
+
+        for (auto concurrency : config.concurrency) {
+            for (uint32_t repetition = 1; repetition <= config.repetitions; ++repetition) {
+                benchmark.runBatch(concurrency, repetition);
+            }
+        }
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    StorageConfig storageConfig;
+    ScanBenchmarkConfig config;
+    crossbow::string storage("rowstore");
+    crossbow::string concurrency;
+    crossbow::string scanThreads("1,2,4");
+    crossbow::string selectivities("0.01,0.1,0.5,1");
+    crossbow::string queryTypes("full,projection,aggregation");
+    bool help = false;
+    crossbow::string logLevel("WARN");
+
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'l'>("log-level", &logLevel),
+            crossbow::program_options::value<'s'>("storage", &storage),
+            crossbow::program_options::value<'n'>("tuples", &config.numTuples),
+            crossbow::program_options::value<'q'>("queries", &concurrency),
+            crossbow::program_options::value<'t'>("scan-threads", &scanThreads),
+            crossbow::program_options::value<'r'>("repetitions", &config.repetitions),
+            crossbow::program_options::value<'m'>("memory", &storageConfig.totalMemory),
+            crossbow::program_options::value<'c'>("capacity", &storageConfig.hashMapCapacity),
+            crossbow::program_options::value<-1>("selectivity", &selectivities,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-2>("mix", &queryTypes,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-3>("int-columns", &config.numIntColumns,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-4>("double-columns", &config.numDoubleColumns,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-5>("text-length", &config.textLength,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-6>("load-threads", &config.numLoadThreads,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-7>("perf-counters", &config.perfCounters,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-8>("interactive-scan-threads",
+                    &storageConfig.numInteractiveScanThreads, crossbow::program_options::tag::ignore_short<true>{}));
+
+    try {
+        crossbow::program_options::parse(opts, argc, argv);
+    } catch (crossbow::program_options::argument_not_found e) {
+        std::cerr << e.what() << std::endl << std::endl;
+        crossbow::program_options::print_help(std::cout, opts);
+        return 1;
+    }
+
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    crossbow::logger::logger->config.level = crossbow::logger::logLevelFromString(logLevel);
+
+    try {
+        // Default to powers of two up to the maximum number of shared queries
+        if (concurrency.empty()) {
+            for (size_t i = 1; i <= MAX_QUERY_SHARING; i *= 2) {
+                config.concurrency.emplace_back(i);
+            }
+        } else {
+            config.concurrency = parseList<size_t>(concurrency, [] (const std::string& element) {
+                return static_cast<size_t>(std::stoul(element));
+            });
+        }
+        config.scanThreads = parseList<size_t>(scanThreads, [] (const std::string& element) {
+            return static_cast<size_t>(std::stoul(element));
+        });
+        config.selectivities = parseList<double>(selectivities, [] (const std::string& element) {
+            return std::stod(element);
+        });
+        config.queryTypes = parseList<ScanQueryType>(queryTypes, queryTypeFromName);
+    } catch (std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (config.numTuples == 0u || config.numTuples > static_cast<uint64_t>(std::numeric_limits<int32_t>::max())
+            || config.numIntColumns == 0u || config.concurrency.empty() || config.scanThreads.empty()
+            || config.selectivities.empty() || config.queryTypes.empty()
+            || std::find(config.scanThreads.begin(), config.scanThreads.end(), 0u) != config.scanThreads.end()) {
+        std::cerr << "Invalid benchmark configuration" << std::endl;
+        return 1;
+    }
+
+    if (config.perfCounters) {
+        perfCounters->enable();
+    }
+
+    // Initialize allocator
+    crossbow::allocator::init();
+
+    try {
+        if (storage == "rowstore") {
+            executeStorage<DeltaMainRewriteRowStore>(storageConfig, config);
+        } else if (storage == "columnmap") {
+            executeStorage<DeltaMainRewriteColumnStore>(storageConfig, config);
+        } else if (storage == "logstructured") {
+            executeStorage<LogstructuredMemoryStore>(storageConfig, config);
+        } else {
+            std::cerr << "Unknown storage " << storage << std::endl;
+            return 1;
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,303 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <server/ModificationWatermark.hpp>
+#include <server/Replication.hpp>
+
+#include <tellstore/GenericTuple.hpp>
+#include <tellstore/Record.hpp>
+
+#include <commitmanager/SnapshotDescriptor.hpp>
+
+#include <crossbow/alignment.hpp>
+#include <crossbow/byte_buffer.hpp>
+#include <crossbow/enum_underlying.hpp>
+
+#include <gtest/gtest.h>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace tell;
+using namespace tell::store;
+
+namespace {
+
+/**
+ * @brief Returns a port on the loopback interface that is currently unused
+ */
+uint16_t unusedPort() {
+    auto fd = ::socket(AF_INET6, SOCK_STREAM, 0);
+    sockaddr_in6 address;
+    memset(&address, 0, sizeof(address));
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_loopback;
+    address.sin6_port = 0;
+    ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+    socklen_t length = sizeof(address);
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+    ::close(fd);
+    return ntohs(address.sin6_port);
+}
+
+/**
+ * @brief Connects a raw socket to the replication port, retrying until the log listens
+ */
+int connectReplica(uint16_t port) {
+    sockaddr_in6 address;
+    memset(&address, 0, sizeof(address));
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_loopback;
+    address.sin6_port = htons(port);
+
+    for (auto attempt = 0; attempt < 100; ++attempt) {
+        auto fd = ::socket(AF_INET6, SOCK_STREAM, 0);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+            return fd;
+        }
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return -1;
+}
+
+/**
+ * @brief Reads the socket until the primary closes the stream
+ */
+std::vector<char> receiveStream(int fd) {
+    std::vector<char> stream;
+    char buffer[4096];
+    while (true) {
+        auto res = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (res <= 0) {
+            break;
+        }
+        stream.insert(stream.end(), buffer, buffer + res);
+    }
+    return stream;
+}
+
+std::unique_ptr<commitmanager::SnapshotDescriptor> createSnapshot(uint64_t baseVersion, uint64_t version) {
+    commitmanager::SnapshotDescriptor::BlockType descriptor = 0x0u;
+    return commitmanager::SnapshotDescriptor::create(0u, baseVersion, version,
+            reinterpret_cast<const char*>(&descriptor));
+}
+
+Schema testSchema() {
+    Schema schema(TableType::TRANSACTIONAL);
+    schema.addField(FieldType::INT, "foo", true);
+    return schema;
+}
+
+/**
+ * @class ReplicationLog
+ * @test Check that the records are encoded in the order they were published and stale versions are skipped
+ */
+TEST(ReplicationLogTest, encoding) {
+    auto port = unusedPort();
+    int replica = -1;
+    std::thread connector([port, &replica] () {
+        replica = connectReplica(port);
+    });
+    std::unique_ptr<ReplicationLog> log(new ReplicationLog(port, 1u));
+    connector.join();
+    ASSERT_LE(0, replica) << "Replica could not connect";
+
+    auto schema = testSchema();
+    const char data[] = "12345";
+    log->publishCreateTable(1u, "testTable", schema);
+    log->publishModification(ReplicationRecordType::INSERT, 1u, 7u, 5u, 3u, sizeof(data), data);
+    log->publishVersion(*createSnapshot(5u, 6u));
+    log->publishVersion(*createSnapshot(3u, 6u));
+    log->publishAlterTable(1u, 4u, schema);
+    log->publishTable(ReplicationRecordType::TRUNCATE_TABLE, 1u);
+
+    // Destroying the log flushes all records and closes the stream
+    log.reset();
+    auto stream = receiveStream(replica);
+    ::close(replica);
+
+    crossbow::buffer_reader reader(stream.data(), stream.size());
+    auto readHeader = [&reader] () {
+        ReplicationRecordHeader header;
+        memcpy(&header, reader.read(sizeof(header)), sizeof(header));
+        return header;
+    };
+
+    auto header = readHeader();
+    EXPECT_EQ(crossbow::to_underlying(ReplicationRecordType::CREATE_TABLE), header.type);
+    EXPECT_EQ(1u, header.tableId);
+    {
+        crossbow::buffer_reader payload(reader.read(crossbow::align(header.length, 8u)), header.length);
+        auto nameLength = payload.read<uint32_t>();
+        EXPECT_EQ(crossbow::string("testTable"), crossbow::string(payload.read(nameLength), nameLength));
+        payload.align(8u);
+        auto replicatedSchema = Schema::deserialize(payload);
+        ASSERT_EQ(1u, replicatedSchema.fixedSizeFields().size());
+        EXPECT_EQ(crossbow::string("foo"), replicatedSchema.fixedSizeFields().front().name());
+    }
+
+    header = readHeader();
+    EXPECT_EQ(crossbow::to_underlying(ReplicationRecordType::INSERT), header.type);
+    EXPECT_EQ(3u, header.schemaVersion);
+    EXPECT_EQ(1u, header.tableId);
+    EXPECT_EQ(7u, header.key);
+    EXPECT_EQ(5u, header.version);
+    ASSERT_EQ(sizeof(data), header.length);
+    auto payload = reader.read(crossbow::align(header.length, 8u));
+    EXPECT_EQ(0, memcmp(data, payload, sizeof(data)));
+    for (auto i = sizeof(data); i < crossbow::align(sizeof(data), 8u); ++i) {
+        EXPECT_EQ(0, payload[i]) << "Padding not cleared at offset " << i;
+    }
+
+    header = readHeader();
+    EXPECT_EQ(crossbow::to_underlying(ReplicationRecordType::VERSION), header.type);
+    EXPECT_EQ(5u, header.version);
+    EXPECT_EQ(0u, header.length);
+
+    // The version record with base version 3 does not advance the version and is skipped
+    header = readHeader();
+    EXPECT_EQ(crossbow::to_underlying(ReplicationRecordType::ALTER_TABLE), header.type);
+    EXPECT_EQ(4u, header.schemaVersion);
+    EXPECT_EQ(1u, header.tableId);
+    reader.advance(crossbow::align(header.length, 8u));
+
+    header = readHeader();
+    EXPECT_EQ(crossbow::to_underlying(ReplicationRecordType::TRUNCATE_TABLE), header.type);
+    EXPECT_EQ(1u, header.tableId);
+    EXPECT_EQ(0u, header.length);
+
+    EXPECT_FALSE(reader.canRead(1u));
+}
+
+/**
+ * @class ReplicationOrderGuard
+ * @test Check that modifications wait for a running table operation before they are applied and published
+ */
+TEST(ReplicationOrderGuardTest, tableOperationExcludesModifications) {
+    auto port = unusedPort();
+    int replica = -1;
+    std::thread connector([port, &replica] () {
+        replica = connectReplica(port);
+    });
+    std::unique_ptr<ReplicationLog> log(new ReplicationLog(port, 1u));
+    connector.join();
+    ASSERT_LE(0, replica) << "Replica could not connect";
+
+    std::atomic<bool> modified(false);
+    std::unique_ptr<std::thread> modifier;
+    {
+        ReplicationOrderGuard _(log.get(), true);
+        modifier.reset(new std::thread([&log, &modified] () {
+            ReplicationOrderGuard _(log.get(), false);
+            modified.store(true);
+        }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT_FALSE(modified.load()) << "Modification ran during the table operation";
+    }
+    modifier->join();
+    EXPECT_TRUE(modified.load());
+
+    // Without replication log the guard does not lock anything
+    {
+        ReplicationOrderGuard first(nullptr, true);
+        ReplicationOrderGuard second(nullptr, true);
+    }
+
+    log.reset();
+    receiveStream(replica);
+    ::close(replica);
+}
+
+/**
+ * @class ReplicationApplier
+ * @test Check that a replica connected over the loopback interface applies the stream of the primary
+ */
+TEST(ReplicationApplierTest, applyOverLoopback) {
+    StorageConfig config;
+    config.totalMemory = 0x10000000ull;
+    config.numScanThreads = 0u;
+    config.hashMapCapacity = 0x10000ull;
+    Storage storage(config);
+    ModificationWatermark watermark;
+
+    auto port = unusedPort();
+    std::unique_ptr<ReplicationLog> log;
+    std::thread listener([port, &log] () {
+        log.reset(new ReplicationLog(port, 1u));
+    });
+    std::unique_ptr<ReplicationApplier> applier(new ReplicationApplier(storage, watermark,
+            crossbow::string("localhost:") + crossbow::to_string(port)));
+    listener.join();
+
+    auto schema = testSchema();
+    Record record(schema);
+    size_t size;
+    std::unique_ptr<char[]> tuple(record.create(GenericTuple({
+            std::make_pair<crossbow::string, boost::any>("foo", int32_t(42))
+    }), size));
+
+    log->publishCreateTable(1u, "testTable", schema);
+    log->publishModification(ReplicationRecordType::INSERT, 1u, 7u, 5u, 0u, size, tuple.get());
+    log->publishVersion(*createSnapshot(5u, 6u));
+
+    for (auto i = 0; i < 500 && applier->appliedVersion() < 5u; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(5u, applier->appliedVersion());
+    EXPECT_TRUE(applier->covers(*createSnapshot(5u, 6u)));
+    EXPECT_FALSE(applier->covers(*createSnapshot(6u, 7u)));
+    EXPECT_LT(0u, watermark.get(1u));
+
+    uint64_t tableId;
+    ASSERT_NE(nullptr, storage.getTable("testTable", tableId));
+    EXPECT_EQ(1u, tableId);
+
+    std::unique_ptr<char[]> dest;
+    auto ec = storage.get(tableId, 7u, *createSnapshot(5u, 6u), [&dest] (size_t size, uint64_t /* version */,
+            bool /* isNewest */) {
+        dest.reset(new char[size]);
+        return dest.get();
+    });
+    ASSERT_EQ(0, ec);
+    Record::id_t fieldId;
+    ASSERT_TRUE(record.idOf("foo", fieldId));
+    bool isNull;
+    auto value = record.data(dest.get(), fieldId, isNull);
+    ASSERT_FALSE(isNull);
+    EXPECT_EQ(42, *reinterpret_cast<const int32_t*>(value));
+
+    applier.reset();
+    log.reset();
+}
+
+} // anonymous namespace
@@ -27,10 +27,11 @@
 
 #include "DummyCommitManager.hpp"
 
-#include <crossbow/allocator.hpp>
-
 #include <gtest/gtest.h>
 
+#include <memory>
+#include <vector>
+
 using namespace tell::store;
 
 namespace {
@@ -57,7 +58,6 @@ protected:
     }
 
     virtual void SetUp() final override {
-        crossbow::allocator _;
         ASSERT_TRUE(mStorage->createTable("testTable", mSchema, mTableId)) << "Creating table failed";
         EXPECT_TRUE(correctTableId("testTable", mTableId));
     }
@@ -86,7 +86,6 @@ using StorageTestImplementations = ::testing::Types<DeltaMainRewriteRowStore, De
 TYPED_TEST_CASE(StorageTest, StorageTestImplementations);
 
 TYPED_TEST(StorageTest, insert_and_get) {
-    crossbow::allocator _; // needed to free memory
     Record record(this->mSchema);
 
     // Force GC - since we did not do anything yet, this should
@@ -99,7 +98,7 @@ TYPED_TEST(StorageTest, insert_and_get) {
         std::unique_ptr<char[]> rec(record.create(GenericTuple({
                 std::make_pair<crossbow::string, boost::any>("foo", 12)
         }), size));
-        auto res = this->mStorage->insert(this->mTableId, 1, size, rec.get(), tx);
+        auto res = this->mStorage->insert(this->mTableId, 1, size, rec.get(), tx, 0u);
         ASSERT_TRUE(!res) << "This insert must not fail!";
     }
     {
@@ -117,6 +116,63 @@ TYPED_TEST(StorageTest, insert_and_get) {
     this->mStorage->forceGC();
 }
 
+/**
+ * @test Check that a batched get reports every key with the same result as a single get
+ *
+ * Reads every key before and after the garbage collection moved the tuples into the main. Only every other key exists.
+ */
+TYPED_TEST(StorageTest, batched_get) {
+    Record record(this->mSchema);
+    constexpr size_t numKeys = 40u;
+
+    auto tx = this->mCommitManager.startTx();
+    for (uint64_t key = 0u; key < numKeys; key += 2) {
+        size_t size;
+        std::unique_ptr<char[]> rec(record.create(GenericTuple({
+                std::make_pair<crossbow::string, boost::any>("foo", static_cast<int32_t>(key))
+        }), size));
+        auto res = this->mStorage->insert(this->mTableId, key, size, rec.get(), tx, 0u);
+        ASSERT_TRUE(!res) << "Insert of key " << key << " failed";
+    }
+    tx.commit();
+
+    std::vector<uint64_t> keys;
+    for (uint64_t key = 0u; key < numKeys; ++key) {
+        keys.emplace_back(key);
+    }
+
+    Record::id_t fieldId;
+    ASSERT_TRUE(record.idOf("foo", fieldId));
+    for (auto i = 0; i < 2; ++i) {
+        auto readTx = this->mCommitManager.startTx();
+        std::vector<int> ec(keys.size(), -1);
+        std::vector<std::unique_ptr<char[]>> dest(keys.size());
+        this->mStorage->get(this->mTableId, keys.data(), keys.size(), readTx, ec.data(), [&dest]
+                (size_t idx, size_t size, uint64_t /* version */, bool isNewest) {
+            EXPECT_TRUE(isNewest);
+            EXPECT_FALSE(dest[idx]) << "Key " << idx << " reported twice";
+            dest[idx].reset(new char[size]);
+            return dest[idx].get();
+        });
+
+        for (size_t idx = 0; idx < keys.size(); ++idx) {
+            if (keys[idx] % 2 != 0) {
+                EXPECT_EQ(error::not_found, ec[idx]) << "Key " << keys[idx] << " found";
+                continue;
+            }
+            ASSERT_EQ(0, ec[idx]) << "Key " << keys[idx] << " not found";
+
+            bool isNull;
+            auto value = record.data(dest[idx].get(), fieldId, isNull);
+            ASSERT_FALSE(isNull);
+            EXPECT_EQ(static_cast<int32_t>(keys[idx]), *reinterpret_cast<const int32_t*>(value));
+        }
+        readTx.commit();
+
+        this->mStorage->forceGC();
+    }
+}
+
 TYPED_TEST(StorageTest, concurrent_transactions) {
     Record record(this->mSchema);
 
@@ -125,12 +181,11 @@ TYPED_TEST(StorageTest, concurrent_transactions) {
 
     // Transaction 1 can insert a new tuple
     {
-        crossbow::allocator _;
         size_t size;
         std::unique_ptr<char[]> rec(record.create(GenericTuple({
                 std::make_pair<crossbow::string, boost::any>("foo", 12)
         }), size));
-        auto res = this->mStorage->insert(this->mTableId, 1, size, rec.get(), tx1);
+        auto res = this->mStorage->insert(this->mTableId, 1, size, rec.get(), tx1, 0u);
         ASSERT_TRUE(!res) << "This insert must not fail!";
     }
 
@@ -139,7 +194,6 @@ TYPED_TEST(StorageTest, concurrent_transactions) {
 
     // Transaction 2 can not read the tuple written by transaction 1
     {
-        crossbow::allocator _;
         std::unique_ptr<char[]> dest;
         auto res = this->mStorage->get(this->mTableId, 1, tx2, [&dest] (size_t size, uint64_t version, bool isNewest) {
             dest.reset(new char[size]);
@@ -150,23 +204,21 @@ TYPED_TEST(StorageTest, concurrent_transactions) {
 
     // Transaction 2 can not insert a new tuple already written by transaction 1
     {
-        crossbow::allocator _;
         size_t size;
         std::unique_ptr<char[]> rec(record.create(GenericTuple({
                 std::make_pair<crossbow::string, boost::any>("foo", 13)
         }), size));
-        auto res = this->mStorage->insert(this->mTableId, 1, size, rec.get(), tx2);
+        auto res = this->mStorage->insert(this->mTableId, 1, size, rec.get(), tx2, 0u);
         EXPECT_FALSE(!res) << "Insert succeeded despite tuple already existing in different version";
     }
 
     // Transaction 2 can not update the tuple written by transaction 1
     {
-        crossbow::allocator _;
         size_t size;
         std::unique_ptr<char[]> rec(record.create(GenericTuple({
                 std::make_pair<crossbow::string, boost::any>("foo", 13)
         }), size));
-        auto res = this->mStorage->update(this->mTableId, 1, size, rec.get(), tx2);
+        auto res = this->mStorage->update(this->mTableId, 1, size, rec.get(), tx2, 0u);
         EXPECT_FALSE(!res) << "Update succeeded despite tuple already existing in different version";
     }
 
@@ -178,7 +230,6 @@ TYPED_TEST(StorageTest, concurrent_transactions) {
 
     // Transaction 3 can read the tuple written by transaction 1
     {
-        crossbow::allocator _;
         std::unique_ptr<char[]> dest;
         auto res = this->mStorage->get(this->mTableId, 1, tx3, [&tx1, &dest]
                 (size_t size, uint64_t version, bool isNewest) {
@@ -192,18 +243,16 @@ TYPED_TEST(StorageTest, concurrent_transactions) {
 
     // Transaction 3 updates tuple written by transaction 1
     {
-        crossbow::allocator _;
         size_t size;
         std::unique_ptr<char[]> rec(record.create(GenericTuple({
                 std::make_pair<crossbow::string, boost::any>("foo", 13)
         }), size));
-        auto res = this->mStorage->update(this->mTableId, 1, size, rec.get(), tx3);
+        auto res = this->mStorage->update(this->mTableId, 1, size, rec.get(), tx3, 0u);
         EXPECT_TRUE(!res) << "Update not successful";
     }
 
     // Transaction 2 should not be able to see all versions
     {
-        crossbow::allocator _;
         std::unique_ptr<char[]> dest;
         auto res = this->mStorage->get(this->mTableId, 1, tx2, [&tx1, &dest]
                 (size_t size, uint64_t version, bool isNewest) {
@@ -257,7 +306,7 @@ public:
         auto transaction = mCommitManager.startTx();
 
         for (auto key = startKey; key < endKey; ++key) {
-            auto ec = mStorage->insert(mTableId, key, mTupleSize, mTuple[key % mTuple.size()].get(), transaction);
+            auto ec = mStorage->insert(mTableId, key, mTupleSize, mTuple[key % mTuple.size()].get(), transaction, 0u);
             ASSERT_FALSE(ec);
 
             std::unique_ptr<char[]> dest;
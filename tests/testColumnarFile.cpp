@@ -0,0 +1,171 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include <tellstore/ColumnarFile.hpp>
+#include <tellstore/GenericTuple.hpp>
+#include <tellstore/Record.hpp>
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace tell::store;
+
+namespace {
+
+class ColumnarFileTest : public ::testing::Test {
+protected:
+    ColumnarFileTest()
+            : mSchema(TableType::TRANSACTIONAL),
+              mPath("/tmp/tellstore-columnar-test") {
+        mSchema.addField(FieldType::INT, "number", true);
+        mSchema.addField(FieldType::BIGINT, "largenumber", false);
+        mSchema.addField(FieldType::DOUBLE, "fraction", false);
+        mSchema.addField(FieldType::TEXT, "text1", true);
+        mSchema.addField(FieldType::TEXT, "text2", false);
+        mRecord = Record(mSchema);
+
+        addTuple(GenericTuple({
+                std::make_pair<crossbow::string, boost::any>("number", int32_t(12)),
+                std::make_pair<crossbow::string, boost::any>("largenumber", int64_t(-4)),
+                std::make_pair<crossbow::string, boost::any>("text1", crossbow::string("Bacon ipsum")),
+                std::make_pair<crossbow::string, boost::any>("text2", crossbow::string("dolor amet"))
+        }));
+        addTuple(GenericTuple({
+                std::make_pair<crossbow::string, boost::any>("number", int32_t(-3)),
+                std::make_pair<crossbow::string, boost::any>("fraction", 2.5),
+                std::make_pair<crossbow::string, boost::any>("text1", crossbow::string(""))
+        }));
+        addTuple(GenericTuple({
+                std::make_pair<crossbow::string, boost::any>("number", int32_t(7)),
+                std::make_pair<crossbow::string, boost::any>("largenumber", int64_t(1000)),
+                std::make_pair<crossbow::string, boost::any>("fraction", -1.0),
+                std::make_pair<crossbow::string, boost::any>("text1", crossbow::string("Short loin")),
+                std::make_pair<crossbow::string, boost::any>("text2", crossbow::string("pork belly chuck"))
+        }));
+    }
+
+    virtual ~ColumnarFileTest() {
+        ::unlink(mPath.c_str());
+    }
+
+    void addTuple(const GenericTuple& tuple) {
+        // The record does not initialize the padding, zero it so the tuples can be compared byte by byte
+        auto size = mRecord.sizeOfTuple(tuple);
+        mTuples.emplace_back(new char[size]());
+        ASSERT_TRUE(mRecord.create(mTuples.back().get(), tuple, size));
+        mSizes.emplace_back(size);
+    }
+
+    Schema mSchema;
+    Record mRecord;
+    crossbow::string mPath;
+
+    std::vector<std::unique_ptr<char[]>> mTuples;
+    std::vector<size_t> mSizes;
+};
+
+/**
+ * @class ColumnarFileWriter
+ * @test Check if tuples written in row groups are materialized unchanged by the reader
+ */
+TEST_F(ColumnarFileTest, RoundTrip) {
+    ColumnarRowGroupBuilder builder(mRecord);
+    std::vector<char> buffer;
+    {
+        ColumnarFileWriter writer(mPath, mSchema);
+
+        builder.add(1u, mTuples[0].get());
+        builder.add(2u, mTuples[1].get());
+        builder.serialize(buffer);
+        writer.append(buffer, builder.rowCount());
+
+        builder.clear();
+        EXPECT_EQ(0u, builder.rowCount());
+        builder.add(3u, mTuples[2].get());
+        builder.serialize(buffer);
+        writer.append(buffer, builder.rowCount());
+
+        EXPECT_EQ(3u, writer.close());
+    }
+
+    ColumnarFileReader reader(mPath);
+    ASSERT_EQ(2u, reader.rowGroupCount());
+    EXPECT_EQ(3u, reader.rowCount());
+    EXPECT_EQ(mRecord.fieldCount(), reader.record().fieldCount());
+
+    uint64_t key = 1u;
+    for (size_t i = 0; i < reader.rowGroupCount(); ++i) {
+        auto rowGroup = reader.rowGroup(i);
+        for (uint64_t row = 0; row < rowGroup.rowCount(); ++row, ++key) {
+            EXPECT_EQ(key, rowGroup.key(row));
+
+            auto size = rowGroup.tupleSize(row);
+            ASSERT_EQ(mSizes[key - 1], size);
+
+            std::unique_ptr<char[]> tuple(new char[size]);
+            rowGroup.materialize(row, tuple.get());
+            EXPECT_EQ(0, memcmp(mTuples[key - 1].get(), tuple.get(), size)) << "Tuple " << key << " differs";
+        }
+    }
+    EXPECT_EQ(4u, key);
+}
+
+/**
+ * @class ColumnarRowGroupBuilder
+ * @test Check if the column chunk headers contain the minimum and maximum of the non-NULL values
+ */
+TEST_F(ColumnarFileTest, MinMax) {
+    ColumnarRowGroupBuilder builder(mRecord);
+    for (size_t i = 0; i < mTuples.size(); ++i) {
+        builder.add(i, mTuples[i].get());
+    }
+    std::vector<char> buffer;
+    builder.serialize(buffer);
+
+    ColumnarRowGroup rowGroup(mRecord, buffer.data(), buffer.size());
+    ASSERT_EQ(3u, rowGroup.rowCount());
+
+    Record::id_t id;
+    ASSERT_TRUE(mRecord.idOf("number", id));
+    auto& number = rowGroup.columnHeader(id);
+    EXPECT_EQ(ColumnChunkHeader::HAS_MIN_MAX, number.flags);
+    EXPECT_EQ(-3, *reinterpret_cast<const int64_t*>(number.min));
+    EXPECT_EQ(12, *reinterpret_cast<const int64_t*>(number.max));
+
+    ASSERT_TRUE(mRecord.idOf("fraction", id));
+    auto& fraction = rowGroup.columnHeader(id);
+    EXPECT_EQ(ColumnChunkHeader::HAS_NULLS | ColumnChunkHeader::HAS_MIN_MAX, fraction.flags);
+    EXPECT_EQ(-1.0, *reinterpret_cast<const double*>(fraction.min));
+    EXPECT_EQ(2.5, *reinterpret_cast<const double*>(fraction.max));
+
+    ASSERT_TRUE(mRecord.idOf("text2", id));
+    EXPECT_EQ(ColumnChunkHeader::HAS_NULLS, rowGroup.columnHeader(id).flags);
+}
+
+} // anonymous namespace
@@ -0,0 +1,307 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include <tellstore/ColumnarFile.hpp>
+#include <tellstore/GenericTuple.hpp>
+#include <tellstore/ImportSource.hpp>
+#include <tellstore/Record.hpp>
+
+#include <crossbow/string.hpp>
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace tell::store;
+
+namespace {
+
+class ImportSourceTest : public ::testing::Test {
+protected:
+    ImportSourceTest()
+            : mSchema(TableType::TRANSACTIONAL),
+              mPath("/tmp/tellstore-import-test") {
+        mSchema.addField(FieldType::INT, "number", true);
+        mSchema.addField(FieldType::BIGINT, "largenumber", false);
+        mSchema.addField(FieldType::DOUBLE, "fraction", false);
+        mSchema.addField(FieldType::TEXT, "text1", true);
+        mSchema.addField(FieldType::TEXT, "text2", false);
+        mRecord = Record(mSchema);
+    }
+
+    virtual ~ImportSourceTest() {
+        ::unlink(mPath.c_str());
+    }
+
+    void writeFile(const std::string& content) {
+        std::ofstream out(mPath.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(content.data(), content.size());
+    }
+
+    std::vector<char> createTuple(const Record& record, const GenericTuple& tuple) {
+        // The record does not initialize the padding, zero it so the tuples can be compared byte by byte
+        auto size = record.sizeOfTuple(tuple);
+        std::vector<char> result(size, 0);
+        EXPECT_TRUE(record.create(result.data(), tuple, size));
+        return result;
+    }
+
+    void expectRow(ImportCursor& cursor, uint64_t expectedKey, const std::vector<char>& expectedTuple) {
+        uint64_t key;
+        const char* data;
+        size_t size;
+        ASSERT_TRUE(cursor.next(key, data, size));
+        EXPECT_EQ(expectedKey, key);
+        ASSERT_EQ(expectedTuple.size(), size);
+        EXPECT_EQ(0, memcmp(expectedTuple.data(), data, size)) << "Tuple " << key << " differs";
+    }
+
+    Schema mSchema;
+    Record mRecord;
+    crossbow::string mPath;
+};
+
+/**
+ * @class CsvImportSource
+ * @test Check if rows are mapped to the fields named in the header, with quoted fields and NULL values
+ */
+TEST_F(ImportSourceTest, CsvHeader) {
+    writeFile("text2,key,number,ignored,fraction,largenumber,text1\r\n"
+            "dolor amet,1,12,x,,-4,\"Bacon \"\"ipsum\"\"\"\r\n"
+            ",2,-3,,2.5,,\"\"\n"
+            "\n"
+            "\"pork, belly\",3,7,y,-1,1000,Short loin");
+
+    ImportConfig config;
+    config.header = true;
+    CsvImportSource source(mPath, mRecord, config, 1u);
+    ASSERT_EQ(1u, source.chunkCount());
+
+    auto cursor = source.chunk(0u);
+    expectRow(*cursor, 1u, createTuple(mRecord, GenericTuple({
+            std::make_pair<crossbow::string, boost::any>("number", int32_t(12)),
+            std::make_pair<crossbow::string, boost::any>("largenumber", int64_t(-4)),
+            std::make_pair<crossbow::string, boost::any>("text1", crossbow::string("Bacon \"ipsum\"")),
+            std::make_pair<crossbow::string, boost::any>("text2", crossbow::string("dolor amet"))
+    })));
+    expectRow(*cursor, 2u, createTuple(mRecord, GenericTuple({
+            std::make_pair<crossbow::string, boost::any>("number", int32_t(-3)),
+            std::make_pair<crossbow::string, boost::any>("fraction", 2.5),
+            std::make_pair<crossbow::string, boost::any>("text1", crossbow::string(""))
+    })));
+    expectRow(*cursor, 3u, createTuple(mRecord, GenericTuple({
+            std::make_pair<crossbow::string, boost::any>("number", int32_t(7)),
+            std::make_pair<crossbow::string, boost::any>("largenumber", int64_t(1000)),
+            std::make_pair<crossbow::string, boost::any>("fraction", -1.0),
+            std::make_pair<crossbow::string, boost::any>("text1", crossbow::string("Short loin")),
+            std::make_pair<crossbow::string, boost::any>("text2", crossbow::string("pork, belly"))
+    })));
+
+    uint64_t key;
+    const char* data;
+    size_t size;
+    EXPECT_FALSE(cursor->next(key, data, size));
+}
+
+/**
+ * @class CsvImportSource
+ * @test Check if every row is returned by exactly one chunk when the file is split at arbitrary offsets
+ */
+TEST_F(ImportSourceTest, CsvChunks) {
+    // Without header the key is followed by the fields in the order of their IDs
+    const uint64_t rowCount = 1000u;
+    std::string content;
+    std::vector<std::vector<char>> tuples;
+    for (uint64_t i = 0; i < rowCount; ++i) {
+        auto text = crossbow::string(i % 7, 'a' + (i % 26));
+        GenericTuple tuple({
+                std::make_pair<crossbow::string, boost::any>("number", int32_t(i)),
+                std::make_pair<crossbow::string, boost::any>("largenumber", int64_t(i) * 1000000007),
+                std::make_pair<crossbow::string, boost::any>("text1", text)
+        });
+        tuples.emplace_back(createTuple(mRecord, tuple));
+
+        content += std::to_string(i);
+        for (Record::id_t id = 0u; id < mRecord.fieldCount(); ++id) {
+            content += '|';
+            auto& name = mRecord.getFieldMeta(id).field.name();
+            auto value = tuple.find(name);
+            if (value == tuple.end()) {
+                continue;
+            }
+            if (name == "number") {
+                content += std::to_string(boost::any_cast<int32_t>(value->second));
+            } else if (name == "largenumber") {
+                content += std::to_string(boost::any_cast<int64_t>(value->second));
+            } else {
+                content += "\"";
+                content += boost::any_cast<crossbow::string>(value->second).c_str();
+                content += "\"";
+            }
+        }
+        content += '\n';
+    }
+    writeFile(content);
+
+    ImportConfig config;
+    config.delimiter = '|';
+    CsvImportSource source(mPath, mRecord, config, 7u);
+    ASSERT_EQ(7u, source.chunkCount());
+
+    std::vector<size_t> seen(rowCount, 0u);
+    for (size_t i = 0; i < source.chunkCount(); ++i) {
+        auto cursor = source.chunk(i);
+        uint64_t key;
+        const char* data;
+        size_t size;
+        while (cursor->next(key, data, size)) {
+            ASSERT_LT(key, rowCount);
+            ++seen[key];
+            ASSERT_EQ(tuples[key].size(), size);
+            EXPECT_EQ(0, memcmp(tuples[key].data(), data, size)) << "Tuple " << key << " differs";
+        }
+    }
+    for (uint64_t i = 0; i < rowCount; ++i) {
+        EXPECT_EQ(1u, seen[i]) << "Row " << i << " not returned exactly once";
+    }
+}
+
+/**
+ * @class CsvImportSource
+ * @test Check if rows that can not be converted are rejected
+ */
+TEST_F(ImportSourceTest, CsvInvalid) {
+    ImportConfig config;
+    config.header = true;
+
+    writeFile("key,number,text1\n1,,abc\n");
+    {
+        CsvImportSource source(mPath, mRecord, config, 1u);
+        auto cursor = source.chunk(0u);
+        uint64_t key;
+        const char* data;
+        size_t size;
+        EXPECT_THROW(cursor->next(key, data, size), std::invalid_argument);
+    }
+
+    writeFile("key,number,text1\n1,3000000000,abc\n");
+    {
+        CsvImportSource source(mPath, mRecord, config, 1u);
+        auto cursor = source.chunk(0u);
+        uint64_t key;
+        const char* data;
+        size_t size;
+        EXPECT_THROW(cursor->next(key, data, size), std::invalid_argument);
+    }
+
+    writeFile("key,number\n1,3\n");
+    EXPECT_THROW(CsvImportSource(mPath, mRecord, config, 1u), std::invalid_argument);
+}
+
+/**
+ * @class BinaryImportSource
+ * @test Check if fixed size rows are split into chunks and returned unchanged
+ */
+TEST_F(ImportSourceTest, Binary) {
+    Schema schema(TableType::TRANSACTIONAL);
+    schema.addField(FieldType::INT, "number", true);
+    schema.addField(FieldType::DOUBLE, "fraction", false);
+    Record record(schema);
+
+    const uint64_t rowCount = 10u;
+    std::string content;
+    std::vector<std::vector<char>> tuples;
+    for (uint64_t i = 0; i < rowCount; ++i) {
+        tuples.emplace_back(createTuple(record, GenericTuple({
+                std::make_pair<crossbow::string, boost::any>("number", int32_t(i)),
+                std::make_pair<crossbow::string, boost::any>("fraction", double(i) / 2.0)
+        })));
+        content.append(reinterpret_cast<const char*>(&i), sizeof(i));
+        content.append(tuples.back().data(), tuples.back().size());
+    }
+    writeFile(content);
+
+    BinaryImportSource source(mPath, record, 3u);
+    ASSERT_EQ(3u, source.chunkCount());
+    uint64_t expectedKey = 0u;
+    for (size_t i = 0; i < source.chunkCount(); ++i) {
+        auto cursor = source.chunk(i);
+        uint64_t key;
+        const char* data;
+        size_t size;
+        while (cursor->next(key, data, size)) {
+            ASSERT_EQ(expectedKey, key);
+            ASSERT_EQ(tuples[key].size(), size);
+            EXPECT_EQ(0, memcmp(tuples[key].data(), data, size)) << "Tuple " << key << " differs";
+            ++expectedKey;
+        }
+    }
+    EXPECT_EQ(rowCount, expectedKey);
+
+    EXPECT_THROW(BinaryImportSource(mPath, mRecord, 1u), std::invalid_argument);
+}
+
+/**
+ * @class ColumnarImportSource
+ * @test Check if the rows of an exported columnar file are imported with one chunk per row group
+ */
+TEST_F(ImportSourceTest, Columnar) {
+    auto tuple1 = createTuple(mRecord, GenericTuple({
+            std::make_pair<crossbow::string, boost::any>("number", int32_t(12)),
+            std::make_pair<crossbow::string, boost::any>("text1", crossbow::string("Bacon ipsum"))
+    }));
+    auto tuple2 = createTuple(mRecord, GenericTuple({
+            std::make_pair<crossbow::string, boost::any>("number", int32_t(-3)),
+            std::make_pair<crossbow::string, boost::any>("fraction", 2.5),
+            std::make_pair<crossbow::string, boost::any>("text1", crossbow::string("")),
+            std::make_pair<crossbow::string, boost::any>("text2", crossbow::string("dolor amet"))
+    }));
+    {
+        ColumnarRowGroupBuilder builder(mRecord);
+        std::vector<char> buffer;
+        ColumnarFileWriter writer(mPath, mSchema);
+        builder.add(1u, tuple1.data());
+        builder.serialize(buffer);
+        writer.append(buffer, builder.rowCount());
+        builder.clear();
+        builder.add(2u, tuple2.data());
+        builder.serialize(buffer);
+        writer.append(buffer, builder.rowCount());
+        writer.close();
+    }
+
+    ColumnarImportSource source(mPath, mRecord);
+    ASSERT_EQ(2u, source.chunkCount());
+    expectRow(*source.chunk(0u), 1u, tuple1);
+    expectRow(*source.chunk(1u), 2u, tuple2);
+}
+
+} // anonymous namespace
@@ -0,0 +1,172 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <util/PageManager.hpp>
+
+#include <tellstore/Statistics.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace tell::store;
+
+namespace {
+
+class PageManagerTest : public ::testing::Test {
+protected:
+    PageManagerTest()
+            : mPageManager(PageManager::construct(10 * TELL_PAGE_SIZE)) {
+    }
+
+    MemoryUsage usage() const {
+        MemoryUsage usage;
+        mPageManager->collectUsage(usage);
+        return usage;
+    }
+
+    PageManager::Ptr mPageManager;
+};
+
+/**
+ * @class PageManager
+ * @test Check if allocated pages are accounted to their owner and category until they are freed
+ */
+TEST_F(PageManagerTest, MemoryTagging) {
+    EXPECT_EQ(10 * TELL_PAGE_SIZE, usage().get(0u, MemoryCategory::FREE));
+
+    auto untagged = mPageManager->alloc();
+    auto insertLog = mPageManager->alloc(MemoryTag(3u, MemoryCategory::INSERT_LOG));
+    auto mainPage1 = mPageManager->alloc(MemoryTag(3u, MemoryCategory::MAIN_PAGE));
+    auto mainPage2 = mPageManager->alloc(MemoryTag(4u, MemoryCategory::MAIN_PAGE));
+
+    auto result = usage();
+    EXPECT_EQ(6 * TELL_PAGE_SIZE, result.get(0u, MemoryCategory::FREE));
+    EXPECT_EQ(TELL_PAGE_SIZE, result.get(0u, MemoryCategory::UNTAGGED));
+    EXPECT_EQ(TELL_PAGE_SIZE, result.get(3u, MemoryCategory::INSERT_LOG));
+    EXPECT_EQ(2 * TELL_PAGE_SIZE, result.table(3u));
+    EXPECT_EQ(2 * TELL_PAGE_SIZE, result.category(MemoryCategory::MAIN_PAGE));
+
+    mPageManager->free(mainPage1);
+    mPageManager->free(insertLog);
+    result = usage();
+    EXPECT_EQ(8 * TELL_PAGE_SIZE, result.get(0u, MemoryCategory::FREE));
+    EXPECT_EQ(0u, result.table(3u));
+    EXPECT_EQ(TELL_PAGE_SIZE, result.table(4u));
+
+    mPageManager->free(mainPage2);
+    mPageManager->free(untagged);
+    EXPECT_EQ(10 * TELL_PAGE_SIZE, usage().get(0u, MemoryCategory::FREE));
+}
+
+/**
+ * @class PageManager
+ * @test Check that retired pages are not returned to the pool while a guard entered before the retirement is active
+ */
+TEST_F(PageManagerTest, RetireWaitsForGuard) {
+    auto page = mPageManager->alloc(MemoryTag(3u, MemoryCategory::MAIN_PAGE));
+    {
+        ReclamationGuard _;
+        mPageManager->retirePages({page});
+        EXPECT_EQ(0u, mPageManager->reclaim());
+        EXPECT_EQ(TELL_PAGE_SIZE, usage().table(3u));
+    }
+    EXPECT_EQ(1u, mPageManager->reclaim());
+    EXPECT_EQ(0u, usage().table(3u));
+    EXPECT_EQ(10 * TELL_PAGE_SIZE, usage().get(0u, MemoryCategory::FREE));
+}
+
+/**
+ * @class PageManager
+ * @test Check that a guard entered after the retirement does not hold back the page
+ */
+TEST_F(PageManagerTest, RetireIgnoresNewerGuard) {
+    auto page = mPageManager->alloc(MemoryTag(3u, MemoryCategory::MAIN_PAGE));
+    mPageManager->retirePages({page});
+
+    ReclamationGuard _;
+    EXPECT_EQ(1u, mPageManager->reclaim());
+    EXPECT_EQ(0u, usage().table(3u));
+}
+
+/**
+ * @class PageManager
+ * @test Check that a guard on another thread holds back the page until it is left
+ */
+TEST_F(PageManagerTest, RetireWaitsForOtherThread) {
+    auto page = mPageManager->alloc(MemoryTag(3u, MemoryCategory::MAIN_PAGE));
+
+    std::atomic<bool> entered(false);
+    std::atomic<bool> leave(false);
+    std::thread reader([&entered, &leave] () {
+        ReclamationGuard _;
+        entered.store(true);
+        while (!leave.load()) {
+            std::this_thread::yield();
+        }
+    });
+    while (!entered.load()) {
+        std::this_thread::yield();
+    }
+
+    mPageManager->retirePages({page});
+    EXPECT_EQ(0u, mPageManager->reclaim());
+
+    leave.store(true);
+    reader.join();
+    EXPECT_EQ(1u, mPageManager->reclaim());
+    EXPECT_EQ(0u, usage().table(3u));
+}
+
+/**
+ * @class PageManager
+ * @test Check that allocating from an exhausted pool reclaims retired pages
+ */
+TEST_F(PageManagerTest, AllocReclaims) {
+    std::vector<void*> pages;
+    for (auto i = 0; i < 10; ++i) {
+        pages.emplace_back(mPageManager->alloc());
+        ASSERT_NE(nullptr, pages.back());
+    }
+    EXPECT_EQ(nullptr, mPageManager->alloc());
+
+    mPageManager->retirePages({pages.back()});
+    EXPECT_EQ(pages.back(), mPageManager->alloc());
+}
+
+/**
+ * @class PageManager
+ * @test Check that destroying the page manager releases retired elements without waiting for active guards
+ */
+TEST_F(PageManagerTest, DestroyReleasesRetired) {
+    auto released = false;
+    ReclamationGuard _;
+    mPageManager->retire([&released] () {
+        released = true;
+    });
+    mPageManager.reset();
+    EXPECT_TRUE(released);
+}
+
+} // anonymous namespace
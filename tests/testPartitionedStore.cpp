@@ -0,0 +1,577 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <config.h>
+
+#include <deltamain/DeltaMainRewriteStore.hpp>
+#include <logstructured/LogstructuredMemoryStore.hpp>
+#include <util/PartitionedStore.hpp>
+
+#include "DummyCommitManager.hpp"
+
+#include <crossbow/alignment.hpp>
+#include <crossbow/byte_buffer.hpp>
+#include <crossbow/enum_underlying.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace tell;
+using namespace tell::store;
+
+namespace {
+
+StorageConfig partitionedConfig() {
+    StorageConfig config;
+    config.totalMemory = 0x10000000ull;
+    config.numScanThreads = 1u;
+    config.hashMapCapacity = 0x100000ull;
+    config.numPartitions = 4u;
+    return config;
+}
+
+/**
+ * @brief Full scan query counting the returned tuples and the scans announced and started by the storage
+ */
+class FanOutScanQuery : public ScanQuery {
+public:
+    static constexpr uint32_t BUFFER_LENGTH = 64u * 1024u;
+
+    FanOutScanQuery(std::unique_ptr<char[]> selectionData, size_t selectionLength,
+            std::unique_ptr<commitmanager::SnapshotDescriptor> snapshot, const Record& record)
+            : ScanQuery(ScanQueryType::FULL, std::move(selectionData), selectionLength, nullptr, 0u,
+                    std::move(snapshot), record),
+              mExpectedScans(0u),
+              mStartedScans(0u),
+              mTupleCount(0u),
+              mDone(false) {
+    }
+
+    size_t expectedScans() const {
+        return mExpectedScans.load();
+    }
+
+    size_t startedScans() const {
+        return mStartedScans.load();
+    }
+
+    uint64_t tupleCount() const {
+        return mTupleCount.load();
+    }
+
+    /**
+     * @brief Waits until all processors of all scans are done
+     */
+    void wait() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this] () {
+            return mDone;
+        });
+    }
+
+    virtual std::tuple<char*, uint32_t> acquireBuffer() final override {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mBuffers.emplace_back(new char[BUFFER_LENGTH]);
+        return std::make_tuple(mBuffers.back().get(), BUFFER_LENGTH);
+    }
+
+    virtual void writeOngoing(const char* start, const char* end, std::error_code& ec) final override {
+        ec = std::error_code();
+        consume(start, end);
+    }
+
+    virtual void writeLast(const char* start, const char* end, std::error_code& ec) final override {
+        ec = std::error_code();
+        consume(start, end);
+        processorDone();
+    }
+
+    virtual void writeLast(std::error_code& ec) final override {
+        ec = std::error_code();
+        processorDone();
+    }
+
+    virtual ScanQueryProcessor createProcessor() final override {
+        processorStarted();
+        return ScanQueryProcessor(this);
+    }
+
+    virtual void expectScans(size_t count) final override {
+        mExpectedScans += count;
+        ScanQuery::expectScans(count);
+    }
+
+    virtual void scanStarted() final override {
+        ++mStartedScans;
+        ScanQuery::scanStarted();
+    }
+
+private:
+    void consume(const char* start, const char* end) {
+        for (auto pos = start; pos < end; ++mTupleCount) {
+            pos += ScanQueryProcessor::TUPLE_OVERHEAD;
+            pos += crossbow::align(record().sizeOfTuple(pos), 8u);
+        }
+    }
+
+    virtual void queryDone() final override {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDone = true;
+        mCondition.notify_all();
+    }
+
+    std::atomic<size_t> mExpectedScans;
+    std::atomic<size_t> mStartedScans;
+    std::atomic<uint64_t> mTupleCount;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mDone;
+    std::vector<std::unique_ptr<char[]>> mBuffers;
+};
+
+constexpr uint32_t FanOutScanQuery::BUFFER_LENGTH;
+
+/**
+ * @brief Creates a full scan query selecting all tuples with a non-negative value in the field
+ */
+std::unique_ptr<FanOutScanQuery> createScanQuery(const Record& record, const commitmanager::SnapshotDescriptor& snapshot,
+        const crossbow::string& field) {
+    Record::id_t fieldId;
+    if (!record.idOf(field, fieldId)) {
+        return nullptr;
+    }
+
+    uint32_t selectionLength = 32;
+    std::unique_ptr<char[]> selection(new char[selectionLength]);
+
+    crossbow::buffer_writer selectionWriter(selection.get(), selectionLength);
+    selectionWriter.write<uint32_t>(0x1u); // Number of columns
+    selectionWriter.write<uint16_t>(0x1u); // Number of conjuncts
+    selectionWriter.write<uint16_t>(0x0u); // Partition shift
+    selectionWriter.write<uint32_t>(0x0u); // Partition key
+    selectionWriter.write<uint32_t>(0x0u); // Partition value
+    selectionWriter.write<uint16_t>(fieldId);
+    selectionWriter.write<uint16_t>(0x1u);
+    selectionWriter.align(sizeof(uint64_t));
+    selectionWriter.write<uint8_t>(crossbow::to_underlying(PredicateType::GREATER_EQUAL));
+    selectionWriter.write<uint8_t>(0x0u);
+    selectionWriter.align(sizeof(uint32_t));
+    selectionWriter.write<int32_t>(0);
+
+    auto scanSnapshot = commitmanager::SnapshotDescriptor::create(snapshot.lowestActiveVersion(),
+            snapshot.baseVersion(), snapshot.version(), snapshot.data());
+    return std::unique_ptr<FanOutScanQuery>(new FanOutScanQuery(std::move(selection), selectionLength,
+            std::move(scanSnapshot), record));
+}
+
+TEST(PartitionedStoreConfigTest, splitResources) {
+    auto config = partitionedConfig();
+    config.numScanThreads = 2u;
+    config.scanCores = {0u, 1u, 2u, 3u};
+    config.gcCores = {4u, 5u};
+
+    auto partition = PartitionedStore<DeltaMainRewriteRowStore>::partitionConfig(config, 1u);
+    EXPECT_EQ(1u, partition.numPartitions);
+    EXPECT_EQ(config.totalMemory / 4u, partition.totalMemory);
+    EXPECT_EQ(0u, partition.totalMemory % TELL_PAGE_SIZE);
+    EXPECT_EQ(config.hashMapCapacity / 4u, partition.hashMapCapacity);
+    EXPECT_EQ(std::vector<unsigned>({2u, 3u, 0u, 1u}), partition.scanCores);
+    EXPECT_EQ(std::vector<unsigned>({5u, 4u}), partition.gcCores);
+}
+
+TEST(PartitionedStoreConfigTest, singlePartition) {
+    auto config = partitionedConfig();
+    config.numPartitions = 1u;
+    config.scanCores = {0u, 1u};
+
+    auto partition = PartitionedStore<DeltaMainRewriteRowStore>::partitionConfig(config, 0u);
+    EXPECT_EQ(config.totalMemory, partition.totalMemory);
+    EXPECT_EQ(config.hashMapCapacity, partition.hashMapCapacity);
+    EXPECT_EQ(config.scanCores, partition.scanCores);
+}
+
+template <typename Impl>
+class PartitionedStoreTest : public ::testing::Test {
+protected:
+    PartitionedStoreTest()
+            : mStorage(partitionedConfig()),
+              mSchema(TableType::TRANSACTIONAL),
+              mTableId(0u) {
+        mSchema.addField(FieldType::INT, "foo", true);
+    }
+
+    virtual void SetUp() final override {
+        ASSERT_TRUE(mStorage.createTable("testTable", mSchema, mTableId)) << "Creating table failed";
+    }
+
+    /**
+     * @brief Inserts the keys 1 to numKeys into the test table
+     */
+    void insertKeys(uint64_t numKeys, const commitmanager::SnapshotDescriptor& snapshot) {
+        Record record(mSchema);
+        for (uint64_t key = 1u; key <= numKeys; ++key) {
+            size_t size;
+            std::unique_ptr<char[]> rec(record.create(GenericTuple({
+                    std::make_pair<crossbow::string, boost::any>("foo", static_cast<int32_t>(key))
+            }), size));
+            ASSERT_EQ(0, mStorage.insert(mTableId, key, size, rec.get(), snapshot, 0u)) << "Insert of key " << key
+                    << " failed";
+        }
+    }
+
+    PartitionedStore<Impl> mStorage;
+
+    DummyCommitManager mCommitManager;
+
+    Schema mSchema;
+
+    uint64_t mTableId;
+};
+
+using PartitionedStoreTestImplementations = ::testing::Types<DeltaMainRewriteRowStore, LogstructuredMemoryStore>;
+TYPED_TEST_CASE(PartitionedStoreTest, PartitionedStoreTestImplementations);
+
+/**
+ * @brief Test that all partitions assign the same table IDs
+ */
+TYPED_TEST(PartitionedStoreTest, createTable) {
+    EXPECT_EQ(4u, this->mStorage.numPartitions());
+
+    uint64_t tableId;
+    EXPECT_FALSE(this->mStorage.createTable("testTable", this->mSchema, tableId)) << "Duplicate table was created";
+
+    uint64_t otherId;
+    ASSERT_TRUE(this->mStorage.createTable("otherTable", this->mSchema, otherId)) << "Creating table failed";
+    EXPECT_NE(this->mTableId, otherId);
+
+    uint64_t id;
+    ASSERT_NE(nullptr, this->mStorage.getTable("otherTable", id));
+    EXPECT_EQ(otherId, id);
+    EXPECT_EQ(2u, this->mStorage.getTables().size());
+}
+
+/**
+ * @brief Test that tuples are spread across the partitions and can be read back from their owning partition
+ */
+TYPED_TEST(PartitionedStoreTest, insertAndGet) {
+    Record record(this->mSchema);
+    constexpr uint64_t numKeys = 64u;
+
+    std::set<size_t> partitions;
+    auto tx = this->mCommitManager.startTx();
+    for (uint64_t key = 1u; key <= numKeys; ++key) {
+        partitions.insert(this->mStorage.partitionOf(key));
+
+        size_t size;
+        std::unique_ptr<char[]> rec(record.create(GenericTuple({
+                std::make_pair<crossbow::string, boost::any>("foo", static_cast<int32_t>(key))
+        }), size));
+        auto res = this->mStorage.insert(this->mTableId, key, size, rec.get(), tx, 0u);
+        ASSERT_TRUE(!res) << "Insert of key " << key << " failed";
+    }
+    EXPECT_EQ(this->mStorage.numPartitions(), partitions.size()) << "Keys are not spread across all partitions";
+
+    Record::id_t fieldId;
+    ASSERT_TRUE(record.idOf("foo", fieldId));
+    for (uint64_t key = 1u; key <= numKeys; ++key) {
+        std::unique_ptr<char[]> dest;
+        auto res = this->mStorage.get(this->mTableId, key, tx, [&dest] (size_t size, uint64_t /* version */,
+                bool /* isNewest */) {
+            dest.reset(new char[size]);
+            return dest.get();
+        });
+        ASSERT_TRUE(!res) << "Key " << key << " not found";
+
+        bool isNull;
+        auto value = record.data(dest.get(), fieldId, isNull);
+        ASSERT_FALSE(isNull);
+        EXPECT_EQ(static_cast<int32_t>(key), *reinterpret_cast<const int32_t*>(value));
+    }
+    tx.commit();
+}
+
+/**
+ * @brief Test that a scan is executed on every partition and announced to the query once per partition
+ */
+TYPED_TEST(PartitionedStoreTest, scanFanOut) {
+    constexpr uint64_t numKeys = 64u;
+    auto tx = this->mCommitManager.startTx();
+    this->insertKeys(numKeys, *tx);
+
+    Record record(this->mSchema);
+    auto query = createScanQuery(record, *tx, "foo");
+    ASSERT_EQ(0, this->mStorage.scan(this->mTableId, query.get()));
+    query->wait();
+
+    EXPECT_EQ(this->mStorage.numPartitions(), query->expectedScans());
+    EXPECT_EQ(this->mStorage.numPartitions(), query->startedScans());
+    EXPECT_EQ(numKeys, query->tupleCount());
+    tx.commit();
+}
+
+/**
+ * @brief Test that an overloaded store rejects a scan before any partition admitted it
+ */
+TEST(PartitionedStoreScanTest, scanOverload) {
+    // Without scan threads the queues are never drained
+    auto config = partitionedConfig();
+    config.numScanThreads = 0u;
+    PartitionedStore<DeltaMainRewriteRowStore> storage(config);
+
+    Schema schema(TableType::TRANSACTIONAL);
+    schema.addField(FieldType::INT, "foo", true);
+    uint64_t tableId;
+    ASSERT_TRUE(storage.createTable("testTable", schema, tableId));
+
+    DummyCommitManager commitManager;
+    auto tx = commitManager.startTx();
+    Record record(schema);
+
+    std::vector<std::unique_ptr<FanOutScanQuery>> queries;
+    for (size_t i = 0; i < MAX_QUERY_SHARING; ++i) {
+        queries.emplace_back(createScanQuery(record, *tx, "foo"));
+        ASSERT_EQ(0, storage.scan(tableId, queries.back().get())) << "Scan " << i << " was rejected";
+    }
+
+    auto query = createScanQuery(record, *tx, "foo");
+    EXPECT_EQ(error::server_overlad, storage.scan(tableId, query.get()));
+    EXPECT_EQ(0u, query->expectedScans());
+    EXPECT_EQ(0u, query->startedScans());
+    tx.commit();
+}
+
+using DeltaMainPartitionedStoreTest = PartitionedStoreTest<DeltaMainRewriteRowStore>;
+
+/**
+ * @brief Test that truncating removes the tuples in all partitions while the table stays usable
+ */
+TEST_F(DeltaMainPartitionedStoreTest, truncateTable) {
+    constexpr uint64_t numKeys = 64u;
+    {
+        auto tx = mCommitManager.startTx();
+        insertKeys(numKeys, *tx);
+        tx.commit();
+    }
+
+    EXPECT_EQ(0, mStorage.truncateTable(mTableId));
+
+    uint64_t id;
+    ASSERT_NE(nullptr, mStorage.getTable("testTable", id));
+    EXPECT_EQ(mTableId, id);
+
+    auto tx = mCommitManager.startTx();
+    for (uint64_t key = 1u; key <= numKeys; ++key) {
+        auto res = mStorage.get(mTableId, key, *tx, [] (size_t /* size */, uint64_t /* version */,
+                bool /* isNewest */) {
+            return static_cast<char*>(nullptr);
+        });
+        EXPECT_EQ(error::not_found, res) << "Key " << key << " survived the truncation";
+    }
+    insertKeys(numKeys, *tx);
+    tx.commit();
+}
+
+/**
+ * @brief Test that a schema change is only applied when it is valid for all partitions
+ */
+TEST_F(DeltaMainPartitionedStoreTest, alterTable) {
+    auto invalidSchema = mSchema;
+    ASSERT_TRUE(invalidSchema.removeField("foo"));
+    ASSERT_TRUE(invalidSchema.addField(FieldType::BIGINT, "foo", true));
+    EXPECT_EQ(error::invalid_schema_change, mStorage.checkAlterTable(mTableId, 0u, invalidSchema));
+    EXPECT_EQ(error::invalid_schema_change, mStorage.alterTable(mTableId, 0u, invalidSchema));
+    EXPECT_EQ(0u, mStorage.getTable(mTableId)->schemaVersion());
+
+    auto schema = mSchema;
+    ASSERT_TRUE(schema.addField(FieldType::BIGINT, "bar", false));
+    EXPECT_EQ(0, mStorage.checkAlterTable(mTableId, 0u, schema));
+    EXPECT_EQ(0u, mStorage.getTable(mTableId)->schemaVersion());
+    ASSERT_EQ(0, mStorage.alterTable(mTableId, 0u, schema));
+    EXPECT_EQ(1u, mStorage.getTable(mTableId)->schemaVersion());
+
+    // Altering an outdated schema version is rejected
+    EXPECT_EQ(error::invalid_schema_change, mStorage.alterTable(mTableId, 0u, schema));
+    EXPECT_EQ(1u, mStorage.getTable(mTableId)->schemaVersion());
+
+    // Clients still using the initial schema version can write into every partition
+    auto tx = mCommitManager.startTx();
+    insertKeys(16u, *tx);
+    tx.commit();
+}
+
+/**
+ * @brief Test that truncating an altered table keeps its schema history so clients of every version can write
+ */
+TEST_F(DeltaMainPartitionedStoreTest, truncateAlteredTable) {
+    auto schema = mSchema;
+    ASSERT_TRUE(schema.addField(FieldType::BIGINT, "bar", false));
+    ASSERT_EQ(0, mStorage.alterTable(mTableId, 0u, schema));
+
+    EXPECT_EQ(0, mStorage.truncateTable(mTableId));
+    EXPECT_EQ(1u, mStorage.getTable(mTableId)->schemaVersion());
+
+    Record oldRecord(mSchema);
+    size_t oldSize;
+    std::unique_ptr<char[]> oldTuple(oldRecord.create(GenericTuple({
+            std::make_pair<crossbow::string, boost::any>("foo", int32_t(1))
+    }), oldSize));
+
+    Record newRecord(schema);
+    size_t newSize;
+    std::unique_ptr<char[]> newTuple(newRecord.create(GenericTuple({
+            std::make_pair<crossbow::string, boost::any>("foo", int32_t(2)),
+            std::make_pair<crossbow::string, boost::any>("bar", int64_t(20))
+    }), newSize));
+
+    auto tx = mCommitManager.startTx();
+    ASSERT_EQ(0, mStorage.insert(mTableId, 1u, oldSize, oldTuple.get(), *tx, 0u));
+    ASSERT_EQ(0, mStorage.insert(mTableId, 2u, newSize, newTuple.get(), *tx, 1u));
+    EXPECT_EQ(error::invalid_schema_change, mStorage.insert(mTableId, 3u, newSize, newTuple.get(), *tx, 2u));
+
+    // Both tuples are read in the newest schema version
+    Record::id_t fooId;
+    ASSERT_TRUE(newRecord.idOf("foo", fooId));
+    Record::id_t barId;
+    ASSERT_TRUE(newRecord.idOf("bar", barId));
+    for (uint64_t key = 1u; key <= 2u; ++key) {
+        std::unique_ptr<char[]> dest;
+        ASSERT_EQ(0, mStorage.get(mTableId, key, *tx, [&dest] (size_t size, uint64_t /* version */,
+                bool /* isNewest */) {
+            dest.reset(new char[size]);
+            return dest.get();
+        })) << "Key " << key << " not found";
+
+        bool isNull = false;
+        auto foo = newRecord.data(dest.get(), fooId, isNull);
+        ASSERT_FALSE(isNull);
+        EXPECT_EQ(static_cast<int32_t>(key), *reinterpret_cast<const int32_t*>(foo));
+        auto bar = newRecord.data(dest.get(), barId, isNull);
+        if (key == 1u) {
+            EXPECT_TRUE(isNull);
+        } else {
+            ASSERT_FALSE(isNull);
+            EXPECT_EQ(20, *reinterpret_cast<const int64_t*>(bar));
+        }
+    }
+    tx.commit();
+
+    EXPECT_EQ(0, mStorage.alterTable(mTableId, 1u, mSchema));
+    EXPECT_EQ(2u, mStorage.getTable(mTableId)->schemaVersion());
+}
+
+/**
+ * @brief Test that a scan racing with a drop either fails or is executed on every partition
+ */
+TEST_F(DeltaMainPartitionedStoreTest, scanDuringDrop) {
+    constexpr uint64_t numKeys = 64u;
+    auto tx = mCommitManager.startTx();
+    insertKeys(numKeys, *tx);
+    Record record(mSchema);
+
+    std::vector<std::unique_ptr<FanOutScanQuery>> queries;
+    std::atomic<bool> dropped(false);
+    std::thread dropper([this, &dropped] () {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        EXPECT_EQ(0, mStorage.dropTable(mTableId));
+        dropped.store(true);
+    });
+
+    // Keep scanning until the drop was observed so some scans race with it
+    while (true) {
+        auto done = dropped.load();
+        auto query = createScanQuery(record, *tx, "foo");
+        auto ec = mStorage.scan(mTableId, query.get());
+        if (ec == 0) {
+            queries.emplace_back(std::move(query));
+        } else {
+            EXPECT_TRUE(ec == error::invalid_table || ec == error::server_overlad) << "Unexpected error " << ec;
+        }
+        if (done) {
+            break;
+        }
+    }
+    dropper.join();
+
+    for (auto& query : queries) {
+        query->wait();
+        EXPECT_EQ(mStorage.numPartitions(), query->startedScans());
+        EXPECT_EQ(numKeys, query->tupleCount()) << "Scan is missing the tuples of a partition";
+    }
+    tx.commit();
+}
+
+/**
+ * @brief Test that a dropped table is gone from all partitions and its name can be reused
+ */
+TEST_F(DeltaMainPartitionedStoreTest, dropTable) {
+    {
+        auto tx = mCommitManager.startTx();
+        insertKeys(16u, *tx);
+        tx.commit();
+    }
+
+    EXPECT_EQ(0, mStorage.dropTable(mTableId));
+    EXPECT_EQ(error::invalid_table, mStorage.dropTable(mTableId));
+    EXPECT_EQ(error::invalid_table, mStorage.truncateTable(mTableId));
+
+    uint64_t id;
+    EXPECT_EQ(nullptr, mStorage.getTable("testTable", id));
+    EXPECT_EQ(nullptr, mStorage.getTable(mTableId));
+    EXPECT_TRUE(mStorage.getTables().empty());
+
+    {
+        Record record(mSchema);
+        size_t size;
+        std::unique_ptr<char[]> rec(record.create(GenericTuple({
+                std::make_pair<crossbow::string, boost::any>("foo", int32_t(1))
+        }), size));
+        auto tx = mCommitManager.startTx();
+        EXPECT_EQ(error::invalid_table, mStorage.insert(mTableId, 1u, size, rec.get(), *tx, 0u));
+        tx.commit();
+    }
+
+    ASSERT_TRUE(mStorage.createTable("testTable", mSchema, id)) << "Recreating dropped table failed";
+    EXPECT_NE(mTableId, id);
+}
+
+using LogstructuredPartitionedStoreTest = PartitionedStoreTest<LogstructuredMemoryStore>;
+
+/**
+ * @brief Test that the log-structured storage rejects dropping and truncating tables
+ */
+TEST_F(LogstructuredPartitionedStoreTest, dropTableUnsupported) {
+    EXPECT_EQ(error::unsupported_operation, mStorage.dropTable(mTableId));
+    EXPECT_EQ(error::unsupported_operation, mStorage.truncateTable(mTableId));
+
+    uint64_t id;
+    EXPECT_NE(nullptr, mStorage.getTable("testTable", id));
+}
+
+} // anonymous namespace
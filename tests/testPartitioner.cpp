@@ -0,0 +1,165 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include <tellstore/Partitioner.hpp>
+#include <tellstore/Record.hpp>
+
+#include <crossbow/byte_buffer.hpp>
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace tell::store;
+
+namespace {
+
+/**
+ * @brief Checks that every key matching the partition selection is located on a shard marked by the partitioner
+ */
+void checkPruning(const Partitioner& partitioner, uint16_t shift, uint32_t modulo, uint32_t number,
+        uint64_t keyCount) {
+    std::vector<bool> shards;
+    partitioner.shardsOf(shift, modulo, number, shards);
+    ASSERT_EQ(partitioner.shardCount(), shards.size());
+
+    for (uint64_t key = 0; key < keyCount; ++key) {
+        if ((key >> shift) % modulo != number) {
+            continue;
+        }
+        EXPECT_TRUE(shards[partitioner.shardOf(key)]) << "Shard of key " << key << " was pruned";
+    }
+}
+
+/**
+ * @class Partitioner
+ * @test Check if the hash partitioner keeps the modulo placement and prunes shards on matching partition selections
+ */
+TEST(PartitionerTest, Hash) {
+    auto partitioner = Partitioner::create(PartitionSpec::hash(), 4);
+    for (uint64_t key = 0; key < 100; ++key) {
+        EXPECT_EQ(key % 4, partitioner->shardOf(key));
+    }
+
+    std::vector<bool> shards;
+    partitioner->shardsOf(0, 8, 5, shards);
+    EXPECT_EQ(std::vector<bool>({false, true, false, false}), shards);
+
+    partitioner->shardsOf(0, 2, 1, shards);
+    EXPECT_EQ(std::vector<bool>({false, true, false, true}), shards);
+
+    partitioner->shardsOf(0, 0, 0, shards);
+    EXPECT_EQ(std::vector<bool>(4, true), shards);
+
+    checkPruning(*partitioner, 0, 6, 3, 1000);
+    checkPruning(*partitioner, 2, 8, 5, 1000);
+}
+
+/**
+ * @class Partitioner
+ * @test Check if the range partitioner assigns keys by range and only keeps shards containing matching keys
+ */
+TEST(PartitionerTest, Range) {
+    auto partitioner = Partitioner::create(PartitionSpec::range({100, 200, 200}), 4);
+    EXPECT_EQ(0u, partitioner->shardOf(0));
+    EXPECT_EQ(0u, partitioner->shardOf(99));
+    EXPECT_EQ(1u, partitioner->shardOf(100));
+    EXPECT_EQ(1u, partitioner->shardOf(199));
+    EXPECT_EQ(3u, partitioner->shardOf(200));
+    EXPECT_EQ(3u, partitioner->shardOf(std::numeric_limits<uint64_t>::max()));
+
+    std::vector<bool> shards;
+    partitioner->shardsOf(6, 4, 2, shards);
+    EXPECT_EQ(std::vector<bool>({false, true, false, true}), shards);
+
+    checkPruning(*partitioner, 0, 7, 3, 1000);
+    checkPruning(*partitioner, 5, 3, 1, 1000);
+
+    EXPECT_THROW(Partitioner::create(PartitionSpec::range({100}), 4), std::invalid_argument);
+    EXPECT_THROW(Partitioner::create(PartitionSpec::range({200, 100}), 3), std::invalid_argument);
+}
+
+/**
+ * @class Partitioner
+ * @test Check if adding a shard to a consistent hash partitioner only moves keys to the new shard
+ */
+TEST(PartitionerTest, ConsistentHashGrowth) {
+    auto partitioner = Partitioner::create(PartitionSpec::consistentHash(64), 4);
+    auto grownPartitioner = Partitioner::create(PartitionSpec::consistentHash(64), 5);
+
+    std::mt19937_64 random;
+    std::vector<size_t> keysPerShard(4, 0);
+    size_t moved = 0;
+    constexpr size_t keyCount = 100000;
+    for (size_t i = 0; i < keyCount; ++i) {
+        auto key = random();
+        auto shard = partitioner->shardOf(key);
+        auto grownShard = grownPartitioner->shardOf(key);
+        ASSERT_LT(shard, 4u);
+        ++keysPerShard[shard];
+        if (shard != grownShard) {
+            EXPECT_EQ(4u, grownShard) << "Key moved between existing shards";
+            ++moved;
+        }
+    }
+
+    // Roughly a fifth of the keys should be moved to the new shard
+    EXPECT_GT(moved, keyCount / 10);
+    EXPECT_LT(moved, keyCount * 3 / 10);
+    for (auto count : keysPerShard) {
+        EXPECT_GT(count, keyCount / 8);
+    }
+
+    EXPECT_THROW(Partitioner::create(PartitionSpec::consistentHash(0), 4), std::invalid_argument);
+}
+
+/**
+ * @class Schema
+ * @test Check if the partition specification is serialized with the schema
+ */
+TEST(PartitionerTest, SchemaSerialization) {
+    Schema schema(TableType::TRANSACTIONAL);
+    schema.addField(FieldType::INT, "number", true);
+    schema.addField(FieldType::TEXT, "text", false);
+    schema.setPartitioning(PartitionSpec::range({10, 20}));
+
+    auto length = schema.serializedLength();
+    std::unique_ptr<uint64_t[]> buffer(new uint64_t[length / sizeof(uint64_t) + 1]);
+    auto data = reinterpret_cast<char*>(buffer.get());
+
+    crossbow::buffer_writer writer(data, length);
+    schema.serialize(writer);
+    EXPECT_EQ(data + length, writer.data());
+
+    crossbow::buffer_reader reader(data, length);
+    auto result = Schema::deserialize(reader);
+    EXPECT_EQ(PartitionType::RANGE, result.partitioning().type());
+    EXPECT_EQ(std::vector<uint64_t>({10, 20}), result.partitioning().bounds());
+    EXPECT_EQ(2u, result.fieldCount());
+}
+
+} // anonymous namespace
@@ -0,0 +1,148 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include <tellstore/ReadCache.hpp>
+#include <tellstore/Record.hpp>
+#include <tellstore/Table.hpp>
+
+#include <crossbow/byte_buffer.hpp>
+#include <crossbow/string.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace tell::store;
+
+namespace {
+
+class ReadCacheTest : public ::testing::Test {
+protected:
+    ReadCacheTest()
+            : mCache(2u, std::vector<crossbow::string>{"cached"}),
+              mCachedTable(1u, "cached", Schema(TableType::TRANSACTIONAL)),
+              mOtherTable(2u, "other", Schema(TableType::TRANSACTIONAL)) {
+    }
+
+    /**
+     * @brief Creates a tuple of the given version in the format of a get response
+     */
+    std::shared_ptr<const Tuple> createTuple(uint64_t version) {
+        std::vector<char> data(2 * sizeof(uint64_t), 0);
+        crossbow::buffer_writer writer(data.data(), data.size());
+        writer.write<uint64_t>(version);
+        writer.write<uint8_t>(0x1u);
+        writer.set(0, sizeof(uint32_t) - sizeof(uint8_t));
+        writer.write<uint32_t>(0u);
+
+        crossbow::buffer_reader reader(data.data(), data.size());
+        return std::shared_ptr<const Tuple>(Tuple::deserialize(reader));
+    }
+
+    ReadCache mCache;
+    Table mCachedTable;
+    Table mOtherTable;
+};
+
+/**
+ * @class ReadCache
+ * @test Check that only the configured tables are cached
+ */
+TEST_F(ReadCacheTest, isCached) {
+    EXPECT_TRUE(mCache.isCached(mCachedTable));
+    EXPECT_FALSE(mCache.isCached(mOtherTable));
+
+    ReadCache disabled(0u, std::vector<crossbow::string>{"cached"});
+    EXPECT_FALSE(disabled.isCached(mCachedTable));
+}
+
+/**
+ * @class ReadCache
+ * @test Check that inserted tuples are returned with their watermark and replaced by a second insert
+ */
+TEST_F(ReadCacheTest, insertAndLookup) {
+    EXPECT_EQ(nullptr, mCache.lookup(1u, 10u));
+
+    mCache.insert(1u, 10u, createTuple(5u), 3u);
+    auto entry = mCache.lookup(1u, 10u);
+    ASSERT_NE(nullptr, entry);
+    EXPECT_EQ(5u, entry->tuple->version());
+    EXPECT_EQ(3u, entry->watermark);
+    EXPECT_EQ(nullptr, mCache.lookup(2u, 10u));
+
+    mCache.insert(1u, 10u, createTuple(7u), 4u);
+    EXPECT_EQ(1u, mCache.size());
+    entry = mCache.lookup(1u, 10u);
+    ASSERT_NE(nullptr, entry);
+    EXPECT_EQ(7u, entry->tuple->version());
+    EXPECT_EQ(4u, entry->watermark);
+}
+
+/**
+ * @class ReadCache
+ * @test Check that the least recently used entry is evicted when the capacity is exceeded
+ */
+TEST_F(ReadCacheTest, evictLeastRecentlyUsed) {
+    mCache.insert(1u, 10u, createTuple(1u), 0u);
+    mCache.insert(1u, 11u, createTuple(1u), 0u);
+
+    // The lookup makes the first entry the most recently used one
+    EXPECT_NE(nullptr, mCache.lookup(1u, 10u));
+
+    mCache.insert(1u, 12u, createTuple(1u), 0u);
+    EXPECT_EQ(2u, mCache.size());
+    EXPECT_NE(nullptr, mCache.lookup(1u, 10u));
+    EXPECT_EQ(nullptr, mCache.lookup(1u, 11u));
+    EXPECT_NE(nullptr, mCache.lookup(1u, 12u));
+
+    // Replacing an entry marks it as recently used without evicting anything
+    mCache.insert(1u, 10u, createTuple(2u), 0u);
+    mCache.insert(1u, 13u, createTuple(1u), 0u);
+    EXPECT_EQ(2u, mCache.size());
+    EXPECT_NE(nullptr, mCache.lookup(1u, 10u));
+    EXPECT_EQ(nullptr, mCache.lookup(1u, 12u));
+    EXPECT_NE(nullptr, mCache.lookup(1u, 13u));
+}
+
+/**
+ * @class ReadCache
+ * @test Check that invalidated entries are removed and free their slot
+ */
+TEST_F(ReadCacheTest, invalidate) {
+    mCache.insert(1u, 10u, createTuple(1u), 0u);
+    mCache.insert(1u, 11u, createTuple(1u), 0u);
+
+    mCache.invalidate(1u, 10u);
+    mCache.invalidate(1u, 20u);
+    EXPECT_EQ(1u, mCache.size());
+    EXPECT_EQ(nullptr, mCache.lookup(1u, 10u));
+
+    mCache.insert(1u, 12u, createTuple(1u), 0u);
+    EXPECT_EQ(2u, mCache.size());
+    EXPECT_NE(nullptr, mCache.lookup(1u, 11u));
+    EXPECT_NE(nullptr, mCache.lookup(1u, 12u));
+}
+
+} // anonymous namespace
@@ -0,0 +1,213 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include <util/SchemaHistory.hpp>
+
+#include <tellstore/ErrorCode.hpp>
+#include <tellstore/GenericTuple.hpp>
+#include <tellstore/Record.hpp>
+
+#include <crossbow/alignment.hpp>
+#include <crossbow/string.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace tell::store;
+
+namespace {
+
+class SchemaHistoryTest : public ::testing::Test {
+protected:
+    SchemaHistoryTest()
+            : mSchema(TableType::TRANSACTIONAL) {
+        mSchema.addField(FieldType::INT, "number", true);
+        mSchema.addField(FieldType::TEXT, "text1", true);
+        mSchema.addField(FieldType::BIGINT, "largenumber", false);
+    }
+
+    std::vector<char> createTuple(const Record& record, const GenericTuple& tuple) {
+        auto size = record.sizeOfTuple(tuple);
+        std::vector<char> result(size, 0);
+        EXPECT_TRUE(record.create(result.data(), tuple, size));
+        return result;
+    }
+
+    std::vector<char> convert(const RecordConverter& converter, const std::vector<char>& tuple) {
+        std::vector<char> result(converter.convertedSize(tuple.data()));
+        EXPECT_EQ(result.size(), converter.convert(tuple.data(), result.data()));
+        return result;
+    }
+
+    const char* field(const Record& record, const std::vector<char>& tuple, const crossbow::string& name,
+            bool& isNull) {
+        Record::id_t id;
+        EXPECT_TRUE(record.idOf(name, id)) << "Field " << name << " does not exist";
+        isNull = false;
+        return record.data(tuple.data(), id, isNull);
+    }
+
+    crossbow::string text(const Record& record, const std::vector<char>& tuple, const crossbow::string& name) {
+        bool isNull;
+        auto offsets = reinterpret_cast<const uint32_t*>(field(record, tuple, name, isNull));
+        return crossbow::string(tuple.data() + offsets[0], offsets[1] - offsets[0]);
+    }
+
+    Schema mSchema;
+};
+
+/**
+ * @class RecordConverter
+ * @test Check if added fields become NULL or empty and dropped fields are removed from the converted tuple
+ */
+TEST_F(SchemaHistoryTest, AddDrop) {
+    SchemaHistory history(mSchema);
+    EXPECT_EQ(0u, history.newestVersion());
+
+    auto schema = mSchema;
+    ASSERT_TRUE(schema.removeField("text1"));
+    ASSERT_TRUE(schema.addField(FieldType::DOUBLE, "fraction", false));
+    ASSERT_TRUE(schema.addField(FieldType::TEXT, "text2", true));
+    ASSERT_EQ(0, history.addVersion(schema));
+    EXPECT_EQ(1u, history.newestVersion());
+    EXPECT_EQ(4u, history.newestRecord().fieldCount());
+
+    auto tuple = createTuple(history.record(0u), GenericTuple({
+            std::make_pair<crossbow::string, boost::any>("number", int32_t(12)),
+            std::make_pair<crossbow::string, boost::any>("text1", crossbow::string("Bacon ipsum dolor amet")),
+            std::make_pair<crossbow::string, boost::any>("largenumber", int64_t(-4))
+    }));
+    auto& record = history.newestRecord();
+    auto converted = convert(history.converter(0u, 1u), tuple);
+    EXPECT_EQ(crossbow::align(record.staticSize(), 8u), converted.size());
+
+    bool isNull;
+    EXPECT_EQ(12, *reinterpret_cast<const int32_t*>(field(record, converted, "number", isNull)));
+    EXPECT_EQ(-4, *reinterpret_cast<const int64_t*>(field(record, converted, "largenumber", isNull)));
+    EXPECT_FALSE(isNull);
+    field(record, converted, "fraction", isNull);
+    EXPECT_TRUE(isNull);
+    EXPECT_EQ("", text(record, converted, "text2"));
+
+    Record::id_t id;
+    EXPECT_FALSE(record.idOf("text1", id));
+}
+
+/**
+ * @class SchemaHistory
+ * @test Check if a dropped field added again in a later version does not get back its old values
+ */
+TEST_F(SchemaHistoryTest, DropReadd) {
+    SchemaHistory history(mSchema);
+
+    auto schema = mSchema;
+    ASSERT_TRUE(schema.removeField("text1"));
+    ASSERT_EQ(0, history.addVersion(schema));
+    ASSERT_TRUE(schema.addField(FieldType::TEXT, "text1", true));
+    ASSERT_EQ(0, history.addVersion(schema));
+
+    auto tuple = createTuple(history.record(0u), GenericTuple({
+            std::make_pair<crossbow::string, boost::any>("number", int32_t(7)),
+            std::make_pair<crossbow::string, boost::any>("text1", crossbow::string("Short loin")),
+            std::make_pair<crossbow::string, boost::any>("largenumber", int64_t(1000))
+    }));
+    auto& record = history.record(2u);
+    auto converted = convert(history.converter(0u, 2u), tuple);
+    EXPECT_EQ("", text(record, converted, "text1"));
+
+    bool isNull;
+    EXPECT_EQ(7, *reinterpret_cast<const int32_t*>(field(record, converted, "number", isNull)));
+    EXPECT_EQ(1000, *reinterpret_cast<const int64_t*>(field(record, converted, "largenumber", isNull)));
+
+    // Tuples written in the intermediate version keep the values of the field
+    auto tuple1 = createTuple(history.record(1u), GenericTuple({
+            std::make_pair<crossbow::string, boost::any>("number", int32_t(8))
+    }));
+    auto converted1 = convert(history.converter(1u, 2u), tuple1);
+    EXPECT_EQ(8, *reinterpret_cast<const int32_t*>(field(record, converted1, "number", isNull)));
+    field(record, converted1, "largenumber", isNull);
+    EXPECT_TRUE(isNull);
+}
+
+/**
+ * @class SchemaHistory
+ * @test Check if changing the type or NULL constraint of an existing field is rejected
+ */
+TEST_F(SchemaHistoryTest, Invalid) {
+    SchemaHistory history(mSchema);
+
+    auto schema = mSchema;
+    ASSERT_TRUE(schema.removeField("number"));
+    ASSERT_TRUE(schema.addField(FieldType::BIGINT, "number", true));
+    EXPECT_EQ(error::invalid_schema_change, history.checkVersion(schema));
+    EXPECT_EQ(error::invalid_schema_change, history.addVersion(schema));
+
+    schema = mSchema;
+    ASSERT_TRUE(schema.removeField("largenumber"));
+    ASSERT_TRUE(schema.addField(FieldType::BIGINT, "largenumber", true));
+    EXPECT_EQ(error::invalid_schema_change, history.addVersion(schema));
+
+    EXPECT_FALSE(schema.removeField("nonexisting"));
+    EXPECT_EQ(0u, history.newestVersion());
+}
+
+/**
+ * @class SchemaHistory
+ * @test Check if changing the partitioning of the table is rejected
+ */
+TEST_F(SchemaHistoryTest, Partitioning) {
+    mSchema.setPartitioning(PartitionSpec::range({100u, 200u}));
+    SchemaHistory history(mSchema);
+
+    auto schema = mSchema;
+    schema.setPartitioning(PartitionSpec::hash());
+    EXPECT_EQ(error::invalid_schema_change, history.checkVersion(schema));
+    EXPECT_EQ(error::invalid_schema_change, history.addVersion(schema));
+
+    schema.setPartitioning(PartitionSpec::range({100u, 300u}));
+    EXPECT_EQ(error::invalid_schema_change, history.addVersion(schema));
+
+    schema.setPartitioning(PartitionSpec::range({100u, 200u}));
+    EXPECT_EQ(0, history.addVersion(schema));
+}
+
+/**
+ * @class SchemaHistory
+ * @test Check if validating a schema change does not add a version
+ */
+TEST_F(SchemaHistoryTest, CheckOnly) {
+    SchemaHistory history(mSchema);
+
+    auto schema = mSchema;
+    ASSERT_TRUE(schema.removeField("text1"));
+    EXPECT_EQ(0, history.checkVersion(schema));
+    EXPECT_EQ(0u, history.newestVersion());
+
+    ASSERT_EQ(0, history.addVersion(schema));
+    EXPECT_EQ(1u, history.newestVersion());
+}
+
+} // anonymous namespace
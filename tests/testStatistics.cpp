@@ -0,0 +1,231 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include <tellstore/Statistics.hpp>
+
+#include <crossbow/byte_buffer.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+using namespace tell::store;
+
+namespace {
+
+/**
+ * @class LatencyBuckets
+ * @test Check if every value is placed in a bucket whose bounds contain the value with at most 1/16 relative error
+ */
+TEST(StatisticsTest, BucketBounds) {
+    for (uint64_t value = 0; value < (1ull << 20); value = value * 5 / 4 + 1) {
+        auto bucket = LatencyBuckets::bucketOf(value);
+        ASSERT_LT(bucket, LatencyBuckets::BUCKET_COUNT);
+        EXPECT_LE(LatencyBuckets::lowerBound(bucket), value);
+        EXPECT_GE(LatencyBuckets::upperBound(bucket), value);
+        EXPECT_LE(LatencyBuckets::upperBound(bucket) - LatencyBuckets::lowerBound(bucket), value / 16);
+    }
+
+    EXPECT_EQ(LatencyBuckets::BUCKET_COUNT - 1u, LatencyBuckets::bucketOf(std::numeric_limits<uint64_t>::max()));
+}
+
+/**
+ * @class LatencyDistribution
+ * @test Check if percentiles and mean of a recorded histogram are within the bucket precision
+ */
+TEST(StatisticsTest, Percentile) {
+    LatencyHistogram histogram;
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        histogram.record(value * 1000);
+    }
+
+    LatencyDistribution distribution;
+    histogram.collect(distribution);
+    EXPECT_EQ(1000u, distribution.count());
+
+    auto median = distribution.percentile(0.5);
+    EXPECT_GE(median, 500000u);
+    EXPECT_LE(median, 500000u + 500000u / 16);
+
+    auto p99 = distribution.percentile(0.99);
+    EXPECT_GE(p99, 990000u);
+    EXPECT_LE(p99, 990000u + 990000u / 16);
+
+    EXPECT_NEAR(500500.0, distribution.mean(), 500500.0 / 16);
+}
+
+/**
+ * @class ServerStatistics
+ * @test Check if merged statistics survive a serialization roundtrip
+ */
+TEST(StatisticsTest, SerializeMerged) {
+    LatencyHistogram first;
+    first.record(100u);
+    first.record(200u);
+    LatencyHistogram second;
+    second.record(100u);
+    second.record(1000000u);
+
+    ServerStatistics statistics;
+    first.collect(statistics.distribution(StatisticsKind::TABLE, 7u));
+    second.collect(statistics.distribution(StatisticsKind::TABLE, 7u));
+    second.collect(statistics.distribution(StatisticsKind::SCAN_PHASE, 2u));
+
+    auto length = statistics.serializedLength();
+    std::unique_ptr<char[]> data(new char[length]);
+    crossbow::buffer_writer writer(data.get(), length);
+    statistics.serialize(writer);
+    EXPECT_EQ(data.get() + length, writer.data());
+
+    crossbow::buffer_reader reader(data.get(), length);
+    auto result = ServerStatistics::deserialize(reader);
+    ASSERT_EQ(2u, result.distributions().size());
+
+    auto& table = result.distribution(StatisticsKind::TABLE, 7u);
+    EXPECT_EQ(4u, table.count());
+    EXPECT_EQ(LatencyBuckets::upperBound(LatencyBuckets::bucketOf(100u)), table.percentile(0.5));
+
+    auto& scan = result.distribution(StatisticsKind::SCAN_PHASE, 2u);
+    EXPECT_EQ(2u, scan.count());
+    EXPECT_EQ(LatencyBuckets::upperBound(LatencyBuckets::bucketOf(1000000u)), scan.percentile(1.0));
+}
+
+/**
+ * @class ServerStatistics
+ * @test Check if truncating drops the tables with the fewest requests until the statistics fit
+ */
+TEST(StatisticsTest, TruncateTables) {
+    ServerStatistics statistics;
+    for (uint64_t tableId = 1u; tableId <= 4u; ++tableId) {
+        LatencyHistogram histogram;
+        for (uint64_t i = 0u; i < tableId; ++i) {
+            histogram.record(100u);
+        }
+        histogram.collect(statistics.distribution(StatisticsKind::TABLE, tableId));
+    }
+    LatencyHistogram request;
+    request.record(100u);
+    request.collect(statistics.distribution(StatisticsKind::REQUEST, 1u));
+
+    auto length = statistics.serializedLength();
+    EXPECT_EQ(0u, statistics.truncateTables(length));
+    EXPECT_EQ(5u, statistics.distributions().size());
+
+    // All table distributions have the same serialized length
+    auto entryLength = (length - ServerStatistics().serializedLength()) / 5u;
+    EXPECT_EQ(2u, statistics.truncateTables(length - entryLength - 1u));
+    EXPECT_LE(statistics.serializedLength(), length - entryLength - 1u);
+
+    auto& distributions = statistics.distributions();
+    EXPECT_EQ(0u, distributions.count(std::make_pair(StatisticsKind::TABLE, 1u)));
+    EXPECT_EQ(0u, distributions.count(std::make_pair(StatisticsKind::TABLE, 2u)));
+    EXPECT_EQ(1u, distributions.count(std::make_pair(StatisticsKind::TABLE, 3u)));
+    EXPECT_EQ(1u, distributions.count(std::make_pair(StatisticsKind::TABLE, 4u)));
+
+    // Other distributions are never dropped
+    EXPECT_EQ(2u, statistics.truncateTables(0u));
+    EXPECT_EQ(1u, statistics.distributions().size());
+}
+
+/**
+ * @class ServerStatistics
+ * @test Check if merged performance counters survive a serialization roundtrip
+ */
+TEST(StatisticsTest, SerializePerfCounters) {
+    PerfCounterSample sample;
+    sample.runs = 1u;
+    sample.cycles = 4000u;
+    sample.instructions = 6000u;
+    sample.llcMisses = 20u;
+    sample.dtlbMisses = 3u;
+    sample.tuples = 100u;
+    sample.pages = 2u;
+
+    ServerStatistics statistics;
+    statistics.perfCounter(PerfCounterSource::SCAN) += sample;
+    statistics.perfCounter(PerfCounterSource::GC) += sample;
+
+    ServerStatistics other;
+    LatencyHistogram histogram;
+    histogram.record(100u);
+    histogram.collect(other.distribution(StatisticsKind::REQUEST, 1u));
+    other.perfCounter(PerfCounterSource::SCAN) += sample;
+    statistics.merge(other);
+
+    auto length = statistics.serializedLength();
+    std::unique_ptr<char[]> data(new char[length]);
+    crossbow::buffer_writer writer(data.get(), length);
+    statistics.serialize(writer);
+    EXPECT_EQ(data.get() + length, writer.data());
+
+    crossbow::buffer_reader reader(data.get(), length);
+    auto result = ServerStatistics::deserialize(reader);
+    ASSERT_EQ(1u, result.distributions().size());
+    ASSERT_EQ(2u, result.perfCounters().size());
+
+    auto& scan = result.perfCounter(PerfCounterSource::SCAN);
+    EXPECT_EQ(2u, scan.runs);
+    EXPECT_EQ(8000u, scan.cycles);
+    EXPECT_EQ(12000u, scan.instructions);
+    EXPECT_EQ(200u, scan.tuples);
+    EXPECT_DOUBLE_EQ(40.0, scan.perTuple(scan.cycles));
+    EXPECT_DOUBLE_EQ(10.0, scan.perPage(scan.llcMisses));
+
+    auto& gc = result.perfCounter(PerfCounterSource::GC);
+    EXPECT_EQ(1u, gc.runs);
+    EXPECT_EQ(3u, gc.dtlbMisses);
+    EXPECT_EQ(2u, gc.pages);
+}
+
+/**
+ * @class MemoryUsage
+ * @test Check if merged memory usages survive a serialization roundtrip
+ */
+TEST(StatisticsTest, SerializeMemoryUsage) {
+    MemoryUsage usage;
+    usage.add(1u, MemoryCategory::MAIN_PAGE, 100u);
+    usage.add(1u, MemoryCategory::INSERT_LOG, 20u);
+
+    MemoryUsage other;
+    other.add(1u, MemoryCategory::MAIN_PAGE, 50u);
+    other.add(0u, MemoryCategory::SCAN_BUFFER, 7u);
+    usage.merge(other);
+
+    auto length = usage.serializedLength();
+    std::unique_ptr<char[]> data(new char[length]);
+    crossbow::buffer_writer writer(data.get(), length);
+    usage.serialize(writer);
+    EXPECT_EQ(data.get() + length, writer.data());
+
+    crossbow::buffer_reader reader(data.get(), length);
+    auto result = MemoryUsage::deserialize(reader);
+    EXPECT_EQ(3u, result.entries().size());
+    EXPECT_EQ(150u, result.get(1u, MemoryCategory::MAIN_PAGE));
+    EXPECT_EQ(170u, result.table(1u));
+    EXPECT_EQ(7u, result.category(MemoryCategory::SCAN_BUFFER));
+    EXPECT_EQ(0u, result.table(2u));
+}
+
+} // anonymous namespace
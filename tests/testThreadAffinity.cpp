@@ -0,0 +1,69 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include <util/ThreadAffinity.hpp>
+
+#include <gtest/gtest.h>
+
+#include <sched.h>
+
+#include <stdexcept>
+#include <vector>
+
+using namespace tell::store;
+
+namespace {
+
+/**
+ * @test Check if single cores and core ranges are parsed in order
+ */
+TEST(ThreadAffinityTest, ParseCoreList) {
+    EXPECT_TRUE(parseCoreList("").empty());
+    EXPECT_EQ(std::vector<unsigned>({3u}), parseCoreList("3"));
+    EXPECT_EQ(std::vector<unsigned>({0u, 2u, 4u, 5u, 6u, 7u}), parseCoreList("0,2,4-7"));
+    EXPECT_EQ(std::vector<unsigned>({8u, 1u}), parseCoreList("8,1-1"));
+}
+
+/**
+ * @test Check if malformed core lists are rejected
+ */
+TEST(ThreadAffinityTest, ParseInvalidCoreList) {
+    EXPECT_THROW(parseCoreList("a"), std::invalid_argument);
+    EXPECT_THROW(parseCoreList("1,"), std::invalid_argument);
+    EXPECT_THROW(parseCoreList("4-2"), std::invalid_argument);
+    EXPECT_THROW(parseCoreList("-1"), std::invalid_argument);
+    EXPECT_THROW(parseCoreList("100000"), std::invalid_argument);
+}
+
+/**
+ * @test Check if the calling thread is only pinned when cores are configured
+ */
+TEST(ThreadAffinityTest, PinCurrentThread) {
+    EXPECT_FALSE(pinCurrentThread(std::vector<unsigned>(), 0u));
+
+    // The core the thread currently runs on is always allowed
+    auto core = static_cast<unsigned>(sched_getcpu());
+    EXPECT_TRUE(pinCurrentThread(std::vector<unsigned>({core}), 3u));
+}
+
+} // anonymous namespace
@@ -0,0 +1,143 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include <tellstore/Record.hpp>
+#include <tellstore/TupleBinding.hpp>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+using namespace tell::store;
+
+namespace {
+
+class TupleBindingTest : public ::testing::Test {
+protected:
+    TupleBindingTest()
+            : mSchema(TableType::TRANSACTIONAL) {
+        mSchema.addField(FieldType::INT, "number", true);
+        mSchema.addField(FieldType::BIGINT, "largenumber", false);
+        mSchema.addField(FieldType::TEXT, "text1", true);
+        mSchema.addField(FieldType::TEXT, "text2", false);
+        mRecord = Record(mSchema);
+    }
+
+    Schema mSchema;
+    Record mRecord;
+};
+
+/**
+ * @class TupleBinding
+ * @test Check if the typed writer produces the same record as the generic tuple path
+ */
+TEST_F(TupleBindingTest, WriterMatchesGenericTuple) {
+    TypedField<int32_t> number(mRecord, "number");
+    TypedField<int64_t> largenumber(mRecord, "largenumber");
+    TypedField<crossbow::string> text1(mRecord, "text1");
+    TypedField<crossbow::string> text2(mRecord, "text2");
+
+    crossbow::string text1Value("Bacon ipsum dolor amet");
+    crossbow::string text2Value("Chuck pork loin ham hock");
+
+    TupleWriter writer(mRecord);
+    writer.set(number, 12);
+    writer.set(largenumber, int64_t(0x7FFFFFFF00000001));
+    writer.set(text1, text1Value);
+    writer.set(text2, text2Value);
+
+    GenericTuple tuple({
+        std::make_pair(crossbow::string("number"), boost::any(int32_t(12))),
+        std::make_pair(crossbow::string("largenumber"), boost::any(int64_t(0x7FFFFFFF00000001))),
+        std::make_pair(crossbow::string("text1"), boost::any(text1Value)),
+        std::make_pair(crossbow::string("text2"), boost::any(text2Value))
+    });
+    ASSERT_EQ(mRecord.sizeOfTuple(tuple), writer.size());
+
+    std::unique_ptr<char[]> data(new char[writer.size()]);
+    writer.serialize(data.get());
+    EXPECT_EQ(writer.size(), mRecord.sizeOfTuple(data.get()));
+
+    EXPECT_FALSE(largenumber.isNull(data.get()));
+    EXPECT_FALSE(text2.isNull(data.get()));
+    EXPECT_EQ(12, number.get(data.get()));
+    EXPECT_EQ(int64_t(0x7FFFFFFF00000001), largenumber.get(data.get()));
+    EXPECT_EQ(text1Value, text1.get(data.get()));
+    EXPECT_EQ(text2Value, text2.get(data.get()));
+
+    TypedField<boost::string_ref> text2Ref(mRecord, "text2");
+    auto ref = text2Ref.get(data.get());
+    EXPECT_EQ(text2Value, crossbow::string(ref.data(), ref.size()));
+    EXPECT_GE(ref.data(), data.get());
+    EXPECT_LT(ref.data(), data.get() + writer.size());
+}
+
+/**
+ * @class TupleBinding
+ * @test Check if unset nullable fields are NULL and the writer can be reused after clear
+ */
+TEST_F(TupleBindingTest, NullFields) {
+    TypedField<int32_t> number(mRecord, "number");
+    TypedField<int64_t> largenumber(mRecord, "largenumber");
+    TypedField<crossbow::string> text1(mRecord, "text1");
+    TypedField<crossbow::string> text2(mRecord, "text2");
+
+    crossbow::string text1Value("Bacon ipsum dolor amet");
+    crossbow::string text2Value("Chuck pork loin ham hock");
+
+    TupleWriter writer(mRecord);
+    writer.set(number, 12);
+    writer.set(largenumber, int64_t(14));
+    writer.set(text1, text1Value);
+    writer.set(text2, text2Value);
+    writer.setNull(largenumber);
+    writer.setNull(text2);
+
+    std::unique_ptr<char[]> data(new char[writer.size()]);
+    writer.serialize(data.get());
+    EXPECT_TRUE(largenumber.isNull(data.get()));
+    EXPECT_TRUE(text2.isNull(data.get()));
+    EXPECT_EQ(text1Value, text1.get(data.get()));
+    EXPECT_EQ(0u, text2.get(data.get()).size());
+
+    writer.clear();
+    writer.set(number, 13);
+    writer.set(text1, text2Value);
+    data.reset(new char[writer.size()]);
+    writer.serialize(data.get());
+    EXPECT_EQ(13, number.get(data.get()));
+    EXPECT_TRUE(largenumber.isNull(data.get()));
+    EXPECT_EQ(text2Value, text1.get(data.get()));
+}
+
+/**
+ * @class TupleBinding
+ * @test Check if binding to a missing field or with the wrong type fails
+ */
+TEST_F(TupleBindingTest, InvalidBinding) {
+    EXPECT_THROW(TypedField<int32_t>(mRecord, "foo"), std::logic_error);
+    EXPECT_THROW(TypedField<int64_t>(mRecord, "number"), std::logic_error);
+    EXPECT_THROW(TypedField<crossbow::string>(mRecord, "largenumber"), std::logic_error);
+}
+
+} // anonymous namespace
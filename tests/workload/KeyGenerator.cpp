@@ -0,0 +1,111 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include "KeyGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace tell {
+namespace store {
+namespace {
+
+/**
+ * @brief 64 bit FNV-1a hash used to scatter the Zipfian ranks across the key space
+ */
+uint64_t fnvHash(uint64_t value) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (int i = 0; i < 8; ++i) {
+        hash ^= (value & 0xFFu);
+        hash *= 0x100000001B3ull;
+        value >>= 8;
+    }
+    return hash;
+}
+
+} // anonymous namespace
+
+ZipfianGenerator::ZipfianGenerator(uint64_t numItems, double theta)
+        : mNumItems(numItems),
+          mTheta(theta),
+          mAlpha(1.0 / (1.0 - theta)),
+          mZetaN(zeta(numItems, theta)),
+          mEta((1.0 - std::pow(2.0 / static_cast<double>(numItems), 1.0 - theta)) / (1.0 - zeta(2, theta) / mZetaN)) {
+    if (numItems < 2u) {
+        throw std::invalid_argument("Zipfian distribution needs at least 2 items");
+    }
+    if (theta <= 0.0 || theta >= 1.0) {
+        throw std::invalid_argument("Zipfian theta must be in the range (0, 1)");
+    }
+}
+
+uint64_t ZipfianGenerator::next(std::mt19937_64& random) const {
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    auto u = distribution(random);
+    auto uz = u * mZetaN;
+    if (uz < 1.0) {
+        return 0u;
+    }
+    if (uz < 1.0 + std::pow(0.5, mTheta)) {
+        return 1u;
+    }
+    auto rank = static_cast<uint64_t>(static_cast<double>(mNumItems) * std::pow(mEta * u - mEta + 1.0, mAlpha));
+    return std::min(rank, mNumItems - 1);
+}
+
+double ZipfianGenerator::zeta(uint64_t n, double theta) {
+    double sum = 0.0;
+    for (uint64_t i = 1; i <= n; ++i) {
+        sum += 1.0 / std::pow(static_cast<double>(i), theta);
+    }
+    return sum;
+}
+
+KeyGenerator::KeyGenerator(KeyDistribution distribution, uint64_t numKeys, double theta)
+        : mDistribution(theta > 0.0 ? distribution : KeyDistribution::UNIFORM),
+          mNumKeys(numKeys),
+          mZipfian(std::max(numKeys, uint64_t(2u)), (theta > 0.0 ? theta : 0.5)) {
+}
+
+uint64_t KeyGenerator::next(std::mt19937_64& random, uint64_t latest) const {
+    switch (mDistribution) {
+    case KeyDistribution::UNIFORM: {
+        std::uniform_int_distribution<uint64_t> distribution(1u, latest);
+        return distribution(random);
+    }
+
+    case KeyDistribution::ZIPFIAN: {
+        return (fnvHash(mZipfian.next(random)) % std::min(mNumKeys, latest)) + 1;
+    }
+
+    case KeyDistribution::LATEST: {
+        auto rank = mZipfian.next(random);
+        return (rank < latest ? latest - rank : 1u);
+    }
+    }
+    return 1u;
+}
+
+} // namespace store
+} // namespace tell
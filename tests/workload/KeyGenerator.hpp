@@ -0,0 +1,103 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Generates ranks following a Zipfian distribution
+ *
+ * Implements the algorithm from "Quickly Generating Billion-Record Synthetic Databases" (Gray et al.) as used by YCSB.
+ * Rank 0 is the most popular item, the skew is controlled by the theta parameter in the range (0, 1).
+ */
+class ZipfianGenerator {
+public:
+    ZipfianGenerator(uint64_t numItems, double theta);
+
+    uint64_t numItems() const {
+        return mNumItems;
+    }
+
+    /**
+     * @brief Draws the next rank in the range [0, numItems)
+     */
+    uint64_t next(std::mt19937_64& random) const;
+
+private:
+    static double zeta(uint64_t n, double theta);
+
+    uint64_t mNumItems;
+    double mTheta;
+    double mAlpha;
+    double mZetaN;
+    double mEta;
+};
+
+/**
+ * @brief Distribution of the keys accessed by a workload
+ */
+enum class KeyDistribution {
+    UNIFORM,
+
+    /// Zipfian distribution with the popular keys scattered across the key space
+    ZIPFIAN,
+
+    /// Zipfian distribution favoring the most recently inserted keys
+    LATEST,
+};
+
+/**
+ * @brief Chooses keys in the range [1, latest] according to a key distribution
+ *
+ * The skew of the Zipfian distributions is computed over the initial number of keys, keys inserted afterwards are only
+ * reachable through the LATEST distribution or when drawn uniformly.
+ */
+class KeyGenerator {
+public:
+    /**
+     * @param distribution Distribution of the generated keys
+     * @param numKeys Number of keys the distribution is computed over
+     * @param theta Skew of the Zipfian distributions (a theta of 0 selects the uniform distribution)
+     */
+    KeyGenerator(KeyDistribution distribution, uint64_t numKeys, double theta);
+
+    /**
+     * @brief Draws the next key
+     *
+     * @param random Random number generator of the calling thread
+     * @param latest The largest key currently in the key space
+     */
+    uint64_t next(std::mt19937_64& random, uint64_t latest) const;
+
+private:
+    KeyDistribution mDistribution;
+    uint64_t mNumKeys;
+    ZipfianGenerator mZipfian;
+};
+
+} // namespace store
+} // namespace tell
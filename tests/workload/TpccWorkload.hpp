@@ -0,0 +1,375 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include "Workload.hpp"
+
+#include <crossbow/string.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Simplified TPC-C like transaction mix
+ *
+ * Loads the warehouse, district, customer, item and stock tables and executes 45% New-Order, 43% Payment and 12%
+ * Order-Status transactions. Delivery and Stock-Level are left out as they require secondary indexes or range scans
+ * the storage interface does not provide. Every tuple carries a single counter value (next order id of a district,
+ * balance of a customer, quantity of a stock item...), New-Order and Payment conflict on the district tuples as in
+ * TPC-C.
+ */
+template <typename Storage>
+class TpccWorkload {
+public:
+    static constexpr uint64_t DISTRICTS_PER_WAREHOUSE = 10u;
+    static constexpr uint64_t CUSTOMERS_PER_DISTRICT = 3000u;
+    static constexpr uint64_t NUM_ITEMS = 100000u;
+    static constexpr uint64_t MAX_ORDER_LINES = 15u;
+
+    TpccWorkload(Storage& storage, DummyCommitManager& commitManager, const WorkloadConfig& config);
+
+    const std::string& name() const {
+        return mName;
+    }
+
+    void load();
+
+    void execute(size_t thread, std::mt19937_64& random, ThreadStatistics& statistics);
+
+private:
+    using WriteSet = std::vector<std::pair<const WorkloadTable*, uint64_t>>;
+
+    /// Warehouse, district, customer and item ids start at 1
+    static uint64_t districtKey(uint64_t warehouse, uint64_t district) {
+        return warehouse * DISTRICTS_PER_WAREHOUSE + district;
+    }
+
+    static uint64_t customerKey(uint64_t warehouse, uint64_t district, uint64_t customer) {
+        return districtKey(warehouse, district) * CUSTOMERS_PER_DISTRICT + customer;
+    }
+
+    static uint64_t stockKey(uint64_t warehouse, uint64_t item) {
+        return warehouse * NUM_ITEMS + item;
+    }
+
+    static uint64_t orderKey(uint64_t warehouse, uint64_t district, uint64_t order) {
+        return (districtKey(warehouse, district) << 32) | order;
+    }
+
+    static uint64_t orderLineKey(uint64_t order, uint64_t line) {
+        return (order << 4) | line;
+    }
+
+    bool newOrder(std::mt19937_64& random, std::vector<char>& tuple);
+
+    bool payment(std::mt19937_64& random, std::vector<char>& tuple);
+
+    bool orderStatus(std::mt19937_64& random, std::vector<char>& tuple);
+
+    /**
+     * @brief Updates the tuple with a new value and adds it to the write set
+     */
+    bool write(Transaction& tx, WriteSet& writes, const WorkloadTable& table, uint64_t key, int64_t value,
+            std::vector<char>& tuple);
+
+    bool insert(Transaction& tx, WriteSet& writes, const WorkloadTable& table, uint64_t key, int64_t value,
+            std::vector<char>& tuple);
+
+    /**
+     * @brief Reverts all writes of the transaction and aborts it
+     */
+    bool abort(Transaction& tx, WriteSet& writes);
+
+    Storage& mStorage;
+    DummyCommitManager& mCommitManager;
+    const WorkloadConfig& mConfig;
+    std::string mName;
+    crossbow::string mPayload;
+
+    WorkloadTable mWarehouse;
+    WorkloadTable mDistrict;
+    WorkloadTable mCustomer;
+    WorkloadTable mItem;
+    WorkloadTable mStock;
+    WorkloadTable mOrder;
+    WorkloadTable mOrderLine;
+
+    /// Tuple buffer of every worker thread
+    std::vector<std::vector<char>> mTuples;
+};
+
+template <typename Storage>
+TpccWorkload<Storage>::TpccWorkload(Storage& storage, DummyCommitManager& commitManager,
+        const WorkloadConfig& config)
+        : mStorage(storage),
+          mCommitManager(commitManager),
+          mConfig(config),
+          mName("tpcc"),
+          mPayload(config.recordSize, 't'),
+          mWarehouse(WorkloadTable::create(storage, "warehouse")),
+          mDistrict(WorkloadTable::create(storage, "district")),
+          mCustomer(WorkloadTable::create(storage, "customer")),
+          mItem(WorkloadTable::create(storage, "item")),
+          mStock(WorkloadTable::create(storage, "stock")),
+          mOrder(WorkloadTable::create(storage, "order")),
+          mOrderLine(WorkloadTable::create(storage, "orderline")),
+          mTuples(config.numThreads) {
+}
+
+template <typename Storage>
+void TpccWorkload<Storage>::load() {
+    auto numWarehouses = mConfig.numWarehouses;
+    loadTable(mStorage, mCommitManager, mConfig, mWarehouse, numWarehouses,
+            [] (uint64_t index, uint64_t& key, int64_t& value) {
+        key = index + 1;
+        value = 300000;
+    });
+    loadTable(mStorage, mCommitManager, mConfig, mDistrict, numWarehouses * DISTRICTS_PER_WAREHOUSE,
+            [] (uint64_t index, uint64_t& key, int64_t& value) {
+        key = districtKey(index / DISTRICTS_PER_WAREHOUSE + 1, index % DISTRICTS_PER_WAREHOUSE + 1);
+        value = 1;
+    });
+    loadTable(mStorage, mCommitManager, mConfig, mCustomer,
+            numWarehouses * DISTRICTS_PER_WAREHOUSE * CUSTOMERS_PER_DISTRICT,
+            [] (uint64_t index, uint64_t& key, int64_t& value) {
+        auto district = index / CUSTOMERS_PER_DISTRICT;
+        key = customerKey(district / DISTRICTS_PER_WAREHOUSE + 1, district % DISTRICTS_PER_WAREHOUSE + 1,
+                index % CUSTOMERS_PER_DISTRICT + 1);
+        value = -10;
+    });
+    loadTable(mStorage, mCommitManager, mConfig, mItem, NUM_ITEMS,
+            [] (uint64_t index, uint64_t& key, int64_t& value) {
+        key = index + 1;
+        value = static_cast<int64_t>(index % 10000) + 100;
+    });
+    loadTable(mStorage, mCommitManager, mConfig, mStock, numWarehouses * NUM_ITEMS,
+            [] (uint64_t index, uint64_t& key, int64_t& value) {
+        key = stockKey(index / NUM_ITEMS + 1, index % NUM_ITEMS + 1);
+        value = static_cast<int64_t>(index % 91) + 10;
+    });
+}
+
+template <typename Storage>
+void TpccWorkload<Storage>::execute(size_t thread, std::mt19937_64& random, ThreadStatistics& statistics) {
+    auto& tuple = mTuples[thread];
+
+    std::uniform_int_distribution<uint32_t> distribution(0u, 99u);
+    auto choice = distribution(random);
+    if (choice < 45u) {
+        measure(statistics, WorkloadOperation::NEW_ORDER, [this, &random, &tuple] () {
+            return newOrder(random, tuple);
+        });
+    } else if (choice < 88u) {
+        measure(statistics, WorkloadOperation::PAYMENT, [this, &random, &tuple] () {
+            return payment(random, tuple);
+        });
+    } else {
+        measure(statistics, WorkloadOperation::ORDER_STATUS, [this, &random, &tuple] () {
+            return orderStatus(random, tuple);
+        });
+    }
+}
+
+template <typename Storage>
+bool TpccWorkload<Storage>::newOrder(std::mt19937_64& random, std::vector<char>& tuple) {
+    auto warehouse = std::uniform_int_distribution<uint64_t>(1u, mConfig.numWarehouses)(random);
+    auto district = std::uniform_int_distribution<uint64_t>(1u, DISTRICTS_PER_WAREHOUSE)(random);
+    auto customer = std::uniform_int_distribution<uint64_t>(1u, CUSTOMERS_PER_DISTRICT)(random);
+    auto numLines = std::uniform_int_distribution<uint64_t>(5u, MAX_ORDER_LINES)(random);
+
+    // The items of an order must be distinct as the storage does not support writing a tuple twice in a transaction
+    std::uniform_int_distribution<uint64_t> itemDistribution(1u, NUM_ITEMS);
+    std::vector<uint64_t> items;
+    while (items.size() < numLines) {
+        auto item = itemDistribution(random);
+        if (std::find(items.begin(), items.end(), item) == items.end()) {
+            items.emplace_back(item);
+        }
+    }
+
+    WriteSet writes;
+    auto tx = mCommitManager.startTx();
+    if (mWarehouse.get(mStorage, warehouse, tx, tuple)) {
+        return abort(tx, writes);
+    }
+
+    auto dKey = districtKey(warehouse, district);
+    if (mDistrict.get(mStorage, dKey, tx, tuple)) {
+        return abort(tx, writes);
+    }
+    auto order = static_cast<uint64_t>(mDistrict.value(tuple));
+    if (!write(tx, writes, mDistrict, dKey, static_cast<int64_t>(order + 1), tuple)) {
+        return false;
+    }
+
+    if (mCustomer.get(mStorage, customerKey(warehouse, district, customer), tx, tuple)) {
+        return abort(tx, writes);
+    }
+
+    auto oKey = orderKey(warehouse, district, order);
+    for (uint64_t line = 0; line < numLines; ++line) {
+        auto item = items[line];
+        if (mItem.get(mStorage, item, tx, tuple)) {
+            return abort(tx, writes);
+        }
+
+        auto sKey = stockKey(warehouse, item);
+        if (mStock.get(mStorage, sKey, tx, tuple)) {
+            return abort(tx, writes);
+        }
+        auto quantity = mStock.value(tuple);
+        auto orderQuantity = std::uniform_int_distribution<int64_t>(1, 10)(random);
+        quantity = (quantity >= orderQuantity + 10 ? quantity - orderQuantity : quantity - orderQuantity + 91);
+        if (!write(tx, writes, mStock, sKey, quantity, tuple)) {
+            return false;
+        }
+
+        if (!insert(tx, writes, mOrderLine, orderLineKey(oKey, line + 1), static_cast<int64_t>(item), tuple)) {
+            return false;
+        }
+    }
+
+    if (!insert(tx, writes, mOrder, oKey, static_cast<int64_t>(customer), tuple)) {
+        return false;
+    }
+
+    tx.commit();
+    return true;
+}
+
+template <typename Storage>
+bool TpccWorkload<Storage>::payment(std::mt19937_64& random, std::vector<char>& tuple) {
+    auto warehouse = std::uniform_int_distribution<uint64_t>(1u, mConfig.numWarehouses)(random);
+    auto district = std::uniform_int_distribution<uint64_t>(1u, DISTRICTS_PER_WAREHOUSE)(random);
+    auto customer = std::uniform_int_distribution<uint64_t>(1u, CUSTOMERS_PER_DISTRICT)(random);
+    auto amount = std::uniform_int_distribution<int64_t>(1, 5000)(random);
+
+    WriteSet writes;
+    auto tx = mCommitManager.startTx();
+    if (mWarehouse.get(mStorage, warehouse, tx, tuple)) {
+        return abort(tx, writes);
+    }
+    if (!write(tx, writes, mWarehouse, warehouse, mWarehouse.value(tuple) + amount, tuple)) {
+        return false;
+    }
+
+    // The district keeps its next order id but is rewritten to model the district year-to-date update
+    auto dKey = districtKey(warehouse, district);
+    if (mDistrict.get(mStorage, dKey, tx, tuple)) {
+        return abort(tx, writes);
+    }
+    if (!write(tx, writes, mDistrict, dKey, mDistrict.value(tuple), tuple)) {
+        return false;
+    }
+
+    auto cKey = customerKey(warehouse, district, customer);
+    if (mCustomer.get(mStorage, cKey, tx, tuple)) {
+        return abort(tx, writes);
+    }
+    if (!write(tx, writes, mCustomer, cKey, mCustomer.value(tuple) - amount, tuple)) {
+        return false;
+    }
+
+    tx.commit();
+    return true;
+}
+
+template <typename Storage>
+bool TpccWorkload<Storage>::orderStatus(std::mt19937_64& random, std::vector<char>& tuple) {
+    auto warehouse = std::uniform_int_distribution<uint64_t>(1u, mConfig.numWarehouses)(random);
+    auto district = std::uniform_int_distribution<uint64_t>(1u, DISTRICTS_PER_WAREHOUSE)(random);
+    auto customer = std::uniform_int_distribution<uint64_t>(1u, CUSTOMERS_PER_DISTRICT)(random);
+
+    auto tx = mCommitManager.startTx(true);
+    mCustomer.get(mStorage, customerKey(warehouse, district, customer), tx, tuple);
+
+    // Read the most recent order of the district and its order lines
+    if (!mDistrict.get(mStorage, districtKey(warehouse, district), tx, tuple)) {
+        auto order = static_cast<uint64_t>(mDistrict.value(tuple));
+        if (order > 1u) {
+            auto oKey = orderKey(warehouse, district, order - 1);
+            if (!mOrder.get(mStorage, oKey, tx, tuple)) {
+                for (uint64_t line = 1; line <= MAX_ORDER_LINES; ++line) {
+                    if (mOrderLine.get(mStorage, orderLineKey(oKey, line), tx, tuple)) {
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    tx.commit();
+    return true;
+}
+
+template <typename Storage>
+bool TpccWorkload<Storage>::write(Transaction& tx, WriteSet& writes, const WorkloadTable& table, uint64_t key,
+        int64_t value, std::vector<char>& tuple) {
+    table.write(value, mPayload, tuple);
+    if (table.update(mStorage, key, tuple, tx)) {
+        return abort(tx, writes);
+    }
+    writes.emplace_back(&table, key);
+    return true;
+}
+
+template <typename Storage>
+bool TpccWorkload<Storage>::insert(Transaction& tx, WriteSet& writes, const WorkloadTable& table, uint64_t key,
+        int64_t value, std::vector<char>& tuple) {
+    table.write(value, mPayload, tuple);
+    if (table.insert(mStorage, key, tuple, tx)) {
+        return abort(tx, writes);
+    }
+    writes.emplace_back(&table, key);
+    return true;
+}
+
+template <typename Storage>
+bool TpccWorkload<Storage>::abort(Transaction& tx, WriteSet& writes) {
+    for (auto& write : writes) {
+        write.first->revert(mStorage, write.second, tx);
+    }
+    tx.abort();
+    return false;
+}
+
+template <typename Storage>
+constexpr uint64_t TpccWorkload<Storage>::DISTRICTS_PER_WAREHOUSE;
+
+template <typename Storage>
+constexpr uint64_t TpccWorkload<Storage>::CUSTOMERS_PER_DISTRICT;
+
+template <typename Storage>
+constexpr uint64_t TpccWorkload<Storage>::NUM_ITEMS;
+
+template <typename Storage>
+constexpr uint64_t TpccWorkload<Storage>::MAX_ORDER_LINES;
+
+} // namespace store
+} // namespace tell
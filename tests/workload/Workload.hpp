@@ -0,0 +1,223 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include "WorkloadStatistics.hpp"
+#include "WorkloadTable.hpp"
+
+#include "../DummyCommitManager.hpp"
+
+#include <util/PerfCounters.hpp>
+
+#include <tellstore/Statistics.hpp>
+
+#include <crossbow/string.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+struct WorkloadConfig {
+    /// Number of worker threads executing the workload
+    size_t numThreads = 4u;
+
+    /// Duration of the measurement in seconds
+    uint32_t duration = 30u;
+
+    /// Interval between two progress reports in seconds
+    uint32_t reportInterval = 1u;
+
+    /// Seed of the random number generators of the worker threads
+    uint64_t seed = 0x5EEDu;
+
+    /// Number of records loaded into the YCSB table
+    uint64_t numRecords = 1000000u;
+
+    /// Size of the payload of every tuple in bytes
+    uint32_t recordSize = 100u;
+
+    /// Skew of the Zipfian key distributions (0 selects a uniform distribution)
+    double theta = 0.99;
+
+    /// Maximum number of records read by a YCSB scan
+    uint32_t maxScanLength = 100u;
+
+    /// Number of warehouses loaded by the TPC-C like workload
+    uint64_t numWarehouses = 1u;
+};
+
+/**
+ * @brief Number of tuples inserted in a single transaction while loading a table
+ */
+constexpr uint64_t gLoadBatchSize = 1000u;
+
+/**
+ * @brief Populates a table with count tuples using multiple threads
+ *
+ * @param fun Function with the signature (uint64_t index, uint64_t& key, int64_t& value) producing the key and value of
+ *        the tuple with the given index
+ */
+template <typename Storage, typename Fun>
+void loadTable(Storage& storage, DummyCommitManager& commitManager, const WorkloadConfig& config,
+        const WorkloadTable& table, uint64_t count, Fun fun) {
+    crossbow::string payload(config.recordSize, 'x');
+    auto numThreads = std::max(std::min(config.numThreads, static_cast<size_t>(count / gLoadBatchSize)), size_t(1u));
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+    for (size_t thread = 0; thread < numThreads; ++thread) {
+        auto begin = (count * thread) / numThreads;
+        auto end = (count * (thread + 1)) / numThreads;
+        threads.emplace_back([&storage, &commitManager, &table, &payload, &fun, begin, end] () {
+            std::vector<char> tuple;
+            for (auto batch = begin; batch < end; batch += gLoadBatchSize) {
+                auto tx = commitManager.startTx();
+                for (auto i = batch; i < std::min(batch + gLoadBatchSize, end); ++i) {
+                    uint64_t key;
+                    int64_t value;
+                    fun(i, key, value);
+                    table.write(value, payload, tuple);
+                    if (auto ec = table.insert(storage, key, tuple, tx)) {
+                        throw std::runtime_error("Loading tuple " + std::to_string(key) + " failed with error "
+                                + std::to_string(ec));
+                    }
+                }
+                tx.commit();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Executes the workload for the configured duration and reports progress and the final result as JSON lines
+ *
+ * The workload has to provide a name() and an execute(thread, random, statistics) function executing a single
+ * operation or transaction. The storage garbage collector keeps running concurrently in the background.
+ */
+template <typename Storage, typename Workload>
+void runWorkload(Storage& storage, Workload& workload, const WorkloadConfig& config, std::ostream& out) {
+    WorkloadStatistics statistics(config.numThreads);
+    std::atomic<bool> running(true);
+
+    std::vector<std::thread> threads;
+    threads.reserve(config.numThreads);
+    for (size_t thread = 0; thread < config.numThreads; ++thread) {
+        threads.emplace_back([&workload, &config, &statistics, &running, thread] () {
+            std::mt19937_64 random(config.seed + thread);
+            auto& threadStatistics = statistics.thread(thread);
+            while (running.load()) {
+                workload.execute(thread, random, threadStatistics);
+            }
+        });
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    auto endTime = startTime + std::chrono::seconds(config.duration);
+    auto lastTime = startTime;
+    uint64_t lastCommits = 0u;
+    while (lastTime < endTime) {
+        auto nextTime = std::min(lastTime + std::chrono::seconds(std::max(config.reportInterval, 1u)), endTime);
+        std::this_thread::sleep_until(nextTime);
+
+        auto now = std::chrono::steady_clock::now();
+        auto commits = statistics.commits();
+        MemoryUsage usage;
+        storage.collectMemoryUsage(usage);
+
+        auto elapsed = std::chrono::duration<double>(now - startTime).count();
+        auto interval = std::chrono::duration<double>(now - lastTime).count();
+        out << "{\"type\":\"progress\""
+            << ",\"elapsed\":" << elapsed
+            << ",\"commits\":" << commits
+            << ",\"aborts\":" << statistics.aborts()
+            << ",\"ops_per_sec\":" << static_cast<uint64_t>(static_cast<double>(commits - lastCommits) / interval)
+            << ",\"memory\":";
+        WorkloadStatistics::printMemory(out, usage);
+        out << "}" << std::endl;
+
+        lastTime = now;
+        lastCommits = commits;
+    }
+
+    running.store(false);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    MemoryUsage usage;
+    storage.collectMemoryUsage(usage);
+    auto commits = statistics.commits();
+    out << "{\"type\":\"summary\""
+        << ",\"storage\":\"" << Storage::implementationName() << "\""
+        << ",\"workload\":\"" << workload.name() << "\""
+        << ",\"threads\":" << config.numThreads
+        << ",\"seconds\":" << seconds
+        << ",\"commits\":" << commits
+        << ",\"aborts\":" << statistics.aborts()
+        << ",\"ops_per_sec\":" << static_cast<uint64_t>(static_cast<double>(commits) / seconds)
+        << ",\"latency\":";
+    statistics.printLatency(out);
+    out << ",\"memory\":";
+    WorkloadStatistics::printMemory(out, usage);
+    if (perfCounters->enabled()) {
+        out << ",\"perf\":{\"scan\":";
+        WorkloadStatistics::printPerfCounters(out, perfCounters->total(PerfCounterSource::SCAN));
+        out << ",\"gc\":";
+        WorkloadStatistics::printPerfCounters(out, perfCounters->total(PerfCounterSource::GC));
+        out << "}";
+    }
+    out << "}" << std::endl;
+}
+
+/**
+ * @brief Measures the latency of a single operation and records it in the statistics
+ *
+ * @param fun Function executing the operation, returns false if the operation was aborted
+ */
+template <typename Fun>
+void measure(ThreadStatistics& statistics, WorkloadOperation operation, Fun fun) {
+    auto startTime = std::chrono::steady_clock::now();
+    if (!fun()) {
+        statistics.abort();
+        return;
+    }
+    auto endTime = std::chrono::steady_clock::now();
+    statistics.commit(operation, std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+}
+
+} // namespace store
+} // namespace tell
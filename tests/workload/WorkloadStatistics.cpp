@@ -0,0 +1,152 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include "WorkloadStatistics.hpp"
+
+namespace tell {
+namespace store {
+namespace {
+
+const char* memoryCategoryName(MemoryCategory category) {
+    switch (category) {
+    case MemoryCategory::FREE:
+        return "free";
+    case MemoryCategory::UNTAGGED:
+        return "untagged";
+    case MemoryCategory::MAIN_PAGE:
+        return "main_page";
+    case MemoryCategory::INSERT_LOG:
+        return "insert_log";
+    case MemoryCategory::UPDATE_LOG:
+        return "update_log";
+    case MemoryCategory::HASH_TABLE:
+        return "hash_table";
+    case MemoryCategory::LOG:
+        return "log";
+    case MemoryCategory::SCAN_BUFFER:
+        return "scan_buffer";
+    case MemoryCategory::INSERT_TABLE:
+        return "insert_table";
+    }
+    return "unknown";
+}
+
+} // anonymous namespace
+
+const char* operationName(WorkloadOperation operation) {
+    switch (operation) {
+    case WorkloadOperation::READ:
+        return "read";
+    case WorkloadOperation::UPDATE:
+        return "update";
+    case WorkloadOperation::INSERT:
+        return "insert";
+    case WorkloadOperation::SCAN:
+        return "scan";
+    case WorkloadOperation::READ_MODIFY_WRITE:
+        return "read_modify_write";
+    case WorkloadOperation::NEW_ORDER:
+        return "new_order";
+    case WorkloadOperation::PAYMENT:
+        return "payment";
+    case WorkloadOperation::ORDER_STATUS:
+        return "order_status";
+    }
+    return "unknown";
+}
+
+WorkloadStatistics::WorkloadStatistics(size_t numThreads) {
+    mThreads.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; ++i) {
+        mThreads.emplace_back(new ThreadStatistics());
+    }
+}
+
+uint64_t WorkloadStatistics::commits() const {
+    uint64_t result = 0u;
+    for (auto& thread : mThreads) {
+        result += thread->commits();
+    }
+    return result;
+}
+
+uint64_t WorkloadStatistics::aborts() const {
+    uint64_t result = 0u;
+    for (auto& thread : mThreads) {
+        result += thread->aborts();
+    }
+    return result;
+}
+
+void WorkloadStatistics::printMemory(std::ostream& out, const MemoryUsage& usage) {
+    out << "{";
+    for (uint8_t i = 0; i <= static_cast<uint8_t>(MemoryCategory::INSERT_TABLE); ++i) {
+        auto category = static_cast<MemoryCategory>(i);
+        out << (i == 0 ? "" : ",") << "\"" << memoryCategoryName(category) << "\":" << usage.category(category);
+    }
+    out << "}";
+}
+
+void WorkloadStatistics::printPerfCounters(std::ostream& out, const PerfCounterSample& sample) {
+    out << "{\"runs\":" << sample.runs
+        << ",\"tuples\":" << sample.tuples
+        << ",\"pages\":" << sample.pages
+        << ",\"cycles_per_tuple\":" << sample.perTuple(sample.cycles)
+        << ",\"instructions_per_tuple\":" << sample.perTuple(sample.instructions)
+        << ",\"llc_misses_per_tuple\":" << sample.perTuple(sample.llcMisses)
+        << ",\"dtlb_misses_per_tuple\":" << sample.perTuple(sample.dtlbMisses)
+        << ",\"cycles_per_page\":" << sample.perPage(sample.cycles)
+        << ",\"llc_misses_per_page\":" << sample.perPage(sample.llcMisses)
+        << ",\"dtlb_misses_per_page\":" << sample.perPage(sample.dtlbMisses)
+        << "}";
+}
+
+void WorkloadStatistics::printLatency(std::ostream& out) const {
+    out << "{";
+    auto first = true;
+    for (size_t i = 0; i < WORKLOAD_OPERATION_COUNT; ++i) {
+        auto operation = static_cast<WorkloadOperation>(i);
+        LatencyDistribution distribution;
+        for (auto& thread : mThreads) {
+            thread->collect(operation, distribution);
+        }
+        if (distribution.count() == 0u) {
+            continue;
+        }
+
+        out << (first ? "" : ",") << "\"" << operationName(operation) << "\":{"
+            << "\"count\":" << distribution.count()
+            << ",\"mean\":" << distribution.mean()
+            << ",\"p50\":" << distribution.percentile(0.5)
+            << ",\"p90\":" << distribution.percentile(0.9)
+            << ",\"p99\":" << distribution.percentile(0.99)
+            << ",\"p999\":" << distribution.percentile(0.999)
+            << ",\"max\":" << distribution.percentile(1.0)
+            << "}";
+        first = false;
+    }
+    out << "}";
+}
+
+} // namespace store
+} // namespace tell
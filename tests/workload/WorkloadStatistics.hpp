@@ -0,0 +1,135 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <tellstore/Statistics.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Operations and transactions executed by the workloads
+ */
+enum class WorkloadOperation : uint8_t {
+    READ = 0,
+    UPDATE,
+    INSERT,
+    SCAN,
+    READ_MODIFY_WRITE,
+    NEW_ORDER,
+    PAYMENT,
+    ORDER_STATUS,
+};
+
+constexpr size_t WORKLOAD_OPERATION_COUNT = static_cast<size_t>(WorkloadOperation::ORDER_STATUS) + 1;
+
+const char* operationName(WorkloadOperation operation);
+
+/**
+ * @brief Latencies and counters of the operations executed by a single worker thread
+ *
+ * Only the owning worker thread records into the statistics, the reporting thread reads them concurrently.
+ */
+class ThreadStatistics {
+public:
+    ThreadStatistics()
+            : mCommits(0u),
+              mAborts(0u) {
+    }
+
+    /**
+     * @brief Records a committed operation with its latency in nanoseconds
+     */
+    void commit(WorkloadOperation operation, uint64_t latency) {
+        mLatency[static_cast<size_t>(operation)].record(latency);
+        mCommits.store(mCommits.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Records an operation aborted due to a conflict
+     */
+    void abort() {
+        mAborts.store(mAborts.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+    }
+
+    uint64_t commits() const {
+        return mCommits.load(std::memory_order_relaxed);
+    }
+
+    uint64_t aborts() const {
+        return mAborts.load(std::memory_order_relaxed);
+    }
+
+    void collect(WorkloadOperation operation, LatencyDistribution& distribution) const {
+        mLatency[static_cast<size_t>(operation)].collect(distribution);
+    }
+
+private:
+    std::array<LatencyHistogram, WORKLOAD_OPERATION_COUNT> mLatency;
+    std::atomic<uint64_t> mCommits;
+    std::atomic<uint64_t> mAborts;
+};
+
+/**
+ * @brief Statistics of all worker threads of a workload run
+ */
+class WorkloadStatistics {
+public:
+    WorkloadStatistics(size_t numThreads);
+
+    ThreadStatistics& thread(size_t thread) {
+        return *mThreads[thread];
+    }
+
+    uint64_t commits() const;
+
+    uint64_t aborts() const;
+
+    /**
+     * @brief Writes the memory usage by category as JSON object
+     */
+    static void printMemory(std::ostream& out, const MemoryUsage& usage);
+
+    /**
+     * @brief Writes the hardware performance counters normalized per tuple and per page as JSON object
+     */
+    static void printPerfCounters(std::ostream& out, const PerfCounterSample& sample);
+
+    /**
+     * @brief Writes the latency distribution of all executed operation types as JSON object
+     */
+    void printLatency(std::ostream& out) const;
+
+private:
+    std::vector<std::unique_ptr<ThreadStatistics>> mThreads;
+};
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,52 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include "WorkloadTable.hpp"
+
+namespace tell {
+namespace store {
+
+Schema WorkloadTable::schema() {
+    Schema schema(TableType::TRANSACTIONAL);
+    schema.addField(FieldType::BIGINT, "value", true);
+    schema.addField(FieldType::TEXT, "data", true);
+    return schema;
+}
+
+WorkloadTable::WorkloadTable(uint64_t tableId, const Schema& schema)
+        : mTableId(tableId),
+          mRecord(schema),
+          mValue(mRecord, "value"),
+          mData(mRecord, "data") {
+}
+
+void WorkloadTable::write(int64_t value, const crossbow::string& data, std::vector<char>& tuple) const {
+    TupleWriter writer(mRecord);
+    writer.set(mValue, value);
+    writer.set(mData, data);
+    tuple.resize(writer.size());
+    writer.serialize(tuple.data());
+}
+
+} // namespace store
+} // namespace tell
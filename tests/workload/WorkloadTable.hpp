@@ -0,0 +1,121 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <tellstore/Record.hpp>
+#include <tellstore/TupleBinding.hpp>
+
+#include <commitmanager/SnapshotDescriptor.hpp>
+
+#include <crossbow/string.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Table accessed by the workloads
+ *
+ * All tables share the same schema: A BIGINT value modified by the transactions and a TEXT payload padding the tuple to
+ * the configured size.
+ */
+class WorkloadTable {
+public:
+    /**
+     * @brief Creates the table in the storage
+     */
+    template <typename Storage>
+    static WorkloadTable create(Storage& storage, const crossbow::string& name);
+
+    WorkloadTable(uint64_t tableId, const Schema& schema);
+
+    uint64_t id() const {
+        return mTableId;
+    }
+
+    /**
+     * @brief Serializes a tuple with the given value and payload into the buffer
+     */
+    void write(int64_t value, const crossbow::string& data, std::vector<char>& tuple) const;
+
+    /**
+     * @brief Reads the value of the serialized tuple
+     */
+    int64_t value(const std::vector<char>& tuple) const {
+        return mValue.get(tuple.data());
+    }
+
+    /**
+     * @brief Reads the tuple with the given key into the buffer
+     */
+    template <typename Storage>
+    int get(Storage& storage, uint64_t key, const commitmanager::SnapshotDescriptor& snapshot,
+            std::vector<char>& tuple) const {
+        return storage.get(mTableId, key, snapshot, [&tuple] (size_t size, uint64_t /* version */,
+                bool /* isNewest */) {
+            tuple.resize(size);
+            return tuple.data();
+        });
+    }
+
+    template <typename Storage>
+    int insert(Storage& storage, uint64_t key, const std::vector<char>& tuple,
+            const commitmanager::SnapshotDescriptor& snapshot) const {
+        return storage.insert(mTableId, key, tuple.size(), tuple.data(), snapshot, 0u);
+    }
+
+    template <typename Storage>
+    int update(Storage& storage, uint64_t key, const std::vector<char>& tuple,
+            const commitmanager::SnapshotDescriptor& snapshot) const {
+        return storage.update(mTableId, key, tuple.size(), tuple.data(), snapshot, 0u);
+    }
+
+    template <typename Storage>
+    int revert(Storage& storage, uint64_t key, const commitmanager::SnapshotDescriptor& snapshot) const {
+        return storage.revert(mTableId, key, snapshot);
+    }
+
+private:
+    static Schema schema();
+
+    uint64_t mTableId;
+    Record mRecord;
+    TypedField<int64_t> mValue;
+    TypedField<crossbow::string> mData;
+};
+
+template <typename Storage>
+WorkloadTable WorkloadTable::create(Storage& storage, const crossbow::string& name) {
+    auto tableSchema = schema();
+    uint64_t tableId;
+    if (!storage.createTable(name, tableSchema, tableId)) {
+        throw std::runtime_error("Unable to create table " + std::string(name.c_str(), name.size()));
+    }
+    return WorkloadTable(tableId, tableSchema);
+}
+
+} // namespace store
+} // namespace tell
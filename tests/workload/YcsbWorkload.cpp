@@ -0,0 +1,49 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include "YcsbWorkload.hpp"
+
+#include <stdexcept>
+
+namespace tell {
+namespace store {
+
+YcsbMix YcsbMix::fromName(const std::string& name) {
+    if (name == "ycsb-a") {
+        return YcsbMix{0.5, 0.5, 0.0, 0.0, 0.0, KeyDistribution::ZIPFIAN};
+    } else if (name == "ycsb-b") {
+        return YcsbMix{0.95, 0.05, 0.0, 0.0, 0.0, KeyDistribution::ZIPFIAN};
+    } else if (name == "ycsb-c") {
+        return YcsbMix{1.0, 0.0, 0.0, 0.0, 0.0, KeyDistribution::ZIPFIAN};
+    } else if (name == "ycsb-d") {
+        return YcsbMix{0.95, 0.0, 0.05, 0.0, 0.0, KeyDistribution::LATEST};
+    } else if (name == "ycsb-e") {
+        return YcsbMix{0.0, 0.0, 0.05, 0.95, 0.0, KeyDistribution::ZIPFIAN};
+    } else if (name == "ycsb-f") {
+        return YcsbMix{0.5, 0.0, 0.0, 0.0, 0.5, KeyDistribution::ZIPFIAN};
+    }
+    throw std::invalid_argument("Unknown YCSB workload " + name);
+}
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,221 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include "KeyGenerator.hpp"
+#include "Workload.hpp"
+
+#include <crossbow/string.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Operation proportions and key distribution of the YCSB core workloads
+ */
+struct YcsbMix {
+    /**
+     * @brief Returns the mix of the core workload with the given name ("ycsb-a" to "ycsb-f")
+     *
+     * @exception std::invalid_argument If the name does not denote a YCSB core workload
+     */
+    static YcsbMix fromName(const std::string& name);
+
+    double read;
+    double update;
+    double insert;
+    double scan;
+    double readModifyWrite;
+    KeyDistribution distribution;
+};
+
+/**
+ * @brief YCSB core workloads A to F against a single table
+ *
+ * Every operation executes in its own transaction. Scans read a short range of consecutive keys through point lookups
+ * as the storage has no ordered key index.
+ */
+template <typename Storage>
+class YcsbWorkload {
+public:
+    YcsbWorkload(Storage& storage, DummyCommitManager& commitManager, const WorkloadConfig& config,
+            const std::string& name);
+
+    const std::string& name() const {
+        return mName;
+    }
+
+    void load();
+
+    void execute(size_t thread, std::mt19937_64& random, ThreadStatistics& statistics);
+
+private:
+    bool read(uint64_t key, std::vector<char>& tuple);
+
+    bool update(uint64_t key, std::mt19937_64& random, std::vector<char>& tuple);
+
+    bool insert(std::vector<char>& tuple);
+
+    bool scan(uint64_t key, std::mt19937_64& random, std::vector<char>& tuple);
+
+    bool readModifyWrite(uint64_t key, std::vector<char>& tuple);
+
+    Storage& mStorage;
+    DummyCommitManager& mCommitManager;
+    const WorkloadConfig& mConfig;
+    std::string mName;
+    YcsbMix mMix;
+    WorkloadTable mTable;
+    KeyGenerator mKeys;
+    crossbow::string mPayload;
+
+    /// The next key to insert
+    std::atomic<uint64_t> mNextKey;
+
+    /// Tuple buffer of every worker thread
+    std::vector<std::vector<char>> mTuples;
+};
+
+template <typename Storage>
+YcsbWorkload<Storage>::YcsbWorkload(Storage& storage, DummyCommitManager& commitManager, const WorkloadConfig& config,
+        const std::string& name)
+        : mStorage(storage),
+          mCommitManager(commitManager),
+          mConfig(config),
+          mName(name),
+          mMix(YcsbMix::fromName(name)),
+          mTable(WorkloadTable::create(storage, "usertable")),
+          mKeys(mMix.distribution, config.numRecords, config.theta),
+          mPayload(config.recordSize, 'y'),
+          mNextKey(config.numRecords + 1),
+          mTuples(config.numThreads) {
+}
+
+template <typename Storage>
+void YcsbWorkload<Storage>::load() {
+    loadTable(mStorage, mCommitManager, mConfig, mTable, mConfig.numRecords,
+            [] (uint64_t index, uint64_t& key, int64_t& value) {
+        key = index + 1;
+        value = 0;
+    });
+}
+
+template <typename Storage>
+void YcsbWorkload<Storage>::execute(size_t thread, std::mt19937_64& random, ThreadStatistics& statistics) {
+    auto& tuple = mTuples[thread];
+    auto key = mKeys.next(random, mNextKey.load() - 1);
+
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    auto choice = distribution(random);
+    if ((choice -= mMix.read) < 0.0) {
+        measure(statistics, WorkloadOperation::READ, [this, key, &tuple] () {
+            return read(key, tuple);
+        });
+    } else if ((choice -= mMix.update) < 0.0) {
+        measure(statistics, WorkloadOperation::UPDATE, [this, key, &random, &tuple] () {
+            return update(key, random, tuple);
+        });
+    } else if ((choice -= mMix.insert) < 0.0) {
+        measure(statistics, WorkloadOperation::INSERT, [this, &tuple] () {
+            return insert(tuple);
+        });
+    } else if ((choice -= mMix.scan) < 0.0) {
+        measure(statistics, WorkloadOperation::SCAN, [this, key, &random, &tuple] () {
+            return scan(key, random, tuple);
+        });
+    } else {
+        measure(statistics, WorkloadOperation::READ_MODIFY_WRITE, [this, key, &tuple] () {
+            return readModifyWrite(key, tuple);
+        });
+    }
+}
+
+template <typename Storage>
+bool YcsbWorkload<Storage>::read(uint64_t key, std::vector<char>& tuple) {
+    auto tx = mCommitManager.startTx(true);
+    mTable.get(mStorage, key, tx, tuple);
+    tx.commit();
+    return true;
+}
+
+template <typename Storage>
+bool YcsbWorkload<Storage>::update(uint64_t key, std::mt19937_64& random, std::vector<char>& tuple) {
+    auto tx = mCommitManager.startTx();
+    mTable.write(static_cast<int64_t>(random()), mPayload, tuple);
+    if (mTable.update(mStorage, key, tuple, tx)) {
+        tx.abort();
+        return false;
+    }
+    tx.commit();
+    return true;
+}
+
+template <typename Storage>
+bool YcsbWorkload<Storage>::insert(std::vector<char>& tuple) {
+    auto tx = mCommitManager.startTx();
+    mTable.write(0, mPayload, tuple);
+    if (mTable.insert(mStorage, mNextKey.fetch_add(1), tuple, tx)) {
+        tx.abort();
+        return false;
+    }
+    tx.commit();
+    return true;
+}
+
+template <typename Storage>
+bool YcsbWorkload<Storage>::scan(uint64_t key, std::mt19937_64& random, std::vector<char>& tuple) {
+    std::uniform_int_distribution<uint64_t> lengthDistribution(1u, mConfig.maxScanLength);
+    auto end = std::min(key + lengthDistribution(random), mNextKey.load());
+
+    auto tx = mCommitManager.startTx(true);
+    for (auto i = key; i < end; ++i) {
+        mTable.get(mStorage, i, tx, tuple);
+    }
+    tx.commit();
+    return true;
+}
+
+template <typename Storage>
+bool YcsbWorkload<Storage>::readModifyWrite(uint64_t key, std::vector<char>& tuple) {
+    auto tx = mCommitManager.startTx();
+    if (mTable.get(mStorage, key, tx, tuple)) {
+        tx.abort();
+        return false;
+    }
+    mTable.write(mTable.value(tuple) + 1, mPayload, tuple);
+    if (mTable.update(mStorage, key, tuple, tx)) {
+        tx.abort();
+        return false;
+    }
+    tx.commit();
+    return true;
+}
+
+} // namespace store
+} // namespace tell
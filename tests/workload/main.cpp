@@ -0,0 +1,175 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <config.h>
+
+#include "TpccWorkload.hpp"
+#include "YcsbWorkload.hpp"
+
+#include "../DummyCommitManager.hpp"
+
+#include <deltamain/DeltaMainRewriteStore.hpp>
+#include <logstructured/LogstructuredMemoryStore.hpp>
+#include <util/PerfCounters.hpp>
+#include <util/StorageConfig.hpp>
+
+#include <crossbow/allocator.hpp>
+#include <crossbow/logger.hpp>
+#include <crossbow/program_options.hpp>
+#include <crossbow/string.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace tell::store;
+
+namespace {
+
+/**
+ * @brief Creates the workload tables, loads the initial data and executes the workload
+ *
+ * @param args Additional arguments passed to the constructor of the workload
+ */
+template <typename Storage, typename Workload, typename... Args>
+void executeWorkload(Storage& storage, DummyCommitManager& commitManager, const WorkloadConfig& config,
+        Args&&... args) {
+    std::unique_ptr<Workload> workload(new Workload(storage, commitManager, config, std::forward<Args>(args)...));
+
+    auto startTime = std::chrono::steady_clock::now();
+    workload->load();
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    MemoryUsage usage;
+    storage.collectMemoryUsage(usage);
+    std::cout << "{\"type\":\"load\""
+              << ",\"storage\":\"" << Storage::implementationName() << "\""
+              << ",\"workload\":\"" << workload->name() << "\""
+              << ",\"seconds\":" << seconds
+              << ",\"memory\":";
+    WorkloadStatistics::printMemory(std::cout, usage);
+    std::cout << "}" << std::endl;
+
+    runWorkload(storage, *workload, config, std::cout);
+}
+
+template <typename Storage>
+void executeStorage(const StorageConfig& storageConfig, const WorkloadConfig& config, const std::string& workload) {
+    Storage storage(storageConfig);
+    DummyCommitManager commitManager;
+
+    if (workload == "tpcc") {
+        executeWorkload<Storage, TpccWorkload<Storage>>(storage, commitManager, config);
+    } else {
+        executeWorkload<Storage, YcsbWorkload<Storage>>(storage, commitManager, config, workload);
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    StorageConfig storageConfig;
+    storageConfig.gcInterval = 1u;
+    WorkloadConfig config;
+    crossbow::string storage("rowstore");
+    crossbow::string workload("ycsb-a");
+    bool help = false;
+    crossbow::string logLevel("WARN");
+    bool perfCounters = false;
+
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'l'>("log-level", &logLevel),
+            crossbow::program_options::value<'s'>("storage", &storage),
+            crossbow::program_options::value<'w'>("workload", &workload),
+            crossbow::program_options::value<'t'>("threads", &config.numThreads),
+            crossbow::program_options::value<'d'>("duration", &config.duration),
+            crossbow::program_options::value<'r'>("records", &config.numRecords),
+            crossbow::program_options::value<'m'>("memory", &storageConfig.totalMemory),
+            crossbow::program_options::value<'c'>("capacity", &storageConfig.hashMapCapacity),
+            crossbow::program_options::value<-1>("gc-interval", &storageConfig.gcInterval,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-2>("report-interval", &config.reportInterval,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-3>("record-size", &config.recordSize,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-4>("theta", &config.theta,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-5>("scan-length", &config.maxScanLength,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-6>("warehouses", &config.numWarehouses,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-7>("seed", &config.seed,
+                    crossbow::program_options::tag::ignore_short<true>{}),
+            crossbow::program_options::value<-8>("perf-counters", &perfCounters,
+                    crossbow::program_options::tag::ignore_short<true>{}));
+
+    try {
+        crossbow::program_options::parse(opts, argc, argv);
+    } catch (crossbow::program_options::argument_not_found e) {
+        std::cerr << e.what() << std::endl << std::endl;
+        crossbow::program_options::print_help(std::cout, opts);
+        return 1;
+    }
+
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    crossbow::logger::logger->config.level = crossbow::logger::logLevelFromString(logLevel);
+
+    if (config.numThreads == 0u || config.numRecords == 0u || config.numWarehouses == 0u
+            || config.maxScanLength == 0u) {
+        std::cerr << "Threads, records, warehouses and scan length must be larger than zero" << std::endl;
+        return 1;
+    }
+
+    if (perfCounters) {
+        tell::store::perfCounters->enable();
+    }
+
+    // Initialize allocator
+    crossbow::allocator::init();
+
+    std::string workloadName(workload.c_str(), workload.size());
+    try {
+        if (storage == "rowstore") {
+            executeStorage<DeltaMainRewriteRowStore>(storageConfig, config, workloadName);
+        } else if (storage == "columnmap") {
+            executeStorage<DeltaMainRewriteColumnStore>(storageConfig, config, workloadName);
+        } else if (storage == "logstructured") {
+            executeStorage<LogstructuredMemoryStore>(storageConfig, config, workloadName);
+        } else {
+            std::cerr << "Unknown storage " << storage << std::endl;
+            return 1;
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -28,8 +28,9 @@
 namespace tell {
 namespace store {
 
-CuckooTable::CuckooTable(PageManager& pageManager)
+CuckooTable::CuckooTable(PageManager& pageManager, const MemoryTag& tag /* = MemoryTag() */)
     : mPageManager(pageManager)
+      , mTag(tag)
       , hash1(ENTRIES_PER_PAGE)
       , hash2(ENTRIES_PER_PAGE)
       , hash3(ENTRIES_PER_PAGE)
@@ -37,7 +38,7 @@ CuckooTable::CuckooTable(PageManager& pageManager)
 {
     mPages.reserve(3);
     for (size_t i = 0; i < 3; ++i) {
-        auto page = pageManager.alloc();
+        auto page = pageManager.alloc(mTag);
         if (!page) {
             LOG_ERROR("PageManager ran out of space");
             std::terminate();
@@ -56,16 +57,22 @@ void CuckooTable::destroy() {
 }
 
 const void* CuckooTable::get(uint64_t key) const {
-    unsigned cnt = 0;
-    for (auto& hasher : {hash1, hash2, hash3}) {
-        auto idx = hasher(key);
-        const EntryT& entry = at(cnt, idx);
-        if (entry.first == key) return entry.second;
-        ++cnt;
-    }
+    // Compute all three slots up front so the loads are issued back to back instead of one miss after the other
+    const EntryT& entry1 = at(0, hash1(key));
+    const EntryT& entry2 = at(1, hash2(key));
+    const EntryT& entry3 = at(2, hash3(key));
+    if (entry1.first == key) return entry1.second;
+    if (entry2.first == key) return entry2.second;
+    if (entry3.first == key) return entry3.second;
     return nullptr;
 }
 
+void CuckooTable::prefetch(uint64_t key) const {
+    __builtin_prefetch(&at(0, hash1(key)));
+    __builtin_prefetch(&at(1, hash2(key)));
+    __builtin_prefetch(&at(2, hash3(key)));
+}
+
 auto CuckooTable::at(unsigned h, size_t idx) const -> const EntryT& {
     auto tIdx = idx / ENTRIES_PER_PAGE;
     auto pIdx = idx - tIdx * ENTRIES_PER_PAGE;
@@ -77,12 +84,13 @@ Modifier CuckooTable::modifier() {
 }
 
 CuckooTable::CuckooTable(PageManager& pageManager,
+                         const MemoryTag& tag,
                          std::vector<EntryT*>&& pages,
                          cuckoo_hash_function hash1,
                          cuckoo_hash_function hash2,
                          cuckoo_hash_function hash3,
                          size_t size)
-    : mPageManager(pageManager), mPages(std::move(pages)), hash1(hash1), hash2(hash2), hash3(hash3), mSize(size) {
+    : mPageManager(pageManager), mTag(tag), mPages(std::move(pages)), hash1(hash1), hash2(hash2), hash3(hash3), mSize(size) {
 }
 
 size_t CuckooTable::capacity() const {
@@ -94,18 +102,12 @@ Modifier::~Modifier() {
         return;
     }
 
-    auto pages = std::move(mToDelete);
-    auto& pageManager = mTable.mPageManager;
-    crossbow::allocator::invoke([pages, &pageManager]() {
-        for (auto page : pages) {
-            pageManager.free(page);
-        }
-    });
+    mTable.mPageManager.retirePages(std::move(mToDelete));
 }
 
 CuckooTable* Modifier::done() const {
-    return crossbow::allocator::construct<CuckooTable>(mTable.mPageManager, std::move(mPages), hash1, hash2, hash3,
-            mSize);
+    return crossbow::allocator::construct<CuckooTable>(mTable.mPageManager, mTable.mTag, std::move(mPages), hash1,
+            hash2, hash3, mSize);
 }
 
 const void* Modifier::get(uint64_t key) const
@@ -227,7 +229,7 @@ bool Modifier::cow(unsigned h, size_t idx) {
     if (pageWasModified[3*idx + h]) return false;
     pageWasModified[3*idx + h] = true;
     auto oldPage = mPages[3*idx + h];
-    auto page = mTable.mPageManager.alloc();
+    auto page = mTable.mPageManager.alloc(mTable.mTag);
     if (!page) {
         LOG_ERROR("PageManager ran out of space");
         std::terminate();
@@ -256,7 +258,7 @@ void Modifier::rehash() {
     oldPages.swap(mPages);
     mPages.reserve(numPages);
     for (decltype(numPages) i = 0; i < numPages; ++i) {
-        auto page = mTable.mPageManager.alloc();
+        auto page = mTable.mPageManager.alloc(mTable.mTag);
         if (!page) {
             LOG_ERROR("PageManager ran out of space");
             std::terminate();
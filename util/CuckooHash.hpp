@@ -56,13 +56,14 @@ private:
     static_assert(isPowerOf2(ENTRIES_PER_PAGE), "Entries per page needs to be a power of two");
 
     PageManager& mPageManager;
+    MemoryTag mTag;
     std::vector<EntryT*> mPages;
     cuckoo_hash_function hash1;
     cuckoo_hash_function hash2;
     cuckoo_hash_function hash3;
     size_t mSize;
 public:
-    CuckooTable(PageManager& pageManager);
+    CuckooTable(PageManager& pageManager, const MemoryTag& tag = MemoryTag());
     ~CuckooTable();
 
     /**
@@ -85,6 +86,7 @@ public:
 
 private:
     CuckooTable(PageManager& pageManager,
+                const MemoryTag& tag,
                 std::vector<EntryT*>&& pages,
                 cuckoo_hash_function hash1,
                 cuckoo_hash_function hash2,
@@ -94,6 +96,13 @@ private:
 public:
     const void* get(uint64_t key) const;
 
+    /**
+     * @brief Issues prefetches for the three slots the key may be stored in
+     *
+     * Used by batched lookups to overlap the cache misses of several keys before any of them is resolved.
+     */
+    void prefetch(uint64_t key) const;
+
     void* get(uint64_t key) {
         return const_cast<void*>(const_cast<const CuckooTable*>(this)->get(key));
     }
@@ -23,33 +23,47 @@
 
 #include "LLVMJIT.hpp"
 
+#include <crossbow/logger.hpp>
+
 #include <llvm/ADT/STLExtras.h>
 #include <llvm/ADT/StringMap.h>
 #include <llvm/ExecutionEngine/Orc/CompileUtils.h>
 #include <llvm/ExecutionEngine/Orc/LambdaResolver.h>
 #include <llvm/ExecutionEngine/RuntimeDyld.h>
 #include <llvm/ExecutionEngine/SectionMemoryManager.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Module.h>
 #include <llvm/MC/SubtargetFeature.h>
+#include <llvm/Object/ObjectFile.h>
+#include <llvm/Object/SymbolSize.h>
 #include <llvm/Support/CodeGen.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/DynamicLibrary.h>
 #include <llvm/Support/Host.h>
 #include <llvm/Support/TargetRegistry.h>
 #include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Target/TargetOptions.h>
+#include <llvm/Transforms/Utils/Cloning.h>
 
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
+#include <unistd.h>
+
 namespace tell {
 namespace store {
 
 LLVMCompiler llvmCompiler;
 
 LLVMCompilerT::LLVMCompilerT()
-        : mTarget(nullptr) {
+        : mTarget(nullptr),
+          mPerfMap(false),
+          mDumpCounter(0u),
+          mPerfMapFile(nullptr) {
     std::array<const char*, 2> args = {{
         "tellstore",
         "--disable-lsr"
@@ -85,6 +99,30 @@ LLVMCompilerT::LLVMCompilerT()
     llvm::sys::DynamicLibrary::LoadLibraryPermanently(nullptr);
 }
 
+LLVMCompilerT::~LLVMCompilerT() {
+    if (mPerfMapFile != nullptr) {
+        std::fclose(mPerfMapFile);
+    }
+}
+
+void LLVMCompilerT::writePerfMap(uint64_t address, uint64_t size, const std::string& name) {
+    std::lock_guard<std::mutex> lock(mPerfMapMutex);
+    if (mPerfMapFile == nullptr) {
+        std::stringstream ss;
+        ss << "/tmp/perf-" << getpid() << ".map";
+        mPerfMapFile = std::fopen(ss.str().c_str(), "a");
+        if (mPerfMapFile == nullptr) {
+            LOG_ERROR("Unable to open perf map %1%", ss.str());
+            mPerfMap = false;
+            return;
+        }
+    }
+
+    std::fprintf(mPerfMapFile, "%lx %lx %s\n", static_cast<unsigned long>(address), static_cast<unsigned long>(size),
+            name.c_str());
+    std::fflush(mPerfMapFile);
+}
+
 std::unique_ptr<llvm::TargetMachine> LLVMCompilerT::createTargetMachine() {
     return std::unique_ptr<llvm::TargetMachine>(mTarget->createTargetMachine(mProcessTriple, mHostCPUName, mFeatures,
             mOptions, llvm::Reloc::Default, llvm::CodeModel::JITDefault, llvm::CodeGenOpt::Aggressive));
@@ -93,12 +131,18 @@ std::unique_ptr<llvm::TargetMachine> LLVMCompilerT::createTargetMachine() {
 LLVMJIT::LLVMJIT()
         : mTargetMachine(llvmCompiler->createTargetMachine()),
           mDataLayout(mTargetMachine->createDataLayout()),
+          mObjectLayer(PerfMapNotifier(*this)),
           mCompileLayer(mObjectLayer, llvm::orc::SimpleCompiler(*mTargetMachine)) {
 }
 
 LLVMJIT::~LLVMJIT() = default;
 
 LLVMJIT::ModuleHandle LLVMJIT::addModule(llvm::Module* module) {
+    mModuleName = module->getModuleIdentifier();
+    if (!llvmCompiler->dumpDirectory().empty()) {
+        dumpModule(*module);
+    }
+
     auto resolver = llvm::orc::createLambdaResolver([this] (const std::string& name) {
         if (auto sym = mCompileLayer.findSymbol(name, true)) {
             return llvm::RuntimeDyld::SymbolInfo(sym.getAddress(), sym.getFlags());
@@ -116,5 +160,60 @@ LLVMJIT::ModuleHandle LLVMJIT::addModule(llvm::Module* module) {
     return handle;
 }
 
+void LLVMJIT::registerObject(const llvm::object::ObjectFile& object,
+        const llvm::RuntimeDyld::LoadedObjectInfo& info) {
+    // The debug object contains the symbols relocated to the addresses the sections were loaded to
+    auto debugObject = info.getObjectForDebug(object);
+    if (!debugObject.getBinary()) {
+        return;
+    }
+
+    for (auto& entry : llvm::object::computeSymbolSizes(*debugObject.getBinary())) {
+        auto& symbol = entry.first;
+        if (symbol.getType() != llvm::object::SymbolRef::ST_Function) {
+            continue;
+        }
+
+        auto name = symbol.getName();
+        auto address = symbol.getAddress();
+        if (!name || !address || entry.second == 0u) {
+            continue;
+        }
+        llvmCompiler->writePerfMap(*address, entry.second, mModuleName + "::" + name->str());
+    }
+}
+
+void LLVMJIT::dumpModule(const llvm::Module& module) {
+    std::stringstream ss;
+    ss << llvmCompiler->dumpDirectory() << "/" << module.getModuleIdentifier() << "." << llvmCompiler->nextDumpId();
+    auto baseName = ss.str();
+
+    std::error_code ec;
+    {
+        llvm::raw_fd_ostream irStream(baseName + ".ll", ec, llvm::sys::fs::F_Text);
+        if (ec) {
+            LOG_ERROR("Unable to dump IR of module %1% [error = %2% %3%]", baseName, ec, ec.message());
+            return;
+        }
+        module.print(irStream, nullptr);
+    }
+
+    // Code generation modifies the module so the machine code is generated from a copy
+    auto copy = llvm::CloneModule(&module);
+    auto targetMachine = llvmCompiler->createTargetMachine();
+
+    llvm::raw_fd_ostream asmStream(baseName + ".s", ec, llvm::sys::fs::F_Text);
+    if (ec) {
+        LOG_ERROR("Unable to dump machine code of module %1% [error = %2% %3%]", baseName, ec, ec.message());
+        return;
+    }
+    llvm::legacy::PassManager codegenPass;
+    if (targetMachine->addPassesToEmitFile(codegenPass, asmStream, llvm::TargetMachine::CGFT_AssemblyFile)) {
+        LOG_ERROR("Target does not support emitting machine code of module %1%", baseName);
+        return;
+    }
+    codegenPass.run(*copy);
+}
+
 } // namespace store
 } // namespace tell
@@ -45,11 +45,19 @@
 #include <crossbow/non_copyable.hpp>
 #include <crossbow/singleton.hpp>
 
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
 #include <memory>
+#include <mutex>
+#include <string>
 
 namespace llvm {
 class Module;
 class TargetMachine;
+namespace object {
+class ObjectFile;
+} // namespace object
 } // namespace llvm
 
 namespace tell {
@@ -65,8 +73,51 @@ class LLVMCompilerT {
 public:
     LLVMCompilerT();
 
+    ~LLVMCompilerT();
+
     std::unique_ptr<llvm::TargetMachine> createTargetMachine();
 
+    /**
+     * @brief Write the address range of every compiled function to the perf map of the process
+     *
+     * The entries are appended to /tmp/perf-<pid>.map so profilers like perf can resolve the JIT compiled functions.
+     * Must be enabled before the first module is compiled.
+     */
+    void enablePerfMap() {
+        mPerfMap = true;
+    }
+
+    bool perfMapEnabled() const {
+        return mPerfMap;
+    }
+
+    /**
+     * @brief Dump the IR and the machine code of every compiled module into the directory
+     *
+     * Must be set before the first module is compiled. An empty directory disables the dump.
+     */
+    void setDumpDirectory(std::string directory) {
+        mDumpDirectory = std::move(directory);
+    }
+
+    const std::string& dumpDirectory() const {
+        return mDumpDirectory;
+    }
+
+    /**
+     * @brief Appends the function to the perf map
+     *
+     * Can be called from any thread.
+     */
+    void writePerfMap(uint64_t address, uint64_t size, const std::string& name);
+
+    /**
+     * @brief Unique ID to distinguish dumps of modules with the same name
+     */
+    uint64_t nextDumpId() {
+        return ++mDumpCounter;
+    }
+
 private:
     std::string mProcessTriple;
 
@@ -77,6 +128,16 @@ private:
     llvm::TargetOptions mOptions;
 
     const llvm::Target* mTarget;
+
+    bool mPerfMap;
+
+    std::string mDumpDirectory;
+
+    std::atomic<uint64_t> mDumpCounter;
+
+    std::mutex mPerfMapMutex;
+
+    std::FILE* mPerfMapFile;
 };
 
 using LLVMCompiler = crossbow::singleton<LLVMCompilerT>;
@@ -87,8 +148,32 @@ extern LLVMCompiler llvmCompiler;
  * @brief JIT based on LLVM
  */
 class LLVMJIT : crossbow::non_copyable, crossbow::non_movable {
+    /**
+     * @brief Registers the functions of every object loaded by the object layer in the perf map
+     */
+    class PerfMapNotifier {
+    public:
+        PerfMapNotifier(LLVMJIT& jit)
+                : mJit(&jit) {
+        }
+
+        template <typename ObjSetT, typename LoadResult>
+        void operator()(llvm::orc::ObjectLinkingLayerBase::ObjSetHandleT /* handle */, const ObjSetT& objects,
+                const LoadResult& infos) {
+            if (!llvmCompiler->perfMapEnabled()) {
+                return;
+            }
+            for (size_t i = 0; i < objects.size(); ++i) {
+                mJit->registerObject(*objects[i], *infos[i]);
+            }
+        }
+
+    private:
+        LLVMJIT* mJit;
+    };
+
 public:
-    using ObjectLayer = llvm::orc::ObjectLinkingLayer<>;
+    using ObjectLayer = llvm::orc::ObjectLinkingLayer<PerfMapNotifier>;
     using CompileLayer = llvm::orc::IRCompileLayer<ObjectLayer>;
     using ModuleHandle = CompileLayer::ModuleSetHandleT;
 
@@ -126,6 +211,16 @@ public:
     }
 
 private:
+    /**
+     * @brief Writes the perf map entries for all functions in the loaded object
+     */
+    void registerObject(const llvm::object::ObjectFile& object, const llvm::RuntimeDyld::LoadedObjectInfo& info);
+
+    /**
+     * @brief Writes the IR and the machine code of the module into the dump directory
+     */
+    void dumpModule(const llvm::Module& module);
+
     std::string mangle(const std::string& name) {
         std::string mangledName;
         {
@@ -139,6 +234,9 @@ private:
     llvm::DataLayout mDataLayout;
     ObjectLayer mObjectLayer;
     CompileLayer mCompileLayer;
+
+    /// Name of the module currently being compiled (prefix of the perf map entries)
+    std::string mModuleName;
 };
 
 } // namespace store
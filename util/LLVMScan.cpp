@@ -64,6 +64,39 @@ uint32_t memcpyWrapper(const char* src, uint32_t length, char* dest) {
     return length;
 }
 
+/**
+ * @brief Hash of the structure of the scan independent of the predicate values and snapshots
+ *
+ * Used to give the compiled code of scans with the same shape a stable name in profiles.
+ */
+size_t shapeHash(const ScanAST& scanAst) {
+    size_t seed = 0;
+    boost::hash_combine(seed, scanAst.numConjunct);
+    boost::hash_combine(seed, scanAst.needsKey);
+    boost::hash_combine(seed, scanAst.needsNull);
+    for (auto& field : scanAst.fields) {
+        boost::hash_combine(seed, field.second.id);
+        boost::hash_combine(seed, crossbow::to_underlying(field.second.type));
+        for (auto& predicate : field.second.predicates) {
+            boost::hash_combine(seed, crossbow::to_underlying(predicate.type));
+            boost::hash_combine(seed, predicate.conjunct);
+        }
+    }
+    for (auto& query : scanAst.queries) {
+        boost::hash_combine(seed, query.shared);
+        boost::hash_combine(seed, query.conjunctOffset);
+        boost::hash_combine(seed, query.numConjunct);
+        boost::hash_combine(seed, query.partitionModulo != 0);
+    }
+    return seed;
+}
+
+std::string moduleName(const std::string& prefix, size_t hash) {
+    std::stringstream ss;
+    ss << prefix << "." << std::hex << hash;
+    return ss.str();
+}
+
 } // anonymous namespace
 
 LLVMCodeModule::LLVMCodeModule(const std::string& name)
@@ -255,6 +288,8 @@ LLVMScanBase::LLVMScanBase(const Record& record, std::vector<ScanQuery*> queries
     }
     LOG_ASSERT(mScanAst.queries.size() == mQueries.size(), "Did not process every query");
     LOG_ASSERT(mScanAst.conjunctProperties.size() == mScanAst.numConjunct, "Number of conjuncts does not match");
+
+    mQueryModule.getModule().setModuleIdentifier(moduleName("ScanQuery", shapeHash(mScanAst)));
 }
 
 LLVMRowScanBase::LLVMRowScanBase(const Record& record, std::vector<ScanQuery*> queries)
@@ -274,6 +309,7 @@ void LLVMRowScanBase::prepareQuery() {
 void LLVMRowScanBase::prepareMaterialization() {
     LOG_ASSERT(mRowMaterializeFuns.empty(), "Scan already finalized");
     std::unordered_map<QueryDataHolder, std::string> materializeCache;
+    size_t materializeHash = 0;
     for (decltype(mQueries.size()) i = 0; i < mQueries.size(); ++i) {
         auto q = mQueries[i];
         if (q->queryType() == ScanQueryType::FULL) {
@@ -289,6 +325,7 @@ void LLVMRowScanBase::prepareMaterialization() {
         ss << ROW_MATERIALIZE_NAME << i;
         auto name = ss.str();
         materializeCache.emplace(holder, name);
+        boost::hash_combine(materializeHash, std::hash<QueryDataHolder>()(holder));
 
         switch (q->queryType()) {
         case ScanQueryType::PROJECTION: {
@@ -307,6 +344,7 @@ void LLVMRowScanBase::prepareMaterialization() {
         }
     }
 
+    mMaterializationModule.getModule().setModuleIdentifier(moduleName("Materialization", materializeHash));
     mMaterializationModule.compile();
 
     for (decltype(mQueries.size()) i = 0; i < mQueries.size(); ++i) {
@@ -331,7 +369,9 @@ LLVMRowScanProcessorBase::LLVMRowScanProcessorBase(const Record& record, const s
           mRowScanFun(rowScanFunc),
           mRowMaterializeFuns(rowMaterializeFuns),
           mNumConjuncts(numConjuncts),
-          mResult(mNumConjuncts, 0u) {
+          mResult(mNumConjuncts, 0u),
+          mTupleCount(0u),
+          mPageCount(0u) {
     LOG_ASSERT(mNumConjuncts >= queries.size(), "More queries than conjuncts");
 
     mQueries.reserve(queries.size());
@@ -344,6 +384,7 @@ void LLVMRowScanProcessorBase::processRowRecord(uint64_t key, uint64_t validFrom
         uint32_t length) {
     LOG_ASSERT(mResult.size() >= mNumConjuncts, "Result array must be larger or equal than number of conjuncts");
 
+    ++mTupleCount;
     mRowScanFun(key, validFrom, validTo, data, &mResult.front());
 
     for (decltype(mQueries.size()) i = 0; i < mQueries.size(); ++i) {
@@ -294,6 +294,21 @@ protected:
 };
 
 class LLVMRowScanProcessorBase {
+public:
+    /**
+     * @brief Number of tuples processed by this processor
+     */
+    uint64_t tupleCount() const {
+        return mTupleCount;
+    }
+
+    /**
+     * @brief Number of pages processed by this processor
+     */
+    uint64_t pageCount() const {
+        return mPageCount;
+    }
+
 protected:
     LLVMRowScanProcessorBase(const Record& record, const std::vector<ScanQuery*>& queries,
             LLVMRowScanBase::RowScanFun rowScanFunc,
@@ -325,6 +340,10 @@ protected:
     uint32_t mNumConjuncts;
 
     std::vector<char, tbb::cache_aligned_allocator<char>> mResult;
+
+    uint64_t mTupleCount;
+
+    uint64_t mPageCount;
 };
 
 } // namespace store
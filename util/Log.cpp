@@ -22,8 +22,6 @@
  */
 #include "Log.hpp"
 
-#include <crossbow/allocator.hpp>
-
 namespace tell {
 namespace store {
 
@@ -113,7 +111,7 @@ void BaseLogImpl::freeEmptyPageNow(LogPage* page) {
 
 void BaseLogImpl::freePage(LogPage* begin, LogPage* end) {
     auto& pageManager = mPageManager;
-    crossbow::allocator::invoke([begin, end, &pageManager]() {
+    pageManager.retire([begin, end, &pageManager] () {
         auto page = begin;
         while (page != end) {
             auto next = page->next().load();
@@ -123,8 +121,8 @@ void BaseLogImpl::freePage(LogPage* begin, LogPage* end) {
     });
 }
 
-UnorderedLogImpl::UnorderedLogImpl(PageManager& pageManager)
-        : BaseLogImpl(pageManager),
+UnorderedLogImpl::UnorderedLogImpl(PageManager& pageManager, const MemoryTag& tag)
+        : BaseLogImpl(pageManager, tag),
           mHead(LogHead(acquirePage(), nullptr)),
           mTail(mHead.load().writeHead),
           mPages(1) {
@@ -248,8 +246,8 @@ UnorderedLogImpl::LogHead UnorderedLogImpl::createPage(LogHead oldHead) {
     }
 }
 
-OrderedLogImpl::OrderedLogImpl(PageManager& pageManager)
-        : BaseLogImpl(pageManager),
+OrderedLogImpl::OrderedLogImpl(PageManager& pageManager, const MemoryTag& tag)
+        : BaseLogImpl(pageManager, tag),
           mHead(acquirePage()),
           mSealedHead(LogPosition(mHead.load(), 0)),
           mTail(LogPosition(mHead.load(), 0)) {
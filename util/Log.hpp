@@ -456,7 +456,7 @@ public:
      * @brief Acquires an empty log page from the page manager
      */
     LogPage* acquirePage() {
-        return new(mPageManager.alloc()) LogPage();
+        return new(mPageManager.alloc(mTag)) LogPage();
     }
 
     /**
@@ -482,12 +482,16 @@ public:
     void freePage(LogPage* begin, LogPage* end);
 
 protected:
-    BaseLogImpl(PageManager& pageManager)
-            : mPageManager(pageManager) {
+    BaseLogImpl(PageManager& pageManager, const MemoryTag& tag)
+            : mPageManager(pageManager),
+              mTag(tag) {
     }
 
 private:
     PageManager& mPageManager;
+
+    /// Owner and category the log pages are accounted to
+    MemoryTag mTag;
 };
 
 /**
@@ -597,7 +601,7 @@ public:
     void erase(LogPage* begin, LogPage* end);
 
 protected:
-    UnorderedLogImpl(PageManager& pageManager);
+    UnorderedLogImpl(PageManager& pageManager, const MemoryTag& tag);
 
     LogEntry* appendEntry(uint32_t size, uint32_t entrySize, uint32_t type);
 
@@ -815,7 +819,7 @@ public:
     bool truncateLog(LogIterator oldTail, LogIterator newTail);
 
 protected:
-    OrderedLogImpl(PageManager& pageManager);
+    OrderedLogImpl(PageManager& pageManager, const MemoryTag& tag);
 
     LogEntry* appendEntry(uint32_t size, uint32_t entrySize, uint32_t type);
 
@@ -958,8 +962,8 @@ public:
     using LogIterator = typename Impl::LogIterator;
     using ConstLogIterator = typename Impl::ConstLogIterator;
 
-    Log(PageManager& pageManager)
-            : Impl(pageManager) {
+    Log(PageManager& pageManager, const MemoryTag& tag = MemoryTag())
+            : Impl(pageManager, tag) {
     }
 
     ~Log();
@@ -23,6 +23,8 @@
 
 #include "PageManager.hpp"
 
+#include <tellstore/Statistics.hpp>
+
 #include <crossbow/logger.hpp>
 
 #include <iostream>
@@ -37,7 +39,8 @@ namespace store {
 PageManager::PageManager(size_t size)
     : mData(mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, 0, 0)),
       mSize(size),
-      mPages(size / TELL_PAGE_SIZE, nullptr)
+      mPages(size / TELL_PAGE_SIZE, nullptr),
+      mTags(new std::atomic<uint64_t>[size / TELL_PAGE_SIZE])
 {
     if (mData == MAP_FAILED) {
         throw std::bad_alloc();
@@ -48,6 +51,7 @@ PageManager::PageManager(size_t size)
     auto data = reinterpret_cast<char*>(mData);
     data += mSize - TELL_PAGE_SIZE; // data does now point to the last page
     for (decltype(numPages) i = 0ul; i < numPages; ++i) {
+        mTags[i].store(0u, std::memory_order_relaxed);
         __attribute__((unused)) auto res = mPages.push(data);
         LOG_ASSERT(res, "Pusing page did not succeed");
         data -= TELL_PAGE_SIZE;
@@ -56,17 +60,16 @@ PageManager::PageManager(size_t size)
 }
 
 PageManager::~PageManager() {
-    // TODO Fix this behavior
-    // Wait for all pages to be released
-    // This is required as the epoch might delete the PageManager while a previous epoch is being deleted (with a
-    // reference to this page manager).
-    while (mPages.capacity() != mPages.size());
+    mReclaimer.releaseAll();
     munmap(mData, mSize);
 }
 
-void* PageManager::alloc() {
+void* PageManager::alloc(const MemoryTag& tag /* = MemoryTag() */) {
     void* page;
     auto success = mPages.pop(page);
+    if (!success && mReclaimer.reclaim() != 0u) {
+        success = mPages.pop(page);
+    }
     LOG_ASSERT(!success || (page != nullptr), "Successful pop must not return null pages");
     LOG_ASSERT(!success || (page >= mData && page < reinterpret_cast<char*>(mData) + mSize), "Page points out of bound");
     LOG_ASSERT(!success || (reinterpret_cast<char*>(page) - reinterpret_cast<char*>(mData)) % TELL_PAGE_SIZE == 0,
@@ -75,6 +78,7 @@ void* PageManager::alloc() {
         return nullptr;
     }
     memset(page, 0, TELL_PAGE_SIZE);
+    mTags[pageIndex(page)].store(encodeTag(tag), std::memory_order_relaxed);
     return page;
 }
 
@@ -87,8 +91,48 @@ void PageManager::free(void* page) {
 }
 
 void PageManager::freeEmpty(void* page) {
+    mTags[pageIndex(page)].store(0u, std::memory_order_relaxed);
     while (!mPages.push(page));
 }
 
+void PageManager::retirePages(std::vector<void*> pages) {
+    if (pages.empty()) {
+        return;
+    }
+    mReclaimer.retire([this, pages] () {
+        for (auto page : pages) {
+            free(page);
+        }
+    });
+}
+
+void PageManager::allocHeap(const MemoryTag& tag, uint64_t bytes) {
+    std::lock_guard<std::mutex> _(mHeapMutex);
+    mHeapUsage[encodeTag(tag)] += bytes;
+}
+
+void PageManager::freeHeap(const MemoryTag& tag, uint64_t bytes) {
+    std::lock_guard<std::mutex> _(mHeapMutex);
+    auto i = mHeapUsage.find(encodeTag(tag));
+    LOG_ASSERT(i != mHeapUsage.end() && i->second >= bytes, "Releasing more heap memory than was accounted");
+    i->second -= bytes;
+    if (i->second == 0u) {
+        mHeapUsage.erase(i);
+    }
+}
+
+void PageManager::collectUsage(MemoryUsage& usage) const {
+    auto numPages = mSize / TELL_PAGE_SIZE;
+    for (decltype(numPages) i = 0ul; i < numPages; ++i) {
+        auto tag = mTags[i].load(std::memory_order_relaxed);
+        usage.add(tag >> 8, static_cast<MemoryCategory>(tag & 0xFFu), TELL_PAGE_SIZE);
+    }
+
+    std::lock_guard<std::mutex> _(mHeapMutex);
+    for (auto& entry : mHeapUsage) {
+        usage.add(entry.first >> 8, static_cast<MemoryCategory>(entry.first & 0xFFu), entry.second);
+    }
+}
+
 } // namespace store
 } // namespace tell
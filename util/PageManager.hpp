@@ -24,22 +24,43 @@
 
 #include <config.h>
 
-#include <crossbow/allocator.hpp>
+#include "Reclamation.hpp"
+
+#include <tellstore/StdTypes.hpp>
+
 #include <crossbow/fixed_size_stack.hpp>
 #include <crossbow/non_copyable.hpp>
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace tell {
 namespace store {
 
+class MemoryUsage;
 class PageManager;
 
-struct PageManagerDeleter {
-    void operator()(PageManager* pageManager) {
-        crossbow::allocator::destroy_in_order(pageManager);
+/**
+ * @brief Owner and category a page is allocated for
+ */
+struct MemoryTag {
+    MemoryTag()
+            : MemoryTag(0u, MemoryCategory::UNTAGGED) {
+    }
+
+    MemoryTag(uint64_t table, MemoryCategory cat)
+            : tableId(table),
+              category(cat) {
     }
+
+    uint64_t tableId;
+    MemoryCategory category;
 };
 
 /**
@@ -53,16 +74,35 @@ private:
     void* mData;
     size_t mSize;
     crossbow::fixed_size_stack<void*> mPages;
+
+    /// Encoded memory tag of every page (0 if the page is free)
+    std::unique_ptr<std::atomic<uint64_t>[]> mTags;
+
+    /// Pages and structures removed by the garbage collection that may still be referenced by readers
+    Reclaimer mReclaimer;
+
+    /// Protects the heap usage (only changes when large structures are allocated or released)
+    mutable std::mutex mHeapMutex;
+
+    /// Bytes allocated from the heap by encoded memory tag
+    std::unordered_map<uint64_t, uint64_t> mHeapUsage;
+
+    static uint64_t encodeTag(const MemoryTag& tag) {
+        return (tag.tableId << 8) | static_cast<uint64_t>(tag.category);
+    }
+
+    size_t pageIndex(const void* page) const {
+        return static_cast<size_t>(reinterpret_cast<const char*>(page) - reinterpret_cast<const char*>(mData))
+                / TELL_PAGE_SIZE;
+    }
 public:
-    using Ptr = std::unique_ptr<PageManager, PageManagerDeleter>;
+    using Ptr = std::unique_ptr<PageManager>;
 
     /**
      * @brief Constructs a new page manager pointer
-     *
-     * The resulting page manager is allocated and destroyed within the epoch.
      */
     static PageManager::Ptr construct(size_t size) {
-        return PageManager::Ptr(crossbow::allocator::construct<PageManager>(size));
+        return PageManager::Ptr(new PageManager(size));
     }
 
     /**
@@ -76,6 +116,10 @@ public:
     */
     PageManager(size_t size);
 
+    /**
+     * Releases all retired elements immediately, no thread may access
+     * any structure backed by this page manager anymore.
+     */
     ~PageManager();
 
     const void* data() const {
@@ -93,9 +137,12 @@ public:
     /**
     * Allocates a new page. It is safe to call this method
     * concurrently. It will return nullptr, if there is no
-    * space left.
+    * space left even after reclaiming retired pages.
+    *
+    * The page is accounted to the owner and category of
+    * the tag until it is freed.
     */
-    void* alloc();
+    void* alloc(const MemoryTag& tag = MemoryTag());
 
     /**
     * Returns the given page back to the pool
@@ -106,6 +153,53 @@ public:
     * Returns the given (already zeroed) page back to the pool
     */
     void freeEmpty(void* page);
+
+    /**
+     * @brief Retires an element that was unlinked from all shared structures
+     *
+     * The function is invoked as soon as no ReclamationGuard entered before the call is active anymore (or when the
+     * page manager is destroyed).
+     */
+    void retire(std::function<void()> fun) {
+        mReclaimer.retire(std::move(fun));
+    }
+
+    /**
+     * @brief Retires the given pages, they are returned to the pool once no reader can reference them anymore
+     */
+    void retirePages(std::vector<void*> pages);
+
+    /**
+     * @brief Releases all retired elements no longer referenced by any reader
+     *
+     * Never blocks on other threads.
+     *
+     * @return Number of released elements
+     */
+    size_t reclaim() {
+        return mReclaimer.reclaim();
+    }
+
+    /**
+     * @brief Accounts memory allocated from the heap on behalf of the owner and category
+     *
+     * Structures that can not be split into pages (e.g. the bucket arrays of hash tables) are allocated from the heap
+     * and have to be accounted here to show up in the memory usage.
+     */
+    void allocHeap(const MemoryTag& tag, uint64_t bytes);
+
+    /**
+     * @brief Releases heap memory previously accounted with allocHeap()
+     */
+    void freeHeap(const MemoryTag& tag, uint64_t bytes);
+
+    /**
+     * @brief Adds the memory of all pages and the accounted heap memory to the usage by owner and category
+     *
+     * Free pages are accounted to the FREE category. Can be called concurrently to allocations, the result may then be
+     * slightly inaccurate.
+     */
+    void collectUsage(MemoryUsage& usage) const;
 };
 
 } // namespace store
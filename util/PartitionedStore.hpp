@@ -0,0 +1,329 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include "ScanQuery.hpp"
+#include "StorageConfig.hpp"
+
+#include <config.h>
+#include <tellstore/ErrorCode.hpp>
+#include <tellstore/Statistics.hpp>
+
+#include <commitmanager/SnapshotDescriptor.hpp>
+
+#include <crossbow/logger.hpp>
+#include <crossbow/non_copyable.hpp>
+#include <crossbow/string.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Storage splitting the key space of every table into independent partitions
+ *
+ * Every partition is a complete storage instance of its own with separate pages, hash tables, logs, GC thread and scan
+ * threads. Point operations are executed on the partition owning the key and never touch the data structures of any
+ * other partition, scans are executed on all partitions in parallel.
+ *
+ * With a single partition all requests are forwarded to the underlying storage as is.
+ */
+template <typename Store>
+class PartitionedStore : crossbow::non_copyable, crossbow::non_movable {
+public:
+    using Table = typename Store::Table;
+
+    static const char* implementationName() {
+        return Store::implementationName();
+    }
+
+    /**
+     * @brief Configuration of the partition with the given index
+     *
+     * The memory and hash map capacity are split evenly across the partitions. Every partition pins its scan threads
+     * to the next set of scan cores and its GC thread to the next GC core.
+     */
+    static StorageConfig partitionConfig(const StorageConfig& config, size_t partition) {
+        auto numPartitions = std::max(config.numPartitions, size_t(1u));
+        if (numPartitions == 1u) {
+            return config;
+        }
+
+        StorageConfig result(config);
+        result.numPartitions = 1u;
+        result.totalMemory = ((config.totalMemory / numPartitions) / TELL_PAGE_SIZE) * TELL_PAGE_SIZE;
+        result.hashMapCapacity = std::max((config.hashMapCapacity + numPartitions - 1u) / numPartitions, size_t(1u));
+        result.scanCores = rotateCores(config.scanCores, partition * config.numScanThreads);
+        result.gcCores = rotateCores(config.gcCores, partition);
+        return result;
+    }
+
+    PartitionedStore(const StorageConfig& config) {
+        auto numPartitions = std::max(config.numPartitions, size_t(1u));
+        mPartitions.reserve(numPartitions);
+        for (decltype(numPartitions) i = 0u; i < numPartitions; ++i) {
+            mPartitions.emplace_back(new Store(partitionConfig(config, i)));
+        }
+    }
+
+    size_t numPartitions() const {
+        return mPartitions.size();
+    }
+
+    /**
+     * @brief Index of the partition owning the key
+     *
+     * The key is mixed before assigning it to a partition as the keys of a single shard are usually already partitioned
+     * by the client (e.g. all keys of a shard are congruent modulo the number of shards).
+     */
+    size_t partitionOf(uint64_t key) const {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) % mPartitions.size();
+    }
+
+    /**
+     * @brief Creates the table in every partition
+     *
+     * The table is created in all partitions even when it fails in one of them so the table IDs assigned by the
+     * partitions stay in sync.
+     */
+    bool createTable(const crossbow::string& name, const Schema& schema, uint64_t& idx) {
+        std::lock_guard<std::mutex> _(mCreateMutex);
+        auto succeeded = mPartitions.front()->createTable(name, schema, idx);
+        for (auto i = mPartitions.begin() + 1; i != mPartitions.end(); ++i) {
+            uint64_t partitionIdx;
+            __attribute__((unused)) auto res = (*i)->createTable(name, schema, partitionIdx);
+            LOG_ASSERT(res == succeeded, "Creating table succeeded only on some partitions");
+            LOG_ASSERT(partitionIdx == idx, "Table IDs of partitions do not match");
+        }
+        return succeeded;
+    }
+
+    /**
+     * @brief Checks if the schema can be added as next schema version of the table in every partition
+     */
+    int checkAlterTable(uint64_t tableId, uint32_t schemaVersion, const Schema& schema) {
+        std::lock_guard<std::mutex> _(mCreateMutex);
+        return checkAlterPartitions(tableId, schemaVersion, schema);
+    }
+
+    /**
+     * @brief Adds the schema as newest schema version of the table in every partition
+     *
+     * The schema change is validated on all partitions before any partition is altered so a rejected change leaves all
+     * partitions untouched.
+     */
+    int alterTable(uint64_t tableId, uint32_t schemaVersion, const Schema& schema) {
+        std::lock_guard<std::mutex> _(mCreateMutex);
+        auto ec = checkAlterPartitions(tableId, schemaVersion, schema);
+        if (ec != 0) {
+            return ec;
+        }
+        for (auto& partition : mPartitions) {
+            __attribute__((unused)) auto res = partition->alterTable(tableId, schemaVersion, schema);
+            LOG_ASSERT(res == 0, "Altering table failed on a validated partition");
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Drops the table in every partition
+     */
+    int dropTable(uint64_t tableId) {
+        std::lock_guard<std::mutex> _(mCreateMutex);
+        auto ec = mPartitions.front()->dropTable(tableId);
+        if (ec != 0) {
+            return ec;
+        }
+        for (auto i = mPartitions.begin() + 1; i != mPartitions.end(); ++i) {
+            __attribute__((unused)) auto res = (*i)->dropTable(tableId);
+            LOG_ASSERT(res == 0, "Dropping table succeeded only on some partitions");
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Truncates the table in every partition
+     */
+    int truncateTable(uint64_t tableId) {
+        std::lock_guard<std::mutex> _(mCreateMutex);
+        auto ec = mPartitions.front()->truncateTable(tableId);
+        if (ec != 0) {
+            return ec;
+        }
+        for (auto i = mPartitions.begin() + 1; i != mPartitions.end(); ++i) {
+            __attribute__((unused)) auto res = (*i)->truncateTable(tableId);
+            LOG_ASSERT(res == 0, "Truncating table succeeded only on some partitions");
+        }
+        return 0;
+    }
+
+    std::vector<const Table*> getTables() const {
+        return mPartitions.front()->getTables();
+    }
+
+    const Table* getTable(uint64_t id) const {
+        return mPartitions.front()->getTable(id);
+    }
+
+    const Table* getTable(const crossbow::string& name, uint64_t& id) const {
+        return mPartitions.front()->getTable(name, id);
+    }
+
+    template <typename Fun>
+    int get(uint64_t tableId, uint64_t key, const commitmanager::SnapshotDescriptor& snapshot, Fun fun) {
+        return partition(key).get(tableId, key, snapshot, std::move(fun));
+    }
+
+    /**
+     * @brief Reads a batch of keys
+     *
+     * The batch is only forwarded as a whole with a single partition, otherwise every key is read from its partition.
+     */
+    template <typename Fun>
+    void get(uint64_t tableId, const uint64_t* keys, size_t count, const commitmanager::SnapshotDescriptor& snapshot,
+            int* ec, Fun fun) {
+        if (mPartitions.size() == 1u) {
+            mPartitions.front()->get(tableId, keys, count, snapshot, ec, std::move(fun));
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            ec[i] = partition(keys[i]).get(tableId, keys[i], snapshot,
+                    [&fun, i] (size_t size, uint64_t version, bool isNewest) {
+                return fun(i, size, version, isNewest);
+            });
+        }
+    }
+
+    int update(uint64_t tableId, uint64_t key, size_t size, const char* data,
+            const commitmanager::SnapshotDescriptor& snapshot, uint32_t schemaVersion) {
+        return partition(key).update(tableId, key, size, data, snapshot, schemaVersion);
+    }
+
+    int insert(uint64_t tableId, uint64_t key, size_t size, const char* data,
+            const commitmanager::SnapshotDescriptor& snapshot, uint32_t schemaVersion) {
+        return partition(key).insert(tableId, key, size, data, snapshot, schemaVersion);
+    }
+
+    int remove(uint64_t tableId, uint64_t key, const commitmanager::SnapshotDescriptor& snapshot) {
+        return partition(key).remove(tableId, key, snapshot);
+    }
+
+    int revert(uint64_t tableId, uint64_t key, const commitmanager::SnapshotDescriptor& snapshot) {
+        return partition(key).revert(tableId, key, snapshot);
+    }
+
+    /**
+     * @brief Executes the scan on every partition
+     *
+     * A query can not be withdrawn once a partition accepted it, so a slot is reserved in the scan queue of every
+     * partition first. If any partition is overloaded the reservations are released and the query is rejected before
+     * any partition saw it.
+     *
+     * The scan is enqueued while holding the same mutex as table drops, so once the first partition accepted the scan
+     * the table exists on all other partitions and their reserved slots guarantee they accept it too.
+     */
+    int scan(uint64_t tableId, ScanQuery* query) {
+        if (mPartitions.size() == 1u) {
+            return mPartitions.front()->scan(tableId, query);
+        }
+
+        for (auto i = mPartitions.begin(); i != mPartitions.end(); ++i) {
+            if (!(*i)->reserveScan(query)) {
+                for (auto j = mPartitions.begin(); j != i; ++j) {
+                    (*j)->releaseScan(query);
+                }
+                return error::server_overlad;
+            }
+        }
+
+        std::lock_guard<std::mutex> _(mCreateMutex);
+        query->expectScans(mPartitions.size());
+        auto ec = mPartitions.front()->scanReserved(tableId, query);
+        if (ec) {
+            for (auto i = mPartitions.begin() + 1; i != mPartitions.end(); ++i) {
+                (*i)->releaseScan(query);
+            }
+            return ec;
+        }
+
+        for (auto i = mPartitions.begin() + 1; i != mPartitions.end(); ++i) {
+            __attribute__((unused)) auto res = (*i)->scanReserved(tableId, query);
+            LOG_ASSERT(res == 0, "Scan succeeded only on some partitions");
+        }
+        return 0;
+    }
+
+    void forceGC() {
+        for (auto& partition : mPartitions) {
+            partition->forceGC();
+        }
+    }
+
+    /**
+     * @brief Adds the memory of all pages in all partitions to the usage by table and category
+     */
+    void collectMemoryUsage(MemoryUsage& usage) const {
+        for (auto& partition : mPartitions) {
+            partition->collectMemoryUsage(usage);
+        }
+    }
+
+private:
+    static std::vector<unsigned> rotateCores(const std::vector<unsigned>& cores, size_t offset) {
+        std::vector<unsigned> result;
+        result.reserve(cores.size());
+        for (decltype(cores.size()) i = 0u; i < cores.size(); ++i) {
+            result.emplace_back(cores[(offset + i) % cores.size()]);
+        }
+        return result;
+    }
+
+    int checkAlterPartitions(uint64_t tableId, uint32_t schemaVersion, const Schema& schema) {
+        for (auto& partition : mPartitions) {
+            auto ec = partition->checkAlterTable(tableId, schemaVersion, schema);
+            if (ec != 0) {
+                return ec;
+            }
+        }
+        return 0;
+    }
+
+    Store& partition(uint64_t key) {
+        return *mPartitions[partitionOf(key)];
+    }
+
+    std::vector<std::unique_ptr<Store>> mPartitions;
+
+    /// Serializes table creation, schema changes, drops, truncations and enqueuing scans so all partitions agree on the
+    /// tables
+    std::mutex mCreateMutex;
+};
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,217 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include "PerfCounters.hpp"
+
+#include <crossbow/enum_underlying.hpp>
+#include <crossbow/logger.hpp>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace tell {
+namespace store {
+namespace {
+
+/**
+ * @brief A hardware event and the sample field it is counted in
+ */
+struct PerfEvent {
+    uint32_t type;
+    uint64_t config;
+    uint64_t PerfCounterSample::* field;
+    const char* name;
+};
+
+constexpr uint64_t cacheEvent(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+constexpr size_t gNumEvents = 4u;
+
+const std::array<PerfEvent, gNumEvents> gEvents = {{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, &PerfCounterSample::cycles, "cycles"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, &PerfCounterSample::instructions, "instructions"},
+    {PERF_TYPE_HW_CACHE, cacheEvent(PERF_COUNT_HW_CACHE_LL), &PerfCounterSample::llcMisses, "LLC read misses"},
+    {PERF_TYPE_HW_CACHE, cacheEvent(PERF_COUNT_HW_CACHE_DTLB), &PerfCounterSample::dtlbMisses, "dTLB read misses"},
+}};
+
+/**
+ * @brief Counter group of a single thread
+ *
+ * The first successfully opened event is the group leader so that all events are scheduled together and can be read
+ * with a single system call.
+ */
+class ThreadCounters : crossbow::non_copyable, crossbow::non_movable {
+public:
+    ThreadCounters()
+            : mLeader(-1),
+              mNumEvents(0u),
+              mOpened(false) {
+    }
+
+    ~ThreadCounters();
+
+    bool read(PerfCounterSample& sample);
+
+private:
+    void open();
+
+    int mLeader;
+    std::array<int, gNumEvents> mFds;
+    std::array<uint64_t PerfCounterSample::*, gNumEvents> mFields;
+    size_t mNumEvents;
+    bool mOpened;
+};
+
+ThreadCounters::~ThreadCounters() {
+    for (size_t i = 0; i < mNumEvents; ++i) {
+        ::close(mFds[i]);
+    }
+}
+
+bool ThreadCounters::read(PerfCounterSample& sample) {
+    if (!mOpened) {
+        open();
+    }
+    if (mLeader == -1) {
+        return false;
+    }
+
+    std::array<uint64_t, gNumEvents + 1> values;
+    auto res = ::read(mLeader, values.data(), (mNumEvents + 1) * sizeof(uint64_t));
+    if (res != static_cast<ssize_t>((mNumEvents + 1) * sizeof(uint64_t))) {
+        return false;
+    }
+    for (size_t i = 0; i < mNumEvents && i < values[0]; ++i) {
+        sample.*mFields[i] = values[i + 1];
+    }
+    return true;
+}
+
+void ThreadCounters::open() {
+    mOpened = true;
+
+    for (auto& event : gEvents) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = event.type;
+        attr.config = event.config;
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        // Measure the calling thread on any CPU
+        auto fd = static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1, mLeader, 0));
+        if (fd == -1) {
+            LOG_WARN("Unable to open performance counter for %1% [error = %2%]", event.name, strerror(errno));
+            continue;
+        }
+        if (mLeader == -1) {
+            mLeader = fd;
+        }
+        mFds[mNumEvents] = fd;
+        mFields[mNumEvents] = event.field;
+        ++mNumEvents;
+    }
+}
+
+thread_local ThreadCounters gThreadCounters;
+
+} // anonymous namespace
+
+PerfCounters perfCounters;
+
+PerfCountersT::PerfCountersT()
+        : mEnabled(false) {
+    for (auto& totals : mTotals) {
+        totals.runs.store(0u);
+        totals.cycles.store(0u);
+        totals.instructions.store(0u);
+        totals.llcMisses.store(0u);
+        totals.dtlbMisses.store(0u);
+        totals.tuples.store(0u);
+        totals.pages.store(0u);
+    }
+}
+
+bool PerfCountersT::read(PerfCounterSample& sample) {
+    return gThreadCounters.read(sample);
+}
+
+void PerfCountersT::record(PerfCounterSource source, const PerfCounterSample& sample) {
+    auto& totals = mTotals.at(crossbow::to_underlying(source) - 1u);
+    totals.runs.fetch_add(sample.runs, std::memory_order_relaxed);
+    totals.cycles.fetch_add(sample.cycles, std::memory_order_relaxed);
+    totals.instructions.fetch_add(sample.instructions, std::memory_order_relaxed);
+    totals.llcMisses.fetch_add(sample.llcMisses, std::memory_order_relaxed);
+    totals.dtlbMisses.fetch_add(sample.dtlbMisses, std::memory_order_relaxed);
+    totals.tuples.fetch_add(sample.tuples, std::memory_order_relaxed);
+    totals.pages.fetch_add(sample.pages, std::memory_order_relaxed);
+}
+
+PerfCounterSample PerfCountersT::total(PerfCounterSource source) const {
+    auto& totals = mTotals.at(crossbow::to_underlying(source) - 1u);
+    PerfCounterSample sample;
+    sample.runs = totals.runs.load(std::memory_order_relaxed);
+    sample.cycles = totals.cycles.load(std::memory_order_relaxed);
+    sample.instructions = totals.instructions.load(std::memory_order_relaxed);
+    sample.llcMisses = totals.llcMisses.load(std::memory_order_relaxed);
+    sample.dtlbMisses = totals.dtlbMisses.load(std::memory_order_relaxed);
+    sample.tuples = totals.tuples.load(std::memory_order_relaxed);
+    sample.pages = totals.pages.load(std::memory_order_relaxed);
+    return sample;
+}
+
+void PerfCountersT::collect(ServerStatistics& statistics) const {
+    if (!enabled()) {
+        return;
+    }
+    for (auto source : {PerfCounterSource::SCAN, PerfCounterSource::GC}) {
+        statistics.perfCounter(source) += total(source);
+    }
+}
+
+PerfCounterScope::~PerfCounterScope() {
+    if (!mActive) {
+        return;
+    }
+
+    PerfCounterSample end;
+    if (!perfCounters->read(end)) {
+        return;
+    }
+
+    end -= mStart;
+    end.runs = 1u;
+    end.tuples = mTuples;
+    end.pages = mPages;
+    perfCounters->record(mSource, end);
+}
+
+} // namespace store
+} // namespace tell
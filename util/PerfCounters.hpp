@@ -0,0 +1,137 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <tellstore/Statistics.hpp>
+
+#include <crossbow/non_copyable.hpp>
+#include <crossbow/singleton.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Process wide totals of the hardware performance counters measured on the scan and garbage collection threads
+ *
+ * Counting is disabled by default. When enabled every thread lazily opens its own perf_event_open group (cycles,
+ * instructions, LLC read misses and dTLB read misses) on first use. Counters not supported by the machine are skipped
+ * and read as 0.
+ */
+class PerfCountersT : crossbow::non_copyable, crossbow::non_movable {
+public:
+    PerfCountersT();
+
+    /**
+     * @brief Enables counting for all subsequently measured work
+     */
+    void enable() {
+        mEnabled.store(true);
+    }
+
+    bool enabled() const {
+        return mEnabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Reads the current counter values of the calling thread
+     *
+     * @param sample Sample to store the counter values in
+     * @return Whether the counters are available on the calling thread
+     */
+    bool read(PerfCounterSample& sample);
+
+    /**
+     * @brief Adds the sample to the totals of the given source
+     */
+    void record(PerfCounterSource source, const PerfCounterSample& sample);
+
+    /**
+     * @brief Snapshot of the totals of the given source
+     */
+    PerfCounterSample total(PerfCounterSource source) const;
+
+    /**
+     * @brief Adds the totals of all sources to the statistics
+     */
+    void collect(ServerStatistics& statistics) const;
+
+private:
+    static constexpr size_t SOURCE_COUNT = 2u;
+
+    struct Totals {
+        std::atomic<uint64_t> runs;
+        std::atomic<uint64_t> cycles;
+        std::atomic<uint64_t> instructions;
+        std::atomic<uint64_t> llcMisses;
+        std::atomic<uint64_t> dtlbMisses;
+        std::atomic<uint64_t> tuples;
+        std::atomic<uint64_t> pages;
+    };
+
+    std::atomic<bool> mEnabled;
+
+    std::array<Totals, SOURCE_COUNT> mTotals;
+};
+
+using PerfCounters = crossbow::singleton<PerfCountersT>;
+
+extern PerfCounters perfCounters;
+
+/**
+ * @brief Measures the hardware performance counters of the calling thread from construction until destruction
+ *
+ * Does nothing if counting is disabled.
+ */
+class PerfCounterScope : crossbow::non_copyable, crossbow::non_movable {
+public:
+    PerfCounterScope(PerfCounterSource source)
+            : mSource(source),
+              mActive(perfCounters->enabled() && perfCounters->read(mStart)),
+              mTuples(0u),
+              mPages(0u) {
+    }
+
+    ~PerfCounterScope();
+
+    /**
+     * @brief Sets the amount of work done in the scope used to normalize the counters
+     */
+    void setWork(uint64_t tuples, uint64_t pages) {
+        mTuples = tuples;
+        mPages = pages;
+    }
+
+private:
+    PerfCounterSource mSource;
+    PerfCounterSample mStart;
+    bool mActive;
+    uint64_t mTuples;
+    uint64_t mPages;
+};
+
+} // namespace store
+} // namespace tell
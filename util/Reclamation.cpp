@@ -0,0 +1,185 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include "Reclamation.hpp"
+
+#include <crossbow/logger.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <new>
+
+namespace tell {
+namespace store {
+namespace {
+
+/// Era announced by threads that are not inside a guard
+constexpr uint64_t IDLE_ERA = std::numeric_limits<uint64_t>::max();
+
+/**
+ * @brief Announcement slot of a thread
+ *
+ * Slots are never freed, a slot released by an exiting thread is reused by the next thread that enters a guard.
+ */
+struct alignas(64) ThreadRecord {
+    ThreadRecord()
+            : era(IDLE_ERA),
+              used(true),
+              next(nullptr) {
+    }
+
+    std::atomic<uint64_t> era;
+    std::atomic<bool> used;
+    ThreadRecord* next;
+};
+
+/**
+ * @brief Per thread guard nesting depth and slot, releases the slot when the thread exits
+ */
+struct ThreadState {
+    ~ThreadState() {
+        if (record) {
+            record->era.store(IDLE_ERA, std::memory_order_release);
+            record->used.store(false, std::memory_order_release);
+        }
+    }
+
+    ThreadRecord* record = nullptr;
+    uint32_t depth = 0u;
+};
+
+std::atomic<uint64_t> gEra(1u);
+
+std::atomic<ThreadRecord*> gRecords(nullptr);
+
+thread_local ThreadState gThreadState;
+
+ThreadRecord* acquireRecord() {
+    for (auto record = gRecords.load(); record != nullptr; record = record->next) {
+        auto used = false;
+        if (!record->used.load(std::memory_order_relaxed) && record->used.compare_exchange_strong(used, true)) {
+            return record;
+        }
+    }
+
+    // Plain new does not honor the extended alignment (records are never freed)
+    void* memory = nullptr;
+    if (posix_memalign(&memory, alignof(ThreadRecord), sizeof(ThreadRecord)) != 0) {
+        throw std::bad_alloc();
+    }
+    auto record = new (memory) ThreadRecord();
+    auto head = gRecords.load();
+    do {
+        record->next = head;
+    } while (!gRecords.compare_exchange_weak(head, record));
+    return record;
+}
+
+uint64_t minimumActiveEra() {
+    // Pairs with the fence in the guard: Either the guard sees the unlinked structures or we see its announcement
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    auto minEra = IDLE_ERA;
+    for (auto record = gRecords.load(); record != nullptr; record = record->next) {
+        minEra = std::min(minEra, record->era.load(std::memory_order_acquire));
+    }
+    return minEra;
+}
+
+} // anonymous namespace
+
+ReclamationGuard::ReclamationGuard() {
+    auto& state = gThreadState;
+    if (state.depth++ != 0u) {
+        return;
+    }
+    if (!state.record) {
+        state.record = acquireRecord();
+    }
+    state.record->era.store(gEra.load(std::memory_order_acquire), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+ReclamationGuard::~ReclamationGuard() {
+    auto& state = gThreadState;
+    LOG_ASSERT(state.depth > 0u, "Leaving guard that was never entered");
+    if (--state.depth != 0u) {
+        return;
+    }
+    state.record->era.store(IDLE_ERA, std::memory_order_release);
+}
+
+Reclaimer::~Reclaimer() {
+    releaseAll();
+}
+
+void Reclaimer::retire(std::function<void()> fun) {
+    std::lock_guard<decltype(mMutex)> _(mMutex);
+    mRetired.emplace_back(gEra.fetch_add(1u), std::move(fun));
+}
+
+size_t Reclaimer::reclaim() {
+    auto minEra = minimumActiveEra();
+
+    std::vector<RetiredElement> released;
+    {
+        std::lock_guard<decltype(mMutex)> _(mMutex);
+        auto end = std::find_if(mRetired.begin(), mRetired.end(), [minEra] (const RetiredElement& element) {
+            return element.era >= minEra;
+        });
+        released.reserve(static_cast<size_t>(end - mRetired.begin()));
+        std::move(mRetired.begin(), end, std::back_inserter(released));
+        mRetired.erase(mRetired.begin(), end);
+    }
+
+    for (auto& element : released) {
+        element.fun();
+    }
+    return released.size();
+}
+
+void Reclaimer::releaseAll() {
+    while (true) {
+        std::vector<RetiredElement> released;
+        {
+            std::lock_guard<decltype(mMutex)> _(mMutex);
+            released.swap(mRetired);
+        }
+        if (released.empty()) {
+            return;
+        }
+
+        for (auto& element : released) {
+            element.fun();
+        }
+    }
+}
+
+size_t Reclaimer::pending() const {
+    std::lock_guard<decltype(mMutex)> _(mMutex);
+    return mRetired.size();
+}
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,112 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <crossbow/non_copyable.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Marks the calling thread as accessing shared storage structures for the lifetime of the guard
+ *
+ * While a guard is active, no element retired to a Reclaimer after the guard was entered is released. Guards can be
+ * nested, only the outermost guard announces and clears the era of the thread.
+ *
+ * Entering and leaving a guard only touches the thread's own announcement slot, there are no epoch lists to maintain.
+ */
+class ReclamationGuard : crossbow::non_copyable, crossbow::non_movable {
+public:
+    ReclamationGuard();
+
+    ~ReclamationGuard();
+};
+
+/**
+ * @brief Releases retired pages and objects once no thread can reference them anymore
+ *
+ * Every retired element is tagged with the global era at the time it was removed from its shared structure. An element
+ * is released as soon as all threads inside a ReclamationGuard entered after that era. Elements are released
+ * independently of each other and of other reclaimers, a long running guard only holds back the elements retired while
+ * it was active.
+ *
+ * Nothing ever waits for other threads: reclaim() releases whatever is safe at the time of the call and releaseAll()
+ * (used on shutdown when no readers are left) releases everything.
+ */
+class Reclaimer : crossbow::non_copyable, crossbow::non_movable {
+public:
+    Reclaimer() = default;
+
+    ~Reclaimer();
+
+    /**
+     * @brief Retires an element that was already unlinked from all shared structures
+     *
+     * The function is invoked (from an arbitrary thread calling reclaim()) once no thread can reference the element.
+     */
+    void retire(std::function<void()> fun);
+
+    /**
+     * @brief Releases all retired elements that are no longer referenced by any thread
+     *
+     * @return Number of released elements
+     */
+    size_t reclaim();
+
+    /**
+     * @brief Releases all retired elements without checking for active threads
+     *
+     * Must only be called when no thread accesses the shared structures anymore.
+     */
+    void releaseAll();
+
+    /**
+     * @brief Number of retired elements waiting to be released
+     */
+    size_t pending() const;
+
+private:
+    struct RetiredElement {
+        RetiredElement(uint64_t e, std::function<void()> f)
+                : era(e),
+                  fun(std::move(f)) {
+        }
+
+        uint64_t era;
+        std::function<void()> fun;
+    };
+
+    mutable std::mutex mMutex;
+
+    /// Retired elements in ascending era order
+    std::vector<RetiredElement> mRetired;
+};
+
+} // namespace store
+} // namespace tell
@@ -23,28 +23,45 @@
 #pragma once
 
 #include <config.h>
+#include "PerfCounters.hpp"
+#include "Reclamation.hpp"
 #include "ScanQuery.hpp"
+#include "StorageConfig.hpp"
+#include "ThreadAffinity.hpp"
 
 #include <tellstore/ErrorCode.hpp>
 #include <tellstore/Record.hpp>
 
-#include <crossbow/allocator.hpp>
 #include <crossbow/non_copyable.hpp>
 #include <crossbow/singleconsumerqueue.hpp>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstring>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <tuple>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace tell {
 namespace store {
 
+/**
+ * @brief Runs the scan processor while measuring the hardware performance counters of the calling thread
+ */
+template <class Processor>
+void processWithCounters(Processor& processor) {
+    PerfCounterScope counters(PerfCounterSource::SCAN);
+    processor.process();
+    counters.setWork(processor.tupleCount(), processor.pageCount());
+}
+
 template<class Table>
 class ScanThread : crossbow::non_copyable, crossbow::non_movable {
 public:
@@ -63,6 +80,10 @@ public:
         notify(processor, PointerTag::PROCESS);
     }
 
+    std::thread::native_handle_type nativeHandle() {
+        return mThread.native_handle();
+    }
+
     bool isBusy() const {
         return (mData.load() != 0);
     }
@@ -115,7 +136,7 @@ void ScanThread<Table>::operator()() {
         } else if ((data & crossbow::to_underlying(PointerTag::PROCESS)) != 0) {
             auto processor = reinterpret_cast<typename Table::ScanProcessor*>(data &
                     ~crossbow::to_underlying(PointerTag::PROCESS));
-            processor->process();
+            processWithCounters(*processor);
         } else {
             LOG_ASSERT(false, "Unknown pointer tag");
         }
@@ -133,87 +154,288 @@ void ScanThread<Table>::notify(void* data, ScanThread::PointerTag tag) {
     mWaitCondition.notify_one();
 }
 
+/**
+ * @brief Shares scans of concurrent queries on the scan threads
+ *
+ * Queries are admitted into one of two queues by their priority: Interactive queries (aggregations) and batch queries
+ * (full scans and projections) are never shared in the same scan, so a short aggregation does not have to wait for a
+ * heavy projection to push all its tuples to the client.
+ *
+ * If threads are reserved for interactive queries they form a separate lane with its own master thread. Otherwise the
+ * single lane alternates between the two queues, always starting with the interactive queue. Scans of the same table
+ * are serialized across the lanes as scans may modify the table (e.g. the log-structured store recycles its log
+ * during every scan).
+ */
 template<class Table>
 class ScanManager : crossbow::non_copyable, crossbow::non_movable {
     using ScanRequest = std::tuple<uint64_t, Table*, ScanQuery*>;
+    using ScanQueue = crossbow::SingleConsumerQueue<ScanRequest, MAX_QUERY_SHARING>;
+
+    /**
+     * @brief Master and slave threads executing the scans of one or both queues
+     */
+    struct ScanLane {
+        ScanLane(size_t numThreads)
+            : numThreads(numThreads)
+            , enqueuedQueries(MAX_QUERY_SHARING, ScanRequest(0u, nullptr, nullptr)) {
+        }
+
+        size_t numThreads;
+        std::vector<ScanRequest> enqueuedQueries;
+        std::vector<std::unique_ptr<ScanThread<Table>>> slaves;
+        std::thread masterThread;
+    };
 
-    size_t mNumThreads;
-    crossbow::SingleConsumerQueue<ScanRequest, MAX_QUERY_SHARING> queryQueue;
-    std::vector<ScanRequest> mEnqueuedQueries;
+    ScanQueue mInteractiveQueue;
+    ScanQueue mBatchQueue;
     std::atomic<bool> stopScans;
 
-    std::vector<std::unique_ptr<ScanThread<Table>>> mSlaves;
-    std::thread mMasterThread;
+    /// Number of slots in the queues that were reserved but not yet read by a master thread
+    std::atomic<size_t> mInteractiveReserved;
+    std::atomic<size_t> mBatchReserved;
+
+    /// Number of scan requests enqueued but not yet completed by table
+    std::mutex mPendingMutex;
+    std::unordered_map<const Table*, size_t> mPendingScans;
+
+    ScanLane mMainLane;
+    ScanLane mInteractiveLane;
+
+    /// Cores the scan threads are pinned to (empty if the threads are not pinned)
+    std::vector<unsigned> mCores;
+
+    /// Protects the set of tables currently scanned by one of the lanes
+    std::mutex mActiveMutex;
+    std::condition_variable mActiveCondition;
+    std::unordered_set<uint64_t> mActiveTables;
+
+    /**
+     * @brief Claims the table for a scan of the calling lane
+     *
+     * Each lane scans at most one table at a time, so waiting for the other lane to finish can not deadlock.
+     */
+    class TableScanGuard : crossbow::non_copyable, crossbow::non_movable {
+    public:
+        TableScanGuard(ScanManager& manager, uint64_t tableId)
+                : mManager(manager),
+                  mTableId(tableId) {
+            std::unique_lock<decltype(mManager.mActiveMutex)> lock(mManager.mActiveMutex);
+            mManager.mActiveCondition.wait(lock, [this] () {
+                return mManager.mActiveTables.count(mTableId) == 0;
+            });
+            mManager.mActiveTables.insert(mTableId);
+        }
+
+        ~TableScanGuard() {
+            {
+                std::unique_lock<decltype(mManager.mActiveMutex)> lock(mManager.mActiveMutex);
+                mManager.mActiveTables.erase(mTableId);
+            }
+            mManager.mActiveCondition.notify_all();
+        }
+
+    private:
+        ScanManager& mManager;
+        uint64_t mTableId;
+    };
 public:
-    ScanManager(size_t numThreads)
-        : mNumThreads(numThreads)
-        , mEnqueuedQueries(MAX_QUERY_SHARING, ScanRequest(0u, nullptr, nullptr))
-        , stopScans(false) {
-        if (mNumThreads == 0u) {
+    /**
+     * Uses config.numScanThreads threads in total of which config.numInteractiveScanThreads are reserved for
+     * interactive queries (0 to share all threads between both queues).
+     */
+    ScanManager(const StorageConfig& config)
+        : stopScans(false)
+        , mInteractiveReserved(0u)
+        , mBatchReserved(0u)
+        , mMainLane(config.numScanThreads - std::min(config.numInteractiveScanThreads,
+                (config.numScanThreads == 0u ? 0u : config.numScanThreads - 1u)))
+        , mInteractiveLane(config.numScanThreads - mMainLane.numThreads)
+        , mCores(config.scanCores) {
+        if (config.numScanThreads == 0u) {
             LOG_WARN("No scan threads set - Scan will be unavailable");
+        } else if (mInteractiveLane.numThreads != config.numInteractiveScanThreads) {
+            LOG_WARN("Only %1% of %2% scan threads reserved for interactive scans", mInteractiveLane.numThreads,
+                    config.numInteractiveScanThreads);
         }
     }
 
     ~ScanManager() {
         stopScans.store(true);
-        if (mNumThreads != 0u) {
-            mMasterThread.join();
+        for (auto lane : {&mMainLane, &mInteractiveLane}) {
+            if (lane->numThreads != 0u) {
+                lane->masterThread.join();
+            }
         }
     }
 
     void run();
 
     int scan(uint64_t tableId, Table* table, ScanQuery* query) {
-        return (queryQueue.tryWrite(std::make_tuple(tableId, table, query)) ? 0 : error::server_overlad);
+        if (!reserve(query)) {
+            return error::server_overlad;
+        }
+        return scanReserved(tableId, table, query);
+    }
+
+    /**
+     * @brief Reserves a slot in the queue the query is executed from
+     *
+     * A scan enqueued into a reserved slot is never rejected, this allows a query to be admitted on several scan
+     * managers at once without having to withdraw it from some of them.
+     *
+     * @return False if the queue is full
+     */
+    bool reserve(ScanQuery* query) {
+        auto& reserved = reservedSlots(query);
+        if (reserved.fetch_add(1u) >= MAX_QUERY_SHARING) {
+            reserved.fetch_sub(1u);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Releases a slot previously reserved with reserve() without enqueuing a scan
+     */
+    void release(ScanQuery* query) {
+        reservedSlots(query).fetch_sub(1u);
+    }
+
+    /**
+     * @brief Enqueues the scan into a slot previously reserved with reserve()
+     */
+    int scanReserved(uint64_t tableId, Table* table, ScanQuery* query) {
+        {
+            std::lock_guard<std::mutex> _(mPendingMutex);
+            ++mPendingScans[table];
+        }
+        if (!queue(query).tryWrite(std::make_tuple(tableId, table, query))) {
+            LOG_ERROR("Scan queue is full despite the reservation");
+            {
+                std::lock_guard<std::mutex> _(mPendingMutex);
+                completeScan(table);
+            }
+            release(query);
+            return error::server_overlad;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Whether scan requests on the table were enqueued but have not yet completed
+     *
+     * Once this returns false no scan references the table unless it was passed to scan() after the call.
+     */
+    bool hasPendingScans(const Table* table) {
+        std::lock_guard<std::mutex> _(mPendingMutex);
+        return (mPendingScans.find(table) != mPendingScans.end());
     }
 
 private:
-    void operator()();
+    /**
+     * @brief The queue the query is executed from
+     *
+     * Garbage collection scans have no query and are always executed as batch scans.
+     */
+    ScanQueue& queue(ScanQuery* query) {
+        return ((query && query->priority() == ScanPriority::INTERACTIVE) ? mInteractiveQueue : mBatchQueue);
+    }
+
+    std::atomic<size_t>& reservedSlots(ScanQuery* query) {
+        return ((query && query->priority() == ScanPriority::INTERACTIVE) ? mInteractiveReserved : mBatchReserved);
+    }
+
+    std::atomic<size_t>& reservedSlots(const ScanQueue& queue) {
+        return (&queue == &mInteractiveQueue ? mInteractiveReserved : mBatchReserved);
+    }
+
+    /**
+     * @brief Removes a scan request on the table from the pending scans
+     *
+     * Must be called while holding the pending mutex.
+     */
+    void completeScan(const Table* table) {
+        auto pending = mPendingScans.find(table);
+        LOG_ASSERT(pending != mPendingScans.end(), "Completed scan was not pending");
+        if (--pending->second == 0u) {
+            mPendingScans.erase(pending);
+        }
+    }
 
-    bool masterThread();
+    void operator()(ScanLane& lane, bool interactive, bool batch);
+
+    /**
+     * @brief Executes shared scans for all queries currently waiting in the queue
+     *
+     * @return Whether any query was waiting in the queue
+     */
+    bool masterThread(ScanLane& lane, ScanQueue& queue);
 };
 
 template<class Table>
 void ScanManager<Table>::run() {
-    if (mNumThreads == 0) {
+    if (mMainLane.numThreads == 0) {
         return;
     }
 
-    mSlaves.reserve(mNumThreads - 1);
-    for (decltype(mNumThreads) i = 0; i < mNumThreads - 1; ++i) {
-        mSlaves.emplace_back(new ScanThread<Table>());
+    // Cores are assigned to the master thread and then the slaves of the main lane followed by the interactive lane
+    auto dedicated = (mInteractiveLane.numThreads != 0);
+    size_t coreIdx = 0;
+    for (auto lane : {&mMainLane, &mInteractiveLane}) {
+        if (lane->numThreads == 0) {
+            continue;
+        }
+        ++coreIdx;
+        lane->slaves.reserve(lane->numThreads - 1);
+        for (decltype(lane->numThreads) i = 0; i < lane->numThreads - 1; ++i) {
+            lane->slaves.emplace_back(new ScanThread<Table>());
+            pinThread(lane->slaves.back()->nativeHandle(), mCores, coreIdx++);
+        }
     }
 
-    mMasterThread = std::thread(&ScanManager<Table>::operator(), this);
+    mMainLane.masterThread = std::thread(&ScanManager<Table>::operator(), this, std::ref(mMainLane), !dedicated,
+            true);
+    pinThread(mMainLane.masterThread.native_handle(), mCores, 0);
+    if (dedicated) {
+        mInteractiveLane.masterThread = std::thread(&ScanManager<Table>::operator(), this, std::ref(mInteractiveLane),
+                true, false);
+        pinThread(mInteractiveLane.masterThread.native_handle(), mCores, mMainLane.numThreads);
+    }
 }
 
 template<class Table>
-void ScanManager<Table>::operator()() {
+void ScanManager<Table>::operator()(ScanLane& lane, bool interactive, bool batch) {
     while (!stopScans.load()) {
-        if (!masterThread()) {
+        // Interactive queries go first but batch queries are served in every round so they can not starve
+        auto processed = (interactive && masterThread(lane, mInteractiveQueue));
+        processed = (batch && masterThread(lane, mBatchQueue)) || processed;
+        if (!processed) {
             std::this_thread::yield();
         }
     }
-    for (auto& slave : mSlaves) {
+    for (auto& slave : lane.slaves) {
         slave->stop();
     }
 }
 
 template<class Table>
-bool ScanManager<Table>::masterThread() {
+bool ScanManager<Table>::masterThread(ScanLane& lane, ScanQueue& queue) {
+    auto& slaves = lane.slaves;
+
     // A map of all queries we get during this scan phase. Key is the table id, value is:
     //  - the Table object
     //  - the total size
     //  - a vector of queries - that means the query object and the size of the query
     std::unordered_map<uint64_t, std::tuple<Table*, std::vector<ScanQuery*>>> queryMap;
-    auto numQueries = queryQueue.readMultiple(mEnqueuedQueries.begin(), mEnqueuedQueries.end());
+    auto numQueries = queue.readMultiple(lane.enqueuedQueries.begin(), lane.enqueuedQueries.end());
     if (numQueries == 0) return false;
+    reservedSlots(queue).fetch_sub(numQueries);
 
     for (size_t i = 0; i < numQueries; ++i) {
         uint64_t tableId;
         Table* table;
         ScanQuery* query;
-        std::tie(tableId, table, query) = mEnqueuedQueries.at(i);
+        std::tie(tableId, table, query) = lane.enqueuedQueries.at(i);
         auto iter = queryMap.find(tableId);
         if (iter == queryMap.end()) {
             auto res = queryMap.emplace(tableId, std::make_tuple(table, std::vector<ScanQuery*>()));
@@ -233,35 +455,46 @@ bool ScanManager<Table>::masterThread() {
         std::vector<ScanQuery*> queries;
         std::tie(table, queries) = std::move(q.second);
 
-        //auto startTime = std::chrono::steady_clock::now();
+        // Released after the scan and all its processors were destroyed at the end of the iteration
+        TableScanGuard tableGuard(*this, q.first);
+
+        auto startTime = std::chrono::steady_clock::now();
         //auto queryCount = queries.size();
+        auto batch = queries;
         typename Table::Scan scan(table, std::move(queries));
 
-        if (!mSlaves.empty()) {
-            mSlaves.front()->prepare(&scan);
+        if (!slaves.empty()) {
+            slaves.front()->prepare(&scan);
         } else {
             scan.prepareMaterialization();
         }
         scan.prepareQuery();
-        if (!mSlaves.empty()) {
-            auto& slave = mSlaves.front();
+        if (!slaves.empty()) {
+            auto& slave = slaves.front();
             while (slave->isBusy()) std::this_thread::yield();
         }
-        //auto prepareTime = std::chrono::steady_clock::now();
+        auto prepareTime = std::chrono::steady_clock::now();
+        auto prepareDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(prepareTime - startTime);
+        for (auto query : batch) {
+            query->setPrepareDuration(prepareDuration);
+        }
 
-        crossbow::allocator _;
+        ReclamationGuard _;
 
-        auto processors = scan.startScan(mNumThreads);
-        for (decltype(mSlaves.size()) i = 0; i < mSlaves.size(); ++i) {
+        auto processors = scan.startScan(lane.numThreads);
+        for (auto query : batch) {
+            query->scanStarted();
+        }
+        for (decltype(slaves.size()) i = 0; i < slaves.size(); ++i) {
             // we do not need to synchronize here, the scan threads start as soon as the processor is set
-            mSlaves[i]->process(processors[i].get());
+            slaves[i]->process(processors[i].get());
         }
 
         // do the master thread part of the scan
-        processors[mSlaves.size()]->process();
+        processWithCounters(*processors[slaves.size()]);
 
         // now we need to wait until the other threads are done
-        for (auto& slave : mSlaves) {
+        for (auto& slave : slaves) {
             // as soon as the thread is done, it will unset the processors - this means that the scan is over and
             // the master can delete the processors savely (which will be done as soon as the scope is left).
             while (slave->isBusy()) std::this_thread::yield();
@@ -274,6 +507,12 @@ bool ScanManager<Table>::masterThread() {
         //LOG_INFO("Scan took %1%ms for %2% queries [prepare = %3%, process = %4%]",
         //         totalDuration.count(), queryCount, prepareDuration.count(), processDuration.count());
     }
+    {
+        std::lock_guard<std::mutex> _(mPendingMutex);
+        for (size_t i = 0; i < numQueries; ++i) {
+            completeScan(std::get<1>(lane.enqueuedQueries[i]));
+        }
+    }
     return true;
 }
 
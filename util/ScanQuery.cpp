@@ -97,11 +97,30 @@ ScanQuery::ScanQuery(ScanQueryType queryType, std::unique_ptr<char[]> selectionD
           mQueryLength(queryLength),
           mSnapshot(std::move(snapshot)),
           mRecord(buildScanRecord(mQueryType, mQueryData.get(), mQueryData.get() + mQueryLength, record)),
-          mMinimumLength(mRecord.staticSize() + ScanQueryProcessor::TUPLE_OVERHEAD) {
+          mMinimumLength(mRecord.staticSize() + ScanQueryProcessor::TUPLE_OVERHEAD),
+          mPrepareDuration(0),
+          mActive(0u),
+          mExpectedScans(0u) {
 }
 
 ScanQuery::~ScanQuery() = default;
 
+void ScanQuery::expectScans(size_t count) {
+    mExpectedScans += static_cast<uint32_t>(count);
+    mActive += static_cast<uint32_t>(count);
+}
+
+void ScanQuery::scanStarted() {
+    // Queries executed by a single scan never expect any scans
+    auto expected = mExpectedScans.load();
+    do {
+        if (expected == 0u) {
+            return;
+        }
+    } while (!mExpectedScans.compare_exchange_weak(expected, expected - 1u));
+    processorDone();
+}
+
 ScanQueryProcessor::~ScanQueryProcessor() {
     if (!mData) {
         return;
@@ -32,6 +32,8 @@
 #include <crossbow/logger.hpp>
 #include <crossbow/non_copyable.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -131,6 +133,24 @@ private:
     const char* mPos;
 };
 
+/**
+ * @brief Scheduling class of a scan query
+ */
+enum class ScanPriority : uint8_t {
+    /// Short running queries producing little output (aggregations)
+    INTERACTIVE = 0x1u,
+
+    /// Queries producing output proportional to the table size (full scans and projections)
+    BATCH,
+};
+
+/**
+ * @brief The scheduling class queries of the given type are executed in
+ */
+inline ScanPriority scanPriority(ScanQueryType queryType) {
+    return (queryType == ScanQueryType::AGGREGATION ? ScanPriority::INTERACTIVE : ScanPriority::BATCH);
+}
+
 /**
  * @brief Information about a scan query
  *
@@ -163,6 +183,10 @@ public:
         return mQueryType;
     }
 
+    ScanPriority priority() const {
+        return scanPriority(mQueryType);
+    }
+
     const char* selection() const {
         return mSelectionData.get();
     }
@@ -211,6 +235,19 @@ public:
         return mMinimumLength;
     }
 
+    /**
+     * @brief Time spent generating and compiling the code of the shared scan this query was executed in
+     *
+     * Set by the scan manager before any processor of the query is created.
+     */
+    std::chrono::nanoseconds prepareDuration() const {
+        return mPrepareDuration;
+    }
+
+    void setPrepareDuration(std::chrono::nanoseconds duration) {
+        mPrepareDuration = duration;
+    }
+
     /**
      * @brief Acquires a new buffer
      */
@@ -250,6 +287,43 @@ public:
      */
     virtual ScanQueryProcessor createProcessor() = 0;
 
+    /**
+     * @brief Announces that the query will be executed by the given number of independent scans
+     *
+     * The query must not be marked as done before every announced scan invoked scanStarted() (i.e. created all its
+     * processors). Keeps the query active until the given number of scans started.
+     */
+    virtual void expectScans(size_t count);
+
+    /**
+     * @brief Invoked by the scan manager after all processors of a scan were created for this query
+     *
+     * Releases one of the expected scans (if any).
+     */
+    virtual void scanStarted();
+
+protected:
+    /**
+     * @brief Increases the number of active ScanQueryProcessor referencing the query
+     */
+    void processorStarted() {
+        ++mActive;
+    }
+
+    /**
+     * @brief Decreases the number of active ScanQueryProcessor and invokes queryDone() once all are done
+     */
+    void processorDone() {
+        if (--mActive == 0u) {
+            queryDone();
+        }
+    }
+
+    /**
+     * @brief Invoked after the last processor of every scan executing the query is done
+     */
+    virtual void queryDone() = 0;
+
 private:
     /// The type of the scan query
     ScanQueryType mQueryType;
@@ -276,6 +350,15 @@ private:
 
     /// Minimum size a tuple requires (i.e. minimum static size)
     uint32_t mMinimumLength;
+
+    /// Time spent preparing the shared scan
+    std::chrono::nanoseconds mPrepareDuration;
+
+    /// Number of active ScanQueryProcessor and announced scans that did not start yet
+    std::atomic<uint32_t> mActive;
+
+    /// Number of announced scans that did not start yet
+    std::atomic<uint32_t> mExpectedScans;
 };
 
 /**
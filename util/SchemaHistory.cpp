@@ -0,0 +1,181 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+
+#include "SchemaHistory.hpp"
+
+#include <tellstore/ErrorCode.hpp>
+
+#include <crossbow/alignment.hpp>
+#include <crossbow/logger.hpp>
+
+#include <cstring>
+
+namespace tell {
+namespace store {
+
+RecordConverter::RecordConverter(const Record& from, const Record& to, std::vector<int32_t> mapping)
+        : mFrom(from),
+          mTo(to),
+          mMapping(std::move(mapping)) {
+    LOG_ASSERT(mMapping.size() == mTo.fieldCount(), "Mapping must contain an entry for every target field");
+}
+
+uint32_t RecordConverter::convertedSize(const char* src) const {
+    auto size = mTo.staticSize();
+    for (auto id = mTo.fixedSizeFieldCount(); id < mTo.fieldCount(); ++id) {
+        auto fromId = mMapping[id];
+        if (fromId < 0) {
+            continue;
+        }
+        auto offsets = reinterpret_cast<const uint32_t*>(src + mFrom.getFieldMeta(fromId).offset);
+        size += offsets[1] - offsets[0];
+    }
+    return crossbow::align(size, 8u);
+}
+
+uint32_t RecordConverter::convert(const char* src, char* dest) const {
+    // Clear the header and all fixed size fields: Fields without source are NULL respectively zero
+    memset(dest, 0, mTo.staticSize());
+
+    auto heapOffset = mTo.staticSize();
+    for (decltype(mTo.fieldCount()) id = 0; id < mTo.fieldCount(); ++id) {
+        auto& meta = mTo.getFieldMeta(id);
+        auto fromId = mMapping[id];
+
+        if (fromId < 0) {
+            if (!meta.field.isNotNull()) {
+                mTo.setFieldNull(dest, meta.nullIdx, true);
+            }
+            if (!meta.field.isFixedSized()) {
+                *reinterpret_cast<uint32_t*>(dest + meta.offset) = heapOffset;
+            }
+            continue;
+        }
+
+        auto& fromMeta = mFrom.getFieldMeta(fromId);
+        if (!meta.field.isNotNull()) {
+            auto isNull = !fromMeta.field.isNotNull() && mFrom.isFieldNull(src, fromMeta.nullIdx);
+            mTo.setFieldNull(dest, meta.nullIdx, isNull);
+        }
+
+        if (meta.field.isFixedSized()) {
+            memcpy(dest + meta.offset, src + fromMeta.offset, meta.field.staticSize());
+        } else {
+            auto offsets = reinterpret_cast<const uint32_t*>(src + fromMeta.offset);
+            auto length = offsets[1] - offsets[0];
+            *reinterpret_cast<uint32_t*>(dest + meta.offset) = heapOffset;
+            memcpy(dest + heapOffset, src + offsets[0], length);
+            heapOffset += length;
+        }
+    }
+
+    if (mTo.varSizeFieldCount() != 0) {
+        *reinterpret_cast<uint32_t*>(dest + mTo.staticSize() - sizeof(uint32_t)) = heapOffset;
+    }
+
+    auto size = crossbow::align(heapOffset, 8u);
+    memset(dest + heapOffset, 0, size - heapOffset);
+    return size;
+}
+
+constexpr uint32_t SchemaHistory::MAX_VERSIONS;
+
+SchemaHistory::SchemaHistory(Schema schema)
+        : mNewestVersion(0u) {
+    mVersions[0].reset(new Version(std::move(schema)));
+}
+
+int SchemaHistory::addVersion(Schema schema) {
+    std::unique_ptr<Version> version;
+    if (auto ec = buildVersion(std::move(schema), version)) {
+        return ec;
+    }
+
+    auto newestVersion = mNewestVersion.load() + 1;
+    mVersions[newestVersion] = std::move(version);
+    mNewestVersion.store(newestVersion);
+    return 0;
+}
+
+int SchemaHistory::checkVersion(const Schema& schema) const {
+    std::unique_ptr<Version> version;
+    return buildVersion(schema, version);
+}
+
+int SchemaHistory::buildVersion(Schema schema, std::unique_ptr<Version>& result) const {
+    auto previousVersion = mNewestVersion.load();
+    if (previousVersion + 1 == MAX_VERSIONS) {
+        LOG_ERROR("Table reached the maximum of %1% schema versions", MAX_VERSIONS);
+        return error::invalid_schema_change;
+    }
+    auto& previous = *mVersions[previousVersion];
+    if (schema.type() != previous.record.schema().type()) {
+        return error::invalid_schema_change;
+    }
+
+    // Clients cache the partitioner of a table, changing it would route existing keys to other shards
+    if (schema.partitioning() != previous.record.schema().partitioning()) {
+        LOG_ERROR("Schema changes must not change the partitioning of the table");
+        return error::invalid_schema_change;
+    }
+
+    std::unique_ptr<Version> version(new Version(std::move(schema)));
+    auto& record = version->record;
+
+    // Match the fields with the previous version by name
+    std::vector<int32_t> mapping;
+    mapping.reserve(record.fieldCount());
+    for (decltype(record.fieldCount()) id = 0; id < record.fieldCount(); ++id) {
+        auto& field = record.getFieldMeta(id).field;
+        Record::id_t previousId;
+        if (!previous.record.idOf(field.name(), previousId)) {
+            mapping.emplace_back(-1);
+            continue;
+        }
+        auto& previousField = previous.record.getFieldMeta(previousId).field;
+        if (field.type() != previousField.type() || field.isNotNull() != previousField.isNotNull()) {
+            LOG_ERROR("Field %1% changed its type or NULL constraint", field.name());
+            return error::invalid_schema_change;
+        }
+        mapping.emplace_back(previousId);
+    }
+
+    // Compose the mapping with the mappings of the previous version to get the converters from all older versions
+    version->converters.reserve(previousVersion + 1);
+    for (decltype(previousVersion) i = 0; i < previousVersion; ++i) {
+        auto& previousMapping = previous.converters[i].mapping();
+        std::vector<int32_t> composed;
+        composed.reserve(mapping.size());
+        for (auto id : mapping) {
+            composed.emplace_back(id < 0 ? -1 : previousMapping[id]);
+        }
+        version->converters.emplace_back(mVersions[i]->record, record, std::move(composed));
+    }
+    version->converters.emplace_back(previous.record, record, std::move(mapping));
+
+    result = std::move(version);
+    return 0;
+}
+
+} // namespace store
+} // namespace tell
@@ -0,0 +1,152 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <tellstore/Record.hpp>
+
+#include <crossbow/non_copyable.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Converts tuples from one schema version of a table into another
+ *
+ * Every field of the target record is either copied from its source field or, if the field has no source, set to NULL
+ * (zero respectively empty if the field is NOT NULL). Source fields without a target field are dropped.
+ */
+class RecordConverter {
+public:
+    /**
+     * @param from Record of the source tuples
+     * @param to Record of the converted tuples
+     * @param mapping ID of the source field for every field of the target record (-1 if the field has no source)
+     */
+    RecordConverter(const Record& from, const Record& to, std::vector<int32_t> mapping);
+
+    const std::vector<int32_t>& mapping() const {
+        return mMapping;
+    }
+
+    /**
+     * @brief Size of the given source tuple after conversion (padded to 8 bytes)
+     */
+    uint32_t convertedSize(const char* src) const;
+
+    /**
+     * @brief Writes the converted source tuple to dest
+     *
+     * The destination must be 8 byte aligned and have space for convertedSize(src) bytes.
+     *
+     * @return The size of the converted tuple
+     */
+    uint32_t convert(const char* src, char* dest) const;
+
+private:
+    const Record& mFrom;
+    const Record& mTo;
+    std::vector<int32_t> mMapping;
+};
+
+/**
+ * @brief All schema versions of a table
+ *
+ * Tuples keep the schema version they were written in until the storage rewrites them. Versions are only appended and
+ * never removed, references to the records and converters of a version remain valid as long as the history exists.
+ */
+class SchemaHistory : crossbow::non_copyable, crossbow::non_movable {
+public:
+    /// Maximum number of schema versions of a table
+    static constexpr uint32_t MAX_VERSIONS = 256u;
+
+    SchemaHistory(Schema schema);
+
+    uint32_t newestVersion() const {
+        return mNewestVersion.load();
+    }
+
+    const Record& record(uint32_t version) const {
+        return mVersions[version]->record;
+    }
+
+    const Record& newestRecord() const {
+        return record(newestVersion());
+    }
+
+    /**
+     * @brief Converter from tuples of version from to version to
+     *
+     * The source version must be older than the target version.
+     */
+    const RecordConverter& converter(uint32_t from, uint32_t to) const {
+        return mVersions[to]->converters[from];
+    }
+
+    /**
+     * @brief Appends the schema as newest version
+     *
+     * Fields are matched by name with the fields of the previous version and must keep their type and NULL constraint.
+     * The table type and partitioning must not change. A dropped field that is added again in a later version does not get back its old values. Must not be called
+     * concurrently.
+     *
+     * @return 0 or error::invalid_schema_change if the schema is not a valid successor of the newest version
+     */
+    int addVersion(Schema schema);
+
+    /**
+     * @brief Checks if the schema is a valid successor of the newest version without appending it
+     *
+     * @return 0 or error::invalid_schema_change if the schema is not a valid successor of the newest version
+     */
+    int checkVersion(const Schema& schema) const;
+
+private:
+    struct Version {
+        Version(Schema schema)
+                : record(std::move(schema)) {
+        }
+
+        Record record;
+
+        /// Converters from every older version into this version (indexed by the older version)
+        std::vector<RecordConverter> converters;
+    };
+
+    /**
+     * @brief Builds the successor of the newest version from the schema
+     */
+    int buildVersion(Schema schema, std::unique_ptr<Version>& result) const;
+
+    std::array<std::unique_ptr<Version>, MAX_VERSIONS> mVersions;
+
+    std::atomic<uint32_t> mNewestVersion;
+};
+
+} // namespace store
+} // namespace tell
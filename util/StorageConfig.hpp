@@ -23,6 +23,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 #include <config.h>
 
 namespace tell {
@@ -31,7 +32,11 @@ struct StorageConfig {
     uint16_t gcInterval = 60;
     size_t totalMemory = TOTAL_MEMORY;
     size_t numScanThreads = 2;
+    size_t numInteractiveScanThreads = 0;
+    std::vector<unsigned> scanCores;
+    std::vector<unsigned> gcCores;
     size_t hashMapCapacity = HASHMAP_CAPACITY;
+    size_t numPartitions = 1;
 };
 } // namespace store
 } // namespace tell
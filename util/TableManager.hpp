@@ -22,8 +22,11 @@
  */
 #pragma once
 
+#include "PageManager.hpp"
+#include "Reclamation.hpp"
 #include "StorageConfig.hpp"
 #include "Scan.hpp"
+#include "ThreadAffinity.hpp"
 #include "VersionManager.hpp"
 
 #include <tellstore/Record.hpp>
@@ -34,6 +37,7 @@
 #include <crossbow/concurrent_map.hpp>
 #include <crossbow/string.hpp>
 
+#include <algorithm>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -57,7 +61,6 @@ namespace tell {
 namespace store {
 
 class ScanQuery;
-class PageManager;
 
 class NoGC {
 public:
@@ -78,6 +81,11 @@ private:
     tbb::concurrent_unordered_map<crossbow::string, uint64_t> mNames;
     tbb::concurrent_unordered_map<uint64_t, Table*> mTables;
     std::atomic<uint64_t> mLastTableIdx;
+
+    /// Tables removed from the table map that may still be referenced by the garbage collection or a queued scan
+    std::vector<Table*> mDroppedTables;
+    std::mutex mDroppedMutex;
+
     std::condition_variable mStopCondition;
     mutable std::mutex mGCMutex;
     std::thread mGCThread;
@@ -94,14 +102,18 @@ private:
             if (mShutDown.load()) return;
             begin = Clock::now();
             std::vector<Table*> tables;
-            tables.reserve(mNames.size());
             {
                 typename decltype(mTablesMutex)::scoped_lock _(mTablesMutex, false);
+                tables.reserve(mTables.size());
                 for (auto& p : mTables) {
                     tables.push_back(p.second);
                 }
             }
             mGC.run(tables, mVersionManager.lowestActiveVersion());
+            retireDroppedTables();
+
+            // Hand back everything the GC retired that is no longer referenced by any reader
+            mPageManager.reclaim();
         }
     }
 
@@ -111,11 +123,12 @@ public:
         , mGC(gc)
         , mPageManager(pageManager)
         , mVersionManager(versionManager)
-        , mScanManager(config.numScanThreads)
+        , mScanManager(config)
         , mShutDown(false)
         , mLastTableIdx(0)
         , mGCThread(std::bind(&TableManager::gcThread, this))
     {
+        pinThread(mGCThread.native_handle(), mConfig.gcCores, 0);
         mScanManager.run();
     }
 
@@ -126,6 +139,9 @@ public:
         for (auto t : mTables) {
             crossbow::allocator::destroy_now(t.second);
         }
+        for (auto t : mDroppedTables) {
+            crossbow::allocator::destroy_now(t);
+        }
     }
 
 public:
@@ -142,7 +158,6 @@ public:
             return false;
         }
 
-        crossbow::allocator __;
         typename decltype(mTablesMutex)::scoped_lock _(mTablesMutex, false);
         idx = ++mLastTableIdx;
         {
@@ -160,6 +175,76 @@ public:
         return true;
     }
 
+    int checkAlterTable(uint64_t tableId, uint32_t schemaVersion, const Schema& schema) {
+        return executeTable(tableId, [schemaVersion, &schema] (Table* table) {
+            return table->checkAlterTable(schemaVersion, schema);
+        });
+    }
+
+    /**
+     * @brief Adds the schema as newest schema version of the table
+     *
+     * The table map is locked while the table is altered so a concurrent truncation copies either all or none of the
+     * schema change into the new table.
+     */
+    int alterTable(uint64_t tableId, uint32_t schemaVersion, const Schema& schema) {
+        typename decltype(mTablesMutex)::scoped_lock _(mTablesMutex, false);
+        auto i = mTables.find(tableId);
+        if (i == mTables.end()) {
+            return error::invalid_table;
+        }
+        return i->second->alterTable(schemaVersion, schema);
+    }
+
+    /**
+     * @brief Removes the table and releases all its pages
+     *
+     * The table is unlinked from the table map at once so its name can be reused immediately. The pages of the table
+     * are handed to the page manager in bulk as soon as no reader, garbage collection or queued scan can reference the
+     * table anymore.
+     */
+    int dropTable(uint64_t tableId) {
+        {
+            typename decltype(mTablesMutex)::scoped_lock _(mTablesMutex, true);
+            auto i = mTables.find(tableId);
+            if (i == mTables.end()) {
+                return error::invalid_table;
+            }
+            auto table = i->second;
+            mNames.unsafe_erase(table->tableName());
+            mTables.unsafe_erase(i);
+            dropLocked(table);
+        }
+        tryRetireDroppedTables();
+        return 0;
+    }
+
+    /**
+     * @brief Removes all tuples from the table
+     *
+     * The table is replaced by an empty table with the same name, ID and schema history so clients keep writing in the
+     * schema version they know. The old table is released the same way as a dropped table. Writes running concurrently
+     * may end up in either table.
+     */
+    template <typename... Args>
+    int truncateTable(uint64_t tableId, Args&&... args) {
+        {
+            typename decltype(mTablesMutex)::scoped_lock _(mTablesMutex, true);
+            auto i = mTables.find(tableId);
+            if (i == mTables.end()) {
+                return error::invalid_table;
+            }
+            auto table = i->second;
+            auto ptr = crossbow::allocator::construct<Table>(mPageManager, table->tableName(), table->schemas(),
+                    tableId, std::forward<Args>(args)...);
+            LOG_ASSERT(ptr, "Unable to allocate table");
+            i->second = ptr;
+            dropLocked(table);
+        }
+        tryRetireDroppedTables();
+        return 0;
+    }
+
     std::vector<const Table*> getTables() const {
         typename decltype(mTablesMutex)::scoped_lock _(mTablesMutex, false);
         std::vector<const Table*> result;
@@ -180,42 +265,64 @@ public:
         auto res = mNames.find(name);
         if (res == mNames.end()) return nullptr;
         id = res->second;
-        return lookupTable(res->second);
+        auto i = mTables.find(res->second);
+        return (i == mTables.end() ? nullptr : i->second);
     }
 
     template <typename Fun>
     int get(uint64_t tableId, uint64_t key, const commitmanager::SnapshotDescriptor& snapshot, Fun fun)
     {
-        crossbow::allocator _;
+        ReclamationGuard _;
         mVersionManager.addSnapshot(snapshot);
         return executeTable(tableId, [key, &snapshot, &fun] (Table* table) {
             return table->get(key, snapshot, fun);
         });
     }
 
+    /**
+     * @brief Reads a batch of keys from the same table
+     *
+     * The function is called as fun(index, size, version, isNewest) for every key that was found. If the table does
+     * not exist all keys fail with error::invalid_table.
+     */
+    template <typename Fun>
+    void get(uint64_t tableId, const uint64_t* keys, size_t count, const commitmanager::SnapshotDescriptor& snapshot,
+            int* ec, Fun fun)
+    {
+        ReclamationGuard _;
+        mVersionManager.addSnapshot(snapshot);
+        auto res = executeTable(tableId, [keys, count, &snapshot, ec, &fun] (Table* table) {
+            table->get(keys, count, snapshot, ec, fun);
+            return 0;
+        });
+        if (res != 0) {
+            std::fill(ec, ec + count, res);
+        }
+    }
+
     int update(uint64_t tableId, uint64_t key, size_t size, const char* data,
-            const commitmanager::SnapshotDescriptor& snapshot)
+            const commitmanager::SnapshotDescriptor& snapshot, uint32_t schemaVersion)
     {
-        crossbow::allocator _;
+        ReclamationGuard _;
         mVersionManager.addSnapshot(snapshot);
-        return executeTable(tableId, [key, size, data, &snapshot] (Table* table) {
-            return table->update(key, size, data, snapshot);
+        return executeTable(tableId, [key, size, data, &snapshot, schemaVersion] (Table* table) {
+            return table->update(key, size, data, snapshot, schemaVersion);
         });
     }
 
     int insert(uint64_t tableId, uint64_t key, size_t size, const char* data,
-            const commitmanager::SnapshotDescriptor& snapshot)
+            const commitmanager::SnapshotDescriptor& snapshot, uint32_t schemaVersion)
     {
-        crossbow::allocator _;
+        ReclamationGuard _;
         mVersionManager.addSnapshot(snapshot);
-        return executeTable(tableId, [key, size, data, &snapshot] (Table* table) {
-            return table->insert(key, size, data, snapshot);
+        return executeTable(tableId, [key, size, data, &snapshot, schemaVersion] (Table* table) {
+            return table->insert(key, size, data, snapshot, schemaVersion);
         });
     }
 
     int remove(uint64_t tableId, uint64_t key, const commitmanager::SnapshotDescriptor& snapshot)
     {
-        crossbow::allocator _;
+        ReclamationGuard _;
         mVersionManager.addSnapshot(snapshot);
         return executeTable(tableId, [key, &snapshot] (Table* table) {
             return table->remove(key, snapshot);
@@ -224,7 +331,7 @@ public:
 
     int revert(uint64_t tableId, uint64_t key, const commitmanager::SnapshotDescriptor& snapshot)
     {
-        crossbow::allocator _;
+        ReclamationGuard _;
         mVersionManager.addSnapshot(snapshot);
         return executeTable(tableId, [key, &snapshot] (Table* table) {
             return table->revert(key, snapshot);
@@ -232,12 +339,44 @@ public:
     }
 
     int scan(uint64_t tableId, ScanQuery* query) {
+        if (!mScanManager.reserve(query)) {
+            return error::server_overlad;
+        }
+        return scanReserved(tableId, query);
+    }
+
+    /**
+     * @brief Reserves a slot in the scan queue so a following scanReserved() can not be rejected due to overload
+     */
+    bool reserveScan(ScanQuery* query) {
+        return mScanManager.reserve(query);
+    }
+
+    /**
+     * @brief Releases a slot reserved with reserveScan() without scanning
+     */
+    void releaseScan(ScanQuery* query) {
+        mScanManager.release(query);
+    }
+
+    /**
+     * @brief Enqueues the scan into the slot reserved with reserveScan()
+     *
+     * The reservation is consumed even if the scan fails.
+     */
+    int scanReserved(uint64_t tableId, ScanQuery* query) {
         if (query && query->snapshot()) {
             mVersionManager.addSnapshot(*query->snapshot());
         }
-        return executeTable(tableId, [this, tableId, query] (Table* table) {
-            return mScanManager.scan(tableId, table, query);
-        });
+
+        // The scan has to be pending before the table can be dropped
+        typename decltype(mTablesMutex)::scoped_lock _(mTablesMutex, false);
+        auto i = mTables.find(tableId);
+        if (i == mTables.end()) {
+            mScanManager.release(query);
+            return error::invalid_table;
+        }
+        return mScanManager.scanReserved(tableId, i->second, query);
     }
 
     void forceGC() {
@@ -246,6 +385,57 @@ public:
     }
 
 private:
+    /**
+     * @brief Queues the table (already removed from the table map) for release
+     *
+     * Must be called while holding the table map lock exclusively: Every scan that found the table is then already
+     * accounted as pending by the scan manager.
+     */
+    void dropLocked(Table* table) {
+        std::lock_guard<std::mutex> _(mDroppedMutex);
+        mDroppedTables.emplace_back(table);
+    }
+
+    /**
+     * @brief Releases the dropped tables right away unless the garbage collection is running
+     *
+     * A running garbage collection may still hold the dropped tables, it releases them when it is done.
+     */
+    void tryRetireDroppedTables() {
+        std::unique_lock<std::mutex> lock(mGCMutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+            retireDroppedTables();
+        }
+    }
+
+    /**
+     * @brief Retires all dropped tables no pending scan references
+     *
+     * Must be called while holding the GC mutex. The tables are destroyed by the page manager once all readers that
+     * may have looked them up left. Tables with pending scans are retried after the next garbage collection.
+     */
+    void retireDroppedTables() {
+        std::vector<Table*> tables;
+        {
+            std::lock_guard<std::mutex> _(mDroppedMutex);
+            auto i = std::partition(mDroppedTables.begin(), mDroppedTables.end(), [this] (Table* table) {
+                return mScanManager.hasPendingScans(table);
+            });
+            if (i == mDroppedTables.end()) {
+                return;
+            }
+            tables.assign(i, mDroppedTables.end());
+            mDroppedTables.erase(i, mDroppedTables.end());
+        }
+
+        mPageManager.retire([tables] () {
+            for (auto table : tables) {
+                crossbow::allocator::destroy_now(table);
+            }
+        });
+        mPageManager.reclaim();
+    }
+
     const Table* lookupTable(uint64_t tableId) const {
         typename decltype(mTablesMutex)::scoped_lock _(mTablesMutex, false);
         auto i = mTables.find(tableId);
@@ -256,8 +446,14 @@ private:
         return const_cast<Table*>(const_cast<const TableManager*>(this)->lookupTable(tableId));
     }
 
+    /**
+     * @brief Executes the function on the table
+     *
+     * The guard keeps the table alive while the function runs even if the table is dropped concurrently.
+     */
     template <typename Fun>
     int executeTable(uint64_t tableId, Fun fun) {
+        ReclamationGuard _;
         auto table = lookupTable(tableId);
         if (!table) {
             return error::invalid_table;
@@ -0,0 +1,106 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include "ThreadAffinity.hpp"
+
+#include <crossbow/logger.hpp>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace tell {
+namespace store {
+namespace {
+
+unsigned parseCore(const std::string& value) {
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+        throw std::invalid_argument("Invalid core \"" + value + "\"");
+    }
+    auto core = std::stoul(value);
+    if (core >= CPU_SETSIZE) {
+        throw std::invalid_argument("Core " + value + " out of range");
+    }
+    return static_cast<unsigned>(core);
+}
+
+} // anonymous namespace
+
+std::vector<unsigned> parseCoreList(const crossbow::string& list) {
+    std::vector<unsigned> cores;
+    std::string value(list.c_str(), list.size());
+    if (value.empty()) {
+        return cores;
+    }
+
+    size_t begin = 0;
+    while (true) {
+        auto end = value.find(',', begin);
+        auto element = value.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+
+        auto dash = element.find('-');
+        if (dash == std::string::npos) {
+            cores.emplace_back(parseCore(element));
+        } else {
+            auto first = parseCore(element.substr(0, dash));
+            auto last = parseCore(element.substr(dash + 1));
+            if (first > last) {
+                throw std::invalid_argument("Invalid core range \"" + element + "\"");
+            }
+            for (auto core = first; core <= last; ++core) {
+                cores.emplace_back(core);
+            }
+        }
+
+        if (end == std::string::npos) {
+            break;
+        }
+        begin = end + 1;
+    }
+    return cores;
+}
+
+bool pinThread(std::thread::native_handle_type thread, const std::vector<unsigned>& cores, size_t index) {
+    if (cores.empty()) {
+        return false;
+    }
+    auto core = cores[index % cores.size()];
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    if (auto res = pthread_setaffinity_np(thread, sizeof(set), &set)) {
+        LOG_ERROR("Unable to pin thread to core %1% [error = %2%]", core, strerror(res));
+        return false;
+    }
+    return true;
+}
+
+bool pinCurrentThread(const std::vector<unsigned>& cores, size_t index) {
+    return pinThread(pthread_self(), cores, index);
+}
+
+} // namespace store
+} // namespace tell
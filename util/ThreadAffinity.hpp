@@ -0,0 +1,62 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <crossbow/string.hpp>
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace tell {
+namespace store {
+
+/**
+ * @brief Parses a comma separated list of cores and core ranges (e.g. "0,2,4-7")
+ *
+ * An empty string yields an empty list.
+ *
+ * @exception std::invalid_argument If the list is malformed
+ */
+std::vector<unsigned> parseCoreList(const crossbow::string& list);
+
+/**
+ * @brief Pins the thread to the core at the given index (wrapping around) in the list of cores
+ *
+ * Does nothing if the list of cores is empty.
+ *
+ * @return Whether the thread is pinned
+ */
+bool pinThread(std::thread::native_handle_type thread, const std::vector<unsigned>& cores, size_t index);
+
+/**
+ * @brief Pins the calling thread to the core at the given index (wrapping around) in the list of cores
+ *
+ * Does nothing if the list of cores is empty.
+ *
+ * @return Whether the thread is pinned
+ */
+bool pinCurrentThread(const std::vector<unsigned>& cores, size_t index);
+
+} // namespace store
+} // namespace tell